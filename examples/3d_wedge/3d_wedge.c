@@ -1086,17 +1086,17 @@ dump_slice(jmm_3d_wedge_problem_s const *wedge, grid2_s const *img_grid,
       fwrite(&Ab, sizeof(Ab), 1, fp);
     }
   } else {
-    jet31t *jet = NULL;
+    eik3_s const *eik = NULL;
     jet32t *jet_gt = NULL;
     jet31t *field_jet = NULL;
 
     if (field == FIELD_T || field == FIELD_E_T) {
       if (wedge_eik == WEDGE_EIK_DIRECT)
-        jet = eik3_get_jet_ptr(wedge->eik_direct);
+        eik = wedge->eik_direct;
       else if (wedge_eik == WEDGE_EIK_O_REFL)
-        jet = eik3_get_jet_ptr(wedge->eik_o_refl);
+        eik = wedge->eik_o_refl;
       else if (wedge_eik == WEDGE_EIK_N_REFL)
-        jet = eik3_get_jet_ptr(wedge->eik_n_refl);
+        eik = wedge->eik_n_refl;
       else
         assert(false);
     }
@@ -1112,18 +1112,22 @@ dump_slice(jmm_3d_wedge_problem_s const *wedge, grid2_s const *img_grid,
         assert(false);
     }
 
-    if (field == FIELD_T)
-      field_jet = jet;
-
     if (field == FIELD_E_T) {
       field_jet = malloc(mesh3_nverts(wedge->mesh)*sizeof(jet31t));
-      for (size_t l = 0; l < mesh3_nverts(wedge->mesh); ++l)
-        jet31t_sub((jet31t const *)&jet_gt[l], &jet[l], &field_jet[l]);
+      for (size_t l = 0; l < mesh3_nverts(wedge->mesh); ++l) {
+        jet31t jet = eik3_get_jet(eik, l);
+        jet31t_sub((jet31t const *)&jet_gt[l], &jet, &field_jet[l]);
+      }
     }
 
     bmesh33_s *bmesh;
     bmesh33_alloc(&bmesh);
-    bmesh33_init_from_mesh3_and_jets(bmesh, wedge->mesh, field_jet);
+    if (field == FIELD_T)
+      bmesh33_init_from_mesh3_and_3d_data(bmesh, wedge->mesh,
+                                          eik3_get_T_ptr(eik),
+                                          eik3_get_DT_ptr(eik));
+    else
+      bmesh33_init_from_mesh3_and_jets(bmesh, wedge->mesh, field_jet);
 
     for (size_t l = 0; l < grid2_nind(img_grid); ++l) {
       dbl value;
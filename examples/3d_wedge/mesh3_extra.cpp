@@ -266,7 +266,9 @@ jmm_error_e mesh3_init_from_3d_wedge_spec(mesh3_s *mesh,
 
   dbl3 xsrc = {spec->sp*cos(spec->phip), spec->sp*sin(spec->phip), 0};
   mesh3_data_insert_vert(&data, xsrc, 1e-10);
-  mesh3_init(mesh, &data, true, NULL);
+  jmm_error_e error = mesh3_init(mesh, &data, true, true, NULL);
+  if (error != JMM_ERROR_NONE)
+    return error;
 
   /* Make sure the point source is actually included in the mesh! */
   assert(mesh3_has_vertex(mesh, addin.pointlist));
@@ -0,0 +1,99 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <jmm/eik3.h>
+#include <jmm/front.h>
+#include <jmm/mesh3.h>
+#include <jmm/util.h>
+#include <jmm/vec.h>
+
+/* Solve a point source problem on a tetrahedralized .off file using
+ * each kind of front, reporting the total solve time, the number of
+ * nodes popped from the front per second, and how far each solution
+ * is from the one computed with the heap (the exact fast marching
+ * order). */
+
+static char const *front_type_name[] = {
+  [FRONT_TYPE_HEAP] = "heap",
+  [FRONT_TYPE_BUCKET] = "bucket"
+};
+
+int main(int argc, char const *argv[]) {
+  if (argc < 6) {
+    printf("usage: %s <off_path> <maxvol> <x> <y> <z> [rfac]\n", argv[0]);
+    exit(EXIT_FAILURE);
+  }
+
+  char const *off_path = argv[1];
+  dbl maxvol = atof(argv[2]);
+  dbl3 xsrc = {atof(argv[3]), atof(argv[4]), atof(argv[5])};
+  dbl rfac = argc >= 7 ? atof(argv[6]) : 0.1;
+  dbl eps = 1e-5;
+
+  toc();
+
+  mesh3_data_s data;
+  mesh3_data_init_from_off_file(&data, off_path, maxvol, false);
+  if (mesh3_data_insert_verts(&data, 1, &xsrc, eps) != SUCCESS) {
+    fprintf(stderr, "ERROR: point source (%g, %g, %g) isn't in the mesh\n",
+            xsrc[0], xsrc[1], xsrc[2]);
+    exit(EXIT_FAILURE);
+  }
+
+  mesh3_s *mesh;
+  mesh3_alloc(&mesh);
+  if (mesh3_init(mesh, &data, true, true, &eps) != JMM_ERROR_NONE) {
+    fprintf(stderr, "ERROR: mesh is too large for %d-bit indices "
+            "(reconfigure with -Dindex_width=64)\n", JMM_INDEX_WIDTH);
+    exit(EXIT_FAILURE);
+  }
+
+  size_t nverts = mesh3_nverts(mesh);
+
+  printf("set up tetrahedron mesh with %lu vertices [%.2fs]\n", nverts, toc());
+
+  eik3_s *eik;
+  eik3_alloc(&eik);
+  eik3_init(eik, mesh, &SFUNC_CONSTANT);
+
+  dbl *T_heap = malloc(nverts*sizeof(dbl));
+
+  front_type_e type[] = {FRONT_TYPE_HEAP, FRONT_TYPE_BUCKET};
+  for (size_t i = 0; i < sizeof(type)/sizeof(type[0]); ++i) {
+    eik3_reset(eik);
+    eik3_set_front_type(eik, type[i]);
+    eik3_add_pt_src_bcs(eik, xsrc, rfac);
+
+    toc();
+    jmm_error_e error = eik3_solve(eik);
+    dbl t = toc();
+
+    size_t num_pops = front_get_num_pops(eik3_get_front(eik));
+
+    dbl max_diff = 0;
+    for (size_t l = 0; l < nverts; ++l) {
+      dbl T = eik3_get_T(eik, l);
+      if (type[i] == FRONT_TYPE_HEAP)
+        T_heap[l] = T;
+      else
+        max_diff = fmax(max_diff, fabs(T - T_heap[l]));
+    }
+
+    printf("%-6s: solved in %.3fs (%s), %lu pops (%.3g pops/s), "
+           "max |T - T_heap| = %g\n",
+           front_type_name[type[i]], t,
+           error == JMM_ERROR_NONE ? "ok" : "failed",
+           num_pops, num_pops/t, max_diff);
+  }
+
+  free(T_heap);
+
+  eik3_deinit(eik);
+  eik3_dealloc(&eik);
+
+  mesh3_deinit(mesh);
+  mesh3_dealloc(&mesh);
+
+  mesh3_data_deinit(&data);
+}
@@ -1,9 +1,11 @@
 #include <omp.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <jmm/bmesh.h>
 #include <jmm/eik3.h>
+#include <jmm/eik3_batch.h>
 #include <jmm/log.h>
 #include <jmm/mesh3.h>
 #include <jmm/util.h>
@@ -69,13 +71,19 @@ int main(int argc, char const *argv[]) {
   mesh3_data_init_from_off_file(&data, off_path, maxvol, verbose);
 
   /* Add the point sources to the mesh */
-  mesh3_data_insert_vert(&data, xsrc_R, eps);
-  mesh3_data_insert_vert(&data, xsrc_L, eps);
+  dbl3 xsrc_RL[2];
+  dbl3_copy(xsrc_R, xsrc_RL[0]);
+  dbl3_copy(xsrc_L, xsrc_RL[1]);
+  mesh3_data_insert_verts(&data, 2, xsrc_RL, eps);
 
   /* Set up tetrahedron mesh */
   mesh3_s *mesh;
   mesh3_alloc(&mesh);
-  mesh3_init(mesh, &data, true, &eps);
+  if (mesh3_init(mesh, &data, true, true, &eps) != JMM_ERROR_NONE) {
+    fprintf(stderr, "ERROR: mesh is too large for %d-bit indices "
+            "(reconfigure with -Dindex_width=64)\n", JMM_INDEX_WIDTH);
+    exit(EXIT_FAILURE);
+  }
 
   /* Write vertices and cells to disk in row-major order */
   mesh3_dump_verts(mesh, "verts.bin");
@@ -83,28 +91,40 @@ int main(int argc, char const *argv[]) {
 
   printf("set up tetrahedron mesh [%.2fs]\n", toc());
 
-  /* Solve the eikonal equation for the left ear */
-  eik3_s *eik_L;
-  eik3_alloc(&eik_L);
-  eik3_init(eik_L, mesh, &SFUNC_CONSTANT);
-  eik3_add_pt_src_bcs(eik_L, xsrc_L, rfac);
-  eik3_solve(eik_L);
-  eik3_dump_jet(eik_L, "jet_L.bin");
+  FILE *fp = NULL;
 
-  printf("computed eikonal for left ear [%.2fs]\n", toc());
+  /* Solve the eikonal equations for both ears at once, recycling the
+   * solver state between them */
+  size_t nverts = mesh3_nverts(mesh);
+  dbl3 xsrc[2];
+  dbl3_copy(xsrc_L, xsrc[0]);
+  dbl3_copy(xsrc_R, xsrc[1]);
+  dbl rfacs[2] = {rfac, rfac};
+  jet31t *jet = malloc(2*nverts*sizeof(jet31t));
+
+  eik3_batch_s *batch;
+  eik3_batch_alloc(&batch);
+  eik3_batch_init(batch, mesh, &SFUNC_CONSTANT, nthreads);
+  if (eik3_batch_solve_pt_srcs(batch, 2, xsrc, rfacs, jet, nverts)
+      != JMM_ERROR_NONE) {
+    fprintf(stderr, "ERROR: failed to solve the point source problems\n");
+    exit(EXIT_FAILURE);
+  }
+  eik3_batch_deinit(batch);
+  eik3_batch_dealloc(&batch);
 
-  /* Solve the eikonal equation for the right ear */
-  eik3_s *eik_R;
-  eik3_alloc(&eik_R);
-  eik3_init(eik_R, mesh, &SFUNC_CONSTANT);
-  eik3_add_pt_src_bcs(eik_R, xsrc_R, rfac);
-  eik3_solve(eik_R);
-  eik3_dump_jet(eik_R, "jet_R.bin");
+  jet31t const *jet_L = &jet[0];
+  jet31t const *jet_R = &jet[nverts];
 
-  printf("computed eikonal for right ear [%.2fs]\n", toc());
+  fp = fopen("jet_L.bin", "wb");
+  fwrite(jet_L, sizeof(jet31t), nverts, fp);
+  fclose(fp);
 
-  jet31t const *jet_L = eik3_get_jet_ptr(eik_L);
-  jet31t const *jet_R = eik3_get_jet_ptr(eik_R);
+  fp = fopen("jet_R.bin", "wb");
+  fwrite(jet_R, sizeof(jet31t), nverts, fp);
+  fclose(fp);
+
+  printf("computed eikonals for left and right ears [%.2fs]\n", toc());
 
   /* Set up tetrahedral spline interpolating jet data for left ear */
   bmesh33_s *tau_L;
@@ -118,23 +138,29 @@ int main(int argc, char const *argv[]) {
 
   printf("set up tetrahedral splines for interpolating L/R eikonals [%.2fs]\n", toc());
 
-  FILE *fp = NULL;
+  dbl3 *point = malloc(num_el*num_az*sizeof(dbl3));
+  for (size_t i = 0, k = 0; i < num_el; ++i) {
+    dbl el = theta_grid[i];
+    for (size_t j = 0; j < num_az; ++j, ++k) {
+      dbl az = phi_grid[j];
+      dbl3 x = {cos(az)*sin(el), sin(az)*sin(el), cos(el)};
+      dbl3_dbl_mul(x, r_grid, point[k]);
+    }
+  }
+
+  dbl *T_L = malloc(num_el*num_az*sizeof(dbl));
+  bmesh33_f_batch(tau_L, num_el*num_az, point, T_L);
+
+  dbl *T_R = malloc(num_el*num_az*sizeof(dbl));
+  bmesh33_f_batch(tau_R, num_el*num_az, point, T_R);
 
   dbl *itd = malloc(num_el*num_az*sizeof(dbl));
+  for (size_t k = 0; k < num_el*num_az; ++k)
+    itd[k] = (T_R[k] - T_L[k])/c;
 
-  { size_t k = 0;
-#pragma omp parallel for
-    for (size_t i = 0; i < num_el; ++i) {
-      dbl el = theta_grid[i];
-      for (size_t j = 0; j < num_az; ++j) {
-        dbl az = phi_grid[j];
-        dbl3 point = {cos(az)*sin(el), sin(az)*sin(el), cos(el)};
-        dbl3_dbl_mul_inplace(point, r_grid);
-        dbl T_L = bmesh33_f(tau_L, point)/c;
-        dbl T_R = bmesh33_f(tau_R, point)/c;
-        itd[k++] = T_R - T_L;
-      }
-    } }
+  free(T_R);
+  free(T_L);
+  free(point);
 
   printf("interpolated ITD to grid [%.2fs]\n", toc());
 
@@ -152,11 +178,7 @@ int main(int argc, char const *argv[]) {
   bmesh33_deinit(tau_L);
   bmesh33_dealloc(&tau_L);
 
-  eik3_deinit(eik_L);
-  eik3_dealloc(&eik_L);
-
-  eik3_deinit(eik_R);
-  eik3_dealloc(&eik_R);
+  free(jet);
 
   mesh3_deinit(mesh);
   mesh3_dealloc(&mesh);
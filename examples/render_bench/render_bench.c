@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <jmm/camera.h>
+#include <jmm/mesh2.h>
+#include <jmm/mesh3.h>
+#include <jmm/rtree.h>
+#include <jmm/util.h>
+#include <jmm/vec.h>
+
+/* Trace the camera rays of a cube map centered at a point through an
+ * R-tree containing the boundary of a tetrahedralized .off file, once
+ * a ray at a time with `rtree_intersect` and once in packets with
+ * `rtree_intersect_packet`. For each, this reports the time taken
+ * and the number of rays traced per second, along with the number of
+ * rays whose hits differ between the two. */
+
+/* The look, left, and up vectors of the six faces of the cube map */
+static dbl3 const cube_map_frame[6][3] = {
+  {{ 1,  0,  0}, { 0,  1,  0}, { 0,  0,  1}},
+  {{-1,  0,  0}, { 0, -1,  0}, { 0,  0,  1}},
+  {{ 0,  1,  0}, {-1,  0,  0}, { 0,  0,  1}},
+  {{ 0, -1,  0}, { 1,  0,  0}, { 0,  0,  1}},
+  {{ 0,  0,  1}, { 0,  1,  0}, {-1,  0,  0}},
+  {{ 0,  0, -1}, { 0,  1,  0}, { 1,  0,  0}}
+};
+
+int main(int argc, char const *argv[]) {
+  if (argc < 6) {
+    printf("usage: %s <off_path> <maxvol> <x> <y> <z> [dim]\n", argv[0]);
+    exit(EXIT_FAILURE);
+  }
+
+  char const *off_path = argv[1];
+  dbl maxvol = atof(argv[2]);
+  dbl3 xcam = {atof(argv[3]), atof(argv[4]), atof(argv[5])};
+  size_t dim = argc >= 7 ? (size_t)atoi(argv[6]) : 512;
+  dbl eps = 1e-5;
+
+  toc();
+
+  mesh3_data_s data;
+  mesh3_data_init_from_off_file(&data, off_path, maxvol, false);
+
+  mesh3_s *mesh;
+  mesh3_alloc(&mesh);
+  if (mesh3_init(mesh, &data, true, false, &eps) != JMM_ERROR_NONE) {
+    fprintf(stderr, "ERROR: mesh is too large for %d-bit indices "
+            "(reconfigure with -Dindex_width=64)\n", JMM_INDEX_WIDTH);
+    exit(EXIT_FAILURE);
+  }
+
+  mesh2_s *surface_mesh = mesh3_get_surface_mesh(mesh);
+
+  rtree_s *rtree;
+  rtree_alloc(&rtree);
+  rtree_init(rtree, 16, RTREE_SPLIT_STRATEGY_SURFACE_AREA);
+  rtree_insert_mesh2(rtree, surface_mesh);
+  rtree_build(rtree);
+
+  printf("built R-tree for %lu boundary faces [%.2fs]\n",
+         mesh2_nfaces(surface_mesh), toc());
+
+  size_t npix = dim*dim, nrays = 6*npix;
+
+  ray3 *ray = malloc(nrays*sizeof(ray3));
+  for (size_t k = 0, l = 0; k < 6; ++k) {
+    camera_s camera = {.type = CAMERA_TYPE_PERSPECTIVE,
+                       .fovy = 90,
+                       .aspect = 1,
+                       .dim = {dim, dim}};
+    dbl3_copy(xcam, camera.pos);
+    dbl3_copy(cube_map_frame[k][0], camera.look);
+    dbl3_copy(cube_map_frame[k][1], camera.left);
+    dbl3_copy(cube_map_frame[k][2], camera.up);
+    for (size_t i = 0; i < dim; ++i)
+      for (size_t j = 0; j < dim; ++j, ++l)
+        ray[l] = camera_get_ray_for_index(&camera, i, j);
+  }
+
+  isect *isect_single = malloc(nrays*sizeof(isect));
+  isect *isect_packet = malloc(nrays*sizeof(isect));
+
+  toc();
+  for (size_t l = 0; l < nrays; ++l)
+    rtree_intersect(rtree, &ray[l], &isect_single[l], NULL);
+  dbl t_single = toc();
+
+  toc();
+  rtree_intersect_packet(rtree, ray, nrays, isect_packet, NULL);
+  dbl t_packet = toc();
+
+  size_t num_hits = 0, num_diffs = 0;
+  for (size_t l = 0; l < nrays; ++l) {
+    num_hits += isect_single[l].obj != NULL;
+    num_diffs += isect_single[l].t != isect_packet[l].t
+      || isect_single[l].obj != isect_packet[l].obj;
+  }
+
+  printf("traced %lu rays (6 faces of %lux%lu pixels, %lu hits)\n",
+         nrays, dim, dim, num_hits);
+  printf("single: %.3fs (%.3g rays/s)\n", t_single, nrays/t_single);
+  printf("packet: %.3fs (%.3g rays/s), %.2fx speedup, %lu rays differ\n",
+         t_packet, nrays/t_packet, t_single/t_packet, num_diffs);
+
+  free(isect_packet);
+  free(isect_single);
+  free(ray);
+
+  rtree_deinit(rtree);
+  rtree_dealloc(&rtree);
+
+  mesh2_deinit(surface_mesh);
+  mesh2_dealloc(&surface_mesh);
+
+  mesh3_deinit(mesh);
+  mesh3_dealloc(&mesh);
+
+  mesh3_data_deinit(&data);
+}
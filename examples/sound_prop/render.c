@@ -1,6 +1,7 @@
 #include <assert.h>
 #include <argp.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -9,7 +10,7 @@
 #include <jmm/camera.h>
 #include <jmm/mesh2.h>
 #include <jmm/mesh3.h>
-#include <jmm/rtree.h>
+#include <jmm/renderer.h>
 #include <jmm/util.h>
 
 const char *argp_program_version = "render 0.0";
@@ -147,7 +148,11 @@ int main(int argc, char *argv[]) {
 
   mesh3_s *mesh;
   mesh3_alloc(&mesh);
-  mesh3_init(mesh, &data, true, &eps);
+  if (mesh3_init(mesh, &data, true, false, &eps) != JMM_ERROR_NONE) {
+    fprintf(stderr, "ERROR: mesh is too large for %d-bit indices "
+            "(reconfigure with -Dindex_width=64)\n", JMM_INDEX_WIDTH);
+    exit(EXIT_FAILURE);
+  }
 
   array_s *bmesh_arr;
   array_alloc(&bmesh_arr);
@@ -197,8 +202,6 @@ int main(int argc, char *argv[]) {
     array_append(org_arr, &org);
   }
 
-  mesh2_s *surface_mesh = mesh3_get_surface_mesh(mesh);
-
   /* TODO: read camera from file */
   camera_s camera = {
     // .type = CAMERA_TYPE_ORTHOGRAPHIC,
@@ -225,144 +228,28 @@ int main(int argc, char *argv[]) {
   for (size_t i = 0; i < num_frames; ++i)
     tau[i] = tau0 + i/spec.frames_per_meter;
 
-  for (size_t i = 0; i < num_frames; ++i) {
-    if (spec.verbose)
-      printf("frame %lu/%lu (tau = %g m)\n", i + 1, num_frames, tau[i]);
-
-    rtree_s *rtree;
-    rtree_alloc(&rtree);
-    rtree_init(rtree, 16, RTREE_SPLIT_STRATEGY_SURFACE_AREA);
+  renderer_s *renderer;
+  renderer_alloc(&renderer);
+  renderer_init(renderer, mesh, &camera);
 
-    rtree_insert_mesh2(rtree, surface_mesh);
+  for (size_t i = 0; i < array_size(bmesh_arr); ++i) {
+    bmesh33_s *bmesh;
+    array_get(bmesh_arr, i, &bmesh);
+    dbl const *spread;
+    array_get(spread_arr, i, &spread);
+    dbl const *org;
+    array_get(org_arr, i, &org);
+    renderer_add_bmesh33(renderer, bmesh, spread, org);
+  }
 
-    array_s *level_bmesh_arr;
-    array_alloc(&level_bmesh_arr);
-    array_init(level_bmesh_arr, sizeof(bmesh33_s *), ARRAY_DEFAULT_CAPACITY);
+  size_t npix = camera.dim[0]*camera.dim[1];
+  dbl4 *img = malloc(npix*sizeof(dbl4));
 
-    for (size_t j = 0; j < array_size(bmesh_arr); ++j) {
-      bmesh33_s *bmesh;
-      array_get(bmesh_arr, j, &bmesh);
-      bmesh33_s *level_bmesh = bmesh33_restrict_to_level(bmesh, tau[i]);
-      rtree_insert_bmesh33(rtree, level_bmesh);
-      array_append(level_bmesh_arr, &level_bmesh);
-    }
+  for (size_t i = 0; i < num_frames; ++i) {
+    if (spec.verbose)
+      printf("frame %lu/%lu (tau = %g m)\n", i + 1, num_frames, tau[i]);
 
-    rtree_build(rtree);
-
-    size_t npix = camera.dim[0]*camera.dim[1];
-
-    dbl4 *img = malloc(npix*sizeof(dbl4));
-
-    dbl3 surf_rgb = {0.54, 0.54, 0.54};
-    dbl3 eik_rgb = {1.0, 1.0, 1.0};
-
-    dbl surf_alpha = 0.5;
-    dbl eik_alpha = 1;
-
-    for (size_t i = 0, l = 0; i < camera.dim[0]; ++i) {
-      for (size_t j = 0; j < camera.dim[1]; ++j, ++l) {
-        ray3 ray = camera_get_ray_for_index(&camera, i, j);
-
-        isect isect;
-        rtree_intersect(rtree, &ray, &isect, NULL);
-
-        img[l][0] = 0;
-        img[l][1] = 0;
-        img[l][2] = 0;
-        img[l][3] = isfinite(isect.t) ? 1 : 0;
-
-        dbl transparency = 1;
-        dbl const *rgb = NULL;
-        dbl3 n;
-
-        while (isfinite(isect.t)) {
-          robj_type_e robj_type = robj_get_type(isect.obj);
-          void const *robj_data = robj_get_data(isect.obj);
-
-          dbl alpha = 1, scale = 1;
-
-          /* Increment the distance along the ray */
-          dbl3_saxpy_inplace(isect.t, ray.dir, ray.org);
-
-          /* Update the current alpha and RGB value */
-          switch (robj_type) {
-          case ROBJ_MESH2_TRI:
-            alpha *= surf_alpha;
-            rgb = &surf_rgb[0];
-            break;
-          case ROBJ_BMESH33_CELL:
-            alpha *= eik_alpha;
-            rgb = &eik_rgb[0];
-            break;
-          default:
-            assert(false);
-          }
-
-          if (robj_type == ROBJ_BMESH33_CELL) {
-            bmesh33_cell_s const *bmesh33_cell = robj_data;
-            dbl spread_interp, org_interp;
-
-            /* Figure out which level mesh this cell belongs to :-( */
-            size_t k;
-            for (k = 0; k < array_size(level_bmesh_arr); ++k) {
-              bmesh33_s *level_bmesh;
-              array_get(level_bmesh_arr, k, &level_bmesh);
-              if (bmesh33_cell->bmesh == level_bmesh)
-                break;
-            }
-            assert(k < array_size(level_bmesh_arr));
-
-            dbl const *spread;
-            array_get(spread_arr, k, &spread);
-            spread_interp = mesh3_linterp(mesh, spread, ray.org);
-
-            dbl const *org;
-            array_get(org_arr, k, &org);
-            org_interp = mesh3_linterp(mesh, org, ray.org);
-
-            // Convert the interpolated spreading factor to dB
-            dbl spread_dB = 20*log10(fmax(1e-16, spread_interp));
-            /* Clamp and map the range [-60 dB, 0 dB] to [0, 1] for
-             * use as a scaling factor */
-            dbl spread_mapped = fmax(0, fmin(1, 1 - spread_dB/(-90)));
-            alpha *= spread_mapped*squash(org_interp, 2);
-          }
-
-          /* Get the surface normal and dot it with the eye vector for
-           * Lambertian shading */
-          if (robj_type == ROBJ_MESH2_TRI) {
-            mesh2_tri_s const *mesh2_tri = robj_data;
-            mesh2_get_unit_surface_normal(surface_mesh, mesh2_tri->l, n);
-          } else if (robj_type == ROBJ_BMESH33_CELL) {
-            bmesh33_cell_s const *bmesh33_cell = robj_data;
-            bmesh33_cell_Df(bmesh33_cell, ray.org, n);
-            dbl3_normalize(n);
-          } else {
-            assert(false);
-          }
-          scale *= fabs(dbl3_dot(n, ray.dir));
-
-          /* We're raymarching, so do backwards alpha blending */
-          dbl3_saxpy_inplace(scale*alpha, rgb, img[l]);
-
-          /* Update transparency for early stopping */
-          transparency *= 1 - alpha;
-          if (transparency < 1e-3)
-            break;
-
-          /* Advance the start of the ray and keep tracing.
-           *
-           * NOTE: if we have multiple overlapping intersections, we
-           * might trip them repeatedly, so we need to skip any
-           * intersections with a distance of zero here. */
-          rtree_intersect(rtree, &ray, &isect, isect.obj);
-          while (isect.t < EPS) {
-            dbl3_saxpy_inplace(EPS, ray.dir, ray.org);
-            rtree_intersect(rtree, &ray, &isect, isect.obj);
-          }
-        }
-      }
-    }
+    renderer_render_frame(renderer, tau[i], img);
 
     char filename[128];
     snprintf(filename, 128, "image%04lu.bin", i);
@@ -370,22 +257,12 @@ int main(int argc, char *argv[]) {
     FILE *fp = fopen(filename, "wb");
     fwrite(img, sizeof(dbl4), npix, fp);
     fclose(fp);
-
-    for (size_t i = 0; i < array_size(level_bmesh_arr); ++i) {
-      bmesh33_s *level_bmesh;
-      array_get(level_bmesh_arr, i, &level_bmesh);
-      bmesh33_deinit(level_bmesh);
-      bmesh33_dealloc(&level_bmesh);
-    }
-    array_deinit(level_bmesh_arr);
-    array_dealloc(&level_bmesh_arr);
-
-    rtree_deinit(rtree);
-    rtree_dealloc(&rtree);
   }
 
-  mesh2_deinit(surface_mesh);
-  mesh2_dealloc(&surface_mesh);
+  free(img);
+
+  renderer_deinit(renderer);
+  renderer_dealloc(&renderer);
 
   for (size_t i = 0; i < array_size(bmesh_arr); ++i) {
     bmesh33_s *bmesh;
@@ -1,6 +1,7 @@
 #include <argp.h>
 #include <assert.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
@@ -121,7 +122,11 @@ int main(int argc, char *argv[]) {
 
   mesh3_s *mesh;
   mesh3_alloc(&mesh);
-  mesh3_init(mesh, &data, true, &eps);
+  if (mesh3_init(mesh, &data, true, true, &eps) != JMM_ERROR_NONE) {
+    fprintf(stderr, "ERROR: mesh is too large for %d-bit indices "
+            "(reconfigure with -Dindex_width=64)\n", JMM_INDEX_WIDTH);
+    exit(EXIT_FAILURE);
+  }
 
   if (!mesh3_contains_ball(mesh, spec.xsrc, spec.rfac)) {
     fprintf(stderr, "ERROR: mesh doesn't fully contain factoring ball\n");
@@ -137,24 +142,28 @@ int main(int argc, char *argv[]) {
   eik3hh_init_with_pt_src(hh, mesh, spec.c, spec.rfac, spec.xsrc);
 
   /* Solve the "root" eikonal problem (the original point source
-   * problem). */
-  eik3hh_branch_s *root_branch = eik3hh_get_root_branch(hh);
-  eik3hh_branch_solve(root_branch, spec.verbose);
+   * problem) and the reflection problems downwind from it. The
+   * reflections are solved concurrently, with each one starting as
+   * soon as the root branch is done. */
+  eik3hh_solve(hh, /* num_refl = */ 1, /* num_threads = */ 0, spec.verbose);
 
+  eik3hh_branch_s *root_branch = eik3hh_get_root_branch(hh);
   save_bin_files(&spec, root_branch, "direct");
 
-  /* Find visible reflecting boundaries */
+  /* The children of the root branch were added in the same order as
+   * the visible reflecting boundaries */
   array_s *refl_inds = eik3hh_branch_get_visible_refls(root_branch);
   printf("Found %lu visible reflections\n", array_size(refl_inds));
 
-  /* Iterate over the reflecting boundaries and solve downwind eikonal
-   * problems. Write some stuff to disk for plotting. */
+  /* Write some stuff to disk for plotting. */
+  array_s *children = eik3hh_branch_get_children(root_branch);
+  assert(array_size(children) == array_size(refl_inds));
   for (size_t i = 0; i < array_size(refl_inds); ++i) {
     size_t refl_ind;
     array_get(refl_inds, i, &refl_ind);
 
-    eik3hh_branch_s *refl_branch = eik3hh_branch_add_refl(root_branch,refl_ind);
-    eik3hh_branch_solve(refl_branch, spec.verbose);
+    eik3hh_branch_s *refl_branch;
+    array_get(children, i, &refl_branch);
 
     char name[128];
     sprintf(name, "refl%03d", (int)refl_ind);
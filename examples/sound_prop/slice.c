@@ -1,4 +1,6 @@
 #include <argp.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <jmm/mesh3.h>
@@ -71,7 +73,11 @@ int main(int argc, char *argv[]) {
 
   mesh3_s *mesh;
   mesh3_alloc(&mesh);
-  mesh3_init(mesh, &data, true, &eps);
+  if (mesh3_init(mesh, &data, true, false, &eps) != JMM_ERROR_NONE) {
+    fprintf(stderr, "ERROR: mesh is too large for %d-bit indices "
+            "(reconfigure with -Dindex_width=64)\n", JMM_INDEX_WIDTH);
+    exit(EXIT_FAILURE);
+  }
 
   rect3 bbox;
   mesh3_get_bbox(mesh, &bbox);
@@ -1,4 +1,6 @@
 #include <argp.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <jmm/mesh3.h>
@@ -87,7 +89,11 @@ int main(int argc, char *argv[]) {
 
   mesh3_s *mesh;
   mesh3_alloc(&mesh);
-  mesh3_init(mesh, &data, true, &spec.eps);
+  if (mesh3_init(mesh, &data, true, false, &spec.eps) != JMM_ERROR_NONE) {
+    fprintf(stderr, "ERROR: mesh is too large for %d-bit indices "
+            "(reconfigure with -Dindex_width=64)\n", JMM_INDEX_WIDTH);
+    exit(EXIT_FAILURE);
+  }
 
   if (spec.verbose) {
     rect3 bbox;
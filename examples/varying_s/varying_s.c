@@ -1,5 +1,6 @@
 #include <argp.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <jmm/bmesh.h>
@@ -138,7 +139,11 @@ int main(int argc, char *argv[]) {
 
   mesh3_s *mesh;
   mesh3_alloc(&mesh);
-  mesh3_init(mesh, &data, true, &eps);
+  if (mesh3_init(mesh, &data, true, true, &eps) != JMM_ERROR_NONE) {
+    fprintf(stderr, "ERROR: mesh is too large for %d-bit indices "
+            "(reconfigure with -Dindex_width=64)\n", JMM_INDEX_WIDTH);
+    exit(EXIT_FAILURE);
+  }
 
   printf("average edge length = %g\n", mesh3_get_mean_edge_length(mesh));
 
@@ -166,11 +171,10 @@ int main(int argc, char *argv[]) {
 
   /** Just dump the solution now for error checking... */
 
-  jet31t const *jet = eik3_get_jet_ptr(eik);
-
   bmesh33_s *bmesh;
   bmesh33_alloc(&bmesh);
-  bmesh33_init_from_mesh3_and_jets(bmesh, mesh, jet);
+  bmesh33_init_from_mesh3_and_3d_data(bmesh, mesh, eik3_get_T_ptr(eik),
+                                      eik3_get_DT_ptr(eik));
 
   size_t N = 256;
 
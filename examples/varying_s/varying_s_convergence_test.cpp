@@ -134,7 +134,7 @@ mesh3_s *tetrahedralize_cube(dbl maxvol, dbl3 const xsrc) {
 
   mesh3_s *mesh;
   mesh3_alloc(&mesh);
-  mesh3_init(mesh, &data, true, NULL);
+  mesh3_init(mesh, &data, true, true, NULL);
 
   /* Make sure the point source is actually included in the mesh! */
   assert(mesh3_has_vertex(mesh, addin.pointlist));
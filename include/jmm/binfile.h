@@ -0,0 +1,59 @@
+#pragma once
+
+#include "common.h"
+#include "error.h"
+
+/* The current version of the binfile container format. This is
+ * bumped whenever the layout of the header or section table
+ * changes. The contents of each section are versioned separately. */
+#define BINFILE_VERSION 2
+
+/* Data in a binfile is aligned to this many bytes. */
+#define BINFILE_ALIGNMENT 64
+
+typedef enum binfile_tag {
+  BINFILE_TAG_MESH3_INFO = 1,
+  BINFILE_TAG_MESH3_VERTS,
+  BINFILE_TAG_MESH3_CELLS,
+  BINFILE_TAG_MESH3_VC,
+  BINFILE_TAG_MESH3_VC_OFFSETS,
+  BINFILE_TAG_MESH3_VV,
+  BINFILE_TAG_MESH3_VV_OFFSETS,
+  BINFILE_TAG_MESH3_VE,
+  BINFILE_TAG_MESH3_VE_OFFSETS,
+  BINFILE_TAG_MESH3_VF,
+  BINFILE_TAG_MESH3_EDGES,
+  BINFILE_TAG_MESH3_LOC_CELLS,
+  BINFILE_TAG_MESH3_LOC_OFFSETS,
+  BINFILE_TAG_MESH3_BDC,
+  BINFILE_TAG_MESH3_BDV,
+  BINFILE_TAG_MESH3_BDF,
+  BINFILE_TAG_MESH3_BDE,
+  BINFILE_TAG_MESH3_BDF_LABEL,
+  BINFILE_TAG_MESH3_BDE_LABEL,
+  BINFILE_TAG_MESH3_VERT_FLAGS,
+  BINFILE_TAG_MESH3_VDE,
+  BINFILE_TAG_MESH3_VDE_OFFSETS,
+  BINFILE_TAG_MESH3_VDL,
+  BINFILE_TAG_MESH3_VDL_OFFSETS,
+  BINFILE_TAG_EIK3_JET,
+  BINFILE_TAG_EIK3_STATE,
+  BINFILE_TAG_EIK3_PAR,
+  BINFILE_TAG_EIK3_ACCEPTED,
+  BINFILE_TAG_EIK3_T,
+  BINFILE_TAG_EIK3_DT,
+  BINFILE_TAG_EIK3_PAR_L,
+  BINFILE_TAG_EIK3_PAR_B
+} binfile_tag_e;
+
+void binfile_alloc(binfile_s **binfile);
+void binfile_dealloc(binfile_s **binfile);
+void binfile_init(binfile_s *binfile);
+jmm_error_e binfile_init_from_path(binfile_s *binfile, char const *path);
+void binfile_deinit(binfile_s *binfile);
+void binfile_add_section(binfile_s *binfile, binfile_tag_e tag, uint32_t version,
+                         void const *data, size_t size, policy_e policy);
+jmm_error_e binfile_write(binfile_s const *binfile, char const *path);
+bool binfile_has_section(binfile_s const *binfile, binfile_tag_e tag);
+void *binfile_get_section(binfile_s const *binfile, binfile_tag_e tag,
+                          uint32_t *version, size_t *size);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "array.h"
 #include "bb.h"
 #include "common.h"
 #include "geom.h"
@@ -20,11 +21,23 @@ bool bmesh33_cell_equal(bmesh33_cell_s const *c1, bmesh33_cell_s const *c2);
 void bmesh33_alloc(bmesh33_s **bmesh);
 void bmesh33_dealloc(bmesh33_s **bmesh);
 void bmesh33_init_from_mesh3_and_jets(bmesh33_s *bmesh, mesh3_s const *mesh, jet31t const *jet);
+void bmesh33_init_from_mesh3_and_3d_data(bmesh33_s *bmesh, mesh3_s const *mesh,
+                                         dbl const *f, dbl3 const *Df);
 void bmesh33_deinit(bmesh33_s *bmesh);
 size_t bmesh33_num_cells(bmesh33_s const *bmesh);
 dbl bmesh33_get_level(bmesh33_s const *bmesh);
 mesh3_s const *bmesh33_get_mesh_ptr(bmesh33_s const *bmesh);
+void bmesh33_get_cells_bracketing_level(bmesh33_s const *bmesh, dbl level,
+                                        array_s *lc);
 bmesh33_s *bmesh33_restrict_to_level(bmesh33_s const *bmesh, dbl level);
 bmesh33_cell_s bmesh33_get_cell(bmesh33_s const *bmesh, size_t l);
 dbl bmesh33_f(bmesh33_s const *bmesh, dbl3 const x);
+void bmesh33_f_batch(bmesh33_s const *bmesh, size_t n, dbl3 const *x, dbl *f);
+void bmesh33_Df(bmesh33_s const *bmesh, dbl3 const x, dbl3 Df);
+void bmesh33_Df_batch(bmesh33_s const *bmesh, size_t n, dbl3 const *x, dbl3 *Df);
 bb33 *bmesh33_get_bb_ptr(bmesh33_s const *bmesh, size_t lc);
+void bmesh33_extract_isosurfaces(bmesh33_s const *bmesh, size_t num_levels,
+                                 dbl const *level, size_t num_subdivisions,
+                                 mesh2_s **surf);
+mesh2_s *bmesh33_extract_isosurface(bmesh33_s const *bmesh, dbl level,
+                                    size_t num_subdivisions);
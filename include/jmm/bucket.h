@@ -12,6 +12,8 @@ void bucket_dealloc(bucket_s **bucket);
 void bucket_grow(bucket_s *bucket);
 void bucket_push(bucket_s *bucket, int l);
 int bucket_pop(bucket_s *bucket);
+int bucket_peek(bucket_s const *bucket);
+int bucket_get(bucket_s const *bucket, size_t i);
 bucket_s *bucket_get_next(bucket_s const *bucket);
 void bucket_set_next(bucket_s *bucket, bucket_s *next);
 size_t bucket_get_size(bucket_s const *bucket);
@@ -2,6 +2,7 @@
 
 #include "def.h"
 
+typedef struct binfile binfile_s;
 typedef struct bmesh33 bmesh33_s;
 typedef struct bmesh33_cell bmesh33_cell_s;
 typedef struct edgemap edgemap_s;
@@ -9,6 +10,7 @@ typedef struct eik2g1 eik2g1_s;
 typedef struct eik2m1 eik2m1_s;
 typedef struct eik2mp eik2mp_s;
 typedef struct eik3 eik3_s;
+typedef struct eik3_batch eik3_batch_s;
 typedef struct eik31m eik31m_s;
 typedef struct eik3hh eik3hh_s;
 typedef struct eik3hh_branch eik3hh_branch_s;
@@ -21,3 +23,4 @@ typedef struct mesh2_tri mesh2_tri_s;
 typedef struct mesh3 mesh3_s;
 typedef struct mesh3_tetra mesh3_tetra_s;
 typedef struct mesh22 mesh22_s;
+typedef struct pool pool_s;
@@ -85,6 +85,30 @@ typedef size_t uint2[2];
 typedef size_t uint3[3];
 typedef size_t uint4[4];
 
+/* Compact indices, used to store the vertex and cell indices in the
+ * larger tables built by `mesh3_s` and `eik3_s`. These are 32 bits
+ * wide by default, which halves the memory traffic when walking a
+ * mesh. Configure with `-Dindex_width=64` to work with meshes with
+ * `JMM_INDEX_MAX` or more vertices or cells. Indices are still
+ * passed to and returned from functions as `size_t`. */
+#ifndef JMM_INDEX_WIDTH
+#define JMM_INDEX_WIDTH 32
+#endif
+
+#if JMM_INDEX_WIDTH == 64
+typedef uint64_t jmm_index_t;
+#define JMM_INDEX_MAX UINT64_MAX
+#elif JMM_INDEX_WIDTH == 32
+typedef uint32_t jmm_index_t;
+#define JMM_INDEX_MAX UINT32_MAX
+#else
+#error "JMM_INDEX_WIDTH must be 32 or 64"
+#endif
+
+typedef jmm_index_t index2[2];
+typedef jmm_index_t index3[3];
+typedef jmm_index_t index4[4];
+
 typedef enum error {
   SUCCESS,
   BAD_ARGUMENT
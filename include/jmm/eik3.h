@@ -4,6 +4,7 @@
 #include "bb.h"
 #include "common.h"
 #include "error.h"
+#include "front.h"
 #include "jet.h"
 #include "par.h"
 #include "slow.h"
@@ -14,6 +15,7 @@ JMM_LINKAGE void eik3_alloc(eik3_s **eik);
 JMM_LINKAGE void eik3_dealloc(eik3_s **eik);
 JMM_LINKAGE void eik3_init(eik3_s *eik, mesh3_s const *mesh, sfunc_s const *sfunc);
 JMM_LINKAGE void eik3_deinit(eik3_s *eik);
+void eik3_reset(eik3_s *eik);
 bool eik3_is_initialized(eik3_s const *eik);
 
 JMM_LINKAGE void eik3_dump_jet(eik3_s const *eik, char const *path);
@@ -21,6 +23,13 @@ void eik3_dump_state(eik3_s const *eik, char const *path);
 void eik3_dump_par_l(eik3_s const *eik, char const *path);
 void eik3_dump_par_b(eik3_s const *eik, char const *path);
 void eik3_dump_accepted(eik3_s const *eik, char const *path);
+void eik3_add_to_binfile(eik3_s const *eik, binfile_s *binfile);
+jmm_error_e eik3_read_binfile(eik3_s *eik, binfile_s const *binfile);
+
+jmm_error_e eik3_set_num_threads(eik3_s *eik, size_t num_threads);
+size_t eik3_get_num_threads(eik3_s const *eik);
+jmm_error_e eik3_set_front_type(eik3_s *eik, front_type_e type);
+front_s const *eik3_get_front(eik3_s const *eik);
 
 size_t eik3_peek(eik3_s const *eik);
 jmm_error_e eik3_step(eik3_s *eik, size_t *l0);
@@ -43,14 +52,21 @@ array_s const *eik3_get_trial_inds(eik3_s const *eik);
 array_s const *eik3_get_bc_inds(eik3_s const *eik);
 
 dbl eik3_get_T(eik3_s const *eik, size_t l);
+dbl const *eik3_get_T_ptr(eik3_s const *eik);
+dbl3 const *eik3_get_DT_ptr(eik3_s const *eik);
 jet31t eik3_get_jet(eik3_s const *eik, size_t l);
-jet31t *eik3_get_jet_ptr(eik3_s const *eik);
+void eik3_copy_jets(eik3_s const *eik, jet31t *jet);
+jet31t *eik3_get_jet_ptr(eik3_s const *eik); // deprecated
 state_e *eik3_get_state_ptr(eik3_s const *eik);
 par3_s eik3_get_par(eik3_s const *eik, size_t l);
 bool eik3_has_par(eik3_s const *eik, size_t l);
 bool eik3_has_BCs(eik3_s const *eik, size_t l);
-size_t const *eik3_get_accepted_ptr(eik3_s const *eik);
+jmm_index_t const *eik3_get_accepted_ptr(eik3_s const *eik);
 size_t eik3_num_bc(eik3_s const *eik);
+void eik3_get_cache_stats(eik3_s const *eik, size_t *num_hits, size_t *num_misses);
+#if JMM_DEBUG
+size_t eik3_get_num_pool_allocs(eik3_s const *eik);
+#endif
 
 void eik3_add_trial(eik3_s *eik, size_t l, jet31t jet);
 void eik3_add_bc(eik3_s *eik, size_t l, jet31t jet);
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "eik3.h"
+
+void eik3_batch_alloc(eik3_batch_s **batch);
+void eik3_batch_dealloc(eik3_batch_s **batch);
+void eik3_batch_init(eik3_batch_s *batch, mesh3_s const *mesh,
+                     sfunc_s const *sfunc, size_t num_threads);
+void eik3_batch_deinit(eik3_batch_s *batch);
+size_t eik3_batch_get_num_threads(eik3_batch_s const *batch);
+jmm_error_e eik3_batch_solve_pt_srcs(eik3_batch_s *batch, size_t num_srcs,
+                                     dbl3 const *xsrc, dbl const *rfac,
+                                     jet31t *jet, size_t stride);
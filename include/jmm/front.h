@@ -0,0 +1,46 @@
+#pragma once
+
+#include "heap.h"
+
+/**
+ * The queue holding the `TRIAL` nodes of a marching method (its
+ * "front"), with a choice of backends:
+ *
+ * - `FRONT_TYPE_HEAP` is a 4-ary heap (`heap_s`), giving the exact
+ *   fast marching order.
+ *
+ * - `FRONT_TYPE_BUCKET` is an "untidy" bucket queue: nodes are
+ *   binned by their values into buckets of a fixed width, and each
+ *   bucket is emptied in FIFO order. Inserting, updating, and
+ *   popping take O(1) time, at the cost of accepting nodes whose
+ *   values are within the width of one another out of order.
+ *
+ * Nodes are identified by indices in `[0, n)`. The value of each
+ * node is read with `value`, and should only ever decrease while a
+ * node is in the front: after it decreases, call `front_update` (or
+ * `front_update_many`, after a batch of values have decreased).
+ */
+typedef enum front_type {
+  FRONT_TYPE_HEAP,
+  FRONT_TYPE_BUCKET
+} front_type_e;
+
+typedef struct front front_s;
+
+void front_alloc(front_s **front);
+void front_dealloc(front_s **front);
+void front_init(front_s *front, front_type_e type, size_t n, dbl width,
+                value_f value, void *context);
+void front_deinit(front_s *front);
+front_type_e front_get_type(front_s const *front);
+dbl front_get_width(front_s const *front);
+void front_clear(front_s *front);
+void front_insert(front_s *front, size_t l);
+void front_update(front_s *front, size_t l);
+void front_update_many(front_s *front, size_t n, size_t const *l);
+size_t front_peek(front_s const *front);
+size_t front_peek_many(front_s const *front, size_t n, size_t *l);
+void front_pop(front_s *front);
+size_t front_size(front_s const *front);
+bool front_contains(front_s const *front, size_t l);
+size_t front_get_num_pops(front_s const *front);
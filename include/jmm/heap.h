@@ -2,18 +2,33 @@
 
 #include "def.h"
 
+/**
+ * A 4-ary min-heap of indices. The key of each index is read with
+ * `value` when it's inserted or when its key has decreased, and is
+ * cached next to the index in the heap, so that sifting doesn't call
+ * back into `value`. Whenever an index moves, its new position is
+ * passed to `setpos` (and `NO_INDEX` is passed when it's popped).
+ *
+ * `getpos` should return the position last passed to `setpos` for an
+ * index. It's only used by `heap_decrease_keys`, and can be `NULL`
+ * otherwise.
+ */
 typedef struct heap heap_s;
 
-typedef dbl (*value_f)(void *, int);
-typedef void (*setpos_f)(void *, int, int);
+typedef dbl (*value_f)(void *, size_t);
+typedef void (*setpos_f)(void *, size_t, size_t);
+typedef size_t (*getpos_f)(void *, size_t);
 
 void heap_alloc(heap_s **heap);
 void heap_dealloc(heap_s **heap);
-void heap_init(heap_s *heap, int capacity, value_f value, setpos_f setpos,
-               void *context);
+void heap_init(heap_s *heap, size_t capacity, value_f value, setpos_f setpos,
+               getpos_f getpos, void *context);
 void heap_deinit(heap_s *heap);
-void heap_insert(heap_s *heap, int ind);
-void heap_swim(heap_s *heap, int ind);
-int heap_front(heap_s *heap);
+void heap_clear(heap_s *heap);
+void heap_insert(heap_s *heap, size_t ind);
+void heap_swim(heap_s *heap, size_t pos);
+void heap_decrease_keys(heap_s *heap, size_t n, size_t const *inds);
+size_t heap_front(heap_s const *heap);
+size_t heap_peek_many(heap_s const *heap, size_t n, size_t *inds);
 void heap_pop(heap_s *heap);
-int heap_size(heap_s *heap);
+size_t heap_size(heap_s const *heap);
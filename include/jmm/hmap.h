@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* A hash map from fixed-size keys to fixed-size elements, with the
+ * same generic interface as `alist_s` but O(1) expected lookups. */
+typedef struct hmap hmap_s;
+
+void hmap_alloc(hmap_s **map);
+void hmap_dealloc(hmap_s **map);
+void hmap_init(hmap_s *map, size_t keysize, size_t eltsize, size_t capacity);
+void hmap_deinit(hmap_s *map);
+bool hmap_is_empty(hmap_s const *map);
+size_t hmap_size(hmap_s const *map);
+bool hmap_contains(hmap_s const *map, void const *key);
+bool hmap_insert(hmap_s *map, void const *key, void const *elt);
+void hmap_set(hmap_s *map, void const *key, void const *elt);
+bool hmap_get(hmap_s const *map, void const *key, void *elt);
+bool hmap_remove(hmap_s *map, void const *key);
+void hmap_clear(hmap_s *map);
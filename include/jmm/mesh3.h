@@ -1,14 +1,15 @@
 #pragma once
 
 #include "common.h"
+#include "error.h"
 #include "geom.h"
 #include "index.h"
 #include "par.h"
 #include "vec.h"
 
-bool face_in_cell(size_t const f[3], size_t const c[4]);
+bool face_in_cell(size_t const f[3], jmm_index_t const c[4]);
 bool point_in_face(size_t l, size_t const f[3]);
-bool point_in_cell(size_t l, size_t const c[4]);
+bool point_in_cell(size_t l, jmm_index_t const c[4]);
 bool edge_in_face(size_t const le[2], size_t const lf[3]);
 
 // Some ideas for improving the design of mesh3:
@@ -42,13 +43,16 @@ void mesh3_data_init_from_bin(mesh3_data_s *data, char const *verts_path, char c
 JMM_LINKAGE void mesh3_data_init_from_off_file(mesh3_data_s *data, char const *path, dbl maxvol, bool verbose);
 void mesh3_data_deinit(mesh3_data_s *data);
 JMM_LINKAGE error_e mesh3_data_insert_vert(mesh3_data_s *data, dbl3 const x, dbl eps);
+error_e mesh3_data_insert_verts(mesh3_data_s *data, size_t n, dbl3 const *x, dbl eps);
 
 JMM_LINKAGE void mesh3_alloc(mesh3_s **mesh);
 JMM_LINKAGE void mesh3_dealloc(mesh3_s **mesh);
-JMM_LINKAGE void mesh3_init(mesh3_s *mesh, mesh3_data_s const *data, bool compute_bd_info, dbl const *eps);
+JMM_LINKAGE jmm_error_e mesh3_init(mesh3_s *mesh, mesh3_data_s const *data, bool compute_bd_info, bool compute_adj_info, dbl const *eps);
 JMM_LINKAGE void mesh3_deinit(mesh3_s *mesh);
+void mesh3_add_to_binfile(mesh3_s const *mesh, binfile_s *binfile);
+jmm_error_e mesh3_init_from_binfile(mesh3_s *mesh, binfile_s const *binfile);
 dbl3 const *mesh3_get_verts_ptr(mesh3_s const *mesh);
-size_t const *mesh3_get_cells_ptr(mesh3_s const *mesh);
+jmm_index_t const *mesh3_get_cells_ptr(mesh3_s const *mesh);
 dbl const *mesh3_get_vert_ptr(mesh3_s const *mesh, size_t i);
 void mesh3_get_vert_ptrs(mesh3_s const *mesh, size_t const *l, int n, dbl const **x);
 void mesh3_copy_vert(mesh3_s const *mesh, size_t i, dbl *v);
@@ -63,15 +67,22 @@ void mesh3_get_cell_bbox(mesh3_s const *mesh, size_t i, rect3 *bbox);
 bool mesh3_cell_contains_point(mesh3_s const *mesh, size_t i, dbl const x[3]);
 JMM_LINKAGE bool mesh3_contains_ball(mesh3_s const *mesh, dbl3 const x, dbl r);
 size_t mesh3_find_cell_containing_point(mesh3_s const *mesh, dbl const x[3], size_t lc);
+void mesh3_find_cells_containing_points(mesh3_s const *mesh, size_t n,
+                                        dbl3 const *x, size_t *lc);
 bool mesh3_contains_point(mesh3_s const *mesh, dbl3 const x);
 int mesh3_nvc(mesh3_s const *mesh, size_t i);
 void mesh3_vc(mesh3_s const *mesh, size_t i, size_t *vc);
+jmm_index_t const *mesh3_get_vc_ptr(mesh3_s const *mesh, size_t i);
 int mesh3_nve(mesh3_s const *mesh, size_t lv);
 void mesh3_ve(mesh3_s const *mesh, size_t lv, size_t (*ve)[2]);
 int mesh3_nvf(mesh3_s const *mesh, size_t i);
 void mesh3_vf(mesh3_s const *mesh, size_t i, size_t (*vf)[3]);
 int mesh3_nvv(mesh3_s const *mesh, size_t i);
 void mesh3_vv(mesh3_s const *mesh, size_t i, size_t *vv);
+bool mesh3_has_adj_info(mesh3_s const *mesh);
+jmm_index_t const *mesh3_get_vv_ptr(mesh3_s const *mesh, size_t i);
+index2 const *mesh3_get_ve_ptr(mesh3_s const *mesh, size_t i);
+index3 const *mesh3_get_vf_ptr(mesh3_s const *mesh, size_t i);
 int mesh3_ncc(mesh3_s const *mesh, size_t i);
 void mesh3_cc(mesh3_s const *mesh, size_t i, size_t *cc);
 void mesh3_cf(mesh3_s const *mesh, size_t lc, size_t lf[4][3]);
@@ -110,6 +121,8 @@ bool mesh3_ray_prop_from_edge_is_occluded(mesh3_s const *mesh, dbl3 const t,
                                           uint2 const le);
 bool mesh3_local_ray_is_occluded(mesh3_s const *mesh, size_t lhat, par3_s const *par);
 bool mesh3_cell_incident_on_diff_edge(mesh3_s const *mesh, size_t lc);
+size_t mesh3_get_num_vert_diff_labels(mesh3_s const *mesh, size_t l);
+size_t const *mesh3_get_vert_diff_labels_ptr(mesh3_s const *mesh, size_t l);
 dbl mesh3_get_min_tetra_alt(mesh3_s const *mesh);
 dbl mesh3_get_min_edge_length(mesh3_s const *mesh);
 dbl mesh3_get_mean_edge_length(mesh3_s const *mesh);
@@ -151,6 +164,8 @@ void mesh3_dump_cells(mesh3_s const *mesh, char const *path);
 JMM_LINKAGE bool mesh3_has_vertex(mesh3_s const *mesh, dbl3 const x);
 size_t mesh3_get_vert_index(mesh3_s const *mesh, dbl3 const x);
 dbl mesh3_linterp(mesh3_s const *mesh, dbl const *values, dbl3 const x);
+void mesh3_linterp_batch(mesh3_s const *mesh, dbl const *values, size_t n,
+                         dbl3 const *x, dbl *y);
 dbl mesh3_diam_2approx(mesh3_s const *mesh, size_t l);
 dbl mesh3_diam_2approx_rand(mesh3_s const *mesh, size_t trials, size_t const *seed);
 dbl mesh3_get_diam(mesh3_s const *mesh);
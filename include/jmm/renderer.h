@@ -0,0 +1,24 @@
+#pragma once
+
+#include "camera.h"
+#include "common.h"
+
+/**
+ * Renders frames of the level sets of one or more `bmesh33_s`
+ * (e.g., wavefronts at a sequence of times) together with the
+ * boundary surface of the mesh they're defined on. The surface is
+ * only put into an R-tree once. The cells of each `bmesh33_s`
+ * bracketing a level are found with its interval tree (see
+ * `bmesh33_get_cells_bracketing_level`) instead of by scanning the
+ * whole mesh.
+ */
+typedef struct renderer renderer_s;
+
+void renderer_alloc(renderer_s **renderer);
+void renderer_dealloc(renderer_s **renderer);
+void renderer_init(renderer_s *renderer, mesh3_s const *mesh,
+                   camera_s const *camera);
+void renderer_deinit(renderer_s *renderer);
+void renderer_add_bmesh33(renderer_s *renderer, bmesh33_s const *bmesh,
+                          dbl const *spread, dbl const *org);
+void renderer_render_frame(renderer_s *renderer, dbl level, dbl4 *img);
@@ -34,6 +34,9 @@ typedef struct {
   robj_s const *obj;
 } isect;
 
+/* The number of rays traced together by `rtree_intersect_packet`. */
+#define RTREE_PACKET_SIZE 8
+
 typedef enum rtree_split_strategy {
   RTREE_SPLIT_STRATEGY_SURFACE_AREA
 } rtree_split_strategy_e;
@@ -53,6 +56,8 @@ void rtree_init(rtree_s *rtree, size_t leaf_thresh,
 void rtree_deinit(rtree_s *rtree);
 rtree_s *rtree_copy(rtree_s const *rtree);
 void rtree_insert_bmesh33(rtree_s *rtree, bmesh33_s const *bmesh);
+void rtree_insert_bmesh33_cells(rtree_s *rtree, bmesh33_s const *bmesh,
+                                dbl level, size_t n, size_t const *lc);
 void rtree_insert_mesh2(rtree_s *rtree, mesh2_s const *mesh);
 void rtree_insert_mesh3(rtree_s *rtree, mesh3_s const *mesh);
 void rtree_build(rtree_s *rtree);
@@ -61,5 +66,7 @@ size_t rtree_get_num_leaf_nodes(rtree_s const *rtree);
 bool rtree_query_bbox(rtree_s const *rtree, rect3 const *bbox);
 void rtree_intersect(rtree_s const *rtree, ray3 const *ray, isect *isect,
                      robj_s const *skip_robj);
+void rtree_intersect_packet(rtree_s const *rtree, ray3 const *ray, size_t n,
+                            isect *isect, robj_s const **skip_robj);
 void rtree_intersectN(rtree_s const *rtree, ray3 const *ray, size_t n,
                       isect *isects);
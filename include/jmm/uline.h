@@ -6,6 +6,7 @@
 typedef struct uline uline_s;
 
 void uline_alloc(uline_s **u);
+void uline_alloc_from_pool(uline_s **u, pool_s *pool);
 void uline_dealloc(uline_s **u);
 void uline_init(uline_s *u, eik3_s const *eik, size_t lhat, size_t l0);
 void uline_init_from_points(uline_s *u, eik3_s const *eik, dbl3 const xhat, dbl3 const x0, dbl tol, dbl T0);
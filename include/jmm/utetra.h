@@ -9,10 +9,12 @@
 typedef struct utetra utetra_s;
 
 void utetra_alloc(utetra_s **cf);
+void utetra_alloc_from_pool(utetra_s **cf, pool_s *pool);
 void utetra_dealloc(utetra_s **cf);
 void utetra_init(utetra_s *u, eik3_s const *eik, size_t lhat, uint3 const l);
 bool utetra_is_degenerate(utetra_s const *u);
 void utetra_solve(utetra_s *cf, dbl const *lam);
+void utetra_solve_surrogate(utetra_s *cf, dbl const *lam);
 dbl utetra_get_value(utetra_s const *cf);
 void utetra_get_jet31t(utetra_s const *cf, jet31t *jet);
 bool utetra_has_interior_point_solution(utetra_s const *cf);
@@ -22,6 +24,7 @@ bool utetra_ray_is_occluded(utetra_s const *utetra, eik3_s const *eik);
 bool utetra_updated_from_refl_BCs(utetra_s const *utetra, eik3_s const *eik);
 int utetra_get_num_interior_coefs(utetra_s const *utetra);
 size_t utetra_get_l(utetra_s const *utetra);
+void utetra_get_update_inds(utetra_s const *utetra, uint3 l);
 size_t utetra_get_active_inds(utetra_s const *utetra, size_t l[3]);
 par3_s utetra_get_parent(utetra_s const *utetra);
 dbl utetra_get_L(utetra_s const *u);
@@ -7,6 +7,7 @@
 typedef struct utri utri_s;
 
 void utri_alloc(utri_s **utri);
+void utri_alloc_from_pool(utri_s **utri, pool_s *pool);
 void utri_dealloc(utri_s **utri);
 void utri_init(utri_s *u, eik3_s const *eik, size_t lhat, size_t const l[2]);
 bool utri_solve(utri_s *utri);
@@ -20,6 +21,7 @@ bool utri_is_backwards(utri_s const *utri, eik3_s const *eik);
 size_t utri_get_active_ind(utri_s const *utri);
 size_t utri_get_inactive_ind(utri_s const *utri);
 size_t utri_get_l(utri_s const *utri);
+void utri_get_update_inds(utri_s const *utri, uint2 l);
 bool utri_is_degenerate(utri_s const *u);
 bool utri_has_inds(utri_s const *u, size_t lhat, uint2 const l);
 
@@ -5,3 +5,5 @@
 #include "jet.h"
 
 void xfer(mesh3_s const *mesh, jet31t const *jet, grid3_s const *grid, dbl *y);
+void xfer_with_grad(mesh3_s const *mesh, jet31t const *jet,
+                    grid3_s const *grid, dbl *y, dbl3 *Dy);
@@ -4,13 +4,23 @@
 #include <stdlib.h>
 #include <string.h>
 
+/* The elements of an array are stored in `data[head:head + size]`.
+ * Popping from the front just advances `head`, so an `array_s` can
+ * be used as a FIFO queue without moving its contents on each pop:
+ * the space in front of `head` is reclaimed when the array would
+ * otherwise need to grow. */
 struct array {
   char *data;
   size_t eltsize;
+  size_t head;
   size_t size;
   size_t capacity;
 };
 
+static char *get_elt_ptr(array_s const *arr, size_t i) {
+  return arr->data + arr->eltsize*(arr->head + i);
+}
+
 void array_alloc(array_s **arr) {
   *arr = malloc(sizeof(array_s));
 }
@@ -24,6 +34,7 @@ void array_dealloc(array_s **arr) {
 void array_init(array_s *arr, size_t eltsize, size_t capacity) {
   arr->data = malloc(eltsize*capacity);
   arr->eltsize = eltsize;
+  arr->head = 0;
   arr->size = 0;
   arr->capacity = capacity;
 }
@@ -43,7 +54,7 @@ size_t array_size(array_s const *arr) {
 }
 
 size_t array_find(array_s const *arr, void const *elt) {
-  char *ptr = arr->data;
+  char *ptr = get_elt_ptr(arr, 0);
   size_t i = 0;
   for (i = 0; i < arr->size; ++i) {
     if (!memcmp(ptr, elt, arr->eltsize)) {
@@ -60,7 +71,16 @@ bool array_contains(array_s const *arr, void const *elt) {
 }
 
 static void grow_if_necessary(array_s *arr) {
-  if (arr->size < arr->capacity) {
+  if (arr->head + arr->size < arr->capacity) {
+    return;
+  }
+  /* If at least half of the array is free space left behind by
+   * `array_pop_front`, slide the elements back to the start instead
+   * of growing. Each element is moved at most once per pop that
+   * freed up room for it, so this is amortized O(1). */
+  if (arr->head >= arr->size) {
+    memmove(arr->data, get_elt_ptr(arr, 0), arr->eltsize*arr->size);
+    arr->head = 0;
     return;
   }
   arr->capacity *= 2;
@@ -69,7 +89,7 @@ static void grow_if_necessary(array_s *arr) {
 
 void array_append(array_s *arr, void const *elt) {
   grow_if_necessary(arr);
-  void *ptr = arr->data + arr->eltsize*arr->size;
+  void *ptr = get_elt_ptr(arr, arr->size);
   memcpy(ptr, elt, arr->eltsize);
   ++arr->size;
 }
@@ -78,16 +98,16 @@ void array_get(array_s const *arr, size_t i, void *elt) {
   if (i >= arr->size) {
     return;
   }
-  memcpy(elt, arr->data + arr->eltsize*i, arr->eltsize);
+  memcpy(elt, get_elt_ptr(arr, i), arr->eltsize);
 }
 
 void *array_get_ptr(array_s const *arr, size_t i) {
-  return i < arr->size ? arr->data + arr->eltsize*i : NULL;
+  return i < arr->size ? get_elt_ptr(arr, i) : NULL;
 }
 
 void array_delete(array_s *arr, size_t i) {
-  void *dst = arr->data + i*arr->eltsize;
-  void const *src = arr->data + (i + 1)*arr->eltsize;
+  void *dst = get_elt_ptr(arr, i);
+  void const *src = get_elt_ptr(arr, i + 1);
   size_t len = (arr->size - i - 1)*arr->eltsize;
   memmove(dst, src, len);
   --arr->size;
@@ -100,11 +120,23 @@ void array_delete_all(array_s *arr, array_s const *i_arr) {
   }
 }
 
+void array_clear(array_s *arr) {
+  arr->head = 0;
+  arr->size = 0;
+}
+
+/* Remove the first element of `arr`, copying it to `elt`. This takes
+ * O(1) time, so repeatedly appending to and popping from an array
+ * gives a FIFO queue (e.g., for a BFS). */
 void array_pop_front(array_s *arr, void *elt) {
+  assert(arr->size > 0);
   array_get(arr, 0, elt);
-  array_delete(arr, 0);
+  if (--arr->size == 0)
+    arr->head = 0;
+  else
+    ++arr->head;
 }
 
 void array_sort(array_s *arr, compar_t cmp) {
-  qsort(arr->data, arr->size, arr->eltsize, cmp);
+  qsort(get_elt_ptr(arr, 0), arr->size, arr->eltsize, cmp);
 }
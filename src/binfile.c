@@ -0,0 +1,260 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <jmm/binfile.h>
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <jmm/array.h>
+
+/**
+ * A binfile consists of a header, followed by a table of sections,
+ * followed by the data for each section. Each section's data starts
+ * at an offset which is a multiple of `BINFILE_ALIGNMENT`, so that
+ * once the file is mapped into memory the sections can be used in
+ * place as arrays.
+ */
+
+static char const magic[8] = {'J', 'M', 'M', 'B', 'I', 'N', 0, 0};
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint16_t index_size; /* sizeof(jmm_index_t) in the writer's build */
+  uint16_t size_size; /* sizeof(size_t) on the machine that wrote it */
+  uint64_t num_sections;
+} header_s;
+
+typedef struct {
+  uint32_t tag;
+  uint32_t version;
+  uint64_t offset;
+  uint64_t size;
+} section_s;
+
+typedef struct {
+  section_s section;
+  void *data;
+  policy_e policy;
+} entry_s;
+
+struct binfile {
+  array_s *entries;
+
+  /* If the binfile was read from disk, the mapping backing it. */
+  void *map;
+  size_t map_size;
+};
+
+static size_t align(size_t offset) {
+  return BINFILE_ALIGNMENT*((offset + BINFILE_ALIGNMENT - 1)/BINFILE_ALIGNMENT);
+}
+
+void binfile_alloc(binfile_s **binfile) {
+  *binfile = malloc(sizeof(binfile_s));
+}
+
+void binfile_dealloc(binfile_s **binfile) {
+  assert(*binfile != NULL);
+  free(*binfile);
+  *binfile = NULL;
+}
+
+/* Initialize an empty binfile, which sections can be added to before
+ * writing it out with `binfile_write`. */
+void binfile_init(binfile_s *binfile) {
+  array_alloc(&binfile->entries);
+  array_init(binfile->entries, sizeof(entry_s), ARRAY_DEFAULT_CAPACITY);
+
+  binfile->map = NULL;
+  binfile->map_size = 0;
+}
+
+/* Map the binfile at `path` into memory. The sections returned by
+ * `binfile_get_section` point directly into the mapping, which is
+ * private to this process: they can be modified without affecting
+ * the file on disk. */
+jmm_error_e binfile_init_from_path(binfile_s *binfile, char const *path) {
+  binfile_init(binfile);
+
+  int fd = open(path, O_RDONLY);
+  if (fd == -1)
+    return JMM_ERROR_BAD_ARGUMENTS;
+
+  struct stat st;
+  if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(header_s)) {
+    close(fd);
+    return JMM_ERROR_RUNTIME_ERROR;
+  }
+
+  void *map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return JMM_ERROR_RUNTIME_ERROR;
+
+  binfile->map = map;
+  binfile->map_size = st.st_size;
+
+  header_s const *header = map;
+  if (memcmp(header->magic, magic, sizeof(magic))
+      || header->version != BINFILE_VERSION
+      || header->index_size != sizeof(jmm_index_t)
+      || header->size_size != sizeof(size_t)
+      || sizeof(header_s) + header->num_sections*sizeof(section_s) > binfile->map_size)
+    return JMM_ERROR_RUNTIME_ERROR;
+
+  section_s const *section = (section_s const *)(header + 1);
+  for (size_t i = 0; i < header->num_sections; ++i) {
+    if (section[i].offset + section[i].size > binfile->map_size)
+      return JMM_ERROR_RUNTIME_ERROR;
+    entry_s entry = {
+      .section = section[i],
+      .data = (char *)map + section[i].offset,
+      .policy = POLICY_VIEW
+    };
+    array_append(binfile->entries, &entry);
+  }
+
+  return JMM_ERROR_NONE;
+}
+
+void binfile_deinit(binfile_s *binfile) {
+  for (size_t i = 0; i < array_size(binfile->entries); ++i) {
+    entry_s *entry = array_get_ptr(binfile->entries, i);
+    if (entry->policy == POLICY_COPY || entry->policy == POLICY_XFER)
+      free(entry->data);
+  }
+
+  array_deinit(binfile->entries);
+  array_dealloc(&binfile->entries);
+
+  if (binfile->map != NULL)
+    munmap(binfile->map, binfile->map_size);
+
+  binfile->map = NULL;
+  binfile->map_size = 0;
+}
+
+/* Add a section to `binfile`. With `POLICY_VIEW`, `data` isn't
+ * copied, and needs to remain valid until `binfile` is written or
+ * deinitialized. With `POLICY_XFER`, `binfile` takes ownership of
+ * `data` and frees it when it's deinitialized. */
+void binfile_add_section(binfile_s *binfile, binfile_tag_e tag, uint32_t version,
+                         void const *data, size_t size, policy_e policy) {
+  assert(!binfile_has_section(binfile, tag));
+  entry_s entry = {
+    .section = {.tag = tag, .version = version, .offset = 0, .size = size},
+    .policy = policy
+  };
+  switch (policy) {
+  case POLICY_COPY:
+    entry.data = malloc(size);
+    memcpy(entry.data, data, size);
+    break;
+  case POLICY_XFER:
+  case POLICY_VIEW:
+    entry.data = (void *)data;
+    break;
+  default:
+    assert(false);
+  }
+  array_append(binfile->entries, &entry);
+}
+
+static bool write_padding(FILE *fp, size_t *pos, size_t offset) {
+  static char const zeros[BINFILE_ALIGNMENT] = {0};
+  assert(offset - *pos < BINFILE_ALIGNMENT);
+  size_t n = offset - *pos;
+  *pos = offset;
+  return fwrite(zeros, 1, n, fp) == n;
+}
+
+jmm_error_e binfile_write(binfile_s const *binfile, char const *path) {
+  size_t num_sections = array_size(binfile->entries);
+
+  header_s header = {
+    .version = BINFILE_VERSION,
+    .index_size = sizeof(jmm_index_t),
+    .size_size = sizeof(size_t),
+    .num_sections = num_sections
+  };
+  memcpy(header.magic, magic, sizeof(magic));
+
+  /* Lay out the sections after the header and section table */
+  section_s *section = malloc(num_sections*sizeof(section_s));
+  size_t offset = align(sizeof(header_s) + num_sections*sizeof(section_s));
+  for (size_t i = 0; i < num_sections; ++i) {
+    entry_s const *entry = array_get_ptr(binfile->entries, i);
+    section[i] = entry->section;
+    section[i].offset = offset;
+    offset = align(offset + section[i].size);
+  }
+
+  jmm_error_e error = JMM_ERROR_NONE;
+
+  FILE *fp = fopen(path, "wb");
+  if (fp == NULL) {
+    error = JMM_ERROR_BAD_ARGUMENTS;
+    goto cleanup;
+  }
+
+  size_t pos = sizeof(header_s) + num_sections*sizeof(section_s);
+  if (fwrite(&header, sizeof(header_s), 1, fp) != 1
+      || fwrite(section, sizeof(section_s), num_sections, fp) != num_sections) {
+    error = JMM_ERROR_RUNTIME_ERROR;
+    goto cleanup;
+  }
+
+  for (size_t i = 0; i < num_sections; ++i) {
+    entry_s const *entry = array_get_ptr(binfile->entries, i);
+    if (!write_padding(fp, &pos, section[i].offset)
+        || fwrite(entry->data, 1, section[i].size, fp) != section[i].size) {
+      error = JMM_ERROR_RUNTIME_ERROR;
+      goto cleanup;
+    }
+    pos += section[i].size;
+  }
+
+cleanup:
+  if (fp != NULL)
+    fclose(fp);
+
+  free(section);
+
+  return error;
+}
+
+static entry_s const *find_entry(binfile_s const *binfile, binfile_tag_e tag) {
+  for (size_t i = 0; i < array_size(binfile->entries); ++i) {
+    entry_s const *entry = array_get_ptr(binfile->entries, i);
+    if (entry->section.tag == tag)
+      return entry;
+  }
+  return NULL;
+}
+
+bool binfile_has_section(binfile_s const *binfile, binfile_tag_e tag) {
+  return find_entry(binfile, tag) != NULL;
+}
+
+/* Get a pointer to the data for the section tagged `tag`, or `NULL`
+ * if there's no such section. If they aren't `NULL`, the version and
+ * size (in bytes) of the section are written to `version` and
+ * `size`. */
+void *binfile_get_section(binfile_s const *binfile, binfile_tag_e tag,
+                          uint32_t *version, size_t *size) {
+  entry_s const *entry = find_entry(binfile, tag);
+  if (entry == NULL)
+    return NULL;
+  if (version != NULL)
+    *version = entry->section.version;
+  if (size != NULL)
+    *size = entry->section.size;
+  return entry->data;
+}
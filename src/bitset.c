@@ -0,0 +1,56 @@
+#include "bitset.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define WORD_BITS 64
+
+struct bitset {
+  uint64_t *word;
+  size_t n;
+};
+
+void bitset_alloc(bitset_s **bitset) {
+  *bitset = malloc(sizeof(bitset_s));
+}
+
+void bitset_dealloc(bitset_s **bitset) {
+  assert(*bitset != NULL);
+  free(*bitset);
+  *bitset = NULL;
+}
+
+/* Initialize `bitset` to hold `n` bits, all of which are unset. */
+void bitset_init(bitset_s *bitset, size_t n) {
+  bitset->word = calloc((n + WORD_BITS - 1)/WORD_BITS, sizeof(uint64_t));
+  bitset->n = n;
+}
+
+void bitset_deinit(bitset_s *bitset) {
+  free(bitset->word);
+  bitset->word = NULL;
+}
+
+bool bitset_get(bitset_s const *bitset, size_t i) {
+  assert(i < bitset->n);
+  return (bitset->word[i/WORD_BITS] >> (i % WORD_BITS)) & 1;
+}
+
+void bitset_set(bitset_s *bitset, size_t i) {
+  assert(i < bitset->n);
+  bitset->word[i/WORD_BITS] |= (uint64_t)1 << (i % WORD_BITS);
+}
+
+void bitset_unset(bitset_s *bitset, size_t i) {
+  assert(i < bitset->n);
+  bitset->word[i/WORD_BITS] &= ~((uint64_t)1 << (i % WORD_BITS));
+}
+
+/* Set bit `i`, returning whether it was already set. Useful for
+ * visiting each node at most once. */
+bool bitset_test_and_set(bitset_s *bitset, size_t i) {
+  bool was_set = bitset_get(bitset, i);
+  bitset_set(bitset, i);
+  return was_set;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* A fixed-size set of bits, e.g. for marking which vertices of a
+ * mesh a BFS has visited in O(1) time and n/8 bytes. */
+typedef struct bitset bitset_s;
+
+void bitset_alloc(bitset_s **bitset);
+void bitset_dealloc(bitset_s **bitset);
+void bitset_init(bitset_s *bitset, size_t n);
+void bitset_deinit(bitset_s *bitset);
+bool bitset_get(bitset_s const *bitset, size_t i);
+void bitset_set(bitset_s *bitset, size_t i);
+void bitset_unset(bitset_s *bitset, size_t i);
+bool bitset_test_and_set(bitset_s *bitset, size_t i);
@@ -1,15 +1,22 @@
 #include <jmm/bmesh.h>
 
 #include <assert.h>
+#include <omp.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include <jmm/array.h>
 #include <jmm/bb.h>
 #include <jmm/geom.h>
 #include <jmm/hybrid.h>
 #include <jmm/mat.h>
+#include <jmm/mesh2.h>
 #include <jmm/mesh3.h>
 #include <jmm/util.h>
+#include <jmm/vec.h>
+
+#include "macros.h"
 
 bool bmesh33_cell_intersect(bmesh33_cell_s const *cell, ray3 const *ray, dbl *t) {
   dbl const atol = 1e-13;
@@ -144,7 +151,7 @@ void bmesh33_cell_Df(bmesh33_cell_s const *cell, dbl3 const x, dbl3 Df) {
   /* Set up transform matrix. The first three rows of A correspond to
    * the standard directions in R^3, which we use to compute the
    * gradient. */
-  static dbl44 A;
+  dbl44 A;
   size_t lv[4];
   mesh3_cv(cell->mesh, cell->l, lv);
   for (size_t i = 0; i < 4; ++i) {
@@ -168,17 +175,159 @@ void bmesh33_cell_Df(bmesh33_cell_s const *cell, dbl3 const x, dbl3 Df) {
 }
 
 bool bmesh33_cell_equal(bmesh33_cell_s const *c1, bmesh33_cell_s const *c2) {
-  return c1->mesh == c2-> mesh && c1->l == c2->l;
+  return c1->bmesh == c2->bmesh && c1->mesh == c2->mesh && c1->l == c2->l;
 }
 
+/**
+ * A node in the interval tree used to find the cells whose range of
+ * Bezier ordinates brackets a level. Each node stores the cells whose
+ * ranges contain `center`, sorted in increasing order of their
+ * minimum ordinate in `by_min[offset:offset + size]` and in
+ * decreasing order of their maximum ordinate in
+ * `by_max[offset:offset + size]`. The cells whose ranges lie entirely
+ * below or above `center` are stored in `child[0]` and `child[1]`.
+ */
+typedef struct {
+  dbl center;
+  size_t offset, size;
+  size_t child[2];
+} itree_node_s;
+
 struct bmesh33 {
   mesh3_s const *mesh;
-  bool mesh_owner;
   size_t num_cells;
   bb33 *bb;
   dbl level;
+
+  /* A level view (see `bmesh33_restrict_to_level`) borrows `bb` from
+   * the original `bmesh33_s` and consists of the cells `lc` of
+   * `mesh`. The interval tree below isn't set up for a view. */
+  bool bb_owner;
+  size_t *lc;
+
+  /* The range of Bezier ordinates of each cell, and the interval tree
+   * over them (with root `itree[0]`). */
+  dbl *min, *max;
+  size_t itree_size;
+  itree_node_s *itree;
+  size_t *itree_by_min, *itree_by_max;
 };
 
+typedef struct {
+  dbl key;
+  size_t l;
+} key_s;
+
+static int key_cmp(key_s const *k1, key_s const *k2) {
+  return k1->key < k2->key ? -1 : k1->key > k2->key ? 1 : 0;
+}
+
+static int dbl_cmp(dbl const *x, dbl const *y) {
+  return *x < *y ? -1 : *x > *y ? 1 : 0;
+}
+
+/* Sort `lc` in place by `key[lc[i]]`, in increasing order if `sign`
+ * is positive and in decreasing order otherwise. */
+static void sort_cells(size_t *lc, size_t n, dbl const *key, int sign) {
+  key_s *k = malloc(n*sizeof(key_s));
+  for (size_t i = 0; i < n; ++i) {
+    k[i].key = sign*key[lc[i]];
+    k[i].l = lc[i];
+  }
+  qsort(k, n, sizeof(key_s), (compar_t)key_cmp);
+  for (size_t i = 0; i < n; ++i)
+    lc[i] = k[i].l;
+  free(k);
+}
+
+/* Build the subtree of the interval tree containing the `n` cells in
+ * `lc`, returning the index of its root. The center of each node is
+ * the median of the midpoints of its cells' ranges, so at most half
+ * of the cells go into either child, and the tree has depth at most
+ * `log2(n)`. */
+static size_t itree_build(bmesh33_s *bmesh, size_t *lc, size_t n, size_t *offset) {
+  if (n == 0)
+    return (size_t)NO_INDEX;
+
+  dbl *mid = malloc(n*sizeof(dbl));
+  for (size_t i = 0; i < n; ++i)
+    mid[i] = (bmesh->min[lc[i]] + bmesh->max[lc[i]])/2;
+  qsort(mid, n, sizeof(dbl), (compar_t)dbl_cmp);
+  dbl center = mid[n/2];
+  free(mid);
+
+  /* Partition the cells into those entirely below `center`, those
+   * entirely above it, and those containing it. */
+  size_t *part = malloc(n*sizeof(size_t));
+  size_t num_below = 0, num_above = 0;
+  for (size_t i = 0; i < n; ++i) {
+    if (bmesh->max[lc[i]] < center)
+      part[num_below++] = lc[i];
+    else if (bmesh->min[lc[i]] > center)
+      part[n - ++num_above] = lc[i];
+  }
+  size_t num_center = n - num_below - num_above;
+  assert(num_center > 0);
+
+  size_t i_node = bmesh->itree_size++;
+  itree_node_s *node = &bmesh->itree[i_node];
+  node->center = center;
+  node->offset = *offset;
+  node->size = num_center;
+
+  size_t *by_min = &bmesh->itree_by_min[*offset];
+  size_t *by_max = &bmesh->itree_by_max[*offset];
+  for (size_t i = 0, j = 0; i < n; ++i)
+    if (bmesh->min[lc[i]] <= center && center <= bmesh->max[lc[i]])
+      by_min[j++] = lc[i];
+  memcpy(by_max, by_min, num_center*sizeof(size_t));
+  sort_cells(by_min, num_center, bmesh->min, 1);
+  sort_cells(by_max, num_center, bmesh->max, -1);
+  *offset += num_center;
+
+  /* `lc` is no longer needed, so the children can reuse it. */
+  memcpy(lc, part, num_below*sizeof(size_t));
+  memcpy(lc + num_below, part + n - num_above, num_above*sizeof(size_t));
+  free(part);
+
+  size_t child[2] = {
+    itree_build(bmesh, lc, num_below, offset),
+    itree_build(bmesh, lc + num_below, num_above, offset)
+  };
+  bmesh->itree[i_node].child[0] = child[0];
+  bmesh->itree[i_node].child[1] = child[1];
+
+  return i_node;
+}
+
+static void init_itree(bmesh33_s *bmesh) {
+  bmesh->min = malloc(bmesh->num_cells*sizeof(dbl));
+  bmesh->max = malloc(bmesh->num_cells*sizeof(dbl));
+
+  /* Cells with NaN ordinates never bracket a level, so we leave them
+   * out of the tree. */
+  size_t n = 0;
+  size_t *lc = malloc(bmesh->num_cells*sizeof(size_t));
+  for (size_t l = 0; l < bmesh->num_cells; ++l) {
+    dblN_minmax(bmesh->bb[l].c, 20, &bmesh->min[l], &bmesh->max[l]);
+    if (!isnan(bmesh->min[l]) && !isnan(bmesh->max[l]))
+      lc[n++] = l;
+  }
+
+  /* Each node contains at least one cell, so there are at most `n`
+   * nodes. */
+  bmesh->itree_size = 0;
+  bmesh->itree = malloc(n*sizeof(itree_node_s));
+  bmesh->itree_by_min = malloc(n*sizeof(size_t));
+  bmesh->itree_by_max = malloc(n*sizeof(size_t));
+
+  size_t offset = 0;
+  itree_build(bmesh, lc, n, &offset);
+  assert(offset == n);
+
+  free(lc);
+}
+
 void bmesh33_alloc(bmesh33_s **bmesh) {
   *bmesh = malloc(sizeof(bmesh33_s));
 }
@@ -191,7 +340,6 @@ void bmesh33_dealloc(bmesh33_s **bmesh) {
 void bmesh33_init_from_mesh3_and_jets(bmesh33_s *bmesh, mesh3_s const *mesh,
                                       jet31t const *jet) {
   bmesh->mesh = mesh;
-  bmesh->mesh_owner = false;
   bmesh->num_cells = mesh3_ncells(mesh);
 
   // Interpolate jets to create Bezier tetrahedra for each cell
@@ -200,16 +348,61 @@ void bmesh33_init_from_mesh3_and_jets(bmesh33_s *bmesh, mesh3_s const *mesh,
     bb33_init_from_cell_and_jets(&bmesh->bb[l], mesh, jet, l);
 
   bmesh->level = NAN;
+
+  bmesh->bb_owner = true;
+  bmesh->lc = NULL;
+
+  init_itree(bmesh);
+}
+
+/* Like `bmesh33_init_from_mesh3_and_jets`, but with the values and
+ * gradients at the vertices of `mesh` stored in separate arrays (as
+ * in `eik3_get_T_ptr` and `eik3_get_DT_ptr`). */
+void bmesh33_init_from_mesh3_and_3d_data(bmesh33_s *bmesh, mesh3_s const *mesh,
+                                         dbl const *f, dbl3 const *Df) {
+  bmesh->mesh = mesh;
+  bmesh->num_cells = mesh3_ncells(mesh);
+
+  bmesh->bb = malloc(bmesh->num_cells*sizeof(bb33));
+  for (size_t l = 0; l < bmesh->num_cells; ++l) {
+    uint4 cv;
+    mesh3_cv(mesh, l, cv);
+
+    dbl3 x[4];
+    jet31t J[4];
+    for (size_t i = 0; i < 4; ++i) {
+      mesh3_copy_vert(mesh, cv[i], x[i]);
+      J[i].f = f[cv[i]];
+      dbl3_copy(Df[cv[i]], J[i].Df);
+    }
+
+    bb33_init_from_jets(&bmesh->bb[l], J, x);
+  }
+
+  bmesh->level = NAN;
+
+  bmesh->bb_owner = true;
+  bmesh->lc = NULL;
+
+  init_itree(bmesh);
 }
 
 void bmesh33_deinit(bmesh33_s *bmesh) {
+  if (!bmesh->bb_owner) {
+    free(bmesh->lc);
+    bmesh->lc = NULL;
+    bmesh->bb = NULL;
+    return;
+  }
+
   free(bmesh->bb);
   bmesh->bb = NULL;
 
-  if (bmesh->mesh_owner) {
-    mesh3_deinit((mesh3_s *)bmesh->mesh);
-    mesh3_dealloc((mesh3_s **)&bmesh->mesh);
-  }
+  free(bmesh->min);
+  free(bmesh->max);
+  free(bmesh->itree);
+  free(bmesh->itree_by_min);
+  free(bmesh->itree_by_max);
 }
 
 size_t bmesh33_num_cells(bmesh33_s const *bmesh) {
@@ -224,94 +417,674 @@ mesh3_s const *bmesh33_get_mesh_ptr(bmesh33_s const *bmesh) {
   return bmesh->mesh;
 }
 
-bmesh33_s *bmesh33_restrict_to_level(bmesh33_s const *bmesh, dbl level) {
-  // First, precompute which Bezier tetra *might* bracket the
-  // level. Since the graph of each Bezier tetra is contained in the
-  // convex hull of the defining control points, we can quickly rule
-  // out points outside of this interval (just check if the level is
-  // greater than the maximum or smaller than the minimum Bezier
-  // ordinate), but we may still have some false positives in what we
-  // compute this way.
-  size_t num_brack = 0;
-  bool *brack = malloc(bmesh->num_cells*sizeof(bool));
-  for (size_t l = 0; l < bmesh->num_cells; ++l) {
-    brack[l] = bb33_convex_hull_brackets_value(&bmesh->bb[l], level);
-    num_brack += brack[l];
-  }
+/* Find the cells of `bmesh` which might contain part of the level set
+ * at `level`, appending their indices to `lc` in increasing
+ * order. Since the graph of each Bezier tetra is contained in the
+ * convex hull of its control points, these are the cells for which
+ * `level` lies between the smallest and largest Bezier ordinate (see
+ * `bb33_convex_hull_brackets_value`). There may still be false
+ * positives. This takes O(log(n) + k) time for `n` cells and `k`
+ * results (before sorting). */
+void bmesh33_get_cells_bracketing_level(bmesh33_s const *bmesh, dbl level,
+                                        array_s *lc) {
+  assert(bmesh->bb_owner);
 
-  bmesh33_s *level_bmesh = malloc(sizeof(bmesh33_s));
-  level_bmesh->bb = malloc(num_brack*sizeof(bb33));
+  size_t size = array_size(lc);
 
-  dbl3 *verts = malloc(4*num_brack*sizeof(dbl3));
-  uint4 *cells = malloc(num_brack*sizeof(uint4));
+  size_t i_node = bmesh->itree_size > 0 ? 0 : (size_t)NO_INDEX;
+  while (i_node != (size_t)NO_INDEX) {
+    itree_node_s const *node = &bmesh->itree[i_node];
+    size_t const *by_min = &bmesh->itree_by_min[node->offset];
+    size_t const *by_max = &bmesh->itree_by_max[node->offset];
 
-  // For each bracketed cell, we go ahead and splat all of the
-  // incident vertices into `verts`. There will be duplicates. For now
-  // we're trading off memory use for simplicity. Later on we can come
-  // back and optimize this. While we're doing this, we also copy over
-  // Bezier tetra data so that we don't have to recompute it.
-  size_t lv = 0, lc = 0, cv[4], j = 0;
-  for (size_t l = 0; l < bmesh->num_cells; ++l) {
-    if (!brack[l]) continue;
-    level_bmesh->bb[lc] = bmesh->bb[l]; // Copy Bezier tetra data
-    mesh3_cv(bmesh->mesh, l, cv); // Grab the inds for this cell
-    for (int i = 0; i < 4; ++i) {
-      mesh3_copy_vert(bmesh->mesh, cv[i], verts[4*lc + i]);
-      cells[lc][i] = j++; // Splat new vert inds into `cells`
+    /* All of the cells in this node contain `center`, so if `level`
+     * is below it, they bracket `level` if their minimum is below
+     * `level`, and vice versa. */
+    if (level < node->center) {
+      for (size_t i = 0; i < node->size && bmesh->min[by_min[i]] <= level; ++i)
+        array_append(lc, &by_min[i]);
+      i_node = node->child[0];
+    } else if (level > node->center) {
+      for (size_t i = 0; i < node->size && bmesh->max[by_max[i]] >= level; ++i)
+        array_append(lc, &by_max[i]);
+      i_node = node->child[1];
+    } else {
+      for (size_t i = 0; i < node->size; ++i)
+        array_append(lc, &by_min[i]);
+      break;
     }
-    lv += 4;
-    ++lc;
   }
 
-  dbl eps = mesh3_get_eps(bmesh->mesh);
+  /* Sort the new indices */
+  size_t *new_lc = array_get_ptr(lc, size);
+  if (new_lc != NULL)
+    qsort(new_lc, array_size(lc) - size, sizeof(size_t), (compar_t)compar_size_t);
+}
 
-  mesh3_data_s data = {
-    .nverts = lv, .verts = verts,
-    .ncells = lc, .cells = cells
-  };
+/* Restrict `bmesh` to the cells which might contain part of the level
+ * set at `level` (see `bmesh33_get_cells_bracketing_level`). The
+ * result is a view: it refers to the mesh and Bezier tetra data of
+ * `bmesh`, which must outlive it, and only stores the indices of its
+ * cells. Cell `l` of the result is cell `lc[l]` of `bmesh`, where the
+ * `lc` are in increasing order. */
+bmesh33_s *bmesh33_restrict_to_level(bmesh33_s const *bmesh, dbl level) {
+  array_s *lc;
+  array_alloc(&lc);
+  array_init(lc, sizeof(size_t), ARRAY_DEFAULT_CAPACITY);
+  bmesh33_get_cells_bracketing_level(bmesh, level, lc);
 
-  mesh3_alloc((mesh3_s **)&level_bmesh->mesh);
-  mesh3_init((mesh3_s *)level_bmesh->mesh, &data, false, &eps);
+  bmesh33_s *level_bmesh = malloc(sizeof(bmesh33_s));
+  level_bmesh->mesh = bmesh->mesh;
+  level_bmesh->num_cells = array_size(lc);
+  level_bmesh->bb = bmesh->bb;
+  level_bmesh->level = level;
 
-  level_bmesh->mesh_owner = true;
-  level_bmesh->num_cells = mesh3_ncells(level_bmesh->mesh);
-  assert(level_bmesh->num_cells == lc);
+  level_bmesh->bb_owner = false;
+  level_bmesh->lc = malloc(level_bmesh->num_cells*sizeof(size_t));
+  for (size_t l = 0; l < level_bmesh->num_cells; ++l)
+    array_get(lc, l, &level_bmesh->lc[l]);
 
-  level_bmesh->level = level;
+  level_bmesh->min = level_bmesh->max = NULL;
+  level_bmesh->itree_size = 0;
+  level_bmesh->itree = NULL;
+  level_bmesh->itree_by_min = level_bmesh->itree_by_max = NULL;
 
-  free(cells);
-  free(verts);
-  free(brack);
+  array_deinit(lc);
+  array_dealloc(&lc);
 
   return level_bmesh;
 }
 
-bmesh33_cell_s bmesh33_get_cell(bmesh33_s const *bmesh, size_t l) {
-  assert(l < bmesh->num_cells);
+/* Get the cell of `bmesh` corresponding to cell `lc` of the
+ * underlying mesh. */
+static bmesh33_cell_s get_mesh_cell(bmesh33_s const *bmesh, size_t lc) {
   return (bmesh33_cell_s) {
     .bmesh = bmesh,
-    .bb = &bmesh->bb[l],
+    .bb = &bmesh->bb[lc],
     .mesh = bmesh->mesh,
-    .l = l,
+    .l = lc,
     .level = bmesh33_get_level(bmesh)
   };
 }
 
+/* Get the `l`th cell of `bmesh`. For a level view, the `l` field of
+ * the result is the index of the cell in the underlying mesh. */
+bmesh33_cell_s bmesh33_get_cell(bmesh33_s const *bmesh, size_t l) {
+  assert(l < bmesh->num_cells);
+  return get_mesh_cell(bmesh, bmesh->bb_owner ? l : bmesh->lc[l]);
+}
+
 /* Evaluate `bmesh` at the point `x`. If `x` lies outside the mesh,
  * return `NAN`. */
 dbl bmesh33_f(bmesh33_s const *bmesh, dbl3 const x) {
-  // TODO: very inefficient implementation! Optimize this using rtree.
-  for (size_t l = 0; l < bmesh->num_cells; ++l) {
-    if (mesh3_cell_contains_point(bmesh->mesh, l, x)) {
-      tetra3 tetra = mesh3_get_tetra(bmesh->mesh, l);
-      dbl4 b;
-      tetra3_get_bary_coords(&tetra, x, b);
-      return bb33_f(&bmesh->bb[l], b);
+  size_t l = mesh3_find_cell_containing_point(bmesh->mesh, x, (size_t)NO_INDEX);
+  if (l == (size_t)NO_INDEX)
+    return NAN;
+
+  tetra3 tetra = mesh3_get_tetra(bmesh->mesh, l);
+  dbl4 b;
+  tetra3_get_bary_coords(&tetra, x, b);
+  return bb33_f(&bmesh->bb[l], b);
+}
+
+/* Evaluate `bmesh` at each of the `n` points `x`, writing the
+ * results to `f`. Points outside the mesh are set to `NAN`. This is
+ * much faster than calling `bmesh33_f` in a loop when `n` is large,
+ * since the cells are located together (see
+ * `mesh3_find_cells_containing_points`). */
+void bmesh33_f_batch(bmesh33_s const *bmesh, size_t n, dbl3 const *x, dbl *f) {
+  size_t *lc = malloc(n*sizeof(size_t));
+  mesh3_find_cells_containing_points(bmesh->mesh, n, x, lc);
+
+#pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < n; ++i) {
+    if (lc[i] == (size_t)NO_INDEX) {
+      f[i] = NAN;
+      continue;
+    }
+    tetra3 tetra = mesh3_get_tetra(bmesh->mesh, lc[i]);
+    dbl4 b;
+    tetra3_get_bary_coords(&tetra, x[i], b);
+    f[i] = bb33_f(&bmesh->bb[lc[i]], b);
+  }
+
+  free(lc);
+}
+
+/* Evaluate the gradient of `bmesh` at the point `x`. If `x` lies
+ * outside the mesh, `Df` is set to `NAN`. */
+void bmesh33_Df(bmesh33_s const *bmesh, dbl3 const x, dbl3 Df) {
+  size_t l = mesh3_find_cell_containing_point(bmesh->mesh, x, (size_t)NO_INDEX);
+  if (l == (size_t)NO_INDEX) {
+    Df[0] = Df[1] = Df[2] = NAN;
+    return;
+  }
+
+  bmesh33_cell_s cell = get_mesh_cell(bmesh, l);
+  bmesh33_cell_Df(&cell, x, Df);
+}
+
+/* Evaluate the gradient of `bmesh` at each of the `n` points `x`,
+ * writing the results to `Df`. Points outside the mesh are set to
+ * `NAN`. Like `bmesh33_f_batch`, this is much faster than calling
+ * `bmesh33_Df` in a loop when `n` is large. */
+void bmesh33_Df_batch(bmesh33_s const *bmesh, size_t n, dbl3 const *x, dbl3 *Df) {
+  size_t *lc = malloc(n*sizeof(size_t));
+  mesh3_find_cells_containing_points(bmesh->mesh, n, x, lc);
+
+#pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < n; ++i) {
+    if (lc[i] == (size_t)NO_INDEX) {
+      Df[i][0] = Df[i][1] = Df[i][2] = NAN;
+      continue;
     }
+    bmesh33_cell_s cell = get_mesh_cell(bmesh, lc[i]);
+    bmesh33_cell_Df(&cell, x[i], Df[i]);
   }
-  return NAN;
+
+  free(lc);
 }
 
 bb33 *bmesh33_get_bb_ptr(bmesh33_s const *bmesh, size_t lc) {
   return &bmesh->bb[lc];
 }
+
+/* A point of the lattice which a cell is subdivided along when
+ * extracting an isosurface. It's stored as the indices of the cell's
+ * vertices with nonzero barycentric coordinates together with the
+ * numerators of those coordinates, sorted by vertex index and padded
+ * with `NO_INDEX`, so that a lattice point on a face shared by two
+ * cells has the same key in both of them. */
+typedef struct {
+  size_t lv[4];
+  size_t n[4];
+} lattice_key_s;
+
+static int lattice_key_cmp(lattice_key_s const *k1, lattice_key_s const *k2) {
+  for (size_t i = 0; i < 4; ++i) {
+    if (k1->lv[i] != k2->lv[i])
+      return k1->lv[i] < k2->lv[i] ? -1 : 1;
+    if (k1->n[i] != k2->n[i])
+      return k1->n[i] < k2->n[i] ? -1 : 1;
+  }
+  return 0;
+}
+
+/* An edge of the lattice, with `p[0] < p[1]`. Each vertex of an
+ * isosurface lies on one of these. */
+typedef struct {
+  lattice_key_s p[2];
+} edge_key_s;
+
+static int edge_key_cmp(edge_key_s const *k1, edge_key_s const *k2) {
+  int cmp = lattice_key_cmp(&k1->p[0], &k2->p[0]);
+  return cmp ? cmp : lattice_key_cmp(&k1->p[1], &k2->p[1]);
+}
+
+typedef struct {
+  edge_key_s key;
+  dbl3 x;
+} iso_vert_s;
+
+typedef struct {
+  size_t i; // index of the level this triangle belongs to
+  iso_vert_s v[3];
+} iso_tri_s;
+
+/**
+ * The subdivision of the reference tetrahedron into `m^3`
+ * subtetrahedra, obtained by splitting each of its edges into `m`
+ * pieces. Writing the lattice points in the cumulative coordinates
+ * `0 <= s[0] <= s[1] <= s[2] <= m`, where the barycentric coordinates
+ * are `(m - s[2], s[2] - s[1], s[1] - s[0], s[0])/m`, the
+ * subtetrahedra are the tetrahedra of the Freudenthal triangulation
+ * of the unit cubes of `Z^3` which lie in this region.
+ */
+typedef struct {
+  size_t m;
+  size_t num_points;
+  size_t (*n)[4]; // numerators of barycentric coordinates of each point
+  size_t num_tetra;
+  size_t (*tetra)[4]; // indices of the points of each subtetrahedron
+} lattice_s;
+
+static void lattice_init(lattice_s *lattice, size_t m) {
+  assert(m >= 1);
+
+  lattice->m = m;
+
+  size_t M = m + 1;
+  size_t *index = malloc(M*M*M*sizeof(size_t));
+  for (size_t i = 0; i < M*M*M; ++i)
+    index[i] = (size_t)NO_INDEX;
+
+  lattice->num_points = (m + 1)*(m + 2)*(m + 3)/6;
+  lattice->n = malloc(lattice->num_points*sizeof(size_t[4]));
+
+  size_t k = 0;
+  for (size_t s2 = 0; s2 <= m; ++s2) {
+    for (size_t s1 = 0; s1 <= s2; ++s1) {
+      for (size_t s0 = 0; s0 <= s1; ++s0) {
+        index[M*(M*s2 + s1) + s0] = k;
+        lattice->n[k][0] = m - s2;
+        lattice->n[k][1] = s2 - s1;
+        lattice->n[k][2] = s1 - s0;
+        lattice->n[k][3] = s0;
+        ++k;
+      }
+    }
+  }
+  assert(k == lattice->num_points);
+
+  static int const perm[6][3] = {
+    {0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}
+  };
+
+  lattice->num_tetra = 0;
+  lattice->tetra = malloc(m*m*m*sizeof(size_t[4]));
+  for (size_t p = 0; p < m*m*m; ++p) {
+    for (size_t j = 0; j < 6; ++j) {
+      size_t s[3] = {p%m, (p/m)%m, p/(m*m)};
+      size_t lp[4];
+      for (size_t i = 0; i < 4; ++i) {
+        if (i > 0)
+          ++s[perm[j][i - 1]];
+        lp[i] = s[0] <= s[1] && s[1] <= s[2] ?
+          index[M*(M*s[2] + s[1]) + s[0]] : (size_t)NO_INDEX;
+      }
+      if (lp[0] == (size_t)NO_INDEX || lp[1] == (size_t)NO_INDEX ||
+          lp[2] == (size_t)NO_INDEX || lp[3] == (size_t)NO_INDEX)
+        continue;
+      memcpy(lattice->tetra[lattice->num_tetra++], lp, sizeof(size_t[4]));
+    }
+  }
+  assert(lattice->num_tetra == m*m*m);
+
+  free(index);
+}
+
+static void lattice_deinit(lattice_s *lattice) {
+  free(lattice->n);
+  free(lattice->tetra);
+}
+
+/* Per-thread storage for the values, positions, and keys of the
+ * lattice points of the current cell. */
+typedef struct {
+  dbl *f;
+  dbl3 *x;
+  lattice_key_s *key;
+} iso_workspace_s;
+
+typedef struct {
+  bool init;
+  cubic_s cubic; // restriction of the cell's Bezier tetra to the edge
+} iso_edge_s;
+
+static dbl cubic_f_wrapper(dbl t, cubic_s const *cubic) {
+  return cubic_f(cubic, t);
+}
+
+static int const iso_edge_index[4][4] = {
+  {-1, 0, 1, 2}, {0, -1, 3, 4}, {1, 3, -1, 5}, {2, 4, 5, -1}
+};
+
+/* Find the point where the level set at `level` crosses the edge
+ * from lattice point `p` to `q` of the current cell, which is known
+ * to change sign along it. Rather than interpolating linearly, we
+ * restrict the cell's Bezier tetra to the edge and find a root of
+ * the resulting cubic. The cubic is cached in `edge`, so that it's
+ * only computed once for all of the levels crossing the edge. */
+static void get_iso_vert(bb33 const *bb, lattice_s const *lattice,
+                         iso_workspace_s const *work, size_t p, size_t q,
+                         iso_edge_s *edge, dbl level, iso_vert_s *vert) {
+  /* Orient the edge consistently in each cell containing it */
+  if (lattice_key_cmp(&work->key[p], &work->key[q]) > 0)
+    SWAP(p, q);
+
+  if (!edge->init) {
+    dbl4 b0, b1;
+    for (size_t i = 0; i < 4; ++i) {
+      b0[i] = (dbl)lattice->n[p][i]/lattice->m;
+      b1[i] = (dbl)lattice->n[q][i]/lattice->m;
+    }
+    edge->cubic = bb33_restrict_along_interval(bb, b0, b1);
+    edge->init = true;
+  }
+
+  cubic_s cubic = edge->cubic;
+  cubic_add_constant(&cubic, -level);
+
+  /* The cubic changes sign on [0, 1], so we can use the hybrid
+   * rootfinder, which is more robust than solving the cubic directly
+   * when it's nearly linear (e.g., on a small subtetrahedron). If
+   * roundoff has spoiled the bracket, we fall back to linear
+   * interpolation. */
+  dbl t;
+  if (!hybrid((hybrid_cost_func_t)cubic_f_wrapper, 0, 1, &cubic, &t))
+    t = fmax(0, fmin(1, (level - work->f[p])/(work->f[q] - work->f[p])));
+
+  /* If the level set passes through an endpoint, key the vertex by
+   * that lattice point instead, so that it's merged with the vertices
+   * on the other edges incident on it */
+  vert->key.p[0] = work->key[t == 1 ? q : p];
+  vert->key.p[1] = work->key[t == 0 ? p : q];
+  for (size_t i = 0; i < 3; ++i)
+    vert->x[i] = (1 - t)*work->x[p][i] + t*work->x[q][i];
+}
+
+/* Append the triangle with vertices `v` to `tris`, oriented so that
+ * its normal points in the direction of `dx`. */
+static void append_iso_tri(array_s *tris, size_t i, iso_vert_s const *v[3],
+                           dbl3 const dx) {
+  iso_tri_s tri = {.i = i, .v = {*v[0], *v[1], *v[2]}};
+
+  dbl3 dx1, dx2, n;
+  dbl3_sub(tri.v[1].x, tri.v[0].x, dx1);
+  dbl3_sub(tri.v[2].x, tri.v[0].x, dx2);
+  dbl3_cross(dx1, dx2, n);
+  if (dbl3_dot(n, dx) < 0) {
+    tri.v[1] = *v[2];
+    tri.v[2] = *v[1];
+  }
+
+  array_append(tris, &tri);
+}
+
+/* Extract the pieces of the isosurfaces of cell `lc` at each of the
+ * `num_levels` levels, which are sorted in increasing order, and
+ * append them to `tris`. We do the marching tetrahedra algorithm on
+ * each subtetrahedron of the cell. */
+static void extract_cell_isosurfaces(bmesh33_s const *bmesh, size_t lc,
+                                     lattice_s const *lattice,
+                                     size_t num_levels, key_s const *level,
+                                     iso_workspace_s *work, array_s *tris) {
+  dbl min = bmesh->min[lc], max = bmesh->max[lc];
+  if (isnan(min) || isnan(max))
+    return;
+
+  /* Find the levels in [min, max]: only these can cross the cell */
+  size_t i0 = 0, i1 = num_levels;
+  while (i0 < i1) {
+    size_t i = (i0 + i1)/2;
+    if (level[i].key < min)
+      i0 = i + 1;
+    else
+      i1 = i;
+  }
+  i1 = i0;
+  while (i1 < num_levels && level[i1].key <= max)
+    ++i1;
+  if (i0 == i1)
+    return;
+
+  bb33 const *bb = &bmesh->bb[lc];
+
+  size_t lv[4];
+  mesh3_cv(bmesh->mesh, lc, lv);
+
+  dbl const *x[4];
+  mesh3_get_vert_ptrs(bmesh->mesh, lv, 4, x);
+
+  /* Evaluate the Bezier tetra at each lattice point, and set up the
+   * lattice point keys */
+  for (size_t k = 0; k < lattice->num_points; ++k) {
+    size_t const *n = lattice->n[k];
+
+    dbl4 b;
+    for (size_t i = 0; i < 4; ++i)
+      b[i] = (dbl)n[i]/lattice->m;
+    work->f[k] = bb33_f(bb, b);
+
+    dbl3_zero(work->x[k]);
+    for (size_t i = 0; i < 4; ++i)
+      dbl3_saxpy_inplace(b[i], x[i], work->x[k]);
+
+    lattice_key_s *key = &work->key[k];
+    for (size_t i = 0; i < 4; ++i) {
+      key->lv[i] = n[i] > 0 ? lv[i] : (size_t)NO_INDEX;
+      key->n[i] = n[i];
+    }
+    for (size_t i = 1; i < 4; ++i)
+      for (size_t j = i; j > 0 && key->lv[j - 1] > key->lv[j]; --j) {
+        SWAP(key->lv[j - 1], key->lv[j]);
+        SWAP(key->n[j - 1], key->n[j]);
+      }
+  }
+
+  for (size_t t = 0; t < lattice->num_tetra; ++t) {
+    size_t const *lp = lattice->tetra[t];
+
+    dbl f[4];
+    for (size_t i = 0; i < 4; ++i)
+      f[i] = work->f[lp[i]];
+
+    dbl fmin, fmax;
+    dblN_minmax(f, 4, &fmin, &fmax);
+
+    iso_edge_s edge[6];
+    for (size_t e = 0; e < 6; ++e)
+      edge[e].init = false;
+
+    for (size_t i = i0; i < i1; ++i) {
+      dbl value = level[i].key;
+      if (!(fmin <= value && value < fmax))
+        continue;
+
+      /* Split the vertices into those above and below `value` */
+      size_t pos[4], neg[4], num_pos = 0, num_neg = 0;
+      for (size_t j = 0; j < 4; ++j) {
+        if (f[j] > value)
+          pos[num_pos++] = j;
+        else
+          neg[num_neg++] = j;
+      }
+
+      /* The triangles are oriented so that their normals point
+       * towards increasing values */
+      dbl3 dx;
+      dbl3_sub(work->x[lp[pos[0]]], work->x[lp[neg[0]]], dx);
+
+#define ISO_VERT(a, b, v)                                       \
+      get_iso_vert(bb, lattice, work, lp[a], lp[b],             \
+                   &edge[iso_edge_index[a][b]], value, v)
+
+      if (num_pos == 1 || num_neg == 1) {
+        size_t a = num_pos == 1 ? pos[0] : neg[0];
+        size_t const *rest = num_pos == 1 ? neg : pos;
+        iso_vert_s v[3];
+        for (size_t j = 0; j < 3; ++j)
+          ISO_VERT(a, rest[j], &v[j]);
+        append_iso_tri(tris, level[i].l, (iso_vert_s const *[3]) {&v[0], &v[1], &v[2]}, dx);
+      } else {
+        assert(num_pos == 2 && num_neg == 2);
+        iso_vert_s v[4];
+        ISO_VERT(pos[0], neg[0], &v[0]);
+        ISO_VERT(pos[0], neg[1], &v[1]);
+        ISO_VERT(pos[1], neg[1], &v[2]);
+        ISO_VERT(pos[1], neg[0], &v[3]);
+        append_iso_tri(tris, level[i].l, (iso_vert_s const *[3]) {&v[0], &v[1], &v[2]}, dx);
+        append_iso_tri(tris, level[i].l, (iso_vert_s const *[3]) {&v[0], &v[2], &v[3]}, dx);
+      }
+
+#undef ISO_VERT
+    }
+  }
+}
+
+typedef struct {
+  edge_key_s key;
+  size_t i; // index of the triangle vertex (3*triangle + vertex)
+} iso_vert_ref_s;
+
+static int iso_vert_ref_cmp(iso_vert_ref_s const *r1, iso_vert_ref_s const *r2) {
+  int cmp = edge_key_cmp(&r1->key, &r2->key);
+  return cmp ? cmp : r1->i < r2->i ? -1 : r1->i > r2->i ? 1 : 0;
+}
+
+/* Make a `mesh2_s` from the `n` triangles `tri[lt[i]]`, merging the
+ * triangle vertices which lie on the same lattice edge. */
+static mesh2_s *make_isosurface(iso_tri_s const *tri, size_t n, size_t const *lt) {
+  iso_vert_ref_s *ref = malloc(3*n*sizeof(iso_vert_ref_s));
+  for (size_t j = 0; j < n; ++j)
+    for (size_t k = 0; k < 3; ++k)
+      ref[3*j + k] = (iso_vert_ref_s) {.key = tri[lt[j]].v[k].key, .i = 3*j + k};
+  qsort(ref, 3*n, sizeof(iso_vert_ref_s), (compar_t)iso_vert_ref_cmp);
+
+  size_t nverts = 0;
+  dbl3 *verts = malloc(3*n*sizeof(dbl3));
+  uint3 *faces = malloc(n*sizeof(uint3));
+  for (size_t r = 0; r < 3*n; ++r) {
+    size_t j = ref[r].i/3, k = ref[r].i%3;
+    if (r == 0 || edge_key_cmp(&ref[r - 1].key, &ref[r].key))
+      dbl3_copy(tri[lt[j]].v[k].x, verts[nverts++]);
+    faces[j][k] = nverts - 1;
+  }
+  if (nverts > 0)
+    verts = realloc(verts, nverts*sizeof(dbl3));
+
+  free(ref);
+
+  /* Drop the triangles which collapsed when the level set passed
+   * through a lattice point */
+  size_t nfaces = 0;
+  for (size_t j = 0; j < n; ++j)
+    if (faces[j][0] != faces[j][1] && faces[j][1] != faces[j][2] &&
+        faces[j][2] != faces[j][0])
+      memcpy(faces[nfaces++], faces[j], sizeof(uint3));
+
+  dbl3 *face_normals = malloc(nfaces*sizeof(dbl3));
+  for (size_t j = 0; j < nfaces; ++j) {
+    dbl3 dx1, dx2;
+    dbl3_sub(verts[faces[j][1]], verts[faces[j][0]], dx1);
+    dbl3_sub(verts[faces[j][2]], verts[faces[j][0]], dx2);
+    dbl3_cross(dx1, dx2, face_normals[j]);
+    if (dbl3_norm(face_normals[j]) > 0)
+      dbl3_normalize(face_normals[j]);
+  }
+
+  mesh2_s *surf;
+  mesh2_alloc(&surf);
+  mesh2_init(surf,
+             verts, nverts, /* verts_policy: */ POLICY_XFER,
+             faces, nfaces, /* faces_policy: */ POLICY_XFER,
+             face_normals, /* face_normals_policy: */ POLICY_XFER);
+
+  return surf;
+}
+
+/**
+ * Extract the level sets of `bmesh` at each of the `num_levels`
+ * values in `level` as triangle meshes, writing a newly allocated
+ * `mesh2_s` for each level to `surf` (these should be cleaned up
+ * with `mesh2_deinit` and `mesh2_dealloc`).
+ *
+ * This uses marching tetrahedra. To follow the cubic level sets more
+ * closely, each edge of each cell is split into `num_subdivisions`
+ * pieces, subdividing the cell into `num_subdivisions^3`
+ * subtetrahedra, and the vertices of the triangles are placed at the
+ * roots of the Bezier tetra restricted to the subtetrahedra's edges,
+ * so that they lie on the level set. Triangles are oriented so that
+ * their normals point towards increasing values. Vertices shared
+ * between neighboring triangles (including those in neighboring
+ * cells) are merged.
+ *
+ * All of the levels are extracted in one pass over the cells, so that
+ * the Bezier tetra of each cell is evaluated at its lattice points and
+ * restricted to each edge only once, and the cells are processed in
+ * parallel. Only the cells whose range of Bezier ordinates brackets a
+ * level (see `bb33_convex_hull_brackets_value`) are subdivided.
+ */
+void bmesh33_extract_isosurfaces(bmesh33_s const *bmesh, size_t num_levels,
+                                 dbl const *level, size_t num_subdivisions,
+                                 mesh2_s **surf) {
+  assert(bmesh->bb_owner);
+
+  lattice_s lattice;
+  lattice_init(&lattice, num_subdivisions);
+
+  /* Sort the levels, keeping track of where they came from */
+  key_s *sorted_level = malloc(num_levels*sizeof(key_s));
+  for (size_t i = 0; i < num_levels; ++i) {
+    sorted_level[i].key = level[i];
+    sorted_level[i].l = i;
+  }
+  qsort(sorted_level, num_levels, sizeof(key_s), (compar_t)key_cmp);
+
+  /* Each thread collects the triangles of a contiguous range of
+   * cells. Concatenating them in order of thread afterwards gives the
+   * triangles in order of cell, independently of scheduling. */
+  size_t num_threads = omp_get_max_threads();
+  array_s **thread_tris = malloc(num_threads*sizeof(array_s *));
+  for (size_t j = 0; j < num_threads; ++j) {
+    array_alloc(&thread_tris[j]);
+    array_init(thread_tris[j], sizeof(iso_tri_s), ARRAY_DEFAULT_CAPACITY);
+  }
+
+#pragma omp parallel num_threads(num_threads)
+  {
+    iso_workspace_s work = {
+      .f = malloc(lattice.num_points*sizeof(dbl)),
+      .x = malloc(lattice.num_points*sizeof(dbl3)),
+      .key = malloc(lattice.num_points*sizeof(lattice_key_s))
+    };
+
+    array_s *tris = thread_tris[omp_get_thread_num()];
+
+#pragma omp for schedule(static)
+    for (size_t lc = 0; lc < bmesh->num_cells; ++lc)
+      extract_cell_isosurfaces(bmesh, lc, &lattice, num_levels, sorted_level,
+                               &work, tris);
+
+    free(work.f);
+    free(work.x);
+    free(work.key);
+  }
+
+  size_t num_tris = 0;
+  for (size_t j = 0; j < num_threads; ++j)
+    num_tris += array_size(thread_tris[j]);
+
+  iso_tri_s *tri = malloc(num_tris*sizeof(iso_tri_s));
+  for (size_t j = 0, k = 0; j < num_threads; ++j) {
+    for (size_t l = 0; l < array_size(thread_tris[j]); ++l)
+      array_get(thread_tris[j], l, &tri[k++]);
+    array_deinit(thread_tris[j]);
+    array_dealloc(&thread_tris[j]);
+  }
+  free(thread_tris);
+
+  /* Group the triangles by level: count them, compute offsets, then
+   * fill `lt` */
+  size_t *offset = calloc(num_levels + 1, sizeof(size_t));
+  for (size_t l = 0; l < num_tris; ++l)
+    ++offset[tri[l].i + 1];
+  for (size_t i = 0; i < num_levels; ++i)
+    offset[i + 1] += offset[i];
+
+  size_t *lt = malloc(num_tris*sizeof(size_t));
+  size_t *count = calloc(num_levels, sizeof(size_t));
+  for (size_t l = 0; l < num_tris; ++l)
+    lt[offset[tri[l].i] + count[tri[l].i]++] = l;
+  free(count);
+
+#pragma omp parallel for schedule(dynamic, 1)
+  for (size_t i = 0; i < num_levels; ++i)
+    surf[i] = make_isosurface(tri, offset[i + 1] - offset[i], &lt[offset[i]]);
+
+  free(lt);
+  free(offset);
+  free(tri);
+  free(sorted_level);
+
+  lattice_deinit(&lattice);
+}
+
+/* Extract the level set of `bmesh` at `level` as a triangle mesh (see
+ * `bmesh33_extract_isosurfaces`). */
+mesh2_s *bmesh33_extract_isosurface(bmesh33_s const *bmesh, dbl level,
+                                    size_t num_subdivisions) {
+  mesh2_s *surf;
+  bmesh33_extract_isosurfaces(bmesh, 1, &level, num_subdivisions, &surf);
+  return surf;
+}
@@ -42,9 +42,9 @@ void bucket_dealloc(bucket_s **bucket) {
 
 void bucket_grow(bucket_s *bucket) {
   int *new_l = malloc(2*sizeof(int)*bucket->capacity);
-  for (size_t i = 0, j = 0; i < bucket->size; ++i) {
+  for (size_t i = 0, j = bucket->start; i < bucket->size; ++i) {
     new_l[i] = bucket->l[j];
-    j = (j + 1) % bucket->size;
+    j = (j + 1) % bucket->capacity;
   }
   free(bucket->l);
   bucket->l = new_l;
@@ -71,6 +71,16 @@ int bucket_pop(bucket_s *bucket) {
   return l;
 }
 
+int bucket_peek(bucket_s const *bucket) {
+  return bucket->l[bucket->start];
+}
+
+/* Get the `i`th index from the front of `bucket` without popping
+ * anything. */
+int bucket_get(bucket_s const *bucket, size_t i) {
+  return bucket->l[(bucket->start + i) % bucket->capacity];
+}
+
 bucket_s *bucket_get_next(bucket_s const *bucket) {
   return bucket->next;
 }
@@ -776,17 +776,16 @@ static void adjust(eik_s *eik, int l0) {
   heap_swim(eik->heap, eik->positions[l0]);
 }
 
-static dbl value(void *vp, int l) {
+static dbl value(void *vp, size_t l) {
   eik_s *eik = (eik_s *)vp;
-  assert(l >= 0);
-  assert(l < eik->nnodes);
+  assert(l < (size_t)eik->nnodes);
   dbl T = eik->jets[l].f;
   return T;
 }
 
-static void setpos(void *vp, int l, int pos) {
+static void setpos(void *vp, size_t l, size_t pos) {
   eik_s *eik = (eik_s *)vp;
-  eik->positions[l] = pos;
+  eik->positions[l] = (int)pos;
 }
 
 void eik_alloc(eik_s **eik) {
@@ -827,7 +826,7 @@ void eik_init(eik_s *eik, field2_s const *slow, grid2_s const *grid) {
   heap_alloc(&eik->heap);
 
   int capacity = (int) 3*sqrt(eik->nnodes);
-  heap_init(eik->heap, capacity, value, setpos, (void *)eik);
+  heap_init(eik->heap, capacity, value, setpos, NULL, (void *)eik);
 
   eik->num_accepted = 0;
   eik->accepted = malloc(eik->nnodes*sizeof(size_t));
@@ -22,13 +22,12 @@ struct eik2g1 {
   par2_s *par;
 };
 
-static dbl value(eik2g1_s const *eik, int l) {
-  assert(l >= 0);
-  assert(l < (int)grid2_nind(eik->grid));
+static dbl value(eik2g1_s const *eik, size_t l) {
+  assert(l < grid2_nind(eik->grid));
   return eik->jet[l].f;
 }
 
-static void setpos(eik2g1_s const *eik, int l, int pos) {
+static void setpos(eik2g1_s const *eik, size_t l, size_t pos) {
   eik->pos[l] = pos;
 }
 
@@ -60,7 +59,7 @@ void eik2g1_init(eik2g1_s *eik, grid2_s const *grid) {
     eik->pos[i] = NO_INDEX;
 
   heap_alloc(&eik->heap);
-  heap_init(eik->heap,3*sqrt(num_nodes),(value_f)value,(setpos_f)setpos,eik);
+  heap_init(eik->heap,3*sqrt(num_nodes),(value_f)value,(setpos_f)setpos,NULL,eik);
 
   eik->par = malloc(num_nodes*sizeof(par2_s));
   for (size_t i = 0; i < num_nodes; ++i)
@@ -19,13 +19,12 @@ struct eik2m1 {
   size_t nvalid;
 };
 
-static dbl value(eik2m1_s const *eik, int l) {
-  assert(l >= 0);
-  assert(l < (int)mesh22_nverts(eik->mesh));
+static dbl value(eik2m1_s const *eik, size_t l) {
+  assert(l < mesh22_nverts(eik->mesh));
   return eik->jet[l].f;
 }
 
-static void setpos(eik2m1_s const *eik, int l, int pos) {
+static void setpos(eik2m1_s const *eik, size_t l, size_t pos) {
   eik->pos[l] = pos;
 }
 
@@ -55,7 +54,7 @@ void eik2m1_init(eik2m1_s *eik, mesh22_s const *mesh) {
     eik->pos[l] = NO_INDEX;
 
   heap_alloc(&eik->heap);
-  heap_init(eik->heap, 3*sqrt(nverts), (value_f)value, (setpos_f)setpos, eik);
+  heap_init(eik->heap, 3*sqrt(nverts), (value_f)value, (setpos_f)setpos, NULL, eik);
 
   eik->par = malloc(nverts*sizeof(par2_s));
   for (size_t l = 0; l < nverts; ++l)
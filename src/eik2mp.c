@@ -18,14 +18,13 @@ struct eik2mp {
   size_t nvalid; // nothing like this
 };
 
-static dbl value(eik2mp_s const *eik, int l) {
+static dbl value(eik2mp_s const *eik, size_t l) {
   // returns the eikonal value stored at the l-th node
-  assert(l >= 0);
-  assert(l < (int)mesh22_nverts(eik->mesh));
+  assert(l < mesh22_nverts(eik->mesh));
   return eik->jet[l].f;
 }
 
-static void setpos(eik2mp_s const *eik, int l, int pos) {
+static void setpos(eik2mp_s const *eik, size_t l, size_t pos) {
   // changes the index in the priority_queue (all these methods can be
   // found in priority_queue.c
   eik->pos[l] = pos;
@@ -57,7 +56,7 @@ void eik2mp_init(eik2mp_s *eik, mesh22_s const *mesh) {
     eik->pos[l] = NO_INDEX;
 
   heap_alloc(&eik->heap);
-  heap_init(eik->heap, 3*sqrt(nverts), (value_f)value, (setpos_f)setpos, eik);
+  heap_init(eik->heap, 3*sqrt(nverts), (value_f)value, (setpos_f)setpos, NULL, eik);
 
   eik->nvalid = 0;
 }
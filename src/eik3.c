@@ -7,12 +7,13 @@
 
 #include <stdio.h>
 
-#include <jmm/alist.h>
 #include <jmm/array.h>
 #include <jmm/bb.h>
+#include <jmm/binfile.h>
 #include <jmm/edge.h>
 #include <jmm/eik3_transport.h>
-#include <jmm/heap.h>
+#include <jmm/front.h>
+#include <jmm/hmap.h>
 #include <jmm/log.h>
 #include <jmm/mat.h>
 #include <jmm/mesh1.h>
@@ -26,7 +27,14 @@
 #include <jmm/utri_cache.h>
 #include <jmm/vec.h>
 
+#include "bitset.h"
 #include "macros.h"
+#include "pool.h"
+
+#define EIK3_POOL_INITIAL_CAPACITY (1 << 16)
+
+/* The most nodes accepted at once by `step_band`, per thread */
+#define EIK3_MAX_BAND_SIZE_PER_THREAD 4
 
 static bool l_OK(size_t l) {
   return l != (size_t)NO_INDEX;
@@ -40,6 +48,100 @@ static bool is_face(uint3 const l) {
   return l_OK(l[0]) && l_OK(l[1]) && l_OK(l[2]);
 }
 
+/* The state used to compute the updates targeting a subset of the
+ * nodes. A serial solver has a single worker. A parallel solver (see
+ * `eik3_set_num_threads`) has one per thread, and updates targeting
+ * node `l` always belong to worker `l % num_workers`, so that two
+ * threads never touch the same worker at once. */
+typedef struct {
+  /* In some cases, we'll skip old updates that might be useful at a
+   * later stage. We keep track of them here. */
+  utetra_cache_s *utetra_cache;
+  utri_cache_s *bd_utri_cache; // old two-point boundary `utri`
+  utri_cache_s *diff_utri_cache; // old two-point updates from diff. edges
+
+  /* Each `utetra`, `utri`, and `uline` used to compute an update is
+   * allocated from `pool` and returned to it when it's released. Once
+   * the pool has grown to the peak number of live updates, marching
+   * doesn't allocate any more memory for them. */
+  pool_s *pool;
+
+  /* Scratch arrays reused by the update functions below */
+  array_s *inc_edges; // `do_utris_if`
+  array_s *fan; // `do_utetra_fan`
+  array_s *fan_diff_inds; // `do_utetra_fan`
+
+  /* The `utetra` solved ahead of time by `step_band`, which
+   * `do_utetra` uses instead of solving them again. The updates from
+   * `l0` targeting `lhat` are stored consecutively, and
+   * `presolved_block` maps `{lhat, l0}` to the index of the first one
+   * and the number of them. */
+  array_s *presolved; // `utetra_s *`
+  hmap_s *presolved_block;
+} worker_s;
+
+static void worker_init(worker_s *worker) {
+  utetra_cache_alloc(&worker->utetra_cache);
+  utetra_cache_init(worker->utetra_cache);
+
+  utri_cache_alloc(&worker->bd_utri_cache);
+  utri_cache_init(worker->bd_utri_cache);
+
+  utri_cache_alloc(&worker->diff_utri_cache);
+  utri_cache_init(worker->diff_utri_cache);
+
+  pool_alloc(&worker->pool);
+  pool_init(worker->pool, EIK3_POOL_INITIAL_CAPACITY);
+
+  array_alloc(&worker->inc_edges);
+  array_init(worker->inc_edges, sizeof(size_t), ARRAY_DEFAULT_CAPACITY);
+
+  array_alloc(&worker->fan);
+  array_init(worker->fan, sizeof(size_t[2]), ARRAY_DEFAULT_CAPACITY);
+
+  array_alloc(&worker->fan_diff_inds);
+  array_init(worker->fan_diff_inds, sizeof(size_t), ARRAY_DEFAULT_CAPACITY);
+
+  array_alloc(&worker->presolved);
+  array_init(worker->presolved, sizeof(utetra_s *), ARRAY_DEFAULT_CAPACITY);
+
+  hmap_alloc(&worker->presolved_block);
+  hmap_init(worker->presolved_block, sizeof(size_t[2]), sizeof(size_t[2]),
+            ARRAY_DEFAULT_CAPACITY);
+}
+
+static void worker_deinit(worker_s *worker) {
+  utetra_cache_deinit(worker->utetra_cache);
+  utetra_cache_dealloc(&worker->utetra_cache);
+
+  utri_cache_deinit(worker->bd_utri_cache);
+  utri_cache_dealloc(&worker->bd_utri_cache);
+
+  utri_cache_deinit(worker->diff_utri_cache);
+  utri_cache_dealloc(&worker->diff_utri_cache);
+
+  array_deinit(worker->inc_edges);
+  array_dealloc(&worker->inc_edges);
+
+  array_deinit(worker->fan);
+  array_dealloc(&worker->fan);
+
+  array_deinit(worker->fan_diff_inds);
+  array_dealloc(&worker->fan_diff_inds);
+
+  /* `step_band` releases its leftover `utetra` before returning */
+  assert(array_is_empty(worker->presolved));
+  array_deinit(worker->presolved);
+  array_dealloc(&worker->presolved);
+
+  hmap_deinit(worker->presolved_block);
+  hmap_dealloc(&worker->presolved_block);
+
+  /* The caches have returned their updates to the pool by now */
+  pool_deinit(worker->pool);
+  pool_dealloc(&worker->pool);
+}
+
 /* A structure managing a jet marching method solving the eikonal
  * equation in 3D on an unstructured tetrahedron mesh.
  *
@@ -49,21 +151,38 @@ struct eik3 {
   mesh3_s const *mesh;
   sfunc_s const *sfunc;
 
-  jet31t *jet;
+  /* The jets and parents are stored as structures of arrays: the
+   * front only ever compares values, and the transport passes only
+   * read gradients, so keeping each field contiguous means each of
+   * them only pulls the data it needs into cache. The accessors
+   * (`eik3_get_jet`, `eik3_get_par`, etc.) assemble the structs. */
+  dbl *T;
+  dbl3 *DT;
   state_e *state;
-  int *pos;
-  par3_s *par;
-  heap_s *heap;
+  index3 *par_l;
+  dbl3 *par_b;
+  front_s *front;
 
-  /* In some cases, we'll skip old updates that might be useful at a
-   * later stage. We keep track of them here. */
-  utetra_cache_s *utetra_cache;
-  utri_cache_s *bd_utri_cache; // old two-point boundary `utri`
-  utri_cache_s *diff_utri_cache; // old two-point updates from diff. edges
+  /* Only used by the deprecated `eik3_get_jet_ptr`, and allocated the
+   * first time it's called. */
+  jet31t *jet;
+
+  size_t num_workers;
+  worker_s *worker;
+
+  /* When solving in parallel, `step_band` tries to accept the
+   * `TRIAL` nodes whose values are within `band` of the smallest one
+   * at once. This is only set if `num_workers > 1`. */
+  dbl band;
+
+  /* Set while the neighbors of a newly accepted node are being
+   * updated: the front is fixed up after all the updates are done,
+   * instead of by `adjust`. */
+  bool defer_adjust;
 
   // Mapping from pairs of vertices (edges) to cubic hermite polynomial values
   // represents diffracting edges
-  alist_s *T_diff;
+  hmap_s *T_diff;
 
   array_s *trial_inds, *bc_inds;
 
@@ -73,7 +192,7 @@ struct eik3 {
   /* An array containing the order in which the individual nodes were
    * accepted. That is, `accepted[i] == l` means that `eik3_step()`
    * returned `l` when it was called for the `i`th time. */
-  size_t *accepted;
+  jmm_index_t *accepted;
 
   bool is_initialized;
 };
@@ -89,72 +208,84 @@ void eik3_dealloc(eik3_s **eik) {
   *eik = NULL;
 }
 
-static dbl value(void *ptr, int l) {
+static dbl value(void *ptr, size_t l) {
   eik3_s *eik = (eik3_s *)ptr;
-  assert(l >= 0);
-  assert(l < (int)mesh3_nverts(eik->mesh));
-  dbl T = eik->jet[l].f;
+  assert(l < mesh3_nverts(eik->mesh));
+  dbl T = eik->T[l];
   return T;
 }
 
-static void setpos(void *ptr, int l, int pos) {
-  eik3_s *eik = (eik3_s *)ptr;
-  eik->pos[l] = pos;
+static bool is_point_source(eik3_s const *eik, size_t l) {
+  return isfinite(eik->T[l]) && dbl3_all_nan(eik->DT[l]);
+}
+
+static size_t get_active_par_inds(eik3_s const *eik, size_t l, size_t la[3]) {
+  par3_s par = eik3_get_par(eik, l);
+  return par3_get_active_inds(&par, la);
+}
+
+static void clear_par(eik3_s *eik, size_t l) {
+  for (size_t i = 0; i < 3; ++i) {
+    eik->par_l[l][i] = (jmm_index_t)NO_PARENT;
+    eik->par_b[l][i] = NAN;
+  }
+}
+
+static worker_s *get_worker(eik3_s const *eik, size_t l) {
+  return &eik->worker[l % eik->num_workers];
+}
+
+/* Remove the cached updates targeting `l` */
+static void purge(eik3_s *eik, size_t l) {
+  worker_s *worker = get_worker(eik, l);
+  utetra_cache_purge(worker->utetra_cache, l);
+  utri_cache_purge(worker->bd_utri_cache, l);
+  utri_cache_purge(worker->diff_utri_cache, l);
 }
 
 void eik3_init(eik3_s *eik, mesh3_s const *mesh, sfunc_s const *sfunc) {
+  /* The solver walks vertex neighborhoods constantly, so we require
+   * that the mesh's adjacency tables have been built. */
+  assert(mesh3_has_adj_info(mesh));
+
   eik->mesh = mesh;
 
   eik->sfunc = sfunc;
 
   size_t nverts = mesh3_nverts(mesh);
 
-  eik->jet = malloc(nverts*sizeof(jet31t));
+  eik->T = malloc(nverts*sizeof(dbl));
+  eik->DT = malloc(nverts*sizeof(dbl3));
   for (size_t l = 0; l < nverts; ++l)
-    eik->jet[l] = jet31t_make_empty();
+    eik3_set_jet(eik, l, jet31t_make_empty());
 
   eik->state = malloc(nverts*sizeof(state_e));
   for (size_t l = 0; l < nverts; ++l) {
     eik->state[l] = FAR;
   }
 
-  eik->pos = malloc(nverts*sizeof(int));
-  for (size_t l = 0; l < nverts; ++l) {
-    eik->pos[l] = NO_INDEX;
-  }
-
-  eik->par = malloc(nverts*sizeof(par3_s));
-  for (size_t l = 0; l < nverts; ++l) {
-    par3_init_empty(&eik->par[l]);
-  }
+  eik->par_l = malloc(nverts*sizeof(index3));
+  eik->par_b = malloc(nverts*sizeof(dbl3));
+  for (size_t l = 0; l < nverts; ++l)
+    clear_par(eik, l);
 
-  /**
-   * When we compute the initial heap capacity, we want to estimate
-   * the number of nodes that could comprise the expanding numerical
-   * front at any one time. We can't know this ahead of time, so we
-   * set it to a constant multiple times (# nodes)^(1/d). In this
-   * case, d=3. Even if this is an underestimate, well still reduce
-   * the number of times the heap needs to be expanded at solve time.
-   */
-  int capacity = (int)3*cbrt(nverts);
+  eik->jet = NULL;
 
-  heap_alloc(&eik->heap);
-  heap_init(eik->heap, capacity, value, setpos, (void *)eik);
+  front_alloc(&eik->front);
+  front_init(eik->front, FRONT_TYPE_HEAP, nverts, NAN, value, (void *)eik);
 
   eik->num_accepted = 0;
 
-  eik->accepted = malloc(nverts*sizeof(size_t));
+  eik->accepted = malloc(nverts*sizeof(jmm_index_t));
   for (size_t i = 0; i < nverts; ++i)
-    eik->accepted[i] = (size_t)NO_INDEX;
+    eik->accepted[i] = (jmm_index_t)NO_INDEX;
 
-  utetra_cache_alloc(&eik->utetra_cache);
-  utetra_cache_init(eik->utetra_cache);
+  eik->num_workers = 1;
+  eik->worker = malloc(sizeof(worker_s));
+  worker_init(&eik->worker[0]);
 
-  utri_cache_alloc(&eik->bd_utri_cache);
-  utri_cache_init(eik->bd_utri_cache);
-
-  utri_cache_alloc(&eik->diff_utri_cache);
-  utri_cache_init(eik->diff_utri_cache);
+  eik->band = NAN;
+  eik->defer_adjust = false;
 
   array_alloc(&eik->bc_inds);
   array_init(eik->bc_inds, sizeof(size_t), ARRAY_DEFAULT_CAPACITY);
@@ -162,39 +293,41 @@ void eik3_init(eik3_s *eik, mesh3_s const *mesh, sfunc_s const *sfunc) {
   array_alloc(&eik->trial_inds);
   array_init(eik->trial_inds, sizeof(size_t), ARRAY_DEFAULT_CAPACITY);
 
-  alist_alloc(&eik->T_diff);
-  alist_init(eik->T_diff, sizeof(size_t[2]), sizeof(bb31), ARRAY_DEFAULT_CAPACITY);
+  hmap_alloc(&eik->T_diff);
+  hmap_init(eik->T_diff, sizeof(size_t[2]), sizeof(bb31), ARRAY_DEFAULT_CAPACITY);
 
   eik->is_initialized = true;
 }
 
 void eik3_deinit(eik3_s *eik) {
-  free(eik->jet);
-  eik->jet = NULL;
+  free(eik->T);
+  eik->T = NULL;
+
+  free(eik->DT);
+  eik->DT = NULL;
 
   free(eik->state);
   eik->state = NULL;
 
-  free(eik->pos);
-  eik->pos = NULL;
+  free(eik->par_l);
+  eik->par_l = NULL;
 
-  free(eik->par);
-  eik->par = NULL;
+  free(eik->par_b);
+  eik->par_b = NULL;
+
+  free(eik->jet);
+  eik->jet = NULL;
 
   free(eik->accepted);
   eik->accepted = NULL;
 
-  heap_deinit(eik->heap);
-  heap_dealloc(&eik->heap);
-
-  utetra_cache_deinit(eik->utetra_cache);
-  utetra_cache_dealloc(&eik->utetra_cache);
-
-  utri_cache_deinit(eik->bd_utri_cache);
-  utri_cache_dealloc(&eik->bd_utri_cache);
+  front_deinit(eik->front);
+  front_dealloc(&eik->front);
 
-  utri_cache_deinit(eik->diff_utri_cache);
-  utri_cache_dealloc(&eik->diff_utri_cache);
+  for (size_t i = 0; i < eik->num_workers; ++i)
+    worker_deinit(&eik->worker[i]);
+  free(eik->worker);
+  eik->worker = NULL;
 
   array_deinit(eik->bc_inds);
   array_dealloc(&eik->bc_inds);
@@ -202,19 +335,51 @@ void eik3_deinit(eik3_s *eik) {
   array_deinit(eik->trial_inds);
   array_dealloc(&eik->trial_inds);
 
-  alist_deinit(eik->T_diff);
-  alist_dealloc(&eik->T_diff);
+  hmap_deinit(eik->T_diff);
+  hmap_dealloc(&eik->T_diff);
 
   eik->is_initialized = false;
 }
 
+/* Return `eik` to the state it was in right after `eik3_init`, so
+ * that it can be used to solve another problem on the same mesh
+ * without reallocating any of its buffers. The number of threads set
+ * with `eik3_set_num_threads` is kept. */
+void eik3_reset(eik3_s *eik) {
+  size_t nverts = mesh3_nverts(eik->mesh);
+
+  /* Drop any cached updates left over from the last solve (e.g., if
+   * it was stopped early) before we forget which nodes have them */
+  for (size_t l = 0; l < nverts; ++l)
+    purge(eik, l);
+
+  for (size_t l = 0; l < nverts; ++l) {
+    eik3_set_jet(eik, l, jet31t_make_empty());
+    eik->state[l] = FAR;
+    clear_par(eik, l);
+    eik->accepted[l] = (jmm_index_t)NO_INDEX;
+  }
+
+  front_clear(eik->front);
+
+  eik->num_accepted = 0;
+
+  array_clear(eik->bc_inds);
+  array_clear(eik->trial_inds);
+
+  hmap_clear(eik->T_diff);
+}
+
 bool eik3_is_initialized(eik3_s const *eik) {
   return eik->is_initialized;
 }
 
 void eik3_dump_jet(eik3_s const *eik, char const *path) {
   FILE *fp = fopen(path, "wb");
-  fwrite(eik->jet, sizeof(eik->jet[0]), mesh3_nverts(eik->mesh), fp);
+  for (size_t i = 0; i < mesh3_nverts(eik->mesh); ++i) {
+    jet31t jet = eik3_get_jet(eik, i);
+    fwrite(&jet, sizeof(jet), 1, fp);
+  }
   fclose(fp);
 }
 
@@ -226,42 +391,128 @@ void eik3_dump_state(eik3_s const *eik, char const *path) {
 
 void eik3_dump_par_l(eik3_s const *eik, char const *path) {
   FILE *fp = fopen(path, "wb");
-  for (size_t i = 0; i < mesh3_nverts(eik->mesh); ++i)
-    fwrite(eik->par[i].l, sizeof(eik->par[i].l[0]), 3, fp);
+  for (size_t i = 0; i < mesh3_nverts(eik->mesh); ++i) {
+    par3_s par = eik3_get_par(eik, i);
+    fwrite(par.l, sizeof(par.l[0]), 3, fp);
+  }
   fclose(fp);
 }
 
 void eik3_dump_par_b(eik3_s const *eik, char const *path) {
   FILE *fp = fopen(path, "wb");
-  for (size_t i = 0; i < mesh3_nverts(eik->mesh); ++i)
-    fwrite(eik->par[i].b, sizeof(eik->par[i].b[0]), 3, fp);
+  fwrite(eik->par_b, sizeof(eik->par_b[0]), mesh3_nverts(eik->mesh), fp);
   fclose(fp);
 }
 
 void eik3_dump_accepted(eik3_s const *eik, char const *path) {
   FILE *fp = fopen(path, "wb");
-  fwrite(eik->accepted, sizeof(eik->accepted[0]), mesh3_nverts(eik->mesh), fp);
+  for (size_t i = 0; i < mesh3_nverts(eik->mesh); ++i) {
+    size_t l = eik->accepted[i] == (jmm_index_t)NO_INDEX ?
+      (size_t)NO_INDEX : eik->accepted[i];
+    fwrite(&l, sizeof(size_t), 1, fp);
+  }
   fclose(fp);
 }
 
+/* The version of the eik3 sections of a binfile. */
+#define EIK3_BINFILE_VERSION 3
+
+/* Add the solution stored in `eik` (its values, gradients, states,
+ * parents, and the order in which nodes were accepted) to `binfile`. The arrays
+ * aren't copied, so `eik` needs to outlive `binfile`. This can be
+ * combined with `mesh3_add_to_binfile` to store a mesh and its
+ * solution in one file. */
+void eik3_add_to_binfile(eik3_s const *eik, binfile_s *binfile) {
+  size_t nverts = mesh3_nverts(eik->mesh);
+  binfile_add_section(binfile, BINFILE_TAG_EIK3_T, EIK3_BINFILE_VERSION,
+                      eik->T, nverts*sizeof(dbl), POLICY_VIEW);
+  binfile_add_section(binfile, BINFILE_TAG_EIK3_DT, EIK3_BINFILE_VERSION,
+                      eik->DT, nverts*sizeof(dbl3), POLICY_VIEW);
+  binfile_add_section(binfile, BINFILE_TAG_EIK3_STATE, EIK3_BINFILE_VERSION,
+                      eik->state, nverts*sizeof(state_e), POLICY_VIEW);
+  binfile_add_section(binfile, BINFILE_TAG_EIK3_PAR_L, EIK3_BINFILE_VERSION,
+                      eik->par_l, nverts*sizeof(index3), POLICY_VIEW);
+  binfile_add_section(binfile, BINFILE_TAG_EIK3_PAR_B, EIK3_BINFILE_VERSION,
+                      eik->par_b, nverts*sizeof(dbl3), POLICY_VIEW);
+  binfile_add_section(binfile, BINFILE_TAG_EIK3_ACCEPTED, EIK3_BINFILE_VERSION,
+                      eik->accepted, nverts*sizeof(jmm_index_t), POLICY_VIEW);
+}
+
+/* Replace the solution in `eik` with the one stored in `binfile` by
+ * `eik3_add_to_binfile`. The sections are copied, since `eik` owns
+ * its arrays; to use a stored solution in place, get its sections
+ * directly with `binfile_get_section`. Any `TRIAL` nodes are put
+ * back on the front, so a partial solution can be resumed. Returns
+ * `JMM_ERROR_BAD_ARGUMENTS` if any of the sections are missing or
+ * don't match the size of `eik`'s mesh. */
+jmm_error_e eik3_read_binfile(eik3_s *eik, binfile_s const *binfile) {
+  size_t nverts = mesh3_nverts(eik->mesh);
+
+  struct {
+    binfile_tag_e tag;
+    void const *data;
+    size_t size;
+  } sections[] = {
+    {BINFILE_TAG_EIK3_T, NULL, nverts*sizeof(dbl)},
+    {BINFILE_TAG_EIK3_DT, NULL, nverts*sizeof(dbl3)},
+    {BINFILE_TAG_EIK3_STATE, NULL, nverts*sizeof(state_e)},
+    {BINFILE_TAG_EIK3_PAR_L, NULL, nverts*sizeof(index3)},
+    {BINFILE_TAG_EIK3_PAR_B, NULL, nverts*sizeof(dbl3)},
+    {BINFILE_TAG_EIK3_ACCEPTED, NULL, nverts*sizeof(jmm_index_t)}
+  };
+
+  for (size_t i = 0; i < sizeof(sections)/sizeof(sections[0]); ++i) {
+    uint32_t version;
+    size_t size;
+    sections[i].data = binfile_get_section(binfile, sections[i].tag, &version, &size);
+    if (sections[i].data == NULL || version != EIK3_BINFILE_VERSION
+        || size != sections[i].size)
+      return JMM_ERROR_BAD_ARGUMENTS;
+  }
+
+  eik3_reset(eik);
+
+  memcpy(eik->T, sections[0].data, sections[0].size);
+  memcpy(eik->DT, sections[1].data, sections[1].size);
+  memcpy(eik->state, sections[2].data, sections[2].size);
+  memcpy(eik->par_l, sections[3].data, sections[3].size);
+  memcpy(eik->par_b, sections[4].data, sections[4].size);
+  memcpy(eik->accepted, sections[5].data, sections[5].size);
+
+  while (eik->num_accepted < nverts
+         && eik->accepted[eik->num_accepted] != (jmm_index_t)NO_INDEX)
+    ++eik->num_accepted;
+
+  for (size_t l = 0; l < nverts; ++l)
+    if (eik->state[l] == TRIAL)
+      front_insert(eik->front, l);
+
+  return JMM_ERROR_NONE;
+}
+
 size_t eik3_peek(eik3_s const *eik) {
-  return heap_front(eik->heap);
+  return front_peek(eik->front);
 }
 
 static void adjust(eik3_s *eik, size_t l) {
   assert(eik->state[l] == TRIAL);
   assert(l < mesh3_nverts(eik->mesh));
 
-  heap_swim(eik->heap, eik->pos[l]);
+  if (eik->defer_adjust)
+    return;
+
+  front_update(eik->front, l);
 }
 
 /** Functions for `do_utri`: */
 
 static void commit_utri(eik3_s *eik, size_t lhat, utri_s const *utri) {
   /* TODO: see comment about caustics in `commit_utetra` */
-  assert(utri_get_value(utri) < eik->jet[lhat].f);
+  assert(utri_get_value(utri) < eik->T[lhat]);
 
-  utri_get_jet31t(utri, &eik->jet[lhat]);
+  jet31t jet;
+  utri_get_jet31t(utri, &jet);
+  eik3_set_jet(eik, lhat, jet);
 
   eik3_set_par(eik, lhat, utri_get_par(utri));
 }
@@ -272,8 +523,7 @@ get_valid_inc_edges(eik3_s const *eik, size_t l0, array_s *l1,
   mesh3_s const *mesh = eik3_get_mesh(eik);
 
   int nvv = mesh3_nvv(mesh, l0);
-  size_t *vv = malloc(nvv*sizeof(size_t));
-  mesh3_vv(mesh, l0, vv);
+  jmm_index_t const *vv = mesh3_get_vv_ptr(mesh, l0);
 
   size_t le[2] = {[0] = l0};
   for (int i = 0; i < nvv; ++i) {
@@ -287,8 +537,6 @@ get_valid_inc_edges(eik3_s const *eik, size_t l0, array_s *l1,
 
     array_append(l1, &le[1]);
   }
-
-  free(vv);
 }
 
 static void
@@ -301,7 +549,7 @@ do_utri(eik3_s *eik, size_t l, size_t l0, size_t l1, utri_cache_s *utri_cache,
     par3_init_empty(par);
 
   utri_s *utri;
-  utri_alloc(&utri);
+  utri_alloc_from_pool(&utri, get_worker(eik, l)->pool);
   utri_init(utri, eik, l, (uint2) {l0, l1});
 
   if (utri_is_backwards(utri, eik))
@@ -313,10 +561,10 @@ do_utri(eik3_s *eik, size_t l, size_t l0, size_t l1, utri_cache_s *utri_cache,
   if (!utri_solve(utri))
     goto cleanup;
 
-  if (par != NULL && utri_get_value(utri) < eik->jet[l].f)
+  if (par != NULL && utri_get_value(utri) < eik->T[l])
     *par = utri_get_par(utri);
 
-  if (utri_get_value(utri) >= eik->jet[l].f)
+  if (utri_get_value(utri) >= eik->T[l])
     goto cleanup;
 
   if (utri_ray_is_occluded(utri, eik))
@@ -355,9 +603,8 @@ static void do_utris_if(eik3_s *eik, size_t l, size_t l0, utri_cache_s *utri_cac
   assert(l != l0);
 
   /* find the diffracting edges incident on l0 with VALID indices */
-  array_s *l1_arr;
-  array_alloc(&l1_arr);
-  array_init(l1_arr, sizeof(size_t), ARRAY_DEFAULT_CAPACITY);
+  array_s *l1_arr = get_worker(eik, l)->inc_edges;
+  array_clear(l1_arr);
   get_valid_inc_edges(eik, l0, l1_arr, pred);
 
   for (size_t i = 0, l1; i < array_size(l1_arr); ++i) {
@@ -366,10 +613,6 @@ static void do_utris_if(eik3_s *eik, size_t l, size_t l0, utri_cache_s *utri_cac
       continue;
     do_utri(eik, l, l0, l1, utri_cache, /* par: */ NULL);
   }
-
-  /* release array of VALID diff edges */
-  array_deinit(l1_arr);
-  array_dealloc(&l1_arr);
 }
 
 /** Functions for `do_freespace_utetra`: */
@@ -431,8 +674,7 @@ static bool face_is_on_valid_front(eik3_s const *eik, uint3 const lf) {
 static void get_update_fan(eik3_s const *eik, size_t l0, array_s *l_arr) {
   /* Find all of the cells incident on `l0` */
   size_t nvc = mesh3_nvc(eik->mesh, l0);
-  size_t *vc = malloc(nvc*sizeof(size_t));
-  mesh3_vc(eik->mesh, l0, vc);
+  jmm_index_t const *vc = mesh3_get_vc_ptr(eik->mesh, l0);
 
   /* Iterate over each cell incident on `l0` */
   for (size_t i = 0; i < nvc; ++i) {
@@ -466,18 +708,17 @@ static void get_update_fan(eik3_s const *eik, size_t l0, array_s *l_arr) {
 
     array_append(l_arr, &l);
   }
-
-  /* Release the cell array */
-  free(vc);
 }
 
 static void commit_utetra(eik3_s *eik, size_t l, utetra_s const *utetra) {
   /* TODO: at some point, we may want to look into dealing with the
    * case where the new value is approximately equal to the current
    * value. This is a sign that a caustic has formed. */
-  assert(utetra_get_value(utetra) < eik->jet[l].f);
+  assert(utetra_get_value(utetra) < eik->T[l]);
 
-  utetra_get_jet31t(utetra, &eik->jet[l]);
+  jet31t jet;
+  utetra_get_jet31t(utetra, &jet);
+  eik3_set_jet(eik, l, jet);
 
   eik3_set_par(eik, l, utetra_get_parent(utetra));
 }
@@ -487,12 +728,13 @@ static bool commit_utetra_if_bracketed(eik3_s *eik, utetra_s const *utetra) {
   assert(num_interior == 0 || num_interior == 2);
 
   /* See if any cached utetra bracket `utetra` */
-  array_s *bracket = utetra_cache_pop_bracket(eik->utetra_cache, utetra);
+  size_t lhat = utetra_get_l(utetra);
+  utetra_cache_s *utetra_cache = get_worker(eik, lhat)->utetra_cache;
+  array_s const *bracket = utetra_cache_pop_bracket(utetra_cache, utetra);
   if (bracket == NULL)
     return false;
 
   /* Commit the `utetra` if there is a bracket */
-  size_t lhat = utetra_get_l(utetra);
   commit_utetra(eik, lhat, utetra);
   adjust(eik, lhat);
 
@@ -502,35 +744,62 @@ static bool commit_utetra_if_bracketed(eik3_s *eik, utetra_s const *utetra) {
     array_get(bracket, i, &utetra_bracket);
     utetra_dealloc(&utetra_bracket);
   }
-  array_deinit(bracket);
-  array_dealloc(&bracket);
 
   return true;
 }
 
+/* Take the `utetra` with target `lhat` and update indices `l` (in
+ * this order) which `step_band` solved ahead of time, if there is
+ * one. Otherwise, return `NULL`. */
+static utetra_s *pop_presolved(worker_s *worker, size_t lhat, uint3 const l) {
+  if (array_is_empty(worker->presolved))
+    return NULL;
+
+  size_t key[2] = {lhat, l[0]}, block[2];
+  if (!hmap_get(worker->presolved_block, key, block))
+    return NULL;
+
+  for (size_t i = block[0]; i < block[0] + block[1]; ++i) {
+    utetra_s **utetra = array_get_ptr(worker->presolved, i);
+    if (*utetra != NULL && utetra_has_inds(*utetra, lhat, l)) {
+      utetra_s *presolved = *utetra;
+      *utetra = NULL;
+      return presolved;
+    }
+  }
+
+  return NULL;
+}
+
 void do_utetra(eik3_s *eik, size_t lhat, uint3 const l, par3_s *par) {
-  if (utetra_cache_contains_inds(eik->utetra_cache, lhat, l))
+  worker_s *worker = get_worker(eik, lhat);
+
+  if (utetra_cache_contains_inds(worker->utetra_cache, lhat, l))
     return;
 
   if (par != NULL)
     par3_init_empty(par);
 
-  utetra_s *utetra;
-  utetra_alloc(&utetra);
-  utetra_init(utetra, eik, lhat, l);
+  /* A `utetra` solved by `step_band` has already been checked for
+   * being backwards or degenerate. */
+  utetra_s *utetra = pop_presolved(worker, lhat, l);
+  if (utetra == NULL) {
+    utetra_alloc_from_pool(&utetra, worker->pool);
+    utetra_init(utetra, eik, lhat, l);
 
-  if (utetra_is_backwards(utetra, eik))
-    goto cleanup;
+    if (utetra_is_backwards(utetra, eik))
+      goto cleanup;
 
-  if (utetra_is_degenerate(utetra))
-    goto cleanup;
+    if (utetra_is_degenerate(utetra))
+      goto cleanup;
 
-  utetra_solve(utetra, /* warm start: */ NULL);
+    utetra_solve(utetra, /* warm start: */ NULL);
+  }
 
   if (par != NULL)
     *par = utetra_get_parent(utetra);
 
-  if (utetra_get_value(utetra) >= eik->jet[lhat].f)
+  if (utetra_get_value(utetra) >= eik->T[lhat])
     goto cleanup;
 
   if (utetra_ray_is_occluded(utetra, eik))
@@ -545,7 +814,7 @@ void do_utetra(eik3_s *eik, size_t lhat, uint3 const l, par3_s *par) {
   if (commit_utetra_if_bracketed(eik, utetra))
     goto cleanup;
 
-  if (utetra_cache_try_add_unique(eik->utetra_cache, utetra))
+  if (utetra_cache_try_add_unique(worker->utetra_cache, utetra))
     return; /* don't dealloc! */
 
 cleanup:
@@ -554,19 +823,21 @@ cleanup:
 
 static void do_1pt_update(eik3_s *eik, size_t l, size_t l0) {
   uline_s *u;
-  uline_alloc(&u);
+  uline_alloc_from_pool(&u, get_worker(eik, l)->pool);
   uline_init(u, eik, l, l0);
   uline_solve(u);
 
   jet31t jet = uline_get_jet(u);
-  if (jet.f >= eik->jet[l].f)
+  uline_dealloc(&u);
+
+  if (jet.f >= eik->T[l])
     return;
 
-  eik->jet[l] = jet;
+  eik3_set_jet(eik, l, jet);
 
-  par3_init_empty(&eik->par[l]);
-  eik->par[l].l[0] = l0;
-  eik->par[l].b[0] = 1;
+  clear_par(eik, l);
+  eik->par_l[l][0] = l0;
+  eik->par_b[l][0] = 1;
 
   adjust(eik, l);
 }
@@ -578,19 +849,19 @@ static bool is_diff_edge(eik3_s const *eik, size_t const l[2]) {
 static void do_utetra_fan(eik3_s *eik, size_t lhat, size_t l0) {
   assert(lhat != l0);
 
+  worker_s *worker = get_worker(eik, lhat);
+
   /* Get the fan of `VALID` triangles incident on `l0`. */
-  array_s *le_arr;
-  array_alloc(&le_arr);
-  array_init(le_arr, sizeof(size_t[2]), ARRAY_DEFAULT_CAPACITY);
+  array_s *le_arr = worker->fan;
+  array_clear(le_arr);
   get_update_fan(eik, l0, le_arr);
 
   size_t l[3] = {l0, (size_t)NO_INDEX, (size_t)NO_INDEX};
 
   /* Array to track which vertices on the rim of the update fan are
    * incident on `VALID` diffracting edges. */
-  array_s *l_diff;
-  array_alloc(&l_diff);
-  array_init(l_diff, sizeof(size_t), ARRAY_DEFAULT_CAPACITY);
+  array_s *l_diff = worker->fan_diff_inds;
+  array_clear(l_diff);
 
   /* Do them all */
   for (size_t i = 0; i < array_size(le_arr); ++i) {
@@ -602,10 +873,10 @@ static void do_utetra_fan(eik3_s *eik, size_t lhat, size_t l0) {
 
     /* Prospectively do 1-point updates from point sources */
     for (size_t j = 1; j < 3; ++j) {
-      if (jet31t_is_point_source(&eik->jet[l[j]])) {
+      if (is_point_source(eik, l[j])) {
         assert(array_contains(eik->bc_inds, &l[j]));
         do_1pt_update(eik, lhat, l[j]);
-        goto cleanup;
+        return;
       }
     }
 
@@ -622,16 +893,8 @@ static void do_utetra_fan(eik3_s *eik, size_t lhat, size_t l0) {
   for (size_t i = 0; i < array_size(l_diff); ++i) {
     size_t l0;
     array_get(l_diff, i, &l0);
-    do_utris_if(eik, lhat, l0, eik->diff_utri_cache, is_diff_edge);
+    do_utris_if(eik, lhat, l0, worker->diff_utri_cache, is_diff_edge);
   }
-
-cleanup:
-
-  array_deinit(l_diff);
-  array_dealloc(&l_diff);
-
-  array_deinit(le_arr);
-  array_dealloc(&le_arr);
 }
 
 /* Check whether the edge indexed by `l` is:
@@ -646,8 +909,7 @@ static bool is_valid_front_bde(eik3_s const *eik, size_t const l[2]) {
     return false;
 
   size_t nvv = mesh3_nvv(mesh, l[1]);
-  size_t *vv = malloc(nvv*sizeof(size_t));
-  mesh3_vv(mesh, l[1], vv);
+  jmm_index_t const *vv = mesh3_get_vv_ptr(mesh, l[1]);
 
   bool has_trial_nb = false;
   for (size_t i = 0; i < nvv; ++i) {
@@ -659,25 +921,25 @@ static bool is_valid_front_bde(eik3_s const *eik, size_t const l[2]) {
     }
   }
 
-  free(vv);
-
   return has_trial_nb;
 }
 
 static void update(eik3_s *eik, size_t l, size_t l0) {
-  if (jet31t_is_point_source(&eik->jet[l0])) {
+  if (is_point_source(eik, l0)) {
     assert(array_contains(eik->bc_inds, &l0));
     do_1pt_update(eik, l, l0);
     return;
   }
 
+  worker_s *worker = get_worker(eik, l);
+
   bool l0_is_on_diff_edge = mesh3_vert_incident_on_diff_edge(eik->mesh, l0);
   bool l_is_on_diff_edge = mesh3_vert_incident_on_diff_edge(eik->mesh, l);
 
   /* If `l0` is incident on a diffracting edge, look for corresponding
    * two-point updates to do. Do not do any other types of updates! */
   if (l0_is_on_diff_edge && !l_is_on_diff_edge) {
-    do_utris_if(eik, l, l0, eik->diff_utri_cache, is_diff_edge);
+    do_utris_if(eik, l, l0, worker->diff_utri_cache, is_diff_edge);
   }
 
   /* Check whether l0 is a boundary vertex */
@@ -687,7 +949,7 @@ static void update(eik3_s *eik, size_t l, size_t l0) {
    * immersed in the boundary. These are updates that can yield
    * "creeping rays". */
   if (l0_is_bdv && mesh3_bdv(eik->mesh, l)) {
-    do_utris_if(eik, l, l0, eik->bd_utri_cache, is_valid_front_bde);
+    do_utris_if(eik, l, l0, worker->bd_utri_cache, is_valid_front_bde);
   }
 
   /* Finally, do the fan of tetrahedron updates. */
@@ -699,50 +961,48 @@ void update_neighbors(eik3_s *eik, size_t l0) {
 
   // Get i0's neighboring nodes.
   int nnb = mesh3_nvv(eik->mesh, l0);
-  size_t *nb = malloc(nnb*sizeof(size_t));
-  mesh3_vv(eik->mesh, l0, nb);
+  jmm_index_t const *nb = mesh3_get_vv_ptr(eik->mesh, l0);
 
-  // Set FAR nodes to TRIAL and insert them into the heap.
+  // Set FAR nodes to TRIAL and insert them into the front.
   for (int i = 0; i < nnb; ++i) {
     if (eik->state[l = nb[i]] == FAR) {
       eik->state[l] = TRIAL;
-      heap_insert(eik->heap, l);
+      front_insert(eik->front, l);
     }
   }
 
-  // Update neighboring nodes.
+  // Update neighboring nodes. Each update can commit several times,
+  // so we hold off on fixing up the front until they're all done.
+  size_t num_updated = 0;
+  size_t updated[nnb];
+  eik->defer_adjust = true;
   for (int i = 0; i < nnb; ++i) {
     if (eik->state[l = nb[i]] == TRIAL) {
       update(eik, l, l0);
-      adjust(eik, l); // TODO: we should avoid calling adjust
-                      // repeatedly here and above. Instead we should
-                      // use a flag to track which nodes actually had
-                      // their values change and then adjust before
-                      // finally returning from this function.
+      updated[num_updated++] = l;
     }
   }
+  eik->defer_adjust = false;
 
-  free(nb);
+  front_update_many(eik->front, num_updated, updated);
 }
 
 jmm_error_e eik3_step(eik3_s *eik, size_t *l0) {
-  /* Get the first node in the heap. It should be `TRIAL`. */
-  *l0 = heap_front(eik->heap);
+  /* Get the first node in the front. It should be `TRIAL`. */
+  *l0 = front_peek(eik->front);
   assert(eik->state[*l0] == TRIAL);
 
   /* If the eikonal of the newly VALID node isn't finite, something
    * bad happened. Bail. */
-  if (!isfinite(eik->jet[*l0].f))
+  if (!isfinite(eik->T[*l0]))
     return JMM_ERROR_RUNTIME_ERROR;
 
-  /* Otherwise, we pop `l0` from the heap and mark it `VALID`. */
-  heap_pop(eik->heap);
+  /* Otherwise, we pop `l0` from the front and mark it `VALID`. */
+  front_pop(eik->front);
   eik->state[*l0] = VALID;
 
   /* Purge cached updates to keep the cache size under control */
-  utetra_cache_purge(eik->utetra_cache, *l0);
-  utri_cache_purge(eik->bd_utri_cache, *l0);
-  utri_cache_purge(eik->diff_utri_cache, *l0);
+  purge(eik, *l0);
 
   update_neighbors(eik, *l0);
 
@@ -753,12 +1013,173 @@ jmm_error_e eik3_step(eik3_s *eik, size_t *l0) {
   return JMM_ERROR_NONE;
 }
 
+/* Solve the tetrahedron updates from the nodes in `band` which
+ * target the nodes belonging to worker `i`, in the order
+ * `update_neighbors` will ask for them, and store them in the
+ * worker's `presolved` array (see `pop_presolved`). The states
+ * should be set as if every node in `band` had been accepted. */
+static void presolve_band_updates(eik3_s *eik, size_t i, size_t n,
+                                  size_t const *band) {
+  worker_s *worker = &eik->worker[i];
+
+  for (size_t j = 0; j < n; ++j) {
+    size_t l0 = band[j];
+
+    /* Updates from point sources are cheap 1-point updates */
+    if (is_point_source(eik, l0))
+      continue;
+
+    array_clear(worker->fan);
+    get_update_fan(eik, l0, worker->fan);
+
+    size_t nnb = mesh3_nvv(eik->mesh, l0);
+    jmm_index_t const *nb = mesh3_get_vv_ptr(eik->mesh, l0);
+
+    for (size_t k = 0; k < nnb; ++k) {
+      size_t lhat = nb[k];
+      if (lhat % eik->num_workers != i || eik->state[lhat] != TRIAL)
+        continue;
+
+      size_t key[2] = {lhat, l0}, block[2] = {array_size(worker->presolved), 0};
+
+      /* Go through the fan the same way `do_utetra_fan` does */
+      size_t l[3] = {l0, (size_t)NO_INDEX, (size_t)NO_INDEX};
+      for (size_t m = 0; m < array_size(worker->fan); ++m) {
+        array_get(worker->fan, m, &l[1]);
+
+        if (lhat == l[1] || lhat == l[2])
+          continue;
+
+        if (is_point_source(eik, l[1]) || is_point_source(eik, l[2]))
+          break;
+
+        utetra_s *utetra;
+        utetra_alloc_from_pool(&utetra, worker->pool);
+        utetra_init(utetra, eik, lhat, l);
+
+        if (utetra_is_backwards(utetra, eik) || utetra_is_degenerate(utetra)) {
+          utetra_dealloc(&utetra);
+          continue;
+        }
+
+        utetra_solve(utetra, /* warm start: */ NULL);
+
+        array_append(worker->presolved, &utetra);
+        ++block[1];
+      }
+
+      hmap_insert(worker->presolved_block, key, block);
+    }
+  }
+}
+
+/* Check whether `l` is a neighbor of one of the `n` nodes in `band` */
+static bool is_adjacent_to_band(eik3_s const *eik, size_t l, size_t n,
+                                size_t const *band) {
+  size_t nnb = mesh3_nvv(eik->mesh, l);
+  jmm_index_t const *nb = mesh3_get_vv_ptr(eik->mesh, l);
+  for (size_t i = 0; i < n; ++i)
+    for (size_t j = 0; j < nnb; ++j)
+      if (nb[j] == band[i])
+        return true;
+  return false;
+}
+
+/* Like `eik3_step`, but accept a band of nodes, computing most of
+ * their updates in parallel, with exactly the same result as calling
+ * `eik3_step` serially.
+ *
+ * We guess that the next nodes to be accepted are the first ones in
+ * the front whose values are within `eik->band` of the smallest one,
+ * stopping before the first node neighboring one we've already
+ * picked. No node in the band updates another one, so their values
+ * are final, and the tetrahedron updates from them only depend on
+ * the jets of `VALID` nodes. So we can solve these updates in
+ * parallel ahead of time. Each worker solves the updates targeting
+ * its own nodes.
+ *
+ * We then call `eik3_step` for each node in the band, which uses the
+ * presolved updates instead of solving them again, and does
+ * everything else (the cached updates, the front, etc.) exactly as
+ * it would serially. If the front's next node isn't the one we
+ * guessed (because an update just lowered a node past it), we stop
+ * there and throw away the rest of the updates. */
+static jmm_error_e step_band(eik3_s *eik) {
+  size_t l0 = front_peek(eik->front);
+  assert(eik->state[l0] == TRIAL);
+
+  if (!isfinite(eik->T[l0]))
+    return JMM_ERROR_RUNTIME_ERROR;
+
+  size_t max_band_size = EIK3_MAX_BAND_SIZE_PER_THREAD*eik->num_workers;
+  size_t band[max_band_size];
+  size_t num_peeked = front_peek_many(eik->front, max_band_size, band);
+
+  /* Since `eik->band` is positive (see `eik3_set_num_threads`), this
+   * always picks at least the first node. */
+  dbl T_max = eik->T[l0] + eik->band;
+  size_t n = 0, num_nb = 0;
+  while (n < num_peeked && eik->T[band[n]] < T_max
+         && !is_adjacent_to_band(eik, band[n], n, band))
+    num_nb += mesh3_nvv(eik->mesh, band[n++]);
+
+  /* Set the states as if the band had been accepted, keeping track
+   * of the `FAR` nodes we made `TRIAL`... */
+  size_t far[num_nb], num_far = 0;
+  for (size_t i = 0; i < n; ++i) {
+    eik->state[band[i]] = VALID;
+    size_t nnb = mesh3_nvv(eik->mesh, band[i]);
+    jmm_index_t const *nb = mesh3_get_vv_ptr(eik->mesh, band[i]);
+    for (size_t j = 0; j < nnb; ++j) {
+      if (eik->state[nb[j]] == FAR) {
+        eik->state[nb[j]] = TRIAL;
+        far[num_far++] = nb[j];
+      }
+    }
+  }
+
+#pragma omp parallel for schedule(static, 1) num_threads(eik->num_workers)
+  for (size_t i = 0; i < eik->num_workers; ++i)
+    presolve_band_updates(eik, i, n, band);
+
+  /* ... and put them back */
+  for (size_t i = 0; i < n; ++i)
+    eik->state[band[i]] = TRIAL;
+  for (size_t i = 0; i < num_far; ++i)
+    eik->state[far[i]] = FAR;
+
+  jmm_error_e error = JMM_ERROR_NONE;
+  for (size_t i = 0; i < n; ++i) {
+    if (front_peek(eik->front) != band[i])
+      break;
+    error = eik3_step(eik, &l0);
+    if (error != JMM_ERROR_NONE)
+      break;
+  }
+
+  /* Release the updates we didn't use */
+  for (size_t i = 0; i < eik->num_workers; ++i) {
+    worker_s *worker = &eik->worker[i];
+    for (size_t j = 0; j < array_size(worker->presolved); ++j) {
+      utetra_s **utetra = array_get_ptr(worker->presolved, j);
+      if (*utetra != NULL)
+        utetra_dealloc(utetra);
+    }
+    array_clear(worker->presolved);
+    hmap_clear(worker->presolved_block);
+  }
+
+  return error;
+}
+
 jmm_error_e eik3_solve(eik3_s *eik) {
-  jmm_error_e error;
+  jmm_error_e error = JMM_ERROR_NONE;
   size_t l0;
-  while (heap_size(eik->heap) > 0)
-    if ((error = eik3_step(eik, &l0)) != JMM_ERROR_NONE)
+  while (front_size(eik->front) > 0) {
+    error = eik->num_workers > 1 ? step_band(eik) : eik3_step(eik, &l0);
+    if (error != JMM_ERROR_NONE)
       break;
+  }
   return error;
 }
 
@@ -780,26 +1201,25 @@ bool eik3_brute_force_remaining(eik3_s *eik) {
     array_pop_front(queue, &l);
 
     size_t nvf = mesh3_nvf(eik->mesh, l);
-    uint3 *vf = malloc(nvf*sizeof(uint3));
-    mesh3_vf(eik->mesh, l, vf);
+    index3 const *vf = mesh3_get_vf_ptr(eik->mesh, l);
 
-    utetra_cache_purge(eik->utetra_cache, l);
+    utetra_cache_purge(get_worker(eik, l)->utetra_cache, l);
 
-    for (size_t i = 0; i < nvf; ++i)
-      if (eik->state[vf[i][0]] == VALID &&
-          eik->state[vf[i][1]] == VALID &&
-          eik->state[vf[i][2]] == VALID)
-        do_utetra(eik, l, vf[i], /* par: */ NULL);
+    for (size_t i = 0; i < nvf; ++i) {
+      size_t lf[3] = {vf[i][0], vf[i][1], vf[i][2]};
+      if (eik->state[lf[0]] == VALID &&
+          eik->state[lf[1]] == VALID &&
+          eik->state[lf[2]] == VALID)
+        do_utetra(eik, l, lf, /* par: */ NULL);
+    }
 
-    if (isfinite(eik->jet[l].f)) {
+    if (isfinite(eik->T[l])) {
       eik->state[l] = VALID;
       eik->accepted[eik->num_accepted++] = l;
     } else {
       array_append(queue, &l);
     }
 
-    free(vf);
-
     if (++it == max_num_iter)
       break;
   }
@@ -815,15 +1235,27 @@ bool eik3_is_solved(eik3_s const *eik) {
 }
 
 static void unaccept_nodes(eik3_s *eik, array_s const *l_arr) {
+  bitset_s *unaccept;
+  bitset_alloc(&unaccept);
+  bitset_init(unaccept, mesh3_nverts(eik->mesh));
+  for (size_t i = 0, l; i < array_size(l_arr); ++i) {
+    array_get(l_arr, i, &l);
+    bitset_set(unaccept, l);
+  }
+
   size_t j = 0;
   for (size_t i = 0; i < eik->num_accepted; ++i) {
-    if (array_contains(l_arr, &eik->accepted[i]))
+    size_t l = eik->accepted[i];
+    if (bitset_get(unaccept, l))
       continue;
-    eik->accepted[j++] = eik->accepted[i];
+    eik->accepted[j++] = l;
   }
   for (; j < eik->num_accepted; ++j)
-    eik->accepted[j] = (size_t)NO_INDEX;
+    eik->accepted[j] = (jmm_index_t)NO_INDEX;
   eik->num_accepted -= array_size(l_arr);
+
+  bitset_deinit(unaccept);
+  bitset_dealloc(&unaccept);
 }
 
 static void reset_nodes(eik3_s *eik, array_s const *l_arr) {
@@ -831,13 +1263,11 @@ static void reset_nodes(eik3_s *eik, array_s const *l_arr) {
     array_get(l_arr, i, &l);
     assert(eik->state[l] == VALID);
 
-    eik->jet[l] = jet31t_make_empty();
+    eik3_set_jet(eik, l, jet31t_make_empty());
     eik->state[l] = FAR;
-    par3_init_empty(&eik->par[l]);
+    clear_par(eik, l);
 
-    utetra_cache_purge(eik->utetra_cache, l);
-    utri_cache_purge(eik->bd_utri_cache, l);
-    utri_cache_purge(eik->diff_utri_cache, l);
+    purge(eik, l);
   }
 
   unaccept_nodes(eik, l_arr);
@@ -848,26 +1278,32 @@ static void fix_valid_front(eik3_s *eik) {
   array_alloc(&l_arr);
   array_init(l_arr, sizeof(size_t), ARRAY_DEFAULT_CAPACITY);
 
+  bitset_s *in_arr;
+  bitset_alloc(&in_arr);
+  bitset_init(in_arr, mesh3_nverts(eik->mesh));
+
   for (size_t l = 0; l < mesh3_nverts(eik->mesh); ++l) {
     if (eik->state[l] != FAR)
       continue;
 
     size_t nvv = mesh3_nvv(eik->mesh, l);
-    size_t *vv = malloc(nvv*sizeof(size_t));
-    mesh3_vv(eik->mesh, l, vv);
-
-    for (size_t i = 0; i < nvv; ++i)
-      if (eik->state[vv[i]] == VALID && !array_contains(l_arr, &vv[i]))
-        array_append(l_arr, &vv[i]);
+    jmm_index_t const *vv = mesh3_get_vv_ptr(eik->mesh, l);
 
-    free(vv);
+    for (size_t i = 0, l_nb; i < nvv; ++i) {
+      l_nb = vv[i];
+      if (eik->state[l_nb] == VALID && !bitset_test_and_set(in_arr, l_nb))
+        array_append(l_arr, &l_nb);
+    }
   }
 
-  /* Reinsert these nodes into the heap */
+  bitset_deinit(in_arr);
+  bitset_dealloc(&in_arr);
+
+  /* Reinsert these nodes into the front */
   for (size_t i = 0, l; i < array_size(l_arr); ++i) {
     array_get(l_arr, i, &l);
     eik->state[l] = TRIAL;
-    heap_insert(eik->heap, l);
+    front_insert(eik->front, l);
   }
 
   unaccept_nodes(eik, l_arr);
@@ -884,7 +1320,7 @@ static void fix_accepted(eik3_s *eik) {
    * this, but not a high priority... just shift all nodes w/o an
    * accepted value to the end of array first */
   for (size_t l = 0; l < nverts; ++l)
-    assert(l_OK(eik->accepted[l]));
+    assert(eik->accepted[l] != (jmm_index_t)NO_INDEX);
 
   /* Go through and count the children of each node.
    *
@@ -893,7 +1329,7 @@ static void fix_accepted(eik3_s *eik) {
   size_t *num_ch = calloc(nverts, sizeof(size_t));
   for (size_t l_ch = 0; l_ch < nverts; ++l_ch) {
     uint3 l;
-    size_t n = par3_get_active_inds(&eik->par[l_ch], l);
+    size_t n = get_active_par_inds(eik, l_ch, l);
     for (size_t i = 0; i < n; ++i)
       ++num_ch[l[i]];
   }
@@ -917,7 +1353,7 @@ static void fix_accepted(eik3_s *eik) {
   size_t *ch = malloc(ch_offset[nverts]*sizeof(size_t));
   for (size_t l_ch = 0; l_ch < nverts; ++l_ch) {
     uint3 l;
-    size_t n = par3_get_active_inds(&eik->par[l_ch], l);
+    size_t n = get_active_par_inds(eik, l_ch, l);
     for (size_t i = 0; i < n; ++i)
       ch[ch_offset[l[i]] + num_ch[l[i]]++] = l_ch;
 
@@ -944,7 +1380,7 @@ static void fix_accepted(eik3_s *eik) {
    * which also have BCs. We also mark these nodes as `TRIAL` so we
    * can quickly determine whether or not they've been queued. */
   for (size_t l = 0; l < nverts; ++l) {
-    if (par3_is_empty(&eik->par[l]) && array_contains(eik->bc_inds, &l)) {
+    if (!eik3_has_par(eik, l) && array_contains(eik->bc_inds, &l)) {
       array_append(queue, &l);
       marked[l] = TRIAL;
     }
@@ -964,7 +1400,7 @@ static void fix_accepted(eik3_s *eik) {
     /* Make sure each of the newly marked node's parents have already
      * been visited */
     uint3 la;
-    size_t na = par3_get_active_inds(&eik->par[l], la);
+    size_t na = get_active_par_inds(eik, l, la);
     for (size_t i = 0; i < na; ++i)
       assert(marked[la[i]] == VALID);
 
@@ -1022,15 +1458,20 @@ void eik3_resolve_downwind_from_diff(eik3_s *eik, size_t diff_index, dbl rfac) {
   size_t (*le)[2] = malloc(diff_size*sizeof(size_t[2]));
   mesh3_get_diffractor(mesh, diff_index, le);
 
-  /* Array of unique diffractor node indices */
+  /* Array of unique diffractor node indices, and a bitset for
+   * quickly checking whether a node is on the diffractor */
   array_s *l_diff;
   array_alloc(&l_diff);
   array_init(l_diff, sizeof(size_t), ARRAY_DEFAULT_CAPACITY);
 
-  /* ... fill it */
+  bitset_s *is_diff;
+  bitset_alloc(&is_diff);
+  bitset_init(is_diff, mesh3_nverts(mesh));
+
+  /* ... fill them */
   for (size_t i = 0; i < diff_size; ++i)
     for (size_t j = 0; j < 2; ++j)
-      if (!array_contains(l_diff, &le[i][j]))
+      if (!bitset_test_and_set(is_diff, le[i][j]))
         array_append(l_diff, &le[i][j]);
 
   /* Free the diffractor edges */
@@ -1050,47 +1491,53 @@ void eik3_resolve_downwind_from_diff(eik3_s *eik, size_t diff_index, dbl rfac) {
   eik3_init_org_from_BCs(eik, org);
   eik3_prop_org(eik, org);
 
-  /* Array used to accumulate indices of nodes to be reset */
+  /* Array used to accumulate indices of nodes to be reset, along
+   * with the corresponding bitset */
   array_s *l_reset;
   array_alloc(&l_reset);
   array_init(l_reset, sizeof(size_t), ARRAY_DEFAULT_CAPACITY);
 
+  bitset_s *is_reset;
+  bitset_alloc(&is_reset);
+  bitset_init(is_reset, mesh3_nverts(mesh));
+
   /* Use a BFS to find each of the nodes downwind from the diffracting
    * edge which should be reset. */
   while (!array_is_empty(l_queue)) {
     size_t l;
     array_pop_front(l_queue, &l);
-    if (array_contains(l_reset, &l))
+    if (bitset_get(is_reset, l))
       continue;
 
-    if (!array_contains(l_diff, &l))
+    if (!bitset_get(is_diff, l)) {
       array_append(l_reset, &l);
+      bitset_set(is_reset, l);
+    }
 
     /* Get the neighbors of the current node */
     size_t nvv = mesh3_nvv(mesh, l);
-    size_t *vv = malloc(nvv*sizeof(size_t));
-    mesh3_vv(mesh, l, vv);
+    jmm_index_t const *vv = mesh3_get_vv_ptr(mesh, l);
 
     /* For each neighbor... */
     for (size_t j = 0; j < nvv; ++j) {
+      size_t l_nb = vv[j];
+
       /* ... skip this node if its origin is too big or if we're
        * already resetting it. */
-      if (org[vv[j]] >= 0.5 || array_contains(l_reset, &vv[j]))
+      if (org[l_nb] >= 0.5 || bitset_get(is_reset, l_nb))
         continue;
 
       /* Get the active parent indices of the current node. */
       size_t la[3];
-      size_t na = par3_get_active_inds(&eik->par[vv[j]], la);
+      size_t na = get_active_par_inds(eik, l_nb, la);
 
       for (size_t k = 0; k < na; ++k) {
-        if (array_contains(l_diff, &la[k]) || array_contains(l_reset, &la[k])) {
-          array_append(l_queue, &vv[j]);
+        if (bitset_get(is_diff, la[k]) || bitset_get(is_reset, la[k])) {
+          array_append(l_queue, &l_nb);
           break;
         }
       }
     }
-
-    free(vv);
   }
 
   reset_nodes(eik, l_reset);
@@ -1104,6 +1551,9 @@ void eik3_resolve_downwind_from_diff(eik3_s *eik, size_t diff_index, dbl rfac) {
 
   /** Cleanup */
 
+  bitset_deinit(is_reset);
+  bitset_dealloc(&is_reset);
+
   array_deinit(l_reset);
   array_dealloc(&l_reset);
 
@@ -1112,10 +1562,106 @@ void eik3_resolve_downwind_from_diff(eik3_s *eik, size_t diff_index, dbl rfac) {
   array_deinit(l_queue);
   array_dealloc(&l_queue);
 
+  bitset_deinit(is_diff);
+  bitset_dealloc(&is_diff);
+
   array_deinit(l_diff);
   array_dealloc(&l_diff);
 }
 
+/* Return a lower bound for the slowness over the whole domain, or
+ * `NAN` if we don't have one. For `STYPE_FUNC_PTR`, the slowness can
+ * only be sampled, which doesn't bound it. */
+static dbl get_min_slowness(eik3_s const *eik) {
+  return eik->sfunc->stype == STYPE_CONSTANT ? 1 : NAN;
+}
+
+/* Solve using `num_threads` threads. Updates are assigned to threads
+ * by their target node and each thread keeps its own cache of old
+ * updates, so this needs to be called before any boundary conditions
+ * are added.
+ *
+ * If `num_threads > 1`, `eik3_solve` tries to accept the `TRIAL`
+ * nodes whose values are within a band of the smallest one at once
+ * (like in Dial's algorithm or delta-stepping), solving their
+ * updates in parallel. The nodes are still accepted one at a time in
+ * the same order as a serial solve, and the solution is exactly the
+ * same (see `step_band`). The band only limits how far ahead we
+ * guess: its width is the smallest tetrahedron altitude times a
+ * lower bound for the slowness.
+ *
+ * We only have a lower bound for the slowness for `STYPE_CONSTANT`.
+ * For other slownesses, a single thread is used and
+ * `JMM_ERROR_BAD_ARGUMENTS` is returned. */
+jmm_error_e eik3_set_num_threads(eik3_s *eik, size_t num_threads) {
+  assert(num_threads > 0);
+  assert(front_size(eik->front) == 0);
+  assert(eik->num_accepted == 0);
+
+  jmm_error_e error = JMM_ERROR_NONE;
+
+  dbl band = mesh3_get_min_tetra_alt(eik->mesh)*get_min_slowness(eik);
+  if (num_threads > 1 && !(isfinite(band) && band > 0)) {
+    num_threads = 1;
+    error = JMM_ERROR_BAD_ARGUMENTS;
+  }
+
+  for (size_t i = 0; i < eik->num_workers; ++i)
+    worker_deinit(&eik->worker[i]);
+
+  eik->num_workers = num_threads;
+  eik->worker = realloc(eik->worker, num_threads*sizeof(worker_s));
+  for (size_t i = 0; i < eik->num_workers; ++i)
+    worker_init(&eik->worker[i]);
+
+  eik->band = num_threads == 1 ? NAN : band;
+
+  return error;
+}
+
+size_t eik3_get_num_threads(eik3_s const *eik) {
+  return eik->num_workers;
+}
+
+/* Choose the queue used for the front of `TRIAL` nodes (see
+ * `front.h`). Like `eik3_set_num_threads`, this needs to be called
+ * before any boundary conditions are added.
+ *
+ * For `FRONT_TYPE_BUCKET`, the width of the buckets is the length of
+ * the shortest edge in the mesh times the smallest slowness, which
+ * is roughly the smallest amount by which an update can increase T
+ * (it's exactly that for Dial's algorithm on the mesh's edge
+ * graph). Nodes within a bucket are accepted in the order they were
+ * added, so the error this introduces is on the order of the bucket
+ * width. If we don't have a lower bound for the slowness (see
+ * `get_min_slowness`), a heap is used instead and
+ * `JMM_ERROR_BAD_ARGUMENTS` is returned. */
+jmm_error_e eik3_set_front_type(eik3_s *eik, front_type_e type) {
+  assert(front_size(eik->front) == 0);
+  assert(eik->num_accepted == 0);
+
+  jmm_error_e error = JMM_ERROR_NONE;
+
+  dbl width = NAN;
+  if (type == FRONT_TYPE_BUCKET) {
+    width = mesh3_get_min_edge_length(eik->mesh)*get_min_slowness(eik);
+    if (!(isfinite(width) && width > 0)) {
+      type = FRONT_TYPE_HEAP;
+      error = JMM_ERROR_BAD_ARGUMENTS;
+    }
+  }
+
+  front_deinit(eik->front);
+  front_init(eik->front, type, mesh3_nverts(eik->mesh), width, value,
+             (void *)eik);
+
+  return error;
+}
+
+front_s const *eik3_get_front(eik3_s const *eik) {
+  return eik->front;
+}
+
 stype_e eik3_get_stype(eik3_s const *eik) {
   return eik->sfunc->stype;
 }
@@ -1130,17 +1676,17 @@ void eik3_add_trial(eik3_s *eik, size_t l, jet31t jet) {
     return;
   }
 
-  if (isfinite(eik->jet[l].f)) {
+  if (isfinite(eik->T[l])) {
     log_warn("failed to add TRIAL node %lu (finite jet)", l);
     return;
   }
 
-  assert(eik->pos[l] == NO_INDEX);
+  assert(!front_contains(eik->front, l));
   assert(eik->state[l] == FAR);
 
-  eik->jet[l] = jet;
+  eik3_set_jet(eik, l, jet);
   eik->state[l] = TRIAL;
-  heap_insert(eik->heap, l);
+  front_insert(eik->front, l);
 
   array_append(eik->trial_inds, &l);
 }
@@ -1159,7 +1705,7 @@ size_t eik3_num_valid(eik3_s const *eik) {
 void eik3_add_bc(eik3_s *eik, size_t l, jet31t jet) {
   assert(!array_contains(eik->bc_inds, &l));
 
-  eik->jet[l] = jet;
+  eik3_set_jet(eik, l, jet);
   eik->state[l] = VALID;
   eik->accepted[eik->num_accepted++] = l;
 
@@ -1168,8 +1714,7 @@ void eik3_add_bc(eik3_s *eik, size_t l, jet31t jet) {
 
 static bool has_nb_with_state(eik3_s const *eik, size_t l, state_e state) {
   size_t nvv = mesh3_nvv(eik->mesh, l);
-  size_t *vv = malloc(nvv*sizeof(size_t));
-  mesh3_vv(eik->mesh, l, vv);
+  jmm_index_t const *vv = mesh3_get_vv_ptr(eik->mesh, l);
 
   bool has_nb = false;
 
@@ -1180,8 +1725,6 @@ static bool has_nb_with_state(eik3_s const *eik, size_t l, state_e state) {
     }
   }
 
-  free(vv);
-
   return has_nb;
 }
 
@@ -1190,9 +1733,9 @@ static void freeze_bc_layer(eik3_s *eik) {
   array_alloc(&l_arr);
   array_init(l_arr, sizeof(size_t), ARRAY_DEFAULT_CAPACITY);
 
-  while (heap_size(eik->heap) > 0) {
-    size_t l = heap_front(eik->heap);
-    heap_pop(eik->heap);
+  while (front_size(eik->front) > 0) {
+    size_t l = front_peek(eik->front);
+    front_pop(eik->front);
     array_append(l_arr, &l);
   }
 
@@ -1200,7 +1743,7 @@ static void freeze_bc_layer(eik3_s *eik) {
     array_get(l_arr, i, &l);
 
     if (has_nb_with_state(eik, l, FAR)) {
-      heap_insert(eik->heap, l);
+      front_insert(eik->front, l);
       continue;
     }
 
@@ -1230,37 +1773,50 @@ void eik3_add_pt_src_bcs(eik3_s *eik, dbl3 const xsrc, dbl rfac) {
   array_alloc(&queue);
   array_init(queue, sizeof(size_t), ARRAY_DEFAULT_CAPACITY);
 
+  /* Nodes which have been put into `queue`, so that each one is only
+   * visited once */
+  bitset_s *queued;
+  bitset_alloc(&queued);
+  bitset_init(queued, mesh3_nverts(mesh));
+
   /* Put `xsrc` into `queue` initially. */
   array_append(queue, &lsrc);
+  bitset_set(queued, lsrc);
 
   /* Main BFS loop: */
   while (!array_is_empty(queue)) {
     size_t l;
     array_pop_front(queue, &l);
 
-    /* Set the node to trial and insert it into the heap */
+    /* Set the node to trial and insert it into the front */
     if (eik3_is_far(eik, l))
       eik3_add_trial(eik, l, jet31t_make_empty());
 
     /* Do one-point updates from `xsrc`. */
     if (l != lsrc)
       do_1pt_update(eik, l, lsrc);
-    assert(isfinite(eik->jet[l].f));
+    assert(isfinite(eik->T[l]));
 
     /* Check if we're in the factoring ball... */
-    if (eik->jet[l].f > rfac)
+    if (eik->T[l] > rfac)
       continue;
 
     /* ... if we are, then add this node's neighbors to the queue. */
     size_t nvv = mesh3_nvv(mesh, l);
-    size_t *vv = malloc(nvv*sizeof(size_t));
-    mesh3_vv(mesh, l, vv);
-    for (size_t i = 0; i < nvv; ++i)
-      if (vv[i] != lsrc && isinf(eik->jet[vv[i]].f))
-        array_append(queue, &vv[i]);
-    free(vv);
+    jmm_index_t const *vv = mesh3_get_vv_ptr(mesh, l);
+    for (size_t i = 0, l_nb; i < nvv; ++i) {
+      l_nb = vv[i];
+      if (isinf(eik->T[l_nb]) && !bitset_test_and_set(queued, l_nb))
+        array_append(queue, &l_nb);
+    }
   }
 
+  bitset_deinit(queued);
+  bitset_dealloc(&queued);
+
+  array_deinit(queue);
+  array_dealloc(&queue);
+
   freeze_bc_layer(eik);
 
   /* Make sure we added some boundary data: */
@@ -1269,11 +1825,12 @@ void eik3_add_pt_src_bcs(eik3_s *eik, dbl3 const xsrc, dbl rfac) {
 }
 
 /* Store the cubic polynomial `T` approximating the eikonal over this
- * diffracting edge. */
+ * diffracting edge. If one was already stored for this edge, it's
+ * kept. */
 static void store_diff_bc_T(eik3_s *eik, size_t const le[2], bb31 const *T) {
   size_t key[2] = {le[0], le[1]};
   SORT2(key[0], key[1]);
-  alist_append(eik->T_diff, key, T);
+  hmap_insert(eik->T_diff, key, T);
 }
 
 static void add_diff_bc_for_edge_from_bb31(eik3_s *eik, size_t const le[2],
@@ -1295,28 +1852,28 @@ static void add_diff_bc_for_edge_from_bb31(eik3_s *eik, size_t const le[2],
 bool eik3_has_diff_bc(eik3_s const *eik, size_t const le[2]) {
   size_t key[2] = {le[0], le[1]};
   SORT2(key[0], key[1]);
-  return alist_contains(eik->T_diff, key);
+  return hmap_contains(eik->T_diff, key);
 }
 
 void eik3_get_diff_bc(eik3_s const *eik, size_t const le[2], bb31 *T) {
   size_t key[2] = {le[0], le[1]};
   SORT2(key[0], key[1]);
-  alist_get_by_key(eik->T_diff, key, T);
+  hmap_get(eik->T_diff, key, T);
 }
 
 static dbl get_par_eik_value(eik3_s const *eik, size_t l) {
-  par3_s const *par = &eik->par[l];
+  if (!eik3_has_par(eik, l))
+    return eik->T[l];
 
-  if (par3_is_empty(par))
-    return eik->jet[l].f;
+  par3_s par = eik3_get_par(eik, l);
 
   size_t la[3];
   dbl3 ba;
-  size_t na = par3_get_active(par, la, ba);
+  size_t na = par3_get_active(&par, la, ba);
 
   dbl T = 0;
   for (size_t i = 0; i < na; ++i)
-    T += ba[i]*eik->jet[la[i]].f;
+    T += ba[i]*eik->T[la[i]];
 
   return T;
 }
@@ -1344,7 +1901,10 @@ static void add_diff_bcs_for_diffractor(eik3_s *eik, eik3_s const *eik_in,
   mesh3_get_diffractor(mesh, diff_index, le);
 
   for (size_t i = 0; i < num_diff_edges; ++i) {
-    jet31t jet[2] = {eik_in->jet[le[i][0]], eik_in->jet[le[i][1]]};
+    jet31t jet[2] = {
+      eik3_get_jet(eik_in, le[i][0]),
+      eik3_get_jet(eik_in, le[i][1])
+    };
 
     dbl3 x[2];
     mesh3_copy_vert(mesh, le[i][0], x[0]);
@@ -1387,7 +1947,7 @@ static size_t add_next_edge_to_queue(eik3_s *eik, mesh1_s const *diff_mesh,
       continue;
 
     if (array_contains(queue, &ev) ||
-        utri_cache_contains_inds(eik->diff_utri_cache, lhat, ev))
+        utri_cache_contains_inds(get_worker(eik, lhat)->diff_utri_cache, lhat, ev))
       continue;
 
     array_append(queue, &ev);
@@ -1411,18 +1971,19 @@ static void do_diffractor_updates(eik3_s *eik, mesh1_s const *diff_mesh,
   SORT2(le[0], le[1]);
   array_append(queue, &le);
 
-  while (isinf(eik->jet[l].f)) {
+  while (isinf(eik->T[l])) {
     assert(!array_is_empty(queue));
     array_pop_front(queue, &le);
 
     par3_s par;
 
     /* Do the current triangle update */
-    assert(!utri_cache_contains_inds(eik->diff_utri_cache, l, le));
-    do_utri(eik, l, le[0], le[1], eik->diff_utri_cache, &par);
+    utri_cache_s *diff_utri_cache = get_worker(eik, l)->diff_utri_cache;
+    assert(!utri_cache_contains_inds(diff_utri_cache, l, le));
+    do_utri(eik, l, le[0], le[1], diff_utri_cache, &par);
 
     /* If we managed to update `l`, break early */
-    if (isfinite(eik->jet[l].f))
+    if (isfinite(eik->T[l]))
       break;
 
     /* TODO: for now... */
@@ -1506,7 +2067,7 @@ void eik3_add_diff_bcs(eik3_s *eik, eik3_s const *eik_in, size_t diff_index, dbl
     size_t l = update_inds.lhat, *le = &update_inds.l[0];
 
     /* If `l` isn't one of the initial points on the diffractor, set
-     * the node to trial, insert it into the heap, and do updates from
+     * the node to trial, insert it into the front, and do updates from
      * the reflector, using `le` as a warm start. */
     if (OK_edge_inds(le) && eik3_is_far(eik, l)) {
       eik3_add_trial(eik, l, jet31t_make_empty());
@@ -1514,7 +2075,7 @@ void eik3_add_diff_bcs(eik3_s *eik, eik3_s const *eik_in, size_t diff_index, dbl
     }
 
     /* Check if we're in the "factoring tube"... */
-    if (eik->jet[l].f - get_par_eik_value(eik, l) > rfac)
+    if (eik->T[l] - get_par_eik_value(eik, l) > rfac)
       continue;
 
     /* ... if we are, then add this node's neighbors to the queue,
@@ -1522,12 +2083,11 @@ void eik3_add_diff_bcs(eik3_s *eik, eik3_s const *eik_in, size_t diff_index, dbl
      * updates for each added node. */
 
     size_t nvv = mesh3_nvv(mesh, l);
-    size_t *vv = malloc(nvv*sizeof(size_t));
-    mesh3_vv(mesh, l, vv);
+    jmm_index_t const *vv = mesh3_get_vv_ptr(mesh, l);
 
     for (size_t i = 0; i < nvv; ++i) {
       /* Skip this node if we've already updated it */
-      if (isfinite(eik->jet[vv[i]].f))
+      if (isfinite(eik->T[vv[i]]))
         continue;
 
       /* Get the update indices for the child and append it to the
@@ -1537,8 +2097,6 @@ void eik3_add_diff_bcs(eik3_s *eik, eik3_s const *eik_in, size_t diff_index, dbl
       if (!array_contains(queue, &child_update_inds))
         array_append(queue, &child_update_inds);
     }
-
-    free(vv);
   }
 
   freeze_bc_layer(eik);
@@ -1558,7 +2116,7 @@ static bool add_face_to_queue(eik3_s const *eik, mesh2_s const *refl_mesh,
   mesh2_fv(refl_mesh, lf, l);
   SORT3(l[0], l[1], l[2]);
 
-  if (array_contains(queue, &l) || utetra_cache_contains_inds(eik->utetra_cache, lhat, l))
+  if (array_contains(queue, &l) || utetra_cache_contains_inds(get_worker(eik, lhat)->utetra_cache, lhat, l))
     return false;
 
   array_append(queue, &l);
@@ -1609,9 +2167,9 @@ static void do_utri_and_add_inc(eik3_s *eik, mesh2_s const *refl_mesh,
   assert(mesh3_is_diff_edge(mesh, l));
 
   par3_s par;
-  do_utri(eik, lhat, l[0], l[1], eik->diff_utri_cache, &par);
+  do_utri(eik, lhat, l[0], l[1], get_worker(eik, lhat)->diff_utri_cache, &par);
   assert(!par3_is_empty(&par));
-  if (isfinite(eik->jet[lhat].f))
+  if (isfinite(eik->T[lhat]))
     return;
 
   size_t la[3];
@@ -1627,7 +2185,7 @@ static void do_utri_and_add_inc(eik3_s *eik, mesh2_s const *refl_mesh,
     mesh2_fv(refl_mesh, vf[i], fv);
     SORT_UINT3(fv);
     if (!array_contains(queue, &fv) &&
-        !utetra_cache_contains_inds(eik->utetra_cache, lhat, fv))
+        !utetra_cache_contains_inds(get_worker(eik, lhat)->utetra_cache, lhat, fv))
       array_append(queue, &fv);
   }
 
@@ -1641,7 +2199,7 @@ static void do_utri_and_add_inc(eik3_s *eik, mesh2_s const *refl_mesh,
         continue;
       if (mesh3_is_diff_edge(mesh, ve_)
           && !array_contains(queue, &ve_)
-          && !utri_cache_contains_inds(eik->diff_utri_cache, lhat, ve_))
+          && !utri_cache_contains_inds(get_worker(eik, lhat)->diff_utri_cache, lhat, ve_))
         array_append(queue, &ve_);
     }
   }
@@ -1660,7 +2218,7 @@ static void add_diff_utri_inc_on_utetra(eik3_s *eik, size_t lhat,
       uint3 le = {le_diff[j][0], le_diff[j][1], (size_t)NO_INDEX};
       SORT_UINT2(le);
       if (!array_contains(queue, &le)
-          && !utri_cache_contains_inds(eik->diff_utri_cache, lhat, le))
+          && !utri_cache_contains_inds(get_worker(eik, lhat)->diff_utri_cache, lhat, le))
         array_append(queue, &le);
     }
     free(le_diff);
@@ -1674,7 +2232,7 @@ static void do_utetra_and_add_inc(eik3_s *eik, mesh2_s const *refl_mesh,
   if (par3_is_empty(&par)) {
     add_diff_utri_inc_on_utetra(eik, lhat, l, queue);
     return;
-  } else if (isfinite(eik->jet[lhat].f))
+  } else if (isfinite(eik->T[lhat]))
     return;
 
   size_t la[3];
@@ -1695,7 +2253,7 @@ static void do_utetra_and_add_inc(eik3_s *eik, mesh2_s const *refl_mesh,
   if (num_added == 0 && na == 2 && mesh3_is_diff_edge(eik->mesh, la)) {
     uint3 la_ = {la[0], la[1], (size_t)NO_INDEX};
     if (!array_contains(queue, &la_)
-        && !utri_cache_contains_inds(eik->diff_utri_cache, lhat, la_))
+        && !utri_cache_contains_inds(get_worker(eik, lhat)->diff_utri_cache, lhat, la_))
       array_append(queue, &la_);
   }
 
@@ -1730,7 +2288,7 @@ static void do_reflector_updates(eik3_s *eik, mesh2_s const *refl_mesh,
   SORT3(l[0], l[1], l[2]);
   array_append(queue, &l);
 
-  while (isinf(eik->jet[lhat].f) && !array_is_empty(queue)) {
+  while (isinf(eik->T[lhat]) && !array_is_empty(queue)) {
     array_pop_front(queue, &l);
 
     if (is_edge(l))
@@ -1878,7 +2436,7 @@ void eik3_add_refl_bcs_with_fac(eik3_s *eik, eik3_s const *eik_in,
     size_t l = update_inds.lhat, *lf = &update_inds.l[0];
 
     /* If `l` is off the reflector, set the node to trial, insert it
-     * into the heap, and do updates from the reflector, using `lf` as
+     * into the front, and do updates from the reflector, using `lf` as
      * a warm start. */
     if (OK_face_inds(lf) && eik3_is_far(eik, l)) {
       eik3_add_trial(eik, l, jet31t_make_empty());
@@ -1886,20 +2444,19 @@ void eik3_add_refl_bcs_with_fac(eik3_s *eik, eik3_s const *eik_in,
     }
 
     /* Check if we're in the "factoring tube"... */
-    if (eik->jet[l].f - get_par_eik_value(eik, l) > rfac)
+    if (eik->T[l] - get_par_eik_value(eik, l) > rfac)
       continue;
 
     /* Get `l`'s neighbors */
     size_t nvv = mesh3_nvv(eik->mesh, l);
-    size_t *vv = malloc(nvv*sizeof(size_t));
-    mesh3_vv(eik->mesh, l, vv);
+    jmm_index_t const *vv = mesh3_get_vv_ptr(eik->mesh, l);
 
     /* Since we're in the "factoring tube" now, add this node's
      * neighbors to the queue, using the parent of `l` as a warm start
      * for the reflector updates for each added node. */
     for (size_t i = 0; i < nvv; ++i) {
       /* Skip this node if we've already updated it */
-      if (isfinite(eik->jet[vv[i]].f))
+      if (isfinite(eik->T[vv[i]]))
         continue;
 
       update_inds_s child_update_inds =
@@ -1907,8 +2464,6 @@ void eik3_add_refl_bcs_with_fac(eik3_s *eik, eik3_s const *eik_in,
       if (!array_contains(queue, &child_update_inds))
         array_append(queue, &child_update_inds);
     }
-
-    free(vv);
   }
 
   freeze_bc_layer(eik);
@@ -1947,19 +2502,53 @@ array_s const *eik3_get_bc_inds(eik3_s const *eik) {
 }
 
 dbl eik3_get_T(eik3_s const *eik, size_t l) {
-  return eik->jet[l].f;
+  return eik->T[l];
+}
+
+dbl const *eik3_get_T_ptr(eik3_s const *eik) {
+  return eik->T;
+}
+
+dbl3 const *eik3_get_DT_ptr(eik3_s const *eik) {
+  return eik->DT;
 }
 
 jet31t eik3_get_jet(eik3_s const *eik, size_t l) {
-  return eik->jet[l];
+  return (jet31t) {
+    .f = eik->T[l],
+    .Df = {eik->DT[l][0], eik->DT[l][1], eik->DT[l][2]}
+  };
 }
 
 void eik3_set_jet(eik3_s *eik, size_t l, jet31t jet) {
-  eik->jet[l] = jet;
+  eik->T[l] = jet.f;
+  dbl3_copy(jet.Df, eik->DT[l]);
 }
 
+/* Copy the jets into `jet`, which should have room for one `jet31t`
+ * per vertex. Since `eik` stores the values and gradients
+ * separately, prefer `eik3_get_T_ptr` and `eik3_get_DT_ptr`, which
+ * don't copy anything. */
+void eik3_copy_jets(eik3_s const *eik, jet31t *jet) {
+  for (size_t l = 0; l < mesh3_nverts(eik->mesh); ++l)
+    jet[l] = eik3_get_jet(eik, l);
+}
+
+/* Deprecated: use `eik3_get_T_ptr` and `eik3_get_DT_ptr`, or
+ * `eik3_copy_jets`, instead. This will be removed in the next
+ * release.
+ *
+ * Since `eik` doesn't store an array of jets anymore, this copies
+ * them into an array owned by `eik` and returns it. The array is
+ * refilled each time this is called, so it goes stale as soon as
+ * `eik` changes, and writing to it doesn't change `eik`. This also
+ * isn't safe to call from more than one thread at a time. */
 jet31t *eik3_get_jet_ptr(eik3_s const *eik) {
-  return eik->jet;
+  eik3_s *eik_mut = (eik3_s *)eik;
+  if (eik_mut->jet == NULL)
+    eik_mut->jet = malloc(mesh3_nverts(eik->mesh)*sizeof(jet31t));
+  eik3_copy_jets(eik, eik_mut->jet);
+  return eik_mut->jet;
 }
 
 state_e *eik3_get_state_ptr(eik3_s const *eik) {
@@ -1967,22 +2556,32 @@ state_e *eik3_get_state_ptr(eik3_s const *eik) {
 }
 
 par3_s eik3_get_par(eik3_s const *eik, size_t l) {
-  return eik->par[l];
+  par3_s par;
+  for (size_t i = 0; i < 3; ++i) {
+    par.l[i] = eik->par_l[l][i] == (jmm_index_t)NO_PARENT ?
+      NO_PARENT : eik->par_l[l][i];
+    par.b[i] = eik->par_b[l][i];
+  }
+  return par;
 }
 
 void eik3_set_par(eik3_s *eik, size_t l, par3_s par) {
-  eik->par[l] = par;
+  for (size_t i = 0; i < 3; ++i) {
+    eik->par_l[l][i] = par.l[i] == NO_PARENT ?
+      (jmm_index_t)NO_PARENT : par.l[i];
+    eik->par_b[l][i] = par.b[i];
+  }
 }
 
 bool eik3_has_par(eik3_s const *eik, size_t l) {
-  return !par3_is_empty(&eik->par[l]);
+  return eik->par_l[l][0] != (jmm_index_t)NO_PARENT;
 }
 
 bool eik3_has_BCs(eik3_s const *eik, size_t l) {
   return array_contains(eik->bc_inds, &l);
 }
 
-size_t const *eik3_get_accepted_ptr(eik3_s const *eik) {
+jmm_index_t const *eik3_get_accepted_ptr(eik3_s const *eik) {
   return eik->accepted;
 }
 
@@ -1990,6 +2589,34 @@ size_t eik3_num_bc(eik3_s const *eik) {
   return array_size(eik->bc_inds);
 }
 
+/* Get the total number of cache hits and misses (i.e., how many
+ * updates were skipped because they had already been done, and how
+ * many weren't) over all of `eik`'s update caches. */
+void eik3_get_cache_stats(eik3_s const *eik, size_t *num_hits, size_t *num_misses) {
+  *num_hits = *num_misses = 0;
+  for (size_t i = 0; i < eik->num_workers; ++i) {
+    worker_s const *worker = &eik->worker[i];
+    *num_hits += utetra_cache_get_num_hits(worker->utetra_cache)
+      + utri_cache_get_num_hits(worker->bd_utri_cache)
+      + utri_cache_get_num_hits(worker->diff_utri_cache);
+    *num_misses += utetra_cache_get_num_misses(worker->utetra_cache)
+      + utri_cache_get_num_misses(worker->bd_utri_cache)
+      + utri_cache_get_num_misses(worker->diff_utri_cache);
+  }
+}
+
+#if JMM_DEBUG
+/* Get the number of times `eik`'s update pool has had to call
+ * `malloc`. This should stop increasing once marching reaches a
+ * steady state. */
+size_t eik3_get_num_pool_allocs(eik3_s const *eik) {
+  size_t num_allocs = 0;
+  for (size_t i = 0; i < eik->num_workers; ++i)
+    num_allocs += pool_get_num_allocs(eik->worker[i].pool);
+  return num_allocs;
+}
+#endif
+
 void eik3_get_edge_T(eik3_s const *eik, size_t const le[2], bb31 *T) {
   assert(mesh3_is_edge(eik->mesh, le));
 
@@ -1997,7 +2624,7 @@ void eik3_get_edge_T(eik3_s const *eik, size_t const le[2], bb31 *T) {
   mesh3_copy_vert(eik->mesh, le[0], x[0]);
   mesh3_copy_vert(eik->mesh, le[1], x[1]);
 
-  jet31t jet[2] = {eik->jet[le[0]], eik->jet[le[1]]};
+  jet31t jet[2] = {eik3_get_jet(eik, le[0]), eik3_get_jet(eik, le[1])};
 
   bb31_init_from_jets(T, jet, x);
 }
@@ -2005,7 +2632,7 @@ void eik3_get_edge_T(eik3_s const *eik, size_t const le[2], bb31 *T) {
 dbl eik3_get_max_T(eik3_s const *eik) {
   dbl T_max = -INFINITY;
   for (size_t l = 0; l < mesh3_nverts(eik->mesh); ++l)
-    T_max = fmax(T_max, eik->jet[l].f);
+    T_max = fmax(T_max, eik->T[l]);
   return T_max;
 }
 
@@ -2068,13 +2695,14 @@ void eik3_prop_org(eik3_s const *eik, dbl *org) {
 
     if (!diffracting[l]) continue;
 
-    par3_s const *par = &eik->par[l];
-    if (par3_is_empty(par))
+    if (!eik3_has_par(eik, l))
       continue;
 
+    par3_s par = eik3_get_par(eik, l);
+
     uint3 la = {NO_INDEX, NO_INDEX, NO_INDEX};
     dbl3 b = {NAN, NAN, NAN};
-    size_t na = par3_get_active(par, la, b);
+    size_t na = par3_get_active(&par, la, b);
     (void)na;
 
     for (size_t j = 0; j < na; ++j)
@@ -2125,7 +2753,8 @@ any_cell_vert_updated_from_diff_edge(eik3_s const *eik, size_t cv[4]) {
 void eik3_get_D2T(eik3_s const *eik, dbl33 *D2T) {
 
      mesh3_s const *mesh = eik3_get_mesh(eik);
-  jet31t const *jet = eik->jet;
+  dbl const *T = eik->T;
+  dbl3 const *DT = eik->DT;
 
   /* we also want to initialize D2T for points which are immediately
    * downwind of the diffracting edge */
@@ -2199,7 +2828,8 @@ void eik3_get_D2T(eik3_s const *eik, dbl33 *D2T) {
     /* get T and DT */
     jet31t J[4];
     for (size_t i = 0; i < 4; ++i) {
-      J[i] = jet[lv[i]];
+      J[i].f = T[lv[i]];
+      dbl3_copy(DT[lv[i]], J[i].Df);
     }
 
     /* set up A */
@@ -2326,7 +2956,7 @@ void eik3_init_A_pt_src(eik3_s const *eik, dbl3 const xsrc, dbl *A) {
   size_t lsrc = mesh3_get_vert_index(eik->mesh, xsrc);
   for (size_t l = 0; l < mesh3_nverts(eik->mesh); ++l) {
     size_t la[3];
-    size_t na = par3_get_active_inds(&eik->par[l], la);
+    size_t na = get_active_par_inds(eik, l, la);
     assert(na <= 1 || (la[0] != lsrc && la[1] != lsrc && la[2] != lsrc));
     if (na == 1 && la[0] == lsrc) {
       assert(!isfinite(A[l]));
@@ -2432,7 +3062,7 @@ void eik3_get_t_in(eik3_s const *eik_parent, eik3_s const *eik_child,
   size_t l;
   for (size_t i = 0; i < array_size(l_diff); ++i) {
     array_get(l_diff, i, &l);
-    dbl3_copy(eik_parent->jet[l].Df, t_in[l]);
+    dbl3_copy(eik_parent->DT[l], t_in[l]);
   }
 
   eik3_transport_unit_vector(eik_child, t_in, true);
@@ -2445,7 +3075,7 @@ void eik3_get_t_in_old(eik3_s const *eik, dbl3 *t_in) {
 
   for (size_t i = 0, l; i < array_size(eik->bc_inds); ++i) {
     array_get(eik->bc_inds, i, &l);
-    dbl3_copy(eik->jet[l].Df, t_in[l]);
+    dbl3_copy(eik->DT[l], t_in[l]);
   }
 
   eik3_transport_unit_vector(eik, t_in, true);
@@ -2485,7 +3115,7 @@ void eik3_get_t_out(eik3_s const *eik_parent, eik3_s const *eik_child,
   size_t *num_ch = calloc(nverts, sizeof(size_t));
   for (size_t l_ch = 0; l_ch < nverts; ++l_ch) {
     uint3 l;
-    size_t n = par3_get_active_inds(&eik_child->par[l_ch], l);
+    size_t n = get_active_par_inds(eik_child, l_ch, l);
     // l[0], l[1], l[2] are parent inds.
     for (size_t j = 0; j < 3; j++) {
       if (array_contains(l_diff, l[j])) {
@@ -2497,7 +3127,7 @@ void eik3_get_t_out(eik3_s const *eik_parent, eik3_s const *eik_child,
   size_t l;
   for (size_t i = 0; i < array_size(l_parent_diff); ++i) {
     array_get(l_parent_diff, i, &l);
-    dbl3_copy(eik_child->jet[l].Df, t_out[l]);
+    dbl3_copy(eik_child->DT[l], t_out[l]);
   }
 
   eik3_transport_unit_vector(eik_child, t_out, true);
@@ -2519,7 +3149,7 @@ void eik3_get_t_out_old(eik3_s const *eik, dbl3 *t_out) {
     if (mesh3_vert_incident_on_diff_edge(mesh, l))
       continue;
 
-    dbl3_copy(eik->jet[l].Df, t_out[l]);
+    dbl3_copy(eik->DT[l], t_out[l]);
 
     if (!mesh3_bdv(mesh, l))
       continue;
@@ -2532,7 +3162,7 @@ void eik3_get_t_out_old(eik3_s const *eik, dbl3 *t_out) {
 
   for (size_t l = 0; l < mesh3_nverts(mesh); ++l)
     if (eik3_updated_from_diff_edge(eik, l))
-      dbl3_copy(eik->jet[l].Df, t_out[l]);
+      dbl3_copy(eik->DT[l], t_out[l]);
 
   eik3_transport_unit_vector(eik, t_out, true);
 }
@@ -2628,7 +3258,7 @@ void eik3_get_sectional_curvature(eik3_s const *eik, eik3_s const *eik_dir, dbl3
     dbl3_sub(t_aux, t_e, q_e);
     dbl3_normalize(q_e);
     sectional_curvature[l] = (-1)*dbl3_dbl33_dbl3_dot(q_e, D2T[l], q_e);
-    sectional_curvature[l] /= dbl3_norm(eik_dir->jet[l].Df);
+    sectional_curvature[l] /= dbl3_norm(eik_dir->DT[l]);
   }
   eik3_transport_curvature(eik, sectional_curvature, true);
 }
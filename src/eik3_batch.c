@@ -0,0 +1,110 @@
+#include <jmm/eik3_batch.h>
+
+#include <assert.h>
+#include <omp.h>
+#include <stdlib.h>
+
+#include <jmm/mesh3.h>
+
+/* Solves a batch of independent eikonal problems on the same mesh,
+ * one per thread at a time. Each thread owns an `eik3` which is
+ * recycled with `eik3_reset` between problems, so the jets, states,
+ * heap, caches, and update pools are only allocated once per thread,
+ * no matter how many problems are solved. */
+struct eik3_batch {
+  mesh3_s const *mesh;
+  sfunc_s const *sfunc;
+  size_t num_threads;
+  eik3_s **eik;
+};
+
+void eik3_batch_alloc(eik3_batch_s **batch) {
+  *batch = malloc(sizeof(eik3_batch_s));
+}
+
+void eik3_batch_dealloc(eik3_batch_s **batch) {
+  free(*batch);
+  *batch = NULL;
+}
+
+/* Set up `batch` to solve problems on `mesh` using `num_threads`
+ * threads. If `num_threads` is zero, the OpenMP default is used. */
+void eik3_batch_init(eik3_batch_s *batch, mesh3_s const *mesh,
+                     sfunc_s const *sfunc, size_t num_threads) {
+  batch->mesh = mesh;
+  batch->sfunc = sfunc;
+
+  if (num_threads == 0)
+    num_threads = omp_get_max_threads();
+  batch->num_threads = num_threads;
+
+  batch->eik = malloc(num_threads*sizeof(eik3_s *));
+  for (size_t i = 0; i < num_threads; ++i) {
+    eik3_alloc(&batch->eik[i]);
+    eik3_init(batch->eik[i], mesh, sfunc);
+  }
+}
+
+void eik3_batch_deinit(eik3_batch_s *batch) {
+  for (size_t i = 0; i < batch->num_threads; ++i) {
+    eik3_deinit(batch->eik[i]);
+    eik3_dealloc(&batch->eik[i]);
+  }
+  free(batch->eik);
+  batch->eik = NULL;
+
+  batch->mesh = NULL;
+  batch->sfunc = NULL;
+  batch->num_threads = 0;
+}
+
+size_t eik3_batch_get_num_threads(eik3_batch_s const *batch) {
+  return batch->num_threads;
+}
+
+static jmm_error_e solve_pt_src(eik3_s *eik, dbl3 const xsrc, dbl rfac,
+                                jet31t *jet) {
+  jmm_error_e error = JMM_ERROR_NONE;
+
+  eik3_reset(eik);
+  eik3_add_pt_src_bcs(eik, xsrc, rfac);
+
+  if (eik3_solve(eik) == JMM_ERROR_RUNTIME_ERROR
+      && !eik3_brute_force_remaining(eik))
+    error = JMM_ERROR_RUNTIME_ERROR;
+
+  size_t nverts = mesh3_nverts(eik3_get_mesh(eik));
+  for (size_t l = 0; l < nverts; ++l)
+    jet[l] = eik3_get_jet(eik, l);
+
+  return error;
+}
+
+/* Solve the point source problems with sources `xsrc[i]` and
+ * factoring radii `rfac[i]` for `i = 0, ..., num_srcs - 1`. Each
+ * `xsrc[i]` must be a mesh vertex. The jets for the `i`th problem are
+ * written to `jet[i*stride + l]`, for each vertex `l`, so `stride`
+ * must be at least the number of vertices.
+ *
+ * The problems are distributed dynamically over the threads. If any
+ * of them couldn't be solved completely, `JMM_ERROR_RUNTIME_ERROR` is
+ * returned, but the remaining problems are still solved. */
+jmm_error_e eik3_batch_solve_pt_srcs(eik3_batch_s *batch, size_t num_srcs,
+                                     dbl3 const *xsrc, dbl const *rfac,
+                                     jet31t *jet, size_t stride) {
+  if (stride < mesh3_nverts(batch->mesh))
+    return JMM_ERROR_BAD_ARGUMENTS;
+
+  jmm_error_e error = JMM_ERROR_NONE;
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(batch->num_threads)
+  for (size_t i = 0; i < num_srcs; ++i) {
+    eik3_s *eik = batch->eik[omp_get_thread_num()];
+    if (solve_pt_src(eik, xsrc[i], rfac[i], &jet[i*stride]) != JMM_ERROR_NONE) {
+#pragma omp atomic write
+      error = JMM_ERROR_RUNTIME_ERROR;
+    }
+  }
+
+  return error;
+}
@@ -41,7 +41,7 @@ void eik3_transport_dbl(eik3_s const *eik, dbl *values, bool skip_filled) {
 
   size_t nverts = mesh3_nverts(mesh);
 
-  size_t const *accepted = eik3_get_accepted_ptr(eik);
+  jmm_index_t const *accepted = eik3_get_accepted_ptr(eik);
 
   for (size_t i = 0; i < nverts; ++i) {
     size_t l0 = accepted[i];
@@ -75,7 +75,7 @@ void eik3_transport_dblz(eik3_s const *eik, dblz *values, bool skip_filled) {
 
   mesh3_s const *mesh = eik3_get_mesh(eik);
 
-  size_t const *accepted = eik3_get_accepted_ptr(eik);
+  jmm_index_t const *accepted = eik3_get_accepted_ptr(eik);
 
   size_t nverts = mesh3_nverts(mesh);
   for (size_t i = 0; i < nverts; ++i) {
@@ -135,7 +135,7 @@ void eik3_transport_curvature(eik3_s const *eik, dbl *kappa, bool skip_filled) {
   mesh3_s const *mesh = eik3_get_mesh(eik);
   size_t nverts = mesh3_nverts(mesh);
 
-  size_t const *accepted = eik3_get_accepted_ptr(eik);
+  jmm_index_t const *accepted = eik3_get_accepted_ptr(eik);
 
   for (size_t i = 0; i < nverts; ++i) {
     size_t l0 = accepted[i];
@@ -228,7 +228,7 @@ void eik3_transport_unit_vector(eik3_s const *eik, dbl3 *t, bool skip_filled) {
   mesh3_s const *mesh = eik3_get_mesh(eik);
   size_t nverts = mesh3_nverts(mesh);
 
-  size_t const *accepted = eik3_get_accepted_ptr(eik);
+  jmm_index_t const *accepted = eik3_get_accepted_ptr(eik);
 
   for (size_t i = 0; i < nverts; ++i) {
     size_t l0 = accepted[i];
@@ -1,8 +1,10 @@
 #include <jmm/eik3hh.h>
 
 #include <assert.h>
+#include <omp.h>
 #include <stdio.h>
 
+#include <jmm/array.h>
 #include <jmm/bmesh.h>
 #include <jmm/eik3.h>
 #include <jmm/eik3hh_branch.h>
@@ -60,3 +62,65 @@ dbl eik3hh_get_rfac(eik3hh_s const *hh) {
 eik3hh_branch_s *eik3hh_get_root_branch(eik3hh_s *hh) {
   return hh->root;
 }
+
+/* Solve `branch` and then spawn a task for each reflection visible
+ * from it. The children of `branch` are only ever modified by the
+ * task solving `branch`, and each child only reads from its parent
+ * after the parent has been solved, so there's no need for any
+ * further synchronization between sibling branches. */
+static void solve_branch_task(eik3hh_branch_s *branch, size_t num_refl,
+                              bool verbose) {
+  eik3hh_branch_solve(branch, /* verbose = */ false);
+  assert(eik3hh_branch_is_solved(branch));
+
+  if (verbose) {
+    eik3_s const *eik = eik3hh_branch_get_eik(branch);
+    size_t nverts = mesh3_nverts(eik3_get_mesh(eik));
+    size_t num_skipped = nverts - eik3_num_valid(eik);
+#pragma omp critical
+    printf("- solved branch (remaining reflections: %lu, skipped: %lu)\n",
+           num_refl, num_skipped);
+  }
+
+  if (num_refl == 0)
+    return;
+
+  array_s *refl_inds = eik3hh_branch_get_visible_refls(branch);
+
+  for (size_t i = 0; i < array_size(refl_inds); ++i) {
+    size_t refl_ind;
+    array_get(refl_inds, i, &refl_ind);
+
+    eik3hh_branch_s *child = eik3hh_branch_add_refl(branch, refl_ind);
+
+#pragma omp task firstprivate(child, num_refl, verbose)
+    solve_branch_task(child, num_refl - 1, verbose);
+  }
+
+  array_deinit(refl_inds);
+  array_dealloc(&refl_inds);
+}
+
+/* Solve the whole tree of branches rooted at the point source,
+ * following each visible reflection up to `num_refl` reflections
+ * deep. Each branch is solved in its own task, and a branch's
+ * children are spawned as soon as it has been solved, so sibling
+ * branches (and their subtrees) are solved concurrently by a pool of
+ * `num_threads` threads. If `num_threads` is zero, the OpenMP default
+ * is used. The solved branches are available afterwards through
+ * `eik3hh_get_root_branch` and `eik3hh_branch_get_children`.
+ *
+ * Each branch owns a full `eik3` and its own fields, so memory use
+ * grows with the number of branches, not with `num_threads`. */
+void eik3hh_solve(eik3hh_s *hh, size_t num_refl, size_t num_threads,
+                  bool verbose) {
+  assert(hh->root != NULL);
+  assert(!eik3hh_branch_is_solved(hh->root));
+
+  if (num_threads == 0)
+    num_threads = omp_get_max_threads();
+
+#pragma omp parallel num_threads(num_threads)
+#pragma omp single
+  solve_branch_task(hh->root, num_refl, verbose);
+}
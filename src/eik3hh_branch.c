@@ -10,7 +10,7 @@
 #include <jmm/eik3hh.h>
 #include <jmm/mat.h>
 #include <jmm/mesh2.h>
-#include <jmm/rtree.h>
+#include <jmm/renderer.h>
 
 #include <jmm/util.h>
 
@@ -24,6 +24,7 @@ struct eik3hh_branch {
   dbl *origin;
   eik3hh_branch_s const *parent;
   array_s *children;
+  bool solved;
 };
 
 void eik3hh_branch_alloc(eik3hh_branch_s **branch) {
@@ -60,6 +61,8 @@ static void init(eik3hh_branch_s *branch, eik3hh_s const *hh,
 
   array_alloc(&branch->children);
   array_init(branch->children, sizeof(eik3hh_branch_s *), ARRAY_DEFAULT_CAPACITY);
+
+  branch->solved = false;
 }
 
 void eik3hh_branch_init_pt_src(eik3hh_branch_s *branch, eik3hh_s const *hh,
@@ -110,11 +113,17 @@ void eik3hh_branch_deinit(eik3hh_branch_s *branch, bool free_children) {
   /* Recursively free children */
   if (free_children) {
     for (size_t i = 0; i < array_size(branch->children); ++i) {
-      eik3hh_branch_s *child = array_get_ptr(branch->children, i);
+      eik3hh_branch_s *child;
+      array_get(branch->children, i, &child);
       eik3hh_branch_deinit(child, true);
       eik3hh_branch_dealloc(&child);
     }
   }
+
+  array_deinit(branch->children);
+  array_dealloc(&branch->children);
+
+  branch->solved = false;
 }
 
 void eik3hh_branch_dealloc(eik3hh_branch_s **hh) {
@@ -278,8 +287,6 @@ static void approx_D2T(eik3hh_branch_s *branch) {
   size_t nverts = mesh3_nverts(mesh);
 
   eik3_s const *eik = branch->eik;
-  jet31t const *jet = eik3_get_jet_ptr(eik);
-
   dbl33 *D2T = branch->D2T;
   dbl33 *D2T_cell = malloc(4*mesh3_ncells(mesh)*sizeof(dbl33));
 
@@ -299,7 +306,7 @@ static void approx_D2T(eik3hh_branch_s *branch) {
     /* get T and DT */
     jet31t J[4];
     for (size_t i = 0; i < 4; ++i) {
-      J[i] = jet[lv[i]];
+      J[i] = eik3_get_jet(eik, lv[i]);
     }
 
     /* set up A */
@@ -436,6 +443,8 @@ static void init_spread_refl(eik3hh_branch_s *branch, dbl const *spread_in) {
         spread[l] = spread_in[l];
     }
   }
+
+  free(lf);
 }
 
 static void prop_spread(eik3hh_branch_s *branch) {
@@ -443,7 +452,7 @@ static void prop_spread(eik3hh_branch_s *branch) {
   size_t nverts = mesh3_nverts(mesh);
 
   eik3_s const *eik = branch->eik;
-  size_t const *accepted = eik3_get_accepted_ptr(eik);
+  jmm_index_t const *accepted = eik3_get_accepted_ptr(eik);
   dbl33 const *D2T = branch->D2T;
   dbl *spread = branch->spread;
 
@@ -552,6 +561,16 @@ void eik3hh_branch_solve(eik3hh_branch_s *branch, bool verbose) {
       printf("- WARNING: %lu visible nodes were skipped\n", num_viz_skipped);
     printf("- solved [%1.2gs]\n", toc());
   }
+
+  branch->solved = true;
+}
+
+/* A branch is solved once its jet, origin, `D2T`, and spread have
+ * all been computed by `eik3hh_branch_solve`. After this, they're
+ * read-only, so it's safe to set up and solve children of `branch`
+ * concurrently. */
+bool eik3hh_branch_is_solved(eik3hh_branch_s const *branch) {
+  return branch->solved;
 }
 
 static void dump_xy_T_slice(eik3hh_branch_s const *branch,
@@ -562,7 +581,8 @@ static void dump_xy_T_slice(eik3hh_branch_s const *branch,
   /* Set up the bmesh */
   bmesh33_s *bmesh;
   bmesh33_alloc(&bmesh);
-  bmesh33_init_from_mesh3_and_jets(bmesh, mesh, eik3_get_jet_ptr(branch->eik));
+  bmesh33_init_from_mesh3_and_3d_data(bmesh, mesh, eik3_get_T_ptr(branch->eik),
+                                      eik3_get_DT_ptr(branch->eik));
 
   FILE *fp = fopen(path, "wb");
 
@@ -710,13 +730,18 @@ array_s *eik3hh_branch_get_visible_refls(eik3hh_branch_s const *branch) {
 
 eik3hh_branch_s *
 eik3hh_branch_add_refl(eik3hh_branch_s const *branch, size_t refl_index) {
+  /* The reflection BCs are taken from `branch`, so it needs to have
+   * been solved already */
+  assert(branch->solved);
+
   /* Make sure this isn't the same reflection */
   assert(branch->type != EIK3HH_BRANCH_TYPE_REFL
          || branch->index != refl_index);
 
   /* Make sure we haven't done this reflection already */
   for (size_t i = 0; i < array_size(branch->children); ++i) {
-    eik3hh_branch_s const *child = array_get_ptr(branch->children, i);
+    eik3hh_branch_s const *child;
+    array_get(branch->children, i, &child);
     if (child->type == EIK3HH_BRANCH_TYPE_REFL
         && child->index == refl_index)
       assert(false);
@@ -775,138 +800,31 @@ void eik3hh_branch_render_frames(eik3hh_branch_s const *branch,
                                  bool verbose) {
   mesh3_s const *mesh = eik3_get_mesh(branch->eik);
 
-  mesh2_s *surface_mesh = mesh3_get_surface_mesh(mesh);
-
   bmesh33_s *bmesh;
   bmesh33_alloc(&bmesh);
-  bmesh33_init_from_mesh3_and_jets(bmesh, mesh, eik3_get_jet_ptr(branch->eik));
+  bmesh33_init_from_mesh3_and_3d_data(bmesh, mesh, eik3_get_T_ptr(branch->eik),
+                                      eik3_get_DT_ptr(branch->eik));
+
+  renderer_s *renderer;
+  renderer_alloc(&renderer);
+  renderer_init(renderer, mesh, camera);
+  renderer_add_bmesh33(renderer, bmesh, eik3hh_branch_get_spread(branch),
+                       eik3hh_branch_get_org(branch));
 
   size_t num_frames = floor(frames_per_meter*(T1 - T0));
   if (verbose)
     printf("rendering %lu frames\n", num_frames);
 
-  dbl *T = malloc(num_frames*sizeof(dbl));
-  for (size_t i = 0; i < num_frames; ++i)
-    T[i] = T0 + i/frames_per_meter;
+  size_t npix = camera->dim[0]*camera->dim[1];
+  dbl4 *img = malloc(npix*sizeof(dbl4));
 
   for (size_t i = 0; i < num_frames; ++i) {
+    dbl T = T0 + i/frames_per_meter;
+
     if (verbose)
-      printf("frame %lu/%lu (T = %g s)\n", i + 1, num_frames, T[i]);
-
-    rtree_s *rtree;
-    rtree_alloc(&rtree);
-    rtree_init(rtree, 16, RTREE_SPLIT_STRATEGY_SURFACE_AREA);
-
-    rtree_insert_mesh2(rtree, surface_mesh);
-
-    bmesh33_s *level_bmesh = bmesh33_restrict_to_level(bmesh, T[i]);
-    rtree_insert_bmesh33(rtree, level_bmesh);
-
-    rtree_build(rtree);
-
-    size_t npix = camera->dim[0]*camera->dim[1];
-
-    dbl4 *img = malloc(npix*sizeof(dbl4));
-
-    dbl3 surf_rgb = {0.54, 0.54, 0.54};
-    dbl3 eik_rgb = {1.0, 1.0, 1.0};
-
-    dbl surf_alpha = 0.5;
-    dbl eik_alpha = 1;
-
-    for (size_t i = 0, l = 0; i < camera->dim[0]; ++i) {
-      for (size_t j = 0; j < camera->dim[1]; ++j, ++l) {
-        ray3 ray = camera_get_ray_for_index(camera, i, j);
-
-        isect isect;
-        rtree_intersect(rtree, &ray, &isect, NULL);
-
-        img[l][0] = 0;
-        img[l][1] = 0;
-        img[l][2] = 0;
-        img[l][3] = isfinite(isect.t) ? 1 : 0;
-
-        dbl transparency = 1;
-        dbl const *rgb = NULL;
-        dbl3 n;
-
-        while (isfinite(isect.t)) {
-          robj_type_e robj_type = robj_get_type(isect.obj);
-          void const *robj_data = robj_get_data(isect.obj);
-
-          dbl alpha = 1, scale = 1;
-
-          /* Increment the distance along the ray */
-          dbl3_saxpy_inplace(isect.t, ray.dir, ray.org);
-
-          /* Update the current alpha and RGB value */
-          switch (robj_type) {
-          case ROBJ_MESH2_TRI:
-            alpha *= surf_alpha;
-            rgb = &surf_rgb[0];
-            break;
-          case ROBJ_BMESH33_CELL:
-            alpha *= eik_alpha;
-            rgb = &eik_rgb[0];
-            break;
-          default:
-            assert(false);
-          }
-
-          if (robj_type == ROBJ_BMESH33_CELL) {
-            bmesh33_cell_s const *bmesh33_cell = robj_data;
-            dbl spread_interp, org_interp;
-            if (bmesh33_cell->bmesh == level_bmesh) {
-              spread_interp = mesh3_linterp(
-                mesh, eik3hh_branch_get_spread(branch), ray.org);
-              org_interp = mesh3_linterp(
-                mesh, eik3hh_branch_get_org(branch), ray.org);
-            } else {
-              assert(false);
-            }
-            /* Convert the interpolated spreading factor to dB */
-            dbl spread_dB = 20*log10(fmax(1e-16, spread_interp));
-            /* Clamp and map the range [-60 dB, 0 dB] to [0, 1] for
-             * use as a scaling factor */
-            dbl spread_mapped = fmax(0, fmin(1, 1 - spread_dB/(-90)));
-            alpha *= spread_mapped*squash(org_interp, 2);
-          }
-
-          /* Get the surface normal and dot it with the eye vector for
-           * Lambertian shading */
-          if (robj_type == ROBJ_MESH2_TRI) {
-            mesh2_tri_s const *mesh2_tri = robj_data;
-            mesh2_get_unit_surface_normal(surface_mesh, mesh2_tri->l, n);
-          } else if (robj_type == ROBJ_BMESH33_CELL) {
-            bmesh33_cell_s const *bmesh33_cell = robj_data;
-            bmesh33_cell_Df(bmesh33_cell, ray.org, n);
-            dbl3_normalize(n);
-          } else {
-            assert(false);
-          }
-          scale *= fabs(dbl3_dot(n, ray.dir));
-
-          /* We're raymarching, so do backwards alpha blending */
-          dbl3_saxpy_inplace(scale*alpha, rgb, img[l]);
-
-          /* Update transparency for early stopping */
-          transparency *= 1 - alpha;
-          if (transparency < 1e-3)
-            break;
-
-          /* Advance the start of the ray and keep tracing.
-           *
-           * NOTE: if we have multiple overlapping intersections, we
-           * might trip them repeatedly, so we need to skip any
-           * intersections with a distance of zero here. */
-          rtree_intersect(rtree, &ray, &isect, isect.obj);
-          while (isect.t < EPS) {
-            dbl3_saxpy_inplace(EPS, ray.dir, ray.org);
-            rtree_intersect(rtree, &ray, &isect, isect.obj);
-          }
-        }
-      }
-    }
+      printf("frame %lu/%lu (T = %g s)\n", i + 1, num_frames, T);
+
+    renderer_render_frame(renderer, T, img);
 
     char filename[128];
     snprintf(filename, 128, "image%04lu.bin", i);
@@ -914,16 +832,12 @@ void eik3hh_branch_render_frames(eik3hh_branch_s const *branch,
     FILE *fp = fopen(filename, "wb");
     fwrite(img, sizeof(dbl4), npix, fp);
     fclose(fp);
-
-    bmesh33_deinit(level_bmesh);
-    bmesh33_dealloc(&level_bmesh);
-
-    rtree_deinit(rtree);
-    rtree_dealloc(&rtree);
   }
 
-  mesh2_deinit(surface_mesh);
-  mesh2_dealloc(&surface_mesh);
+  free(img);
+
+  renderer_deinit(renderer);
+  renderer_dealloc(&renderer);
 
   bmesh33_deinit(bmesh);
   bmesh33_dealloc(&bmesh);
@@ -0,0 +1,457 @@
+#include <jmm/front.h>
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <jmm/bucket.h>
+
+#define INIT_NUM_BUCKETS 16
+
+/* Values of `bucket_index` for nodes which aren't in the front, and
+ * for nodes whose values aren't finite yet */
+#define NOT_QUEUED SIZE_MAX
+#define INF_BUCKET (SIZE_MAX - 1)
+
+struct front {
+  front_type_e type;
+  size_t n;
+  value_f value;
+  void *context;
+
+  size_t size;
+  size_t num_pops;
+
+  /** `FRONT_TYPE_HEAP`: */
+
+  heap_s *heap;
+  size_t *pos;
+
+  /** `FRONT_TYPE_BUCKET`: */
+
+  dbl width;
+
+  /* The buckets for finite values form a ring: bucket `k` (holding
+   * values in `[k*width, (k + 1)*width)`) is `bucket[k % num_buckets]`,
+   * and buckets `k0, ..., k0 + num_buckets - 1` are the ones which
+   * are currently in use. The ring is grown if a value lands too far
+   * ahead of `k0`. */
+  bucket_s **bucket;
+  size_t num_buckets;
+  size_t k0;
+
+  /* Nodes which are in the front but whose values are infinite */
+  bucket_s *inf_bucket;
+
+  /* The bucket each node is currently in. When a node's value
+   * decreases, it's pushed onto its new bucket, and the entry left
+   * behind in its old bucket becomes stale: we skip it when it gets
+   * popped, since its bucket no longer matches `bucket_index`. */
+  size_t *bucket_index;
+
+  /* The number of nodes in the front with finite values */
+  size_t num_finite;
+};
+
+void front_alloc(front_s **front) {
+  *front = malloc(sizeof(front_s));
+}
+
+void front_dealloc(front_s **front) {
+  assert(*front != NULL);
+  free(*front);
+  *front = NULL;
+}
+
+static dbl heap_value(void *ptr, size_t l) {
+  front_s *front = ptr;
+  return front->value(front->context, l);
+}
+
+static void heap_setpos(void *ptr, size_t l, size_t pos) {
+  front_s *front = ptr;
+  front->pos[l] = pos;
+}
+
+static size_t heap_getpos(void *ptr, size_t l) {
+  front_s *front = ptr;
+  return front->pos[l];
+}
+
+static bucket_s *make_bucket(void) {
+  bucket_s *bucket;
+  bucket_alloc(&bucket);
+  bucket_init(bucket);
+  return bucket;
+}
+
+static void free_bucket(bucket_s *bucket) {
+  bucket_deinit(bucket);
+  bucket_dealloc(&bucket);
+}
+
+/* Initialize a front for nodes with indices in `[0, n)`. The width
+ * of the buckets is `width`, which is only used if `type` is
+ * `FRONT_TYPE_BUCKET`. */
+void front_init(front_s *front, front_type_e type, size_t n, dbl width,
+                value_f value, void *context) {
+  front->type = type;
+  front->n = n;
+  front->value = value;
+  front->context = context;
+
+  front->size = 0;
+  front->num_pops = 0;
+
+  front->heap = NULL;
+  front->pos = NULL;
+
+  front->bucket = NULL;
+  front->inf_bucket = NULL;
+  front->bucket_index = NULL;
+
+  if (type == FRONT_TYPE_HEAP) {
+    front->pos = malloc(n*sizeof(size_t));
+    for (size_t l = 0; l < n; ++l)
+      front->pos[l] = (size_t)NO_INDEX;
+
+    /**
+     * When we compute the initial heap capacity, we want to estimate
+     * the number of nodes that could comprise the expanding numerical
+     * front at any one time. We can't know this ahead of time, so we
+     * set it to a constant multiple times (# nodes)^(1/d). In this
+     * case, d=3. Even if this is an underestimate, well still reduce
+     * the number of times the heap needs to be expanded at solve time.
+     */
+    size_t capacity = 3*cbrt(n);
+
+    heap_alloc(&front->heap);
+    heap_init(front->heap, capacity, heap_value, heap_setpos, heap_getpos,
+              front);
+  } else if (type == FRONT_TYPE_BUCKET) {
+    assert(width > 0 && isfinite(width));
+    front->width = width;
+
+    front->num_buckets = INIT_NUM_BUCKETS;
+    front->bucket = malloc(front->num_buckets*sizeof(bucket_s *));
+    for (size_t k = 0; k < front->num_buckets; ++k)
+      front->bucket[k] = make_bucket();
+    front->k0 = 0;
+
+    front->inf_bucket = make_bucket();
+
+    front->bucket_index = malloc(n*sizeof(size_t));
+    for (size_t l = 0; l < n; ++l)
+      front->bucket_index[l] = NOT_QUEUED;
+
+    front->num_finite = 0;
+  } else {
+    assert(false);
+  }
+}
+
+void front_deinit(front_s *front) {
+  if (front->type == FRONT_TYPE_HEAP) {
+    heap_deinit(front->heap);
+    heap_dealloc(&front->heap);
+
+    free(front->pos);
+    front->pos = NULL;
+  }
+
+  if (front->type == FRONT_TYPE_BUCKET) {
+    for (size_t k = 0; k < front->num_buckets; ++k)
+      free_bucket(front->bucket[k]);
+    free(front->bucket);
+    front->bucket = NULL;
+
+    free_bucket(front->inf_bucket);
+    front->inf_bucket = NULL;
+
+    free(front->bucket_index);
+    front->bucket_index = NULL;
+  }
+}
+
+front_type_e front_get_type(front_s const *front) {
+  return front->type;
+}
+
+dbl front_get_width(front_s const *front) {
+  return front->type == FRONT_TYPE_BUCKET ? front->width : NAN;
+}
+
+static void empty_bucket(bucket_s *bucket) {
+  while (!bucket_is_empty(bucket))
+    (void)bucket_pop(bucket);
+}
+
+/* Remove every node from `front`, keeping its storage */
+void front_clear(front_s *front) {
+  if (front->type == FRONT_TYPE_HEAP) {
+    heap_clear(front->heap);
+    for (size_t l = 0; l < front->n; ++l)
+      front->pos[l] = (size_t)NO_INDEX;
+  }
+
+  if (front->type == FRONT_TYPE_BUCKET) {
+    for (size_t k = 0; k < front->num_buckets; ++k)
+      empty_bucket(front->bucket[k]);
+    front->k0 = 0;
+
+    empty_bucket(front->inf_bucket);
+
+    for (size_t l = 0; l < front->n; ++l)
+      front->bucket_index[l] = NOT_QUEUED;
+
+    front->num_finite = 0;
+  }
+
+  front->size = 0;
+  front->num_pops = 0;
+}
+
+static size_t get_bucket_index(front_s const *front, size_t l) {
+  dbl T = front->value(front->context, l);
+  if (!isfinite(T))
+    return INF_BUCKET;
+
+  /* A value which lands behind the current bucket (which can happen
+   * since the nodes in the current bucket aren't accepted in order)
+   * goes into the current bucket. */
+  size_t k = T > 0 ? floor(T/front->width) : 0;
+  return k < front->k0 ? front->k0 : k;
+}
+
+/* Make sure that bucket `k` fits in the ring */
+static void grow_ring_if_necessary(front_s *front, size_t k) {
+  assert(k >= front->k0);
+
+  size_t num_buckets = front->num_buckets;
+  if (k - front->k0 < num_buckets)
+    return;
+
+  while (k - front->k0 >= front->num_buckets)
+    front->num_buckets *= 2;
+
+  bucket_s **bucket = malloc(front->num_buckets*sizeof(bucket_s *));
+  for (size_t j = 0; j < front->num_buckets; ++j)
+    bucket[j] = NULL;
+
+  /* Move the buckets in use over to their new slots... */
+  for (size_t j = front->k0; j < front->k0 + num_buckets; ++j)
+    bucket[j % front->num_buckets] = front->bucket[j % num_buckets];
+
+  /* ... and fill in the rest with new ones */
+  for (size_t j = 0; j < front->num_buckets; ++j)
+    if (bucket[j] == NULL)
+      bucket[j] = make_bucket();
+
+  free(front->bucket);
+  front->bucket = bucket;
+}
+
+static void push(front_s *front, size_t l, size_t k) {
+  if (k == INF_BUCKET) {
+    bucket_push(front->inf_bucket, l);
+  } else {
+    grow_ring_if_necessary(front, k);
+    bucket_push(front->bucket[k % front->num_buckets], l);
+  }
+  front->bucket_index[l] = k;
+}
+
+void front_insert(front_s *front, size_t l) {
+  assert(l < front->n);
+  assert(!front_contains(front, l));
+
+  if (front->type == FRONT_TYPE_HEAP) {
+    heap_insert(front->heap, l);
+  }
+
+  if (front->type == FRONT_TYPE_BUCKET) {
+    size_t k = get_bucket_index(front, l);
+    push(front, l, k);
+    if (k != INF_BUCKET)
+      ++front->num_finite;
+  }
+
+  ++front->size;
+}
+
+/* Let `front` know that the value of `l` has decreased. */
+void front_update(front_s *front, size_t l) {
+  assert(front_contains(front, l));
+
+  if (front->type == FRONT_TYPE_HEAP) {
+    heap_swim(front->heap, front->pos[l]);
+  }
+
+  if (front->type == FRONT_TYPE_BUCKET) {
+    size_t k_old = front->bucket_index[l];
+    size_t k = get_bucket_index(front, l);
+    if (k == k_old)
+      return;
+    push(front, l, k);
+    if (k_old == INF_BUCKET && k != INF_BUCKET)
+      ++front->num_finite;
+  }
+}
+
+/* Let `front` know that the values of the `n` nodes in `l` have
+ * decreased. Equivalent to calling `front_update` for each of them,
+ * but lets the heap sift each node once. */
+void front_update_many(front_s *front, size_t n, size_t const *l) {
+  if (front->type == FRONT_TYPE_HEAP) {
+    heap_decrease_keys(front->heap, n, l);
+  }
+
+  if (front->type == FRONT_TYPE_BUCKET) {
+    for (size_t i = 0; i < n; ++i)
+      front_update(front, l[i]);
+  }
+}
+
+/* Drop stale entries from the front of `bucket`. Returns whether
+ * there's a node left in it. */
+static bool skip_stale(front_s const *front, bucket_s *bucket, size_t k) {
+  while (!bucket_is_empty(bucket)) {
+    size_t l = bucket_peek(bucket);
+    if (front->bucket_index[l] == k)
+      return true;
+    (void)bucket_pop(bucket);
+  }
+  return false;
+}
+
+/* Find the bucket holding the next node to pop, dropping the stale
+ * entries and empty buckets in front of it along the way. */
+static bucket_s *get_front_bucket(front_s *front) {
+  assert(front->size > 0);
+
+  if (front->num_finite == 0) {
+    bool found = skip_stale(front, front->inf_bucket, INF_BUCKET);
+    assert(found);
+    (void)found;
+    return front->inf_bucket;
+  }
+
+  /* Since there's at least one node with a finite value, this will
+   * find a nonempty bucket before we get to the end of the ring */
+  while (true) {
+    bucket_s *bucket = front->bucket[front->k0 % front->num_buckets];
+    if (skip_stale(front, bucket, front->k0))
+      return bucket;
+    ++front->k0;
+  }
+}
+
+/* Find the first node in `bucket` which isn't stale, without
+ * modifying it. Returns `NO_INDEX` if there isn't one. */
+static size_t find_live(front_s const *front, bucket_s const *bucket,
+                        size_t k) {
+  for (size_t i = 0; i < bucket_get_size(bucket); ++i) {
+    size_t l = bucket_get(bucket, i);
+    if (front->bucket_index[l] == k)
+      return l;
+  }
+  return (size_t)NO_INDEX;
+}
+
+/* Get the next node which will be popped. For `FRONT_TYPE_BUCKET`,
+ * this looks past stale entries and empty buckets without removing
+ * them: that's left to `front_pop`. */
+size_t front_peek(front_s const *front) {
+  assert(front->size > 0);
+
+  if (front->type == FRONT_TYPE_HEAP)
+    return heap_front(front->heap);
+
+  if (front->type == FRONT_TYPE_BUCKET) {
+    if (front->num_finite == 0)
+      return find_live(front, front->inf_bucket, INF_BUCKET);
+
+    for (size_t k = front->k0;; ++k) {
+      size_t l = find_live(front, front->bucket[k % front->num_buckets], k);
+      if (l != (size_t)NO_INDEX)
+        return l;
+    }
+  }
+
+  assert(false);
+  return (size_t)NO_INDEX;
+}
+
+/* Append the live entries of `bucket` (which is bucket `k`) to
+ * `found`, which already holds `num_found` nodes, in the order
+ * they'll be popped until there are `n` of them. Returns the new
+ * number of nodes in `found`. */
+static size_t get_live(front_s const *front, bucket_s const *bucket, size_t k,
+                       size_t n, size_t *found, size_t num_found) {
+  for (size_t i = 0; i < bucket_get_size(bucket) && num_found < n; ++i) {
+    size_t l = bucket_get(bucket, i);
+    if (front->bucket_index[l] == k)
+      found[num_found++] = l;
+  }
+  return num_found;
+}
+
+/* Get the first `n` nodes which will be popped (or all of them, if
+ * there are fewer than `n` in `front`), assuming none of their
+ * values change in the meantime. Like `front_peek`, this doesn't
+ * modify `front`. Returns the number of nodes written to `l`. */
+size_t front_peek_many(front_s const *front, size_t n, size_t *l) {
+  if (front->type == FRONT_TYPE_HEAP)
+    return heap_peek_many(front->heap, n, l);
+
+  if (front->type == FRONT_TYPE_BUCKET) {
+    size_t num_found = 0;
+    if (front->num_finite > 0)
+      for (size_t k = front->k0; k < front->k0 + front->num_buckets; ++k)
+        num_found = get_live(front, front->bucket[k % front->num_buckets], k,
+                             n, l, num_found);
+    return get_live(front, front->inf_bucket, INF_BUCKET, n, l, num_found);
+  }
+
+  assert(false);
+  return 0;
+}
+
+void front_pop(front_s *front) {
+  if (front->type == FRONT_TYPE_HEAP) {
+    heap_pop(front->heap);
+  }
+
+  if (front->type == FRONT_TYPE_BUCKET) {
+    bucket_s *bucket = get_front_bucket(front);
+    size_t l = bucket_pop(bucket);
+    if (front->bucket_index[l] != INF_BUCKET)
+      --front->num_finite;
+    front->bucket_index[l] = NOT_QUEUED;
+  }
+
+  --front->size;
+  ++front->num_pops;
+}
+
+size_t front_size(front_s const *front) {
+  return front->size;
+}
+
+bool front_contains(front_s const *front, size_t l) {
+  if (front->type == FRONT_TYPE_HEAP)
+    return front->pos[l] != (size_t)NO_INDEX;
+
+  if (front->type == FRONT_TYPE_BUCKET)
+    return front->bucket_index[l] != NOT_QUEUED;
+
+  assert(false);
+  return false;
+}
+
+/* The number of nodes popped from `front` since it was initialized
+ * or last cleared. */
+size_t front_get_num_pops(front_s const *front) {
+  return front->num_pops;
+}
@@ -1,15 +1,24 @@
 #include <jmm/heap.h>
 
 #include <assert.h>
-#include <math.h>
 #include <stdlib.h>
 
+#define ARITY 4
+
+/* Each slot of the heap holds an index together with a cached copy
+ * of its key. */
+typedef struct {
+  dbl key;
+  size_t ind;
+} node_s;
+
 struct heap {
-  int capacity;
-  int size;
-  int* inds;
+  size_t capacity;
+  size_t size;
+  node_s *node;
   value_f value;
   setpos_f setpos;
+  getpos_f getpos;
   void *context;
 };
 
@@ -23,150 +32,168 @@ void heap_dealloc(heap_s **heap) {
   *heap = NULL;
 }
 
-void heap_init(heap_s *heap, int capacity, value_f value, setpos_f setpos,
-               void *context) {
-  heap->capacity = capacity;
+void heap_init(heap_s *heap, size_t capacity, value_f value, setpos_f setpos,
+               getpos_f getpos, void *context) {
+  heap->capacity = capacity > 0 ? capacity : 1;
   heap->size = 0;
-  heap->inds = malloc(heap->capacity*sizeof(int));
-  assert(heap->inds != NULL);
-#if SJS_DEBUG
-  for (int i = 0; i < heap->capacity; ++i) {
-    heap->inds[i] = NO_INDEX;
-  }
-#endif
+  heap->node = malloc(heap->capacity*sizeof(node_s));
+  assert(heap->node != NULL);
   heap->value = value;
   heap->setpos = setpos;
+  heap->getpos = getpos;
   heap->context = context;
 }
 
 void heap_deinit(heap_s *heap) {
-  free(heap->inds);
-  heap->inds = NULL;
+  free(heap->node);
+  heap->node = NULL;
 }
 
-void heap_grow(heap_s *heap) {
-  heap->capacity *= 2;
-  heap->inds = realloc(heap->inds, sizeof(int)*heap->capacity);
-  assert(heap->inds != NULL);
-#if SJS_DEBUG
-  for (int i = heap->size; i < heap->capacity; ++i) {
-    heap->inds[i] = NO_INDEX;
-  }
-#endif
+/* Remove every element from `heap`, keeping its storage */
+void heap_clear(heap_s *heap) {
+  heap->size = 0;
 }
 
-int left(int pos) {
-  return 2*pos + 1;
+static void grow(heap_s *heap) {
+  heap->capacity *= 2;
+  heap->node = realloc(heap->node, heap->capacity*sizeof(node_s));
+  assert(heap->node != NULL);
 }
 
-int right(int pos) {
-  return 2*pos + 2;
+static size_t parent(size_t pos) {
+  return (pos - 1)/ARITY;
 }
 
-int parent(int pos) {
-  return (pos - 1)/2;
+static size_t first_child(size_t pos) {
+  return ARITY*pos + 1;
 }
 
-dbl value(heap_s *heap, int pos) {
-  assert(pos >= 0);
-  assert(pos < heap->size);
-
-#ifdef SJS_DEBUG
-  int ind = heap->inds[pos];
-  assert(ind != NO_INDEX);
-#endif
-
-  return heap->value(heap->context, heap->inds[pos]);
+/* Order nodes by key, breaking ties by index. Since this is a total
+ * order, the order in which indices are popped depends only on their
+ * keys, and not on the order they were inserted in. This makes
+ * marching reproducible, e.g. when resuming a solve read from a
+ * binfile (see `eik3_read_binfile`). */
+static bool precedes(node_s const *node1, node_s const *node2) {
+  return node1->key < node2->key ||
+    (node1->key == node2->key && node1->ind < node2->ind);
 }
 
-void heap_set(heap_s *heap, int pos, int ind) {
-  assert(pos >= 0);
-  assert(pos < heap->size);
+static void set(heap_s *heap, size_t pos, node_s node) {
+  heap->node[pos] = node;
+  heap->setpos(heap->context, node.ind, pos);
+}
 
-  heap->inds[pos] = ind;
-  heap->setpos(heap->context, ind, pos);
+/* Move the node at `pos` up until its parent precedes it. Instead
+ * of swapping at each level, the parents are shifted down into the
+ * hole and the node is written once at the end. */
+static void sift_up(heap_s *heap, size_t pos) {
+  node_s node = heap->node[pos];
+  while (pos > 0) {
+    size_t par = parent(pos);
+    if (!precedes(&node, &heap->node[par]))
+      break;
+    set(heap, pos, heap->node[par]);
+    pos = par;
+  }
+  set(heap, pos, node);
+}
+
+/* Like `sift_up`, but move `node` down from `pos` */
+static void sift_down(heap_s *heap, size_t pos, node_s node) {
+  size_t ch;
+  while ((ch = first_child(pos)) < heap->size) {
+    size_t ch_end = ch + ARITY < heap->size ? ch + ARITY : heap->size;
+    size_t ch_min = ch;
+    for (++ch; ch < ch_end; ++ch)
+      if (precedes(&heap->node[ch], &heap->node[ch_min]))
+        ch_min = ch;
+    if (!precedes(&heap->node[ch_min], &node))
+      break;
+    set(heap, pos, heap->node[ch_min]);
+    pos = ch_min;
+  }
+  set(heap, pos, node);
 }
 
-void heap_swap(heap_s *heap, int pos1, int pos2) {
-  assert(pos1 >= 0);
-  assert(pos1 < heap->size);
-  assert(pos2 >= 0);
-  assert(pos2 < heap->size);
+/* The key of the index at `pos` has decreased: reload it and restore
+ * the heap property. */
+void heap_swim(heap_s *heap, size_t pos) {
+  assert(pos < heap->size);
 
-  int tmp = heap->inds[pos1];
-  heap->inds[pos1] = heap->inds[pos2];
-  heap->inds[pos2] = tmp;
+  node_s *node = &heap->node[pos];
+  dbl key = heap->value(heap->context, node->ind);
+  assert(!(key > node->key));
+  node->key = key;
 
-  heap_set(heap, pos1, heap->inds[pos1]);
-  heap_set(heap, pos2, heap->inds[pos2]);
+  sift_up(heap, pos);
 }
 
-// TODO: this calls `value` and `heap_set` about 2x as many times as
-// necessary
-void heap_swim(heap_s *heap, int pos) {
-  assert(pos >= 0);
-  assert(pos < heap->size);
+/* Let `heap` know that the keys of the `n` indices in `inds` (which
+ * all need to be in `heap`) have decreased. This is cheaper than
+ * calling `heap_swim` each time an index's key changes, since each
+ * index is only sifted up once, however many times its key changed
+ * beforehand. Indices may be repeated. */
+void heap_decrease_keys(heap_s *heap, size_t n, size_t const *inds) {
+  assert(heap->getpos != NULL);
 
-  int par = parent(pos);
-  while (pos > 0 && value(heap, par) > value(heap, pos)) {
-    heap_swap(heap, par, pos);
-    pos = par;
-    par = parent(pos);
-  }
+  for (size_t i = 0; i < n; ++i)
+    heap_swim(heap, heap->getpos(heap->context, inds[i]));
 }
 
-void heap_insert(heap_s *heap, int ind) {
-  if (heap->size == heap->capacity) {
-    heap_grow(heap);
-  }
+void heap_insert(heap_s *heap, size_t ind) {
+  if (heap->size == heap->capacity)
+    grow(heap);
 
-  int pos = heap->size++;
-  heap_set(heap, pos, ind);
-  heap_swim(heap, pos);
+  size_t pos = heap->size++;
+  heap->node[pos] = (node_s) {.key = heap->value(heap->context, ind), .ind = ind};
+  sift_up(heap, pos);
 }
 
-int heap_front(heap_s *heap) {
-#if SJS_DEBUG
-  int ind = heap->inds[0];
-  return ind;
-#else
-  return heap->inds[0];
-#endif
+size_t heap_front(heap_s const *heap) {
+  return heap->node[0].ind;
 }
 
-void heap_sink(heap_s *heap, int pos) {
-  assert(pos >= 0);
-  assert(pos < heap->size);
+/* Write the first `n` indices which would be popped from `heap` (or
+ * all of them, if it holds fewer) to `inds`, without modifying it.
+ * Each index's parent precedes it, so the next one to be popped is
+ * always a child of one found already (or the root). We keep those
+ * children as candidates and take the first of them each time.
+ * Returns the number of indices found. */
+size_t heap_peek_many(heap_s const *heap, size_t n, size_t *inds) {
+  if (heap->size == 0 || n == 0)
+    return 0;
 
-  int ch = left(pos), next = ch + 1, n = heap->size;
-  dbl cval, nval;
-  while (ch < n) {
-    cval = value(heap, ch);
-    if (next < n) {
-      nval = value(heap, next);
-      if (cval > nval) {
-        ch = next;
-        cval = nval;
-      }
-    }
-    if (value(heap, pos) > cval) {
-      heap_swap(heap, pos, ch);
-    }
-    pos = ch;
-    ch = left(pos);
-    next = ch + 1;
+  size_t cand[ARITY*n + 1], num_cand = 0;
+  cand[num_cand++] = 0;
+
+  size_t num_found = 0;
+  while (num_found < n && num_cand > 0) {
+    size_t i_min = 0;
+    for (size_t i = 1; i < num_cand; ++i)
+      if (precedes(&heap->node[cand[i]], &heap->node[cand[i_min]]))
+        i_min = i;
+
+    size_t pos = cand[i_min];
+    cand[i_min] = cand[--num_cand];
+    inds[num_found++] = heap->node[pos].ind;
+
+    size_t ch = first_child(pos);
+    for (size_t i = 0; i < ARITY && ch + i < heap->size; ++i)
+      cand[num_cand++] = ch + i;
   }
+
+  return num_found;
 }
 
 void heap_pop(heap_s *heap) {
-  size_t front_ind = heap->inds[0];
-  heap_swap(heap, 0, heap->size - 1);
-  if (--heap->size > 0) {
-    heap_sink(heap, 0);
-  }
-  heap->setpos(heap->context, front_ind, NO_INDEX);
+  assert(heap->size > 0);
+
+  size_t front_ind = heap->node[0].ind;
+  if (--heap->size > 0)
+    sift_down(heap, 0, heap->node[heap->size]);
+  heap->setpos(heap->context, front_ind, (size_t)NO_INDEX);
 }
 
-int heap_size(heap_s *heap) {
+size_t heap_size(heap_s const *heap) {
   return heap->size;
 }
@@ -0,0 +1,188 @@
+#include <jmm/hmap.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* An open addressing hash table using linear probing. The number of
+ * slots is always a power of two, and the table is kept at most half
+ * full so that probe sequences stay short. Entries are removed by
+ * shifting the rest of their probe sequence back, so there are no
+ * tombstones and lookups never slow down after many removals. */
+struct hmap {
+  char *data; /* slot `i` holds a key followed by its element */
+  bool *used;
+  size_t keysize;
+  size_t eltsize;
+  size_t nodesize;
+  size_t size;
+  size_t num_slots;
+};
+
+void hmap_alloc(hmap_s **map) {
+  *map = malloc(sizeof(hmap_s));
+}
+
+void hmap_dealloc(hmap_s **map) {
+  assert(*map != NULL);
+  free(*map);
+  *map = NULL;
+}
+
+static size_t get_num_slots(size_t capacity) {
+  size_t num_slots = 8;
+  while (num_slots < 2*capacity)
+    num_slots *= 2;
+  return num_slots;
+}
+
+/* Initialize an empty map which can hold `capacity` entries before
+ * it needs to grow. */
+void hmap_init(hmap_s *map, size_t keysize, size_t eltsize, size_t capacity) {
+  map->keysize = keysize;
+  map->eltsize = eltsize;
+  map->nodesize = keysize + eltsize;
+  map->size = 0;
+  map->num_slots = get_num_slots(capacity);
+  map->data = malloc(map->nodesize*map->num_slots);
+  map->used = calloc(map->num_slots, sizeof(bool));
+}
+
+void hmap_deinit(hmap_s *map) {
+  assert(map->data != NULL);
+  free(map->data);
+  map->data = NULL;
+
+  free(map->used);
+  map->used = NULL;
+}
+
+bool hmap_is_empty(hmap_s const *map) {
+  return map->size == 0;
+}
+
+size_t hmap_size(hmap_s const *map) {
+  return map->size;
+}
+
+/* Word-sized keys (almost always node indices) are hashed with a
+ * single Fibonacci hashing step, which mixes runs of consecutive
+ * indices well. Other keys are hashed with 64-bit FNV-1a. */
+static size_t hash(void const *key, size_t keysize) {
+  if (keysize == sizeof(uint64_t)) {
+    uint64_t k;
+    memcpy(&k, key, sizeof(uint64_t));
+    return (size_t)(k*UINT64_C(0x9e3779b97f4a7c15) >> 32);
+  }
+
+  unsigned char const *byte = key;
+  uint64_t h = 14695981039346656037ull;
+  for (size_t i = 0; i < keysize; ++i) {
+    h ^= byte[i];
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+static char *get_node(hmap_s const *map, size_t i) {
+  return map->data + map->nodesize*i;
+}
+
+/* Find the slot containing `key`, or the empty slot where it would
+ * be inserted. */
+static size_t find_slot(hmap_s const *map, void const *key) {
+  size_t mask = map->num_slots - 1;
+  size_t i = hash(key, map->keysize) & mask;
+  while (map->used[i] && memcmp(get_node(map, i), key, map->keysize))
+    i = (i + 1) & mask;
+  return i;
+}
+
+bool hmap_contains(hmap_s const *map, void const *key) {
+  return map->used[find_slot(map, key)];
+}
+
+static void grow_if_necessary(hmap_s *map) {
+  if (2*(map->size + 1) <= map->num_slots)
+    return;
+
+  char *data = map->data;
+  bool *used = map->used;
+  size_t num_slots = map->num_slots;
+
+  map->num_slots *= 2;
+  map->data = malloc(map->nodesize*map->num_slots);
+  map->used = calloc(map->num_slots, sizeof(bool));
+
+  for (size_t i = 0; i < num_slots; ++i) {
+    if (!used[i])
+      continue;
+    char const *node = data + map->nodesize*i;
+    size_t j = find_slot(map, node);
+    memcpy(get_node(map, j), node, map->nodesize);
+    map->used[j] = true;
+  }
+
+  free(data);
+  free(used);
+}
+
+/* Insert `elt` for `key` if `key` isn't in `map` yet. Returns whether
+ * anything was inserted: if `key` is already present, its element is
+ * left alone. */
+bool hmap_insert(hmap_s *map, void const *key, void const *elt) {
+  grow_if_necessary(map);
+  size_t i = find_slot(map, key);
+  if (map->used[i])
+    return false;
+  char *node = get_node(map, i);
+  memcpy(node, key, map->keysize);
+  memcpy(node + map->keysize, elt, map->eltsize);
+  map->used[i] = true;
+  ++map->size;
+  return true;
+}
+
+/* Insert `elt` for `key`, replacing any element already stored for
+ * `key`. */
+void hmap_set(hmap_s *map, void const *key, void const *elt) {
+  if (!hmap_insert(map, key, elt))
+    memcpy(get_node(map, find_slot(map, key)) + map->keysize, elt, map->eltsize);
+}
+
+bool hmap_get(hmap_s const *map, void const *key, void *elt) {
+  size_t i = find_slot(map, key);
+  if (!map->used[i])
+    return false;
+  memcpy(elt, get_node(map, i) + map->keysize, map->eltsize);
+  return true;
+}
+
+bool hmap_remove(hmap_s *map, void const *key) {
+  size_t mask = map->num_slots - 1;
+
+  size_t i = find_slot(map, key);
+  if (!map->used[i])
+    return false;
+
+  /* Walk the rest of the cluster after `i`, moving back each entry
+   * whose home slot isn't cyclically in `(i, j]`, since otherwise it
+   * would become unreachable once slot `i` is emptied */
+  for (size_t j = (i + 1) & mask; map->used[j]; j = (j + 1) & mask) {
+    size_t k = hash(get_node(map, j), map->keysize) & mask;
+    if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+      continue;
+    memcpy(get_node(map, i), get_node(map, j), map->nodesize);
+    i = j;
+  }
+  map->used[i] = false;
+  --map->size;
+
+  return true;
+}
+
+void hmap_clear(hmap_s *map) {
+  memset(map->used, 0x0, map->num_slots*sizeof(bool));
+  map->size = 0;
+}
@@ -6,6 +6,7 @@
 #include <string.h>
 
 #include <jmm/array.h>
+#include <jmm/binfile.h>
 #include <jmm/edge.h>
 #include <jmm/index.h>
 #include <jmm/mat.h>
@@ -15,6 +16,7 @@
 
 #include "macros.h"
 #include "mesh_util.h"
+#include "radix.h"
 
 typedef struct {
   size_t le[2];
@@ -55,16 +57,140 @@ int bdf_cmp(bdf_s const *f1, bdf_s const *f2) {
   return 0;
 }
 
+/* Flags describing how each vertex relates to the diffracting edges
+ * of the mesh, computed along with the rest of the boundary info. */
+typedef enum vert_flag {
+  VERT_FLAG_INC_ON_DIFF_EDGE = 1 << 0,
+  VERT_FLAG_TERMINAL_DIFF_EDGE_VERT = 1 << 1
+} vert_flag_e;
+
+/* A uniform grid of buckets over a bounding box, used to quickly find
+ * the cells of a tetrahedron mesh near a point. The bucket side
+ * length `h` is chosen so that there are about as many buckets as
+ * cells, which keeps the number of cells per bucket small and roughly
+ * independent of the size of the mesh. */
+typedef struct {
+  rect3 bbox;
+  int dim[3];
+  dbl h;
+} loc_grid_s;
+
+static void loc_grid_init(loc_grid_s *grid, rect3 const *bbox, size_t ncells) {
+  grid->bbox = *bbox;
+
+  dbl extent[3];
+  rect3_get_extent(&grid->bbox, extent);
+
+  grid->h = cbrt(extent[0]*extent[1]*extent[2]/ncells);
+  for (int i = 0; i < 3; ++i)
+    grid->dim[i] = MAX(1, (int)ceil(extent[i]/grid->h));
+}
+
+static size_t loc_grid_get_num_buckets(loc_grid_s const *grid) {
+  return (size_t)grid->dim[0]*grid->dim[1]*grid->dim[2];
+}
+
+static size_t loc_grid_get_index(loc_grid_s const *grid, int const ind[3]) {
+  return ((size_t)ind[0]*grid->dim[1] + ind[1])*grid->dim[2] + ind[2];
+}
+
+/* Get the index of the bucket containing `x`, clamped to the grid. */
+static void loc_grid_get_bucket(loc_grid_s const *grid, dbl3 const x,
+                                int ind[3]) {
+  for (int i = 0; i < 3; ++i) {
+    dbl t = floor((x[i] - grid->bbox.min[i])/grid->h);
+    ind[i] = t < 0 ? 0 : t >= grid->dim[i] ? grid->dim[i] - 1 : (int)t;
+  }
+}
+
+/* Get the range of buckets overlapped by `bbox` padded by `eps`. */
+static void loc_grid_get_range(loc_grid_s const *grid, rect3 const *bbox,
+                               dbl eps, int ind0[3], int ind1[3]) {
+  dbl3 xmin, xmax;
+  for (int i = 0; i < 3; ++i) {
+    xmin[i] = bbox->min[i] - eps;
+    xmax[i] = bbox->max[i] + eps;
+  }
+  loc_grid_get_bucket(grid, xmin, ind0);
+  loc_grid_get_bucket(grid, xmax, ind1);
+}
+
+/* Sort the `ncells` cells with bounding boxes `bbox` (padded by
+ * `eps`) into the buckets of `grid`. Each cell is tagged with the
+ * buckets it overlaps, and the tags are radix sorted, as in
+ * `init_vc`. On return, bucket `i` holds the cells
+ * `(*cells)[(*offsets)[i]:(*offsets)[i + 1]]`, in increasing
+ * order. Both arrays are allocated here. */
+static void loc_grid_sort_cells(loc_grid_s const *grid, size_t ncells,
+                                rect3 const *bbox, dbl eps,
+                                size_t **offsets, size_t **cells) {
+  /* Count the buckets overlapped by each cell... */
+  size_t *offset = malloc((ncells + 1)*sizeof(size_t));
+  offset[0] = 0;
+#pragma omp parallel for schedule(static)
+  for (size_t lc = 0; lc < ncells; ++lc) {
+    int ind0[3], ind1[3];
+    loc_grid_get_range(grid, &bbox[lc], eps, ind0, ind1);
+    offset[lc + 1] = 1;
+    for (int i = 0; i < 3; ++i)
+      offset[lc + 1] *= ind1[i] - ind0[i] + 1;
+  }
+  for (size_t lc = 0; lc < ncells; ++lc)
+    offset[lc + 1] += offset[lc];
+
+  /* ... tag each cell with the buckets it overlaps... */
+  size_t n = offset[ncells];
+  uint64_t *key = malloc(n*sizeof(uint64_t));
+  *cells = malloc(n*sizeof(size_t));
+#pragma omp parallel for schedule(static)
+  for (size_t lc = 0; lc < ncells; ++lc) {
+    int ind0[3], ind1[3], ind[3];
+    loc_grid_get_range(grid, &bbox[lc], eps, ind0, ind1);
+    size_t j = offset[lc];
+    for (ind[0] = ind0[0]; ind[0] <= ind1[0]; ++ind[0])
+      for (ind[1] = ind0[1]; ind[1] <= ind1[1]; ++ind[1])
+        for (ind[2] = ind0[2]; ind[2] <= ind1[2]; ++ind[2]) {
+          key[j] = loc_grid_get_index(grid, ind);
+          (*cells)[j++] = lc;
+        }
+  }
+
+  /* ... and sort them into buckets */
+  size_t nbuckets = loc_grid_get_num_buckets(grid);
+  radix_sort_u64(n, key, *cells, nbuckets - 1);
+  *offsets = malloc((nbuckets + 1)*sizeof(size_t));
+  radix_get_offsets(n, key, nbuckets, *offsets);
+
+  free(key);
+  free(offset);
+}
+
 struct mesh3 {
+  /* Either `POLICY_COPY`, if the mesh owns its arrays, or
+   * `POLICY_VIEW`, if they live in a binfile owned by the caller (see
+   * `mesh3_init_from_binfile`). */
+  policy_e policy;
+
   size_t nverts;
   dbl3 *verts;
 
   size_t ncells;
-  uint4 *cells;
+  index4 *cells;
 
-  size_t *vc;
+  jmm_index_t *vc;
   size_t *vc_offsets;
 
+  /* Optional vertex adjacency tables, stored in the same compressed
+   * format as `vc` and `vc_offsets`. The faces opposite each vertex
+   * are stored in the same order as `vc`, so `vf` is indexed using
+   * `vc_offsets`. */
+  bool has_adj_info;
+  jmm_index_t *vv;
+  size_t *vv_offsets;
+  index2 *ve;
+  size_t *ve_offsets;
+  index3 *vf;
+
   size_t (*edges)[2];
   size_t nedges;
 
@@ -82,6 +208,16 @@ struct mesh3 {
   size_t num_bde_labels;
   size_t *bde_label;
 
+  /* Per-vertex diffracting edge info: a `vert_flag_e` bitmask for
+   * each vertex, the indices into `bde` of the diffracting edges
+   * incident on each vertex (in the order `mesh3_vv` visits them),
+   * and the distinct labels of those edges. */
+  uint8_t *vert_flags;
+  size_t *vde;
+  size_t *vde_offsets;
+  size_t *vdl;
+  size_t *vdl_offsets;
+
   /* "Mesh epsilon": a small parameter derived from the mesh, used to
    * make geometric calculations a bit more robust. */
   dbl eps;
@@ -91,10 +227,18 @@ struct mesh3 {
   dbl min_edge_length;
   dbl mean_edge_length;
   dbl diam;
+
+  /* A uniform grid of buckets over the bounding box of the mesh, used
+   * to locate the cell containing a point. Bucket `i` holds the cells
+   * whose (slightly padded) bounding boxes overlap it, in increasing
+   * order, in `loc_cells[loc_offsets[i]:loc_offsets[i + 1]]`. */
+  loc_grid_s loc_grid;
+  jmm_index_t *loc_cells;
+  size_t *loc_offsets;
 };
 
 tri3 mesh3_tetra_get_face(mesh3_tetra_s const *tetra, int f[3]) {
-  size_t *cv = tetra->mesh->cells[tetra->l];
+  jmm_index_t const *cv = tetra->mesh->cells[tetra->l];
   dbl (*verts)[3] = tetra->mesh->verts;
   tri3 tri;
   memcpy(tri.v[0], verts[cv[f[0]]], sizeof(dbl[3]));
@@ -147,13 +291,6 @@ void mesh3_data_append_cells(mesh3_data_s *data, size_t n, uint4 const C[4]) {
   data->ncells += n;
 }
 
-void mesh3_data_delete_cell(mesh3_data_s *data, size_t lc0) {
-  --data->ncells;
-  for (size_t lc = lc0; lc < data->ncells; ++lc)
-    memcpy(data->cells[lc], data->cells[lc + 1], sizeof(uint4));
-  data->cells = realloc(data->cells, data->ncells*sizeof(uint4));
-}
-
 bool mesh3_data_cell_contains_point(mesh3_data_s const *data, size_t lc,
                                     dbl3 const x, dbl eps) {
   tetra3 tetra;
@@ -169,23 +306,175 @@ size_t mesh3_data_find_cell_containing_point(mesh3_data_s const *data, dbl3 cons
   return (size_t)NO_INDEX;
 }
 
-error_e mesh3_data_insert_vert(mesh3_data_s *data, dbl3 const x, dbl eps) {
-  size_t lc = mesh3_data_find_cell_containing_point(data, x, eps);
-  if (lc == (size_t)NO_INDEX)
-    return BAD_ARGUMENT;
+/* A node in the tree of cells which an original cell of a
+ * `mesh3_data_s` is split into by `mesh3_data_insert_verts`. Each
+ * split cell has four children, and the leaves are the current cells
+ * of the `mesh3_data_s`. */
+typedef struct {
+  uint4 cv;
+  size_t lc; // index of the cell in the `mesh3_data_s`, if a leaf
+  size_t child; // index of the first of four children, or `NO_INDEX`
+} data_loc_node_s;
+
+/* A `loc_grid_s` over the original cells of a `mesh3_data_s`, set up
+ * like the one in `mesh3_s` (see `init_loc`), together with the trees
+ * of nodes rooted at the original cells (node `lc` is the root for
+ * cell `lc`). */
+typedef struct {
+  loc_grid_s grid;
+  size_t *cells;
+  size_t *offsets;
+
+  size_t num_nodes;
+  data_loc_node_s *node;
+} data_loc_s;
+
+/* Set up `loc` for `data`, with enough room for `n` insertions. */
+static void data_loc_init(data_loc_s *loc, mesh3_data_s const *data,
+                          size_t n, dbl eps) {
+  rect3 bbox = rect3_get_bounding_box_for_points(data->nverts, data->verts);
+  loc_grid_init(&loc->grid, &bbox, data->ncells);
+
+  rect3 *cell_bbox = malloc(data->ncells*sizeof(rect3));
+  for (size_t lc = 0; lc < data->ncells; ++lc) {
+    cell_bbox[lc] = rect3_make_empty();
+    for (size_t i = 0; i < 4; ++i)
+      rect3_insert_point(&cell_bbox[lc], data->verts[data->cells[lc][i]]);
+  }
+
+  loc_grid_sort_cells(&loc->grid, data->ncells, cell_bbox, eps,
+                      &loc->offsets, &loc->cells);
+
+  free(cell_bbox);
+
+  /* Each insertion adds four nodes */
+  loc->num_nodes = data->ncells;
+  loc->node = malloc((data->ncells + 4*n)*sizeof(data_loc_node_s));
+  for (size_t lc = 0; lc < data->ncells; ++lc) {
+    memcpy(loc->node[lc].cv, data->cells[lc], sizeof(uint4));
+    loc->node[lc].lc = lc;
+    loc->node[lc].child = (size_t)NO_INDEX;
+  }
+}
+
+static void data_loc_deinit(data_loc_s *loc) {
+  free(loc->cells);
+  free(loc->offsets);
+  free(loc->node);
+}
+
+/* Find the original cell of `data` containing `x`. Since these are
+ * never modified, this can be done before inserting any vertices. */
+static size_t data_loc_find_root(data_loc_s const *loc, mesh3_data_s const *data,
+                                 dbl3 const x, dbl eps) {
+  int ind[3];
+  loc_grid_get_bucket(&loc->grid, x, ind);
+  size_t i = loc_grid_get_index(&loc->grid, ind);
+  for (size_t p = loc->offsets[i]; p < loc->offsets[i + 1]; ++p) {
+    tetra3 tetra;
+    for (size_t j = 0; j < 4; ++j)
+      dbl3_copy(data->verts[loc->node[loc->cells[p]].cv[j]], tetra.v[j]);
+    if (tetra3_contains_point(&tetra, x, &eps))
+      return loc->cells[p];
+  }
+  return (size_t)NO_INDEX;
+}
 
-  size_t lv = mesh3_data_append_vert(data, x);
+/* Walk down the tree rooted at node `k` to the leaf containing
+ * `x`. At each level we go to the child in which `x` is furthest from
+ * the boundary (i.e., has the largest minimum barycentric
+ * coordinate), which is the one containing `x` up to roundoff. */
+static size_t data_loc_find_leaf(data_loc_s const *loc, mesh3_data_s const *data,
+                                 size_t k, dbl3 const x) {
+  while (loc->node[k].child != (size_t)NO_INDEX) {
+    size_t k_best = (size_t)NO_INDEX;
+    dbl b_best = -INFINITY;
+    for (size_t i = 0; i < 4; ++i) {
+      size_t k_child = loc->node[k].child + i;
+      tetra3 tetra;
+      for (size_t j = 0; j < 4; ++j)
+        dbl3_copy(data->verts[loc->node[k_child].cv[j]], tetra.v[j]);
+      dbl4 b;
+      tetra3_get_bary_coords(&tetra, x, b);
+      dbl b_min, b_max;
+      dblN_minmax(b, 4, &b_min, &b_max);
+      if (b_min > b_best) {
+        k_best = k_child;
+        b_best = b_min;
+      }
+    }
+    k = k_best;
+  }
+  return k;
+}
 
-  uint4 cells[4];
+/* Split the cell of `data` at leaf `k` into four by connecting its
+ * vertices to vertex `lv`. The first new cell replaces the old one
+ * and the other three are appended to `data->cells`, which must have
+ * room for them. */
+static void data_loc_split_leaf(data_loc_s *loc, mesh3_data_s *data,
+                                size_t k, size_t lv) {
+  data_loc_node_s *node = &loc->node[k];
+  node->child = loc->num_nodes;
   for (size_t i = 0; i < 4; ++i) {
-    memcpy(cells[i], data->cells[lc], sizeof(uint4));
-    cells[i][i] = lv;
+    data_loc_node_s *child = &loc->node[loc->num_nodes++];
+    memcpy(child->cv, node->cv, sizeof(uint4));
+    child->cv[i] = lv;
+    child->lc = i == 0 ? node->lc : data->ncells++;
+    child->child = (size_t)NO_INDEX;
+    memcpy(data->cells[child->lc], child->cv, sizeof(uint4));
+  }
+}
+
+/* Insert the `n` points `x` into `data` as new vertices, in order,
+ * splitting the cell containing each into four. If any of the points
+ * don't lie in a cell (up to `eps`), nothing is inserted and
+ * `BAD_ARGUMENT` is returned.
+ *
+ * This sets up a grid over the cells once and keeps track of how they
+ * are split, so that after O(number of cells) setup, each insertion
+ * takes O(1) time for points which are spread out over the mesh. */
+error_e mesh3_data_insert_verts(mesh3_data_s *data, size_t n, dbl3 const *x,
+                                dbl eps) {
+  if (data->ncells == 0)
+    return BAD_ARGUMENT;
+
+  data_loc_s loc;
+  data_loc_init(&loc, data, n, eps);
+
+  error_e error = SUCCESS;
+
+  size_t *root = malloc(n*sizeof(size_t));
+  for (size_t i = 0; i < n; ++i) {
+    root[i] = data_loc_find_root(&loc, data, x[i], eps);
+    if (root[i] == (size_t)NO_INDEX)
+      error = BAD_ARGUMENT;
   }
 
-  mesh3_data_delete_cell(data, lc);
-  mesh3_data_append_cells(data, 4, cells);
+  if (error == SUCCESS) {
+    data->verts = realloc(data->verts, (data->nverts + n)*sizeof(dbl3));
+    data->cells = realloc(data->cells, (data->ncells + 3*n)*sizeof(uint4));
+    for (size_t i = 0; i < n; ++i) {
+      size_t k = data_loc_find_leaf(&loc, data, root[i], x[i]);
+      size_t lv = data->nverts++;
+      dbl3_copy(x[i], data->verts[lv]);
+      data_loc_split_leaf(&loc, data, k, lv);
+    }
+  }
+
+  free(root);
 
-  return SUCCESS;
+  data_loc_deinit(&loc);
+
+  return error;
+}
+
+/* Insert a single vertex into `data`. This sets up the same grid as
+ * `mesh3_data_insert_verts`, so each call costs O(number of cells):
+ * to insert several vertices, use `mesh3_data_insert_verts`
+ * instead. */
+error_e mesh3_data_insert_vert(mesh3_data_s *data, dbl3 const x, dbl eps) {
+  return mesh3_data_insert_verts(data, 1, (dbl3 const *)x, eps);
 }
 
 void mesh3_alloc(mesh3_s **mesh) {
@@ -197,99 +486,202 @@ void mesh3_dealloc(mesh3_s **mesh) {
   *mesh = NULL;
 }
 
+/* Build the compressed table of cells incident on each vertex. Each
+ * (vertex, cell) incidence is keyed by its vertex and radix sorted,
+ * which keeps the cells incident on each vertex in increasing order,
+ * after which the offsets can be read off of the sorted keys. */
 static void init_vc(mesh3_s *mesh) {
-  // Allocate space to count the number of cells incident on each
-  // vertex.
-  int *nvc = calloc(mesh->nverts, sizeof(int));
+  size_t n = 4*mesh->ncells;
 
-  // Traverse the cells, incrementing the count of each incident
-  // vertex.
-  for (size_t i = 0; i < mesh->ncells; ++i) {
-    for (int j = 0; j < 4; ++j) {
-      size_t k = mesh->cells[i][j];
-      assert(k < mesh->nverts);
-      ++nvc[k];
-    }
+  uint64_t *key = malloc(n*sizeof(uint64_t));
+  size_t *lc = malloc(n*sizeof(size_t));
+
+#pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < n; ++i) {
+    key[i] = mesh->cells[i/4][i%4];
+    assert(key[i] < mesh->nverts);
+    lc[i] = i/4;
   }
 
-  // Compute the offsets into the array of vc's. The last entry
-  // contains the length of the number of elements pointed to by vc.
+  radix_sort_u64(n, key, lc, mesh->nverts - 1);
+
   size_t *vc_offsets = malloc(sizeof(size_t)*(mesh->nverts + 1));
-  vc_offsets[0] = 0;
+  radix_get_offsets(n, key, mesh->nverts, vc_offsets);
+
+  jmm_index_t *vc = malloc(n*sizeof(jmm_index_t));
+#pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < n; ++i)
+    vc[i] = lc[i];
+
+  mesh->vc = vc;
+  mesh->vc_offsets = vc_offsets;
+
+  free(lc);
+  free(key);
+}
+
+static void get_opposite_edges(jmm_index_t const cv[4], size_t lv, edge_s edge[3]) {
+  size_t l[3];
+  for (int i = 0, j = 0; i < 4; ++i) {
+    if (cv[i] == lv)
+      continue;
+    l[j++] = cv[i];
+  }
+  edge[0] = make_edge(l[0], l[1]);
+  edge[1] = make_edge(l[1], l[2]);
+  edge[2] = make_edge(l[2], l[0]);
+}
+
+/* Build the vertex-vertex adjacency table. Each vertex's neighbors
+ * are stored in the order they're first encountered while traversing
+ * its incident cells, which matches the order `mesh3_vv` has always
+ * returned them in. */
+static void init_vv(mesh3_s *mesh) {
+  // Mark each vertex with the index of the last vertex whose
+  // neighborhood it was added to. This lets us deduplicate without
+  // searching.
+  size_t *mark = malloc(mesh->nverts*sizeof(size_t));
+  for (size_t i = 0; i < mesh->nverts; ++i)
+    mark[i] = (size_t)NO_INDEX;
+
+  // Each incident cell contributes at most three new neighbors, so
+  // we can bound the total size by 3*|vc|, fill, and shrink after.
+  jmm_index_t *vv = malloc(3*mesh->vc_offsets[mesh->nverts]*sizeof(jmm_index_t));
+  size_t *vv_offsets = malloc((mesh->nverts + 1)*sizeof(size_t));
+
+  size_t k = 0;
   for (size_t i = 0; i < mesh->nverts; ++i) {
-    vc_offsets[i + 1] = vc_offsets[i] + nvc[i];
+    vv_offsets[i] = k;
+    for (size_t p = mesh->vc_offsets[i]; p < mesh->vc_offsets[i + 1]; ++p) {
+      jmm_index_t const *cell = mesh->cells[mesh->vc[p]];
+      for (int q = 0; q < 4; ++q) {
+        size_t j = cell[q];
+        if (j == i || mark[j] == i)
+          continue;
+        mark[j] = i;
+        vv[k++] = j;
+      }
+    }
   }
+  vv_offsets[mesh->nverts] = k;
 
-  // To avoid allocating a new block of memory, we zero out nvc here
-  // and use it to store indices past the corresponding vc_offsets
-  memset(nvc, 0x0, sizeof(int)*mesh->nverts);
+  mesh->vv = realloc(vv, k*sizeof(jmm_index_t));
+  mesh->vv_offsets = vv_offsets;
 
-  // Now that we've allocated some space and have the required offsets
-  // into the array, we can traverse the cells again and fill the
-  // array of vc's.
-  size_t *vc = malloc(sizeof(size_t)*vc_offsets[mesh->nverts]);
-  for (size_t i = 0; i < mesh->ncells; ++i) {
-    for (int j = 0; j < 4; ++j) {
-      size_t k = mesh->cells[i][j];
-      vc[vc_offsets[k] + nvc[k]++] = i;
+  free(mark);
+}
+
+/* Build the vertex-edge adjacency table (the edges opposite each
+ * vertex in its incident cells). This needs `mesh->vv`, which we use
+ * to map the edges around each vertex into a small local index space
+ * so that we can deduplicate them using a bitmap. */
+static void init_ve(mesh3_s *mesh) {
+  size_t *loc = malloc(mesh->nverts*sizeof(size_t));
+
+  size_t max_nvv = 0;
+  for (size_t i = 0; i < mesh->nverts; ++i)
+    max_nvv = MAX(max_nvv, mesh->vv_offsets[i + 1] - mesh->vv_offsets[i]);
+  bool *seen = calloc(max_nvv*max_nvv, sizeof(bool));
+
+  index2 *ve = malloc(3*mesh->vc_offsets[mesh->nverts]*sizeof(index2));
+  size_t *ve_offsets = malloc((mesh->nverts + 1)*sizeof(size_t));
+
+  size_t k = 0;
+  for (size_t i = 0; i < mesh->nverts; ++i) {
+    jmm_index_t const *vv = &mesh->vv[mesh->vv_offsets[i]];
+    size_t nvv = mesh->vv_offsets[i + 1] - mesh->vv_offsets[i];
+    for (size_t p = 0; p < nvv; ++p)
+      loc[vv[p]] = p;
+
+    ve_offsets[i] = k;
+    for (size_t p = mesh->vc_offsets[i]; p < mesh->vc_offsets[i + 1]; ++p) {
+      edge_s edge[3];
+      get_opposite_edges(mesh->cells[mesh->vc[p]], i, edge);
+      for (int q = 0; q < 3; ++q) {
+        size_t a = loc[edge[q].l[0]], b = loc[edge[q].l[1]];
+        SORT2(a, b);
+        if (seen[a*nvv + b])
+          continue;
+        seen[a*nvv + b] = true;
+        ve[k][0] = edge[q].l[0];
+        ve[k][1] = edge[q].l[1];
+        ++k;
+      }
     }
+
+    memset(seen, 0x0, nvv*nvv*sizeof(bool));
   }
+  ve_offsets[mesh->nverts] = k;
 
-  mesh->vc = vc;
-  mesh->vc_offsets = vc_offsets;
+  mesh->ve = realloc(ve, k*sizeof(index2));
+  mesh->ve_offsets = ve_offsets;
 
-  free(nvc);
+  free(seen);
+  free(loc);
+}
+
+/* Build the vertex-face adjacency table. The faces are stored in the
+ * same order as `vc`. */
+static void init_vf(mesh3_s *mesh) {
+  mesh->vf = malloc(mesh->vc_offsets[mesh->nverts]*sizeof(index3));
+  for (size_t i = 0; i < mesh->nverts; ++i) {
+    for (size_t p = mesh->vc_offsets[i]; p < mesh->vc_offsets[i + 1]; ++p) {
+      jmm_index_t const *cell = mesh->cells[mesh->vc[p]];
+      for (int j = 0, k = 0; j < 4; ++j)
+        if (cell[j] != i)
+          mesh->vf[p][k++] = cell[j];
+    }
+  }
+}
+
+static void init_adj(mesh3_s *mesh) {
+  init_vv(mesh);
+  init_ve(mesh);
+  init_vf(mesh);
 }
 
 static void init_edges(mesh3_s *mesh) {
-  array_s *edge_arr;
-  array_alloc(&edge_arr);
-  array_init(edge_arr, sizeof(size_t[2]), ARRAY_DEFAULT_CAPACITY);
+  size_t n = 6*mesh->ncells;
 
   /* Initially accumulate all the cell edges into one big array */
+  size_t (*edge)[2] = malloc(n*sizeof(size_t[2]));
   size_t ie[6][2] = {{0, 1}, {0, 2}, {0, 3}, {1, 2}, {1, 3}, {2, 3}};
+#pragma omp parallel for schedule(static)
   for (size_t lc = 0; lc < mesh->ncells; ++lc) {
-    size_t const *cell = mesh->cells[lc];
+    jmm_index_t const *cell = mesh->cells[lc];
     for (size_t i = 0; i < 6; ++i) {
-      size_t le[2] = {cell[ie[i][0]], cell[ie[i][1]]};
-      SORT2(le[0], le[1]);
-      array_append(edge_arr, &le);
+      size_t *le = edge[6*lc + i];
+      le[0] = cell[ie[i][0]];
+      le[1] = cell[ie[i][1]];
+      SORT_UINT2(le);
     }
   }
 
   /* Sort the array */
-  array_sort(edge_arr, (compar_t)edge_cmp);
-
-  array_s *unique_edge_arr;
-  array_alloc(&unique_edge_arr);
-  array_init(unique_edge_arr, sizeof(size_t[2]), ARRAY_DEFAULT_CAPACITY);
-
-  /* Pull out the unique edges into a new array */
-  size_t n = array_size(edge_arr);
-  for (size_t i = 0, le[2]; i < n; ) {
-    array_get(edge_arr, i++, &le);
-    array_append(unique_edge_arr, &le);
-    while (i < n && !edge_cmp(le, array_get_ptr(edge_arr, i)))
-      ++i;
+  size_t *perm = radix_sort_tuples(n, 2, &edge[0][0], mesh->nverts);
+
+  /* Count the unique edges... */
+  mesh->nedges = 0;
+  for (size_t i = 0; i < n; ++i)
+    if (i == 0 || edge_cmp(edge[perm[i - 1]], edge[perm[i]]))
+      ++mesh->nedges;
+
+  /* ... and pull them out */
+  mesh->edges = malloc(mesh->nedges*sizeof(size_t[2]));
+  for (size_t i = 0, j = 0; i < n; ++i) {
+    if (i == 0 || edge_cmp(edge[perm[i - 1]], edge[perm[i]])) {
+      memcpy(mesh->edges[j++], edge[perm[i]], sizeof(size_t[2]));
+    }
   }
 
-  /* Copy the edges over */
-  mesh->nedges = array_size(unique_edge_arr);
-  size_t nbytes = mesh->nedges*sizeof(size_t[2]);
-  mesh->edges = malloc(nbytes);
-  memcpy(mesh->edges, array_get_ptr(unique_edge_arr, 0), nbytes);
-
   /* Sanity check */
 #if JMM_DEBUG
   for (size_t i = 1; i < mesh->nedges; ++i)
     assert(edge_cmp(mesh->edges[i - 1], mesh->edges[i]));
 #endif
 
-  array_deinit(unique_edge_arr);
-  array_dealloc(&unique_edge_arr);
-
-  array_deinit(edge_arr);
-  array_dealloc(&edge_arr);
+  free(perm);
+  free(edge);
 }
 
 static void get_op_edge(mesh3_s const *mesh, size_t lc, size_t const le[2],
@@ -584,6 +976,90 @@ cleanup:
   return done;
 }
 
+/* Find the diffracting edges incident on each vertex, storing their
+ * indices into `mesh->bde` in `mesh->vde`, and flag the vertices that
+ * have any. Diffracting edges are boundary edges, so we only need to
+ * look at the neighborhoods of boundary vertices. */
+static void init_vde(mesh3_s *mesh) {
+  mesh->vert_flags = calloc(mesh->nverts, sizeof(uint8_t));
+
+  array_s *vde_arr;
+  array_alloc(&vde_arr);
+  array_init(vde_arr, sizeof(size_t), ARRAY_DEFAULT_CAPACITY);
+
+  mesh->vde_offsets = malloc((mesh->nverts + 1)*sizeof(size_t));
+
+  size_t nvv_max = 0, *vv = NULL;
+
+  for (size_t l = 0; l < mesh->nverts; ++l) {
+    mesh->vde_offsets[l] = array_size(vde_arr);
+
+    if (!mesh->bdv[l])
+      continue;
+
+    size_t nvv = mesh3_nvv(mesh, l);
+    if (nvv > nvv_max) {
+      nvv_max = nvv;
+      vv = realloc(vv, nvv_max*sizeof(size_t));
+    }
+    mesh3_vv(mesh, l, vv);
+
+    for (size_t i = 0; i < nvv; ++i) {
+      bde_s q = make_bde(l, vv[i]);
+      size_t le = find_bde(mesh, &q);
+      if (le == (size_t)NO_INDEX || !mesh->bde[le].diff)
+        continue;
+      array_append(vde_arr, &le);
+      mesh->vert_flags[l] |= VERT_FLAG_INC_ON_DIFF_EDGE;
+    }
+  }
+
+  size_t nvde = array_size(vde_arr);
+  mesh->vde_offsets[mesh->nverts] = nvde;
+  mesh->vde = malloc(nvde*sizeof(size_t));
+  if (nvde > 0)
+    memcpy(mesh->vde, array_get_ptr(vde_arr, 0), nvde*sizeof(size_t));
+
+  free(vv);
+
+  array_deinit(vde_arr);
+  array_dealloc(&vde_arr);
+}
+
+/* Collect the distinct diffractor labels incident on each vertex. A
+ * vertex is a terminal diffracting edge vertex if none of its
+ * incident diffracting edges share a label (i.e., it's where one or
+ * more diffractors end instead of a vertex in the middle of one). */
+static void init_vdl(mesh3_s *mesh) {
+  mesh->vdl = malloc(mesh->vde_offsets[mesh->nverts]*sizeof(size_t));
+  mesh->vdl_offsets = malloc((mesh->nverts + 1)*sizeof(size_t));
+
+  size_t k = 0;
+  for (size_t l = 0; l < mesh->nverts; ++l) {
+    mesh->vdl_offsets[l] = k;
+
+    size_t const *vde = &mesh->vde[mesh->vde_offsets[l]];
+    size_t nvde = mesh->vde_offsets[l + 1] - mesh->vde_offsets[l];
+    if (nvde == 0)
+      continue;
+
+    bool terminal = true;
+    for (size_t i = 0; i < nvde; ++i) {
+      size_t label = mesh->bde_label[vde[i]];
+      assert(label != NO_LABEL);
+      if (contains(&mesh->vdl[mesh->vdl_offsets[l]], k - mesh->vdl_offsets[l],
+                   &label, sizeof(size_t)))
+        terminal = false;
+      else
+        mesh->vdl[k++] = label;
+    }
+
+    if (terminal)
+      mesh->vert_flags[l] |= VERT_FLAG_TERMINAL_DIFF_EDGE_VERT;
+  }
+  mesh->vdl_offsets[mesh->nverts] = k;
+}
+
 static void init_bde_labels(mesh3_s *mesh) {
   /* Allocate and initialize all labels with `NO_LABEL` */
   mesh->bde_label = malloc(mesh->nbde*sizeof(size_t));
@@ -596,6 +1072,10 @@ static void init_bde_labels(mesh3_s *mesh) {
   /* Label each diffractor */
   while (!label_diffractor(mesh))
     ++mesh->num_bde_labels;
+
+  /* Now that the diffractors are labeled, gather up the labels
+   * incident on each vertex */
+  init_vdl(mesh);
 }
 
 /**
@@ -612,24 +1092,34 @@ static void init_bd(mesh3_s *mesh) {
   mesh->bdc = calloc(mesh->ncells, sizeof(bool));
   mesh->bdv = calloc(mesh->nverts, sizeof(bool));
 
-  // Allocate some space for the faces of each cell in the mesh.
+  // Collect the faces of each cell in the mesh, with the vertices of
+  // each face sorted.
   size_t nf = 4*mesh->ncells;
-  bdf_s *f = malloc(nf*sizeof(bdf_s));
-
-  // Traverse the cells in the mesh, and populate `f`. These faces are
-  // "tagged", meaning that they have a backpointer to the originating
-  // cell.
-  size_t *C;
+  size_t (*face)[3] = malloc(nf*sizeof(size_t[3]));
+  size_t iv[4][3] = {{0, 1, 2}, {0, 1, 3}, {0, 2, 3}, {1, 2, 3}};
+#pragma omp parallel for schedule(static)
   for (size_t lc = 0; lc < mesh->ncells; ++lc) {
-    C = mesh->cells[lc];
-    f[4*lc] = make_bdf(C[0], C[1], C[2], lc);
-    f[4*lc + 1] = make_bdf(C[0], C[1], C[3], lc);
-    f[4*lc + 2] = make_bdf(C[0], C[2], C[3], lc);
-    f[4*lc + 3] = make_bdf(C[1], C[2], C[3], lc);
+    jmm_index_t const *C = mesh->cells[lc];
+    for (int i = 0; i < 4; ++i) {
+      size_t *l = face[4*lc + i];
+      for (int j = 0; j < 3; ++j)
+        l[j] = C[iv[i][j]];
+      SORT_UINT3(l);
+    }
   }
 
-  // Sort the tagged faces themselves into a dictionary order.
-  qsort(f, nf, sizeof(bdf_s), (compar_t)bdf_cmp);
+  // Sort the faces into a dictionary order, and populate `f` with
+  // them. These faces are "tagged", meaning that they have a
+  // backpointer to the originating cell.
+  size_t *perm = radix_sort_tuples(nf, 3, &face[0][0], mesh->nverts);
+  bdf_s *f = malloc(nf*sizeof(bdf_s));
+#pragma omp parallel for schedule(static)
+  for (size_t l = 0; l < nf; ++l) {
+    memcpy(f[l].lf, face[perm[l]], sizeof(size_t[3]));
+    f[l].lc = perm[l]/4;
+  }
+  free(perm);
+  free(face);
 
   /**
    * Set up the boundary vertex, cell, face data structures (stored in
@@ -684,9 +1174,9 @@ static void init_bd(mesh3_s *mesh) {
   assert(lf == mesh->nbdf); // sanity
   assert(lf > 0);           // check
 
-  // Sort the faces so that we can quickly query whether a face is a
-  // boundary face or not.
-  qsort(mesh->bdf, mesh->nbdf, sizeof(bdf_s), (compar_t)bdf_cmp);
+  // Note: there's no need to sort mesh->bdf so that we can quickly
+  // query whether a face is a boundary face or not, since it's
+  // pulled out of `f` in order.
 
   /**
    * Set up the boundary edge data structure (stored in `mesh->bde`)
@@ -725,9 +1215,13 @@ static void init_bd(mesh3_s *mesh) {
   assert(le > 0);           // check
 
   /* Check whether each boundary edge is a diffracting edge */
+#pragma omp parallel for schedule(dynamic)
   for (size_t l = 0; l < mesh->nbde; ++l)
     mesh->bde[l].diff = edge_is_diff(mesh, mesh->bde[l].le);
 
+  /* Record which diffracting edges are incident on each vertex */
+  init_vde(mesh);
+
   // Cleanup
   free(bde);
   free(f);
@@ -735,63 +1229,113 @@ static void init_bd(mesh3_s *mesh) {
 
 static void compute_geometric_quantities(mesh3_s *mesh) {
   // Compute minimum tetrahedron altitude
-  mesh->min_tetra_alt = INFINITY;
+  dbl min_tetra_alt = INFINITY;
+#pragma omp parallel for schedule(static) reduction(min:min_tetra_alt)
   for (size_t l = 0; l < mesh->ncells; ++l) {
     dbl x[4][3];
     for (int i = 0; i < 4; ++i)
       mesh3_copy_vert(mesh, mesh->cells[l][i], x[i]);
     dbl h = min_tetra_altitude(x);
-    mesh->min_tetra_alt = fmin(mesh->min_tetra_alt, h);
+    min_tetra_alt = fmin(min_tetra_alt, h);
   }
+  mesh->min_tetra_alt = min_tetra_alt;
 
-  /* Compute the minimum edge length */
-  mesh->min_edge_length = INFINITY;
+  /* Compute the minimum and mean edge lengths */
+  dbl min_edge_length = INFINITY, sum_edge_length = 0;
+#pragma omp parallel for schedule(static) \
+  reduction(min:min_edge_length) reduction(+:sum_edge_length)
   for (size_t i = 0; i < mesh->nedges; ++i) {
     size_t const *le = mesh->edges[i];
     dbl h = dbl3_dist(mesh->verts[le[0]], mesh->verts[le[1]]);
-    mesh->min_edge_length = fmin(h, mesh->min_edge_length);
+    min_edge_length = fmin(h, min_edge_length);
+    sum_edge_length += h;
   }
-
-  /* Compute mean edge length */
-  mesh->mean_edge_length = 0;
-  for (size_t i = 0; i < mesh->nedges; ++i) {
-    size_t const *le = mesh->edges[i];
-    dbl h = dbl3_dist(mesh->verts[le[0]], mesh->verts[le[1]]);
-    mesh->mean_edge_length += h;
-  }
-  mesh->mean_edge_length /= mesh->nedges;
+  mesh->min_edge_length = min_edge_length;
+  mesh->mean_edge_length = sum_edge_length/mesh->nedges;
 
   /* Approximate the diameter */
   mesh->diam = mesh3_diam_2approx_rand(mesh, 100, NULL);
 }
 
-void mesh3_init(mesh3_s *mesh, mesh3_data_s const *data,
-                bool compute_bd_info, dbl const *eps) {
+/* Build the grid used by `mesh3_find_cell_containing_point`. */
+static void init_loc(mesh3_s *mesh) {
+  rect3 bbox;
+  mesh3_get_bbox(mesh, &bbox);
+  loc_grid_init(&mesh->loc_grid, &bbox, mesh->ncells);
+
+  rect3 *cell_bbox = malloc(mesh->ncells*sizeof(rect3));
+#pragma omp parallel for schedule(static)
+  for (size_t lc = 0; lc < mesh->ncells; ++lc)
+    mesh3_get_cell_bbox(mesh, lc, &cell_bbox[lc]);
+
+  size_t *loc_cells;
+  loc_grid_sort_cells(&mesh->loc_grid, mesh->ncells, cell_bbox, mesh->eps,
+                      &mesh->loc_offsets, &loc_cells);
+
+  size_t n = mesh->loc_offsets[loc_grid_get_num_buckets(&mesh->loc_grid)];
+  mesh->loc_cells = malloc(n*sizeof(jmm_index_t));
+#pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < n; ++i)
+    mesh->loc_cells[i] = loc_cells[i];
+
+  free(loc_cells);
+  free(cell_bbox);
+}
+
+/* Initialize `mesh` from `data`. The largest index is reserved for
+ * `NO_INDEX`, so a mesh with `JMM_INDEX_MAX` or more vertices or
+ * cells can't be represented with the configured `jmm_index_t`. In
+ * that case nothing is allocated and `JMM_ERROR_BAD_ARGUMENTS` is
+ * returned (reconfigure with `-Dindex_width=64` to fix this). */
+jmm_error_e mesh3_init(mesh3_s *mesh, mesh3_data_s const *data,
+                       bool compute_bd_info, bool compute_adj_info,
+                       dbl const *eps) {
+  if (data->nverts >= JMM_INDEX_MAX || data->ncells >= JMM_INDEX_MAX)
+    return JMM_ERROR_BAD_ARGUMENTS;
+
+  mesh->policy = POLICY_COPY;
+
   mesh->verts = malloc(data->nverts*sizeof(dbl3));
   memcpy(mesh->verts, data->verts, data->nverts*sizeof(dbl3));
   mesh->nverts = data->nverts;
 
-  mesh->cells = malloc(data->ncells*sizeof(uint4));
-  memcpy(mesh->cells, data->cells, data->ncells*sizeof(uint4));
+  mesh->cells = malloc(data->ncells*sizeof(index4));
+#pragma omp parallel for schedule(static)
+  for (size_t lc = 0; lc < data->ncells; ++lc)
+    for (int i = 0; i < 4; ++i)
+      mesh->cells[lc][i] = data->cells[lc][i];
   mesh->ncells = data->ncells;
 
   init_vc(mesh);
 
+  mesh->has_adj_info = compute_adj_info;
+  if (compute_adj_info)
+    init_adj(mesh);
+
   init_edges(mesh);
 
   compute_geometric_quantities(mesh);
 
   mesh->eps = eps ? *eps : EPS;
 
+  init_loc(mesh);
+
   mesh->has_bd_info = compute_bd_info;
   if (compute_bd_info) {
     init_bd(mesh);
     init_bdf_labels(mesh);
     init_bde_labels(mesh);
   }
+
+  return JMM_ERROR_NONE;
 }
 
 void mesh3_deinit(mesh3_s *mesh) {
+  if (mesh->policy == POLICY_VIEW) {
+    mesh->policy = POLICY_INVALID;
+    return;
+  }
+
   free(mesh->verts);
   free(mesh->cells);
   free(mesh->edges);
@@ -804,6 +1348,26 @@ void mesh3_deinit(mesh3_s *mesh) {
   mesh->vc = NULL;
   mesh->vc_offsets = NULL;
 
+  free(mesh->loc_cells);
+  free(mesh->loc_offsets);
+
+  mesh->loc_cells = NULL;
+  mesh->loc_offsets = NULL;
+
+  if (mesh->has_adj_info) {
+    free(mesh->vv);
+    free(mesh->vv_offsets);
+    free(mesh->ve);
+    free(mesh->ve_offsets);
+    free(mesh->vf);
+
+    mesh->vv = NULL;
+    mesh->vv_offsets = NULL;
+    mesh->ve = NULL;
+    mesh->ve_offsets = NULL;
+    mesh->vf = NULL;
+  }
+
   if (mesh->has_bd_info) {
     free(mesh->bdc);
     free(mesh->bdv);
@@ -811,6 +1375,11 @@ void mesh3_deinit(mesh3_s *mesh) {
     free(mesh->bde);
     free(mesh->bdf_label);
     free(mesh->bde_label);
+    free(mesh->vert_flags);
+    free(mesh->vde);
+    free(mesh->vde_offsets);
+    free(mesh->vdl);
+    free(mesh->vdl_offsets);
 
     mesh->bdc = NULL;
     mesh->bdv = NULL;
@@ -818,14 +1387,236 @@ void mesh3_deinit(mesh3_s *mesh) {
     mesh->bde = NULL;
     mesh->bdf_label = NULL;
     mesh->bde_label = NULL;
+    mesh->vert_flags = NULL;
+    mesh->vde = NULL;
+    mesh->vde_offsets = NULL;
+    mesh->vdl = NULL;
+    mesh->vdl_offsets = NULL;
   }
+
+  mesh->policy = POLICY_INVALID;
+}
+
+/* The version of the mesh3 sections of a binfile. This should be
+ * bumped whenever the layout of any of them changes. The index tables
+ * are stored using `jmm_index_t`, so a binfile written with a
+ * different index width fails the section size checks. */
+#define MESH3_BINFILE_VERSION 2
+
+/* The scalar data needed to restore a `mesh3_s` from a binfile. */
+typedef struct {
+  uint64_t nverts;
+  uint64_t ncells;
+  uint64_t nedges;
+  uint8_t has_adj_info;
+  uint8_t has_bd_info;
+  uint64_t nbdf;
+  uint64_t nbde;
+  uint64_t num_bdf_labels;
+  uint64_t num_bde_labels;
+  dbl eps;
+  dbl min_tetra_alt;
+  dbl min_edge_length;
+  dbl mean_edge_length;
+  dbl diam;
+  rect3 loc_bbox;
+  int32_t loc_dim[3];
+  dbl loc_h;
+} mesh3_info_s;
+
+/* Add everything needed to restore `mesh` to `binfile`, including all
+ * of the tables computed by `mesh3_init`. The arrays aren't copied,
+ * so `mesh` needs to outlive `binfile`. */
+void mesh3_add_to_binfile(mesh3_s const *mesh, binfile_s *binfile) {
+  mesh3_info_s info = {
+    .nverts = mesh->nverts,
+    .ncells = mesh->ncells,
+    .nedges = mesh->nedges,
+    .has_adj_info = mesh->has_adj_info,
+    .has_bd_info = mesh->has_bd_info,
+    .nbdf = mesh->has_bd_info ? mesh->nbdf : 0,
+    .nbde = mesh->has_bd_info ? mesh->nbde : 0,
+    .num_bdf_labels = mesh->has_bd_info ? mesh->num_bdf_labels : 0,
+    .num_bde_labels = mesh->has_bd_info ? mesh->num_bde_labels : 0,
+    .eps = mesh->eps,
+    .min_tetra_alt = mesh->min_tetra_alt,
+    .min_edge_length = mesh->min_edge_length,
+    .mean_edge_length = mesh->mean_edge_length,
+    .diam = mesh->diam,
+    .loc_bbox = mesh->loc_grid.bbox,
+    .loc_dim = {
+      mesh->loc_grid.dim[0], mesh->loc_grid.dim[1], mesh->loc_grid.dim[2]
+    },
+    .loc_h = mesh->loc_grid.h
+  };
+
+  size_t nvc = mesh->vc_offsets[mesh->nverts];
+  size_t nloc = loc_grid_get_num_buckets(&mesh->loc_grid);
+
+  struct {
+    binfile_tag_e tag;
+    void const *data;
+    size_t size;
+  } sections[] = {
+    {BINFILE_TAG_MESH3_VERTS, mesh->verts, mesh->nverts*sizeof(dbl3)},
+    {BINFILE_TAG_MESH3_CELLS, mesh->cells, mesh->ncells*sizeof(index4)},
+    {BINFILE_TAG_MESH3_VC, mesh->vc, nvc*sizeof(jmm_index_t)},
+    {BINFILE_TAG_MESH3_VC_OFFSETS, mesh->vc_offsets, (mesh->nverts + 1)*sizeof(size_t)},
+    {BINFILE_TAG_MESH3_EDGES, mesh->edges, mesh->nedges*sizeof(uint2)},
+    {BINFILE_TAG_MESH3_LOC_CELLS, mesh->loc_cells, mesh->loc_offsets[nloc]*sizeof(jmm_index_t)},
+    {BINFILE_TAG_MESH3_LOC_OFFSETS, mesh->loc_offsets, (nloc + 1)*sizeof(size_t)}
+  };
+
+  binfile_add_section(binfile, BINFILE_TAG_MESH3_INFO, MESH3_BINFILE_VERSION,
+                      &info, sizeof(info), POLICY_COPY);
+
+  for (size_t i = 0; i < sizeof(sections)/sizeof(sections[0]); ++i)
+    binfile_add_section(binfile, sections[i].tag, MESH3_BINFILE_VERSION,
+                        sections[i].data, sections[i].size, POLICY_VIEW);
+
+  if (mesh->has_adj_info) {
+    struct {
+      binfile_tag_e tag;
+      void const *data;
+      size_t size;
+    } adj_sections[] = {
+      {BINFILE_TAG_MESH3_VV, mesh->vv, mesh->vv_offsets[mesh->nverts]*sizeof(jmm_index_t)},
+      {BINFILE_TAG_MESH3_VV_OFFSETS, mesh->vv_offsets, (mesh->nverts + 1)*sizeof(size_t)},
+      {BINFILE_TAG_MESH3_VE, mesh->ve, mesh->ve_offsets[mesh->nverts]*sizeof(index2)},
+      {BINFILE_TAG_MESH3_VE_OFFSETS, mesh->ve_offsets, (mesh->nverts + 1)*sizeof(size_t)},
+      {BINFILE_TAG_MESH3_VF, mesh->vf, nvc*sizeof(index3)}
+    };
+
+    for (size_t i = 0; i < sizeof(adj_sections)/sizeof(adj_sections[0]); ++i)
+      binfile_add_section(binfile, adj_sections[i].tag, MESH3_BINFILE_VERSION,
+                          adj_sections[i].data, adj_sections[i].size, POLICY_VIEW);
+  }
+
+  if (mesh->has_bd_info) {
+    struct {
+      binfile_tag_e tag;
+      void const *data;
+      size_t size;
+    } bd_sections[] = {
+      {BINFILE_TAG_MESH3_BDC, mesh->bdc, mesh->ncells*sizeof(bool)},
+      {BINFILE_TAG_MESH3_BDV, mesh->bdv, mesh->nverts*sizeof(bool)},
+      {BINFILE_TAG_MESH3_BDF, mesh->bdf, mesh->nbdf*sizeof(bdf_s)},
+      {BINFILE_TAG_MESH3_BDE, mesh->bde, mesh->nbde*sizeof(bde_s)},
+      {BINFILE_TAG_MESH3_BDF_LABEL, mesh->bdf_label, mesh->nbdf*sizeof(size_t)},
+      {BINFILE_TAG_MESH3_BDE_LABEL, mesh->bde_label, mesh->nbde*sizeof(size_t)},
+      {BINFILE_TAG_MESH3_VERT_FLAGS, mesh->vert_flags, mesh->nverts*sizeof(uint8_t)},
+      {BINFILE_TAG_MESH3_VDE, mesh->vde, mesh->vde_offsets[mesh->nverts]*sizeof(size_t)},
+      {BINFILE_TAG_MESH3_VDE_OFFSETS, mesh->vde_offsets, (mesh->nverts + 1)*sizeof(size_t)},
+      {BINFILE_TAG_MESH3_VDL, mesh->vdl, mesh->vdl_offsets[mesh->nverts]*sizeof(size_t)},
+      {BINFILE_TAG_MESH3_VDL_OFFSETS, mesh->vdl_offsets, (mesh->nverts + 1)*sizeof(size_t)}
+    };
+
+    for (size_t i = 0; i < sizeof(bd_sections)/sizeof(bd_sections[0]); ++i)
+      binfile_add_section(binfile, bd_sections[i].tag, MESH3_BINFILE_VERSION,
+                          bd_sections[i].data, bd_sections[i].size, POLICY_VIEW);
+  }
+}
+
+/* Get the section `tag` from `binfile`, checking that it has the
+ * right version and size. Returns `NULL` otherwise. */
+static void *get_mesh3_section(binfile_s const *binfile, binfile_tag_e tag,
+                               size_t size) {
+  uint32_t version;
+  size_t section_size;
+  void *data = binfile_get_section(binfile, tag, &version, &section_size);
+  if (data == NULL || version != MESH3_BINFILE_VERSION || section_size != size)
+    return NULL;
+  return data;
+}
+
+/* Initialize `mesh` from a binfile written using
+ * `mesh3_add_to_binfile`. Nothing is recomputed and no data is
+ * copied: the mesh's arrays point directly into `binfile`, which
+ * must outlive `mesh`. Returns `JMM_ERROR_BAD_ARGUMENTS` if any of
+ * the sections are missing or malformed. */
+jmm_error_e mesh3_init_from_binfile(mesh3_s *mesh, binfile_s const *binfile) {
+  mesh3_info_s const *info = get_mesh3_section(
+    binfile, BINFILE_TAG_MESH3_INFO, sizeof(mesh3_info_s));
+  if (info == NULL)
+    return JMM_ERROR_BAD_ARGUMENTS;
+
+  mesh->policy = POLICY_VIEW;
+
+  mesh->nverts = info->nverts;
+  mesh->ncells = info->ncells;
+  mesh->nedges = info->nedges;
+  mesh->has_adj_info = info->has_adj_info;
+  mesh->has_bd_info = info->has_bd_info;
+  mesh->nbdf = info->nbdf;
+  mesh->nbde = info->nbde;
+  mesh->num_bdf_labels = info->num_bdf_labels;
+  mesh->num_bde_labels = info->num_bde_labels;
+  mesh->eps = info->eps;
+  mesh->min_tetra_alt = info->min_tetra_alt;
+  mesh->min_edge_length = info->min_edge_length;
+  mesh->mean_edge_length = info->mean_edge_length;
+  mesh->diam = info->diam;
+  mesh->loc_grid.bbox = info->loc_bbox;
+  for (int i = 0; i < 3; ++i)
+    mesh->loc_grid.dim[i] = info->loc_dim[i];
+  mesh->loc_grid.h = info->loc_h;
+
+  size_t nverts = mesh->nverts;
+  size_t nloc = loc_grid_get_num_buckets(&mesh->loc_grid);
+
+  /* The sizes of the CSR arrays depend on their offsets, so we need
+   * to get those first */
+#define GET(field, tag, size) do {                          \
+    void *data = get_mesh3_section(binfile, tag, size);     \
+    if (data == NULL)                                       \
+      goto error;                                           \
+    mesh->field = data;                                     \
+  } while (0)
+
+  GET(verts, BINFILE_TAG_MESH3_VERTS, nverts*sizeof(dbl3));
+  GET(cells, BINFILE_TAG_MESH3_CELLS, mesh->ncells*sizeof(index4));
+  GET(vc_offsets, BINFILE_TAG_MESH3_VC_OFFSETS, (nverts + 1)*sizeof(size_t));
+  GET(vc, BINFILE_TAG_MESH3_VC, mesh->vc_offsets[nverts]*sizeof(jmm_index_t));
+  GET(edges, BINFILE_TAG_MESH3_EDGES, mesh->nedges*sizeof(uint2));
+  GET(loc_offsets, BINFILE_TAG_MESH3_LOC_OFFSETS, (nloc + 1)*sizeof(size_t));
+  GET(loc_cells, BINFILE_TAG_MESH3_LOC_CELLS, mesh->loc_offsets[nloc]*sizeof(jmm_index_t));
+
+  if (mesh->has_adj_info) {
+    GET(vv_offsets, BINFILE_TAG_MESH3_VV_OFFSETS, (nverts + 1)*sizeof(size_t));
+    GET(vv, BINFILE_TAG_MESH3_VV, mesh->vv_offsets[nverts]*sizeof(jmm_index_t));
+    GET(ve_offsets, BINFILE_TAG_MESH3_VE_OFFSETS, (nverts + 1)*sizeof(size_t));
+    GET(ve, BINFILE_TAG_MESH3_VE, mesh->ve_offsets[nverts]*sizeof(index2));
+    GET(vf, BINFILE_TAG_MESH3_VF, mesh->vc_offsets[nverts]*sizeof(index3));
+  }
+
+  if (mesh->has_bd_info) {
+    GET(bdc, BINFILE_TAG_MESH3_BDC, mesh->ncells*sizeof(bool));
+    GET(bdv, BINFILE_TAG_MESH3_BDV, nverts*sizeof(bool));
+    GET(bdf, BINFILE_TAG_MESH3_BDF, mesh->nbdf*sizeof(bdf_s));
+    GET(bde, BINFILE_TAG_MESH3_BDE, mesh->nbde*sizeof(bde_s));
+    GET(bdf_label, BINFILE_TAG_MESH3_BDF_LABEL, mesh->nbdf*sizeof(size_t));
+    GET(bde_label, BINFILE_TAG_MESH3_BDE_LABEL, mesh->nbde*sizeof(size_t));
+    GET(vert_flags, BINFILE_TAG_MESH3_VERT_FLAGS, nverts*sizeof(uint8_t));
+    GET(vde_offsets, BINFILE_TAG_MESH3_VDE_OFFSETS, (nverts + 1)*sizeof(size_t));
+    GET(vde, BINFILE_TAG_MESH3_VDE, mesh->vde_offsets[nverts]*sizeof(size_t));
+    GET(vdl_offsets, BINFILE_TAG_MESH3_VDL_OFFSETS, (nverts + 1)*sizeof(size_t));
+    GET(vdl, BINFILE_TAG_MESH3_VDL, mesh->vdl_offsets[nverts]*sizeof(size_t));
+  }
+
+#undef GET
+
+  return JMM_ERROR_NONE;
+
+error:
+  mesh->policy = POLICY_INVALID;
+  return JMM_ERROR_BAD_ARGUMENTS;
 }
 
 dbl3 const *mesh3_get_verts_ptr(mesh3_s const *mesh) {
   return mesh->verts;
 }
 
-size_t const *mesh3_get_cells_ptr(mesh3_s const *mesh) {
+jmm_index_t const *mesh3_get_cells_ptr(mesh3_s const *mesh) {
   return mesh->cells[0];
 }
 
@@ -901,7 +1692,7 @@ void mesh3_get_bbox(mesh3_s const *mesh, rect3 *bbox) {
 }
 
 void mesh3_get_cell_bbox(mesh3_s const *mesh, size_t i, rect3 *bbox) {
-  size_t const *cell = mesh->cells[i];
+  jmm_index_t const *cell = mesh->cells[i];
 
   dbl *min = bbox->min, *max = bbox->max, *v;
 
@@ -927,19 +1718,132 @@ bool mesh3_cell_contains_point(mesh3_s const *mesh, size_t lc, dbl const x[3]) {
   return tetra3_contains_point(&tetra, x, &mesh->eps);
 }
 
+/* Find the cell other than `lc` which is incident on the face `lf`,
+ * or return `NO_INDEX` if `lf` is a boundary face. */
+static size_t get_cell_across_face(mesh3_s const *mesh, size_t lc,
+                                   size_t const lf[3]) {
+  for (size_t p = mesh->vc_offsets[lf[0]]; p < mesh->vc_offsets[lf[0] + 1]; ++p) {
+    size_t lc_nb = mesh->vc[p];
+    if (lc_nb != lc
+        && point_in_cell(lf[1], mesh->cells[lc_nb])
+        && point_in_cell(lf[2], mesh->cells[lc_nb]))
+      return lc_nb;
+  }
+  return (size_t)NO_INDEX;
+}
+
+/* Starting from `lc`, walk through the mesh towards `x`, each time
+ * stepping across the face opposite the vertex with the most negative
+ * barycentric coordinate. Since the mesh needn't be convex, the walk
+ * can run into the boundary, in which case we give up and return
+ * `NO_INDEX`. We also give up after a bounded number of steps so that
+ * we don't cycle in degenerate cases. */
+static size_t walk_to_cell_containing_point(mesh3_s const *mesh, dbl3 const x,
+                                            size_t lc) {
+  int const *dim = mesh->loc_grid.dim;
+  int max_steps = 2*(dim[0] + dim[1] + dim[2]);
+
+  for (int step = 0; step < max_steps; ++step) {
+    tetra3 tetra = mesh3_get_tetra(mesh, lc);
+    if (tetra3_contains_point(&tetra, x, &mesh->eps))
+      return lc;
+
+    dbl4 b;
+    tetra3_get_bary_coords(&tetra, x, b);
+
+    int i_min = 0;
+    for (int i = 1; i < 4; ++i)
+      if (b[i] < b[i_min])
+        i_min = i;
+
+    size_t lf[3];
+    for (int i = 0, j = 0; i < 4; ++i)
+      if (i != i_min)
+        lf[j++] = mesh->cells[lc][i];
+
+    lc = get_cell_across_face(mesh, lc, lf);
+    if (lc == (size_t)NO_INDEX)
+      break;
+  }
+
+  return (size_t)NO_INDEX;
+}
+
+/* Find the cell containing `x`, or return `NO_INDEX` if `x` isn't
+ * contained in the mesh. If `lc` isn't `NO_INDEX`, it's used as a
+ * starting guess, and we walk from it towards `x`, which is the
+ * fastest way to locate a sequence of nearby points. Otherwise, we
+ * search the cells in the bucket of the locator grid containing
+ * `x`. In the latter case, if `x` lies on a face shared by several
+ * cells, the one with the smallest index is returned. */
 size_t mesh3_find_cell_containing_point(mesh3_s const *mesh, dbl const x[3],
                                         size_t lc) {
-  /* First, try the passed guess... */
-  if (lc != (size_t)NO_INDEX && mesh3_cell_contains_point(mesh, lc, x))
-    return lc;
-
-  /* ... otherwise, proceed as usual */
-  for (size_t lc = 0; lc < mesh->ncells; ++lc)
-    if (mesh3_cell_contains_point(mesh, lc, x))
+  if (lc != (size_t)NO_INDEX) {
+    lc = walk_to_cell_containing_point(mesh, x, lc);
+    if (lc != (size_t)NO_INDEX)
       return lc;
+  }
+
+  for (int i = 0; i < 3; ++i)
+    if (x[i] < mesh->loc_grid.bbox.min[i] - mesh->eps ||
+        x[i] > mesh->loc_grid.bbox.max[i] + mesh->eps)
+      return (size_t)NO_INDEX;
+
+  int ind[3];
+  loc_grid_get_bucket(&mesh->loc_grid, x, ind);
+
+  size_t i = loc_grid_get_index(&mesh->loc_grid, ind);
+  for (size_t p = mesh->loc_offsets[i]; p < mesh->loc_offsets[i + 1]; ++p)
+    if (mesh3_cell_contains_point(mesh, mesh->loc_cells[p], x))
+      return mesh->loc_cells[p];
+
   return (size_t)NO_INDEX;
 }
 
+typedef struct {
+  size_t key;
+  size_t l;
+} loc_query_s;
+
+static int loc_query_cmp(loc_query_s const *q1, loc_query_s const *q2) {
+  return q1->key < q2->key ? -1 : q1->key > q2->key ? 1 :
+    q1->l < q2->l ? -1 : q1->l > q2->l ? 1 : 0;
+}
+
+/* Find the cells containing each of the `n` points `x`, writing the
+ * results to `lc` (`NO_INDEX` for points outside the mesh). The
+ * queries are first sorted by the bucket of the locator grid they
+ * fall in. Each thread then works through a contiguous run of the
+ * sorted queries, using the cell it found for the previous query as
+ * the hint for the next, so that most queries are resolved after a
+ * step or two of walking. */
+void mesh3_find_cells_containing_points(mesh3_s const *mesh, size_t n,
+                                        dbl3 const *x, size_t *lc) {
+  loc_query_s *q = malloc(n*sizeof(loc_query_s));
+
+  int ind[3];
+  for (size_t i = 0; i < n; ++i) {
+    loc_grid_get_bucket(&mesh->loc_grid, x[i], ind);
+    q[i] = (loc_query_s) {.key = loc_grid_get_index(&mesh->loc_grid, ind), .l = i};
+  }
+
+  qsort(q, n, sizeof(loc_query_s), (compar_t)loc_query_cmp);
+
+#pragma omp parallel
+  {
+    size_t lc_prev = (size_t)NO_INDEX;
+#pragma omp for schedule(static)
+    for (size_t i = 0; i < n; ++i) {
+      size_t l = q[i].l;
+      lc[l] = mesh3_find_cell_containing_point(mesh, x[l], lc_prev);
+      if (lc[l] != (size_t)NO_INDEX)
+        lc_prev = lc[l];
+    }
+  }
+
+  free(q);
+}
+
 bool mesh3_contains_point(mesh3_s const *mesh, dbl3 const x) {
   size_t lc = mesh3_find_cell_containing_point(mesh, x, (size_t)NO_INDEX);
   return lc != (size_t)NO_INDEX;
@@ -966,23 +1870,22 @@ int mesh3_nvc(mesh3_s const *mesh, size_t i) {
 
 void mesh3_vc(mesh3_s const *mesh, size_t i, size_t *vc) {
   int nvc = mesh3_nvc(mesh, i);
-  size_t *vci = &mesh->vc[mesh->vc_offsets[i]];
-  memcpy((void *)vc, (void *)vci, sizeof(size_t)*nvc);
+  jmm_index_t const *vci = &mesh->vc[mesh->vc_offsets[i]];
+  for (int p = 0; p < nvc; ++p)
+    vc[p] = vci[p];
 }
 
-static void get_opposite_edges(size_t const cv[4], size_t lv, edge_s edge[3]) {
-  size_t l[3];
-  for (int i = 0, j = 0; i < 4; ++i) {
-    if (cv[i] == lv)
-      continue;
-    l[j++] = cv[i];
-  }
-  edge[0] = make_edge(l[0], l[1]);
-  edge[1] = make_edge(l[1], l[2]);
-  edge[2] = make_edge(l[2], l[0]);
+/* Like `mesh3_vc`, but returns a pointer to the `mesh3_nvc(mesh, i)`
+ * cells incident on vertex `i` instead of copying them. */
+jmm_index_t const *mesh3_get_vc_ptr(mesh3_s const *mesh, size_t i) {
+  assert(i < mesh->nverts);
+  return &mesh->vc[mesh->vc_offsets[i]];
 }
 
 int mesh3_nve(mesh3_s const *mesh, size_t lv) {
+  if (mesh->has_adj_info)
+    return mesh->ve_offsets[lv + 1] - mesh->ve_offsets[lv];
+
   array_s *edges;
   array_alloc(&edges);
   array_init(edges, sizeof(edge_s), /* capacity */ 8);
@@ -991,12 +1894,9 @@ int mesh3_nve(mesh3_s const *mesh, size_t lv) {
   size_t *vc = malloc(sizeof(size_t)*nvc);
   mesh3_vc(mesh, lv, vc);
 
-  size_t cv[4];
-
   edge_s new_edges[3];
   for (int i = 0; i < nvc; ++i) {
-    mesh3_cv(mesh, vc[i], cv);
-    get_opposite_edges(cv, lv, new_edges);
+    get_opposite_edges(mesh->cells[vc[i]], lv, new_edges);
     for (int j = 0; j < 3; ++j) {
       if (array_contains(edges, &new_edges[j]))
         continue;
@@ -1015,6 +1915,15 @@ int mesh3_nve(mesh3_s const *mesh, size_t lv) {
 }
 
 void mesh3_ve(mesh3_s const *mesh, size_t lv, size_t (*ve)[2]) {
+  if (mesh->has_adj_info) {
+    index2 const *ve_ptr = mesh3_get_ve_ptr(mesh, lv);
+    for (int p = 0; p < mesh3_nve(mesh, lv); ++p) {
+      ve[p][0] = ve_ptr[p][0];
+      ve[p][1] = ve_ptr[p][1];
+    }
+    return;
+  }
+
   array_s *edges;
   array_alloc(&edges);
   array_init(edges, sizeof(edge_s), /* capacity */ 8);
@@ -1023,12 +1932,9 @@ void mesh3_ve(mesh3_s const *mesh, size_t lv, size_t (*ve)[2]) {
   size_t *vc = malloc(sizeof(size_t)*nvc);
   mesh3_vc(mesh, lv, vc);
 
-  size_t cv[4];
-
   edge_s new_edges[3];
   for (int i = 0; i < nvc; ++i) {
-    mesh3_cv(mesh, vc[i], cv);
-    get_opposite_edges(cv, lv, new_edges);
+    get_opposite_edges(mesh->cells[vc[i]], lv, new_edges);
     for (int j = 0; j < 3; ++j) {
       if (array_contains(edges, &new_edges[j]))
         continue;
@@ -1056,7 +1962,13 @@ int mesh3_nvf(mesh3_s const *mesh, size_t l) {
 }
 
 void mesh3_vf(mesh3_s const *mesh, size_t l, size_t (*vf)[3]) {
-  // TODO: this is a very bad implementation!
+  if (mesh->has_adj_info) {
+    index3 const *vf_ptr = mesh3_get_vf_ptr(mesh, l);
+    for (int p = 0; p < mesh3_nvf(mesh, l); ++p)
+      for (int q = 0; q < 3; ++q)
+        vf[p][q] = vf_ptr[p][q];
+    return;
+  }
 
   int nvc = mesh3_nvc(mesh, l);
   size_t *vc = malloc(nvc*sizeof(size_t));
@@ -1087,6 +1999,9 @@ void mesh3_vf(mesh3_s const *mesh, size_t l, size_t (*vf)[3]) {
  */
 
 int mesh3_nvv(mesh3_s const *mesh, size_t i) {
+  if (mesh->has_adj_info)
+    return mesh->vv_offsets[i + 1] - mesh->vv_offsets[i];
+
   int nvc = mesh3_nvc(mesh, i);
   size_t *vc = malloc(sizeof(size_t)*nvc);
   mesh3_vc(mesh, i, vc);
@@ -1096,7 +2011,7 @@ int mesh3_nvv(mesh3_s const *mesh, size_t i) {
 
   int nvv = 0;
   for (int p = 0; p < nvc; ++p) {
-    size_t const *cell = mesh->cells[vc[p]];
+    jmm_index_t const *cell = mesh->cells[vc[p]];
     for (int q = 0; q < 4; ++q) {
       size_t j = cell[q];
       if (i == j || contains((void *)vv, nvv, &j, sizeof(size_t))) {
@@ -1113,13 +2028,20 @@ int mesh3_nvv(mesh3_s const *mesh, size_t i) {
 }
 
 void mesh3_vv(mesh3_s const *mesh, size_t i, size_t *vv) {
+  if (mesh->has_adj_info) {
+    jmm_index_t const *vv_ptr = mesh3_get_vv_ptr(mesh, i);
+    for (int p = 0; p < mesh3_nvv(mesh, i); ++p)
+      vv[p] = vv_ptr[p];
+    return;
+  }
+
   int nvc = mesh3_nvc(mesh, i);
   size_t *vc = malloc(sizeof(size_t)*nvc);
   mesh3_vc(mesh, i, vc);
 
   int k = 0;
   for (int p = 0; p < nvc; ++p) {
-    size_t const *cell = mesh->cells[vc[p]];
+    jmm_index_t const *cell = mesh->cells[vc[p]];
     for (int q = 0; q < 4; ++q) {
       size_t j = cell[q];
       if (i == j || contains((void *)vv, k, &j, sizeof(size_t))) {
@@ -1132,7 +2054,33 @@ void mesh3_vv(mesh3_s const *mesh, size_t i, size_t *vv) {
   free(vc);
 }
 
-static int num_shared_verts(size_t const *cell1, size_t const *cell2) {
+bool mesh3_has_adj_info(mesh3_s const *mesh) {
+  return mesh->has_adj_info;
+}
+
+/* The functions below return views into the precomputed adjacency
+ * tables. The number of elements in each view is given by
+ * `mesh3_nvv`, `mesh3_nve`, and `mesh3_nvf`, respectively. */
+
+jmm_index_t const *mesh3_get_vv_ptr(mesh3_s const *mesh, size_t i) {
+  assert(mesh->has_adj_info);
+  assert(i < mesh->nverts);
+  return &mesh->vv[mesh->vv_offsets[i]];
+}
+
+index2 const *mesh3_get_ve_ptr(mesh3_s const *mesh, size_t i) {
+  assert(mesh->has_adj_info);
+  assert(i < mesh->nverts);
+  return (index2 const *)&mesh->ve[mesh->ve_offsets[i]];
+}
+
+index3 const *mesh3_get_vf_ptr(mesh3_s const *mesh, size_t i) {
+  assert(mesh->has_adj_info);
+  assert(i < mesh->nverts);
+  return (index3 const *)&mesh->vf[mesh->vc_offsets[i]];
+}
+
+static int num_shared_verts(jmm_index_t const *cell1, jmm_index_t const *cell2) {
   // TODO: speed up using SIMD?
   int n = 0;
   for (int p = 0; p < 4; ++p) {
@@ -1147,7 +2095,7 @@ static int num_shared_verts(size_t const *cell1, size_t const *cell2) {
 }
 
 int mesh3_ncc(mesh3_s const *mesh, size_t i) {
-  size_t const *cell = mesh->cells[i];
+  jmm_index_t const *cell = mesh->cells[i];
 
   int nvc[4], max_nvc = -1;
   for (int p = 0; p < 4; ++p) {
@@ -1182,7 +2130,7 @@ int mesh3_ncc(mesh3_s const *mesh, size_t i) {
 }
 
 void mesh3_cc(mesh3_s const *mesh, size_t i, size_t *cc) {
-  size_t const *cell = mesh->cells[i];
+  jmm_index_t const *cell = mesh->cells[i];
 
   int nvc[4], max_nvc = -1;
   for (int p = 0; p < 4; ++p) {
@@ -1215,7 +2163,7 @@ void mesh3_cc(mesh3_s const *mesh, size_t i, size_t *cc) {
  * different sets of vertices comprising the faces of the cell indexed
  * by `lc`, but returned in sorted order. */
 void mesh3_cf(mesh3_s const *mesh, size_t lc, size_t lf[4][3]) {
-  size_t const *cv = mesh->cells[lc];
+  jmm_index_t const *cv = mesh->cells[lc];
   for (size_t i = 0; i < 4; ++i) {
     for (size_t j = 0, k = 0; k < 4; ++k) {
       if (i == k)
@@ -1227,7 +2175,8 @@ void mesh3_cf(mesh3_s const *mesh, size_t lc, size_t lf[4][3]) {
 }
 
 void mesh3_cv(mesh3_s const *mesh, size_t i, size_t *cv) {
-  memcpy(cv, mesh->cells[i], 4*sizeof(size_t));
+  for (int j = 0; j < 4; ++j)
+    cv[j] = mesh->cells[i][j];
 }
 
 int mesh3_nec(mesh3_s const *mesh, size_t const le[2]) {
@@ -1236,12 +2185,10 @@ int mesh3_nec(mesh3_s const *mesh, size_t const le[2]) {
   size_t i = le[0], j = le[1];
 
   int nvci = mesh3_nvc(mesh, i);
-  size_t *vci = malloc(sizeof(size_t)*nvci);
-  mesh3_vc(mesh, i, vci);
+  jmm_index_t const *vci = mesh3_get_vc_ptr(mesh, i);
 
   int nvcj = mesh3_nvc(mesh, j);
-  size_t *vcj = malloc(sizeof(size_t)*nvcj);
-  mesh3_vc(mesh, j, vcj);
+  jmm_index_t const *vcj = mesh3_get_vc_ptr(mesh, j);
 
   int nec = 0;
 
@@ -1256,9 +2203,6 @@ int mesh3_nec(mesh3_s const *mesh, size_t const le[2]) {
     }
   }
 
-  free(vci);
-  free(vcj);
-
   return nec;
 }
 
@@ -1268,12 +2212,10 @@ void mesh3_ec(mesh3_s const *mesh, size_t const le[2], size_t *lc) {
   size_t i = le[0], j = le[1];
 
   int nvci = mesh3_nvc(mesh, i);
-  size_t *vci = malloc(sizeof(size_t)*nvci);
-  mesh3_vc(mesh, i, vci);
+  jmm_index_t const *vci = mesh3_get_vc_ptr(mesh, i);
 
   int nvcj = mesh3_nvc(mesh, j);
-  size_t *vcj = malloc(sizeof(size_t)*nvcj);
-  mesh3_vc(mesh, j, vcj);
+  jmm_index_t const *vcj = mesh3_get_vc_ptr(mesh, j);
 
   int nec = 0;
 
@@ -1287,9 +2229,6 @@ void mesh3_ec(mesh3_s const *mesh, size_t const le[2], size_t *lc) {
       }
     }
   }
-
-  free(vci);
-  free(vcj);
 }
 
 bool mesh3_cee(mesh3_s const *mesh, size_t c, size_t const e[2],
@@ -1417,18 +2356,13 @@ int mesh3_nfc(mesh3_s const *mesh, size_t const f[3]) {
   // this.
 
   int nvc = mesh3_nvc(mesh, f[0]);
-  size_t *vc = malloc(nvc*sizeof(size_t)), cv[4];
-  mesh3_vc(mesh, f[0], vc);
+  jmm_index_t const *vc = mesh3_get_vc_ptr(mesh, f[0]);
 
   int nfc = 0;
-  for (int i = 0; i < nvc; ++i) {
-    mesh3_cv(mesh, vc[i], cv);
-    nfc += face_in_cell(f, cv);
-  }
+  for (int i = 0; i < nvc; ++i)
+    nfc += face_in_cell(f, mesh->cells[vc[i]]);
   assert(nfc == 1 || nfc == 2);
 
-  free(vc);
-
   return nfc;
 }
 
@@ -1437,25 +2371,19 @@ void mesh3_fc(mesh3_s const *mesh, size_t const f[3], uint2 fc) {
 
   /* Find all of the cells which are incident on one of the faces */
   int nvc = mesh3_nvc(mesh, f[0]);
-  size_t *vc = malloc(nvc*sizeof(size_t)), cv[4];
-  mesh3_vc(mesh, f[0], vc);
+  jmm_index_t const *vc = mesh3_get_vc_ptr(mesh, f[0]);
 
   /* Iterate over each cell, accumulating the cells which contain the
      target face `f`. There can be at most two of these. If there's
      only one, the face is a boundary face. */
   int nfc = 0;
-  for (int i = 0; i < nvc; ++i) {
-    mesh3_cv(mesh, vc[i], cv);
-    if (face_in_cell(f, cv))
+  for (int i = 0; i < nvc; ++i)
+    if (face_in_cell(f, mesh->cells[vc[i]]))
       fc[nfc++] = vc[i];
-  }
-
-  free(vc);
 }
 
 bool mesh3_cfv(mesh3_s const *mesh, size_t lc, size_t const lf[3], size_t *lv) {
-  size_t cv[4];
-  mesh3_cv(mesh, lc, cv);
+  jmm_index_t const *cv = mesh->cells[lc];
   // First, check if the verts in lf actually belong to cv. If they
   // don't, return false, since cfv no longer makes any sense.
   for (int i = 0; i < 3; ++i)
@@ -1486,8 +2414,7 @@ bool mesh3_ccfv(mesh3_s const *mesh, size_t lc, size_t const lf[3],
 }
 
 bool mesh3_cvf(mesh3_s const *mesh, size_t lc, size_t lv, size_t lf[3]) {
-  size_t cv[4];
-  mesh3_cv(mesh, lc, cv);
+  jmm_index_t const *cv = mesh->cells[lc];
   // First, check if lv is actually incident on lc
   if (!point_in_cell(lv, cv))
     return false;
@@ -1551,6 +2478,7 @@ void mesh3_set_bdf(mesh3_s *mesh, size_t lf[3]) {
   mesh->bdv[lf[0]] = mesh->bdv[lf[1]] = mesh->bdv[lf[2]] = true;
 
   assert(mesh->has_bd_info);
+  assert(mesh->policy != POLICY_VIEW); // can't grow a binfile's `bdf`
   bdf_s bdf = make_bdf(lf[0], lf[1], lf[2], NO_PARENT);
 
   int cmp;
@@ -1576,21 +2504,10 @@ bool mesh3_is_bdf(mesh3_s const *mesh, size_t const lf[3]) {
 }
 
 bool mesh3_is_edge(mesh3_s const *mesh, size_t const l[2]) {
-  int nvv = mesh3_nvv(mesh, l[0]);
-  size_t *vv = malloc(nvv*sizeof(size_t));
-  mesh3_vv(mesh, l[0], vv);
-
-  bool is_edge = false;
-  for (int i = 0; i < nvv; ++i) {
-    if (vv[i] == l[1]) {
-      is_edge = true;
-      break;
-    }
-  }
-
-  free(vv);
-
-  return is_edge;
+  size_t le[2] = {l[0], l[1]};
+  SORT2(le[0], le[1]);
+  return bsearch(le, mesh->edges, mesh->nedges, sizeof(size_t[2]),
+                 (compar_t)edge_cmp) != NULL;
 }
 
 bool mesh3_is_diff_edge(mesh3_s const *mesh, size_t const le[2]) {
@@ -1603,58 +2520,12 @@ bool mesh3_is_diff_edge(mesh3_s const *mesh, size_t const le[2]) {
 
 bool mesh3_vert_incident_on_diff_edge(mesh3_s const *mesh, size_t l) {
   assert(mesh->has_bd_info);
-
-  int nvv = mesh3_nvv(mesh, l);
-  size_t *vv = malloc(nvv*sizeof(size_t));
-  mesh3_vv(mesh, l, vv);
-
-  bool is_incident = false;
-  for (int i = 0; i < nvv; ++i)
-    if ((is_incident = mesh3_is_diff_edge(mesh, (size_t[2]) {l, vv[i]})))
-      break;
-
-  free(vv);
-
-  return is_incident;
+  return mesh->vert_flags[l] & VERT_FLAG_INC_ON_DIFF_EDGE;
 }
 
 bool mesh3_vert_is_terminal_diff_edge_vert(mesh3_s const *mesh, size_t l) {
   assert(mesh->has_bd_info);
-
-  if (!mesh3_vert_incident_on_diff_edge(mesh, l))
-    return false;
-
-  array_s *diff_labels_seen;
-  array_alloc(&diff_labels_seen);
-  array_init(diff_labels_seen, sizeof(size_t), ARRAY_DEFAULT_CAPACITY);
-
-  size_t nvv = mesh3_nvv(mesh, l);
-  size_t *vv = malloc(nvv*sizeof(size_t));
-  mesh3_vv(mesh, l, vv);
-
-  bool terminal = true;
-
-  for (size_t i = 0; i < nvv; ++i) {
-    if (!mesh3_is_diff_edge(mesh, (size_t[2]) {l, vv[i]}))
-      continue;
-    bde_s bde = make_bde(l, vv[i]);
-    size_t j = find_bde(mesh, &bde);
-    size_t bde_label = mesh->bde_label[j];
-    assert(bde_label != NO_LABEL);
-    if (array_contains(diff_labels_seen, &bde_label)) {
-      terminal = false;
-      break;
-    } else {
-      array_append(diff_labels_seen, &bde_label);
-    }
-  }
-
-  free(vv);
-
-  array_deinit(diff_labels_seen);
-  array_dealloc(&diff_labels_seen);
-
-  return terminal;
+  return mesh->vert_flags[l] & VERT_FLAG_TERMINAL_DIFF_EDGE_VERT;
 }
 
 bool mesh3_cell_incident_on_diff_edge(mesh3_s const *mesh, size_t lc) {
@@ -1664,6 +2535,19 @@ bool mesh3_cell_incident_on_diff_edge(mesh3_s const *mesh, size_t lc) {
   return false;
 }
 
+/* Get the number of distinct diffractors incident on `l`. */
+size_t mesh3_get_num_vert_diff_labels(mesh3_s const *mesh, size_t l) {
+  assert(mesh->has_bd_info);
+  return mesh->vdl_offsets[l + 1] - mesh->vdl_offsets[l];
+}
+
+/* Get a view of the labels (diffractor indices) of the diffractors
+ * incident on `l`. */
+size_t const *mesh3_get_vert_diff_labels_ptr(mesh3_s const *mesh, size_t l) {
+  assert(mesh->has_bd_info);
+  return &mesh->vdl[mesh->vdl_offsets[l]];
+}
+
 static bool local_ray_in_tetra_cone(mesh3_s const *mesh, dbl3 const p, size_t lc, size_t lv) {
   dbl3 xhat;
   mesh3_copy_vert(mesh, lv, xhat);
@@ -1691,16 +2575,13 @@ static bool local_ray_in_tetra_cone(mesh3_s const *mesh, dbl3 const p, size_t lc
 
 bool mesh3_local_ray_in_vertex_cone(mesh3_s const *mesh, dbl3 const p, size_t lv) {
   size_t nvc = mesh3_nvc(mesh, lv);
-  size_t *vc = malloc(mesh->nverts*sizeof(size_t));
-  mesh3_vc(mesh, lv, vc);
+  jmm_index_t const *vc = mesh3_get_vc_ptr(mesh, lv);
 
   bool in_cone = false;
   for (size_t i = 0; i < nvc; ++i)
     if ((in_cone = local_ray_in_tetra_cone(mesh, p, vc[i], lv)))
       break;
 
-  free(vc);
-
   return in_cone;
 }
 
@@ -1708,16 +2589,19 @@ bool mesh3_ray_prop_from_edge_is_occluded(mesh3_s const *mesh, dbl3 const t,
                                           uint2 const l) {
   bool occluded = true;
 
-  /* gets cells incident on active edge */
-  size_t nec = mesh3_nec(mesh, l);
-  size_t *ec = malloc(nec*sizeof(size_t));
-  mesh3_ec(mesh, l, ec);
+  /* gets cells incident on `l[0]`---we skip the ones which aren't
+   * incident on the active edge below */
+  size_t nvc = mesh3_nvc(mesh, l[0]);
+  jmm_index_t const *vc = mesh3_get_vc_ptr(mesh, l[0]);
 
   /* check whether `dxhat` points into a tetrahedron incident on the
    * base of the active edge */
-  for (size_t i = 0, l_op[2]; i < nec; ++i) {
+  for (size_t i = 0, l_op[2]; i < nvc; ++i) {
+    if (!point_in_cell(l[1], mesh->cells[vc[i]]))
+      continue;
+
     /* get the opposite edge */
-    mesh3_cee(mesh, ec[i], l, l_op);
+    mesh3_cee(mesh, vc[i], l, l_op);
 
     dbl3 x[2];
     mesh3_copy_vert(mesh, l[0], x[0]);
@@ -1766,8 +2650,6 @@ bool mesh3_ray_prop_from_edge_is_occluded(mesh3_s const *mesh, dbl3 const t,
     }
   }
 
-  free(ec);
-
   return occluded;
 }
 
@@ -1801,7 +2683,7 @@ bool mesh3_local_ray_is_occluded(mesh3_s const *mesh, size_t lhat, par3_s const
   if (num_active_constraints == 0) {
     /* get cells incident on base of update */
     size_t nfc = mesh3_nfc(mesh, l_active);
-    size_t *fc = malloc(nfc*sizeof(size_t));
+    uint2 fc;
     mesh3_fc(mesh, l_active, fc);
 
     /* check whether the `dxhat` points into a tetrahedron incident on
@@ -1833,8 +2715,6 @@ bool mesh3_local_ray_is_occluded(mesh3_s const *mesh, size_t lhat, par3_s const
         break;
       }
     }
-
-    free(fc);
   }
 
   /* edge minimizer */
@@ -1956,41 +2836,22 @@ mesh2_s *mesh3_get_surface_mesh(mesh3_s const *mesh) {
  * endpoint. */
 size_t mesh3_get_num_inc_diff_edges(mesh3_s const *mesh, size_t l) {
   assert(mesh->has_bd_info);
-
-  int nvv = mesh3_nvv(mesh, l);
-  size_t *vv = malloc(nvv*sizeof(size_t));
-  mesh3_vv(mesh, l, vv);
-
-  size_t num_inc_diff_edges = 0;
-  for (int i = 0; i < nvv; ++i)
-    if (mesh3_is_diff_edge(mesh, (size_t[2]) {l, vv[i]}))
-      ++num_inc_diff_edges;
-
-  free(vv);
-
-  return num_inc_diff_edges;
+  return mesh->vde_offsets[l + 1] - mesh->vde_offsets[l];
 }
 
 /* Get the diffracting edges incident on `l`. This assumes that `le`
  * has space enough for all edges, the number of which can be found by
- * calling `mesh3_get_num_inc_diff_edges`. */
+ * calling `mesh3_get_num_inc_diff_edges`. Each edge is oriented so
+ * that `le[i][0] == l`. */
 void mesh3_get_inc_diff_edges(mesh3_s const *mesh, size_t l, size_t (*le)[2]) {
   assert(mesh->has_bd_info);
 
-  int nvv = mesh3_nvv(mesh, l);
-  size_t *vv = malloc(nvv*sizeof(size_t));
-  mesh3_vv(mesh, l, vv);
-
-  int j = 0;
-  for (int i = 0; i < nvv; ++i) {
-    if (mesh3_is_diff_edge(mesh, (size_t[2]) {l, vv[i]})) {
-      le[j][0] = l;
-      le[j][1] = vv[i];
-      ++j;
-    }
+  for (size_t i = mesh->vde_offsets[l], j = 0; i < mesh->vde_offsets[l + 1]; ++i) {
+    size_t const *bde_le = mesh->bde[mesh->vde[i]].le;
+    le[j][0] = l;
+    le[j][1] = bde_le[0] == l ? bde_le[1] : bde_le[0];
+    ++j;
   }
-
-  free(vv);
 }
 
 size_t mesh3_get_num_inc_bdf(mesh3_s const *mesh, size_t l) {
@@ -2366,26 +3227,66 @@ void mesh3_dump_verts(mesh3_s const *mesh, char const *path) {
 
 void mesh3_dump_cells(mesh3_s const *mesh, char const *path) {
   FILE *fp = fopen(path, "wb");
-  fwrite(mesh->cells, sizeof(size_t[4]), mesh->ncells, fp);
+  for (size_t lc = 0; lc < mesh->ncells; ++lc) {
+    uint4 cv;
+    mesh3_cv(mesh, lc, cv);
+    fwrite(cv, sizeof(uint4), 1, fp);
+  }
   fclose(fp);
 }
 
+#define VERT_ATOL 1e-13
+
+/* Find the vertex of `mesh` within `VERT_ATOL` of `x`, or
+ * `NO_INDEX` if there isn't one. Any such vertex is a vertex of one
+ * of the cells in the buckets of the locator grid overlapping the box
+ * of half-width `VERT_ATOL` around `x` (usually just one bucket), so
+ * only those cells need to be checked. If there are several such
+ * vertices, the one with the smallest index is returned. Vertices
+ * which aren't incident on any cell aren't found. */
+static size_t find_vert(mesh3_s const *mesh, dbl3 const x) {
+  rect3 bbox;
+  for (int i = 0; i < 3; ++i) {
+    bbox.min[i] = x[i] - VERT_ATOL;
+    bbox.max[i] = x[i] + VERT_ATOL;
+    if (bbox.max[i] < mesh->loc_grid.bbox.min[i] ||
+        bbox.min[i] > mesh->loc_grid.bbox.max[i])
+      return (size_t)NO_INDEX;
+  }
+
+  int ind0[3], ind1[3], ind[3];
+  loc_grid_get_range(&mesh->loc_grid, &bbox, 0, ind0, ind1);
+
+  size_t lv = (size_t)NO_INDEX;
+  for (ind[0] = ind0[0]; ind[0] <= ind1[0]; ++ind[0])
+    for (ind[1] = ind0[1]; ind[1] <= ind1[1]; ++ind[1])
+      for (ind[2] = ind0[2]; ind[2] <= ind1[2]; ++ind[2]) {
+        size_t i = loc_grid_get_index(&mesh->loc_grid, ind);
+        for (size_t p = mesh->loc_offsets[i]; p < mesh->loc_offsets[i + 1]; ++p) {
+          jmm_index_t const *cv = mesh->cells[mesh->loc_cells[p]];
+          for (size_t j = 0; j < 4; ++j)
+            if (cv[j] < lv && dbl3_dist(x, mesh->verts[cv[j]]) < VERT_ATOL)
+              lv = cv[j];
+        }
+      }
+
+  return lv;
+}
+
 bool mesh3_has_vertex(mesh3_s const *mesh, dbl3 const x) {
-  for (size_t l = 0; l < mesh->nverts; ++l)
-    if (dbl3_dist(x, mesh->verts[l]) < 1e-13)
-      return true;
-  return false;
+  return find_vert(mesh, x) != (size_t)NO_INDEX;
 }
 
 size_t mesh3_get_vert_index(mesh3_s const *mesh, dbl3 const x) {
-  for (size_t l = 0; l < mesh->nverts; ++l)
-    if (dbl3_dist(x, mesh->verts[l]) < 1e-13)
-      return l;
-  return (size_t)NO_INDEX;
+  return find_vert(mesh, x);
 }
 
+/* Evaluate the piecewise linear interpolant of `values` at `x`. If
+ * `x` lies outside the mesh, return `NAN`. */
 dbl mesh3_linterp(mesh3_s const *mesh, dbl const *values, dbl3 const x) {
   size_t lc = mesh3_find_cell_containing_point(mesh, x, (size_t)NO_INDEX);
+  if (lc == (size_t)NO_INDEX)
+    return NAN;
   tetra3 tetra = mesh3_get_tetra(mesh, lc);
   dbl4 b; tetra3_get_bary_coords(&tetra, x, b);
   size_t lv[4]; mesh3_cv(mesh, lc, lv);
@@ -2395,6 +3296,30 @@ dbl mesh3_linterp(mesh3_s const *mesh, dbl const *values, dbl3 const x) {
   return value;
 }
 
+/* Evaluate the piecewise linear interpolant of `values` at each of
+ * the `n` points `x`, writing the results to `y`. Points outside the
+ * mesh are set to `NAN`. */
+void mesh3_linterp_batch(mesh3_s const *mesh, dbl const *values, size_t n,
+                         dbl3 const *x, dbl *y) {
+  size_t *lc = malloc(n*sizeof(size_t));
+  mesh3_find_cells_containing_points(mesh, n, x, lc);
+
+#pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < n; ++i) {
+    if (lc[i] == (size_t)NO_INDEX) {
+      y[i] = NAN;
+      continue;
+    }
+    tetra3 tetra = mesh3_get_tetra(mesh, lc[i]);
+    dbl4 b; tetra3_get_bary_coords(&tetra, x[i], b);
+    jmm_index_t const *lv = mesh->cells[lc[i]];
+    y[i] = b[0]*values[lv[0]] + b[1]*values[lv[1]]
+         + b[2]*values[lv[2]] + b[3]*values[lv[3]];
+  }
+
+  free(lc);
+}
+
 /* Approximate the diameter of the mesh to within a factor of two. For
  * the vertex with index `l`, find the vertex with the maximum
  * distance to `l`. The true diameter of the mesh is within a factor
@@ -2414,11 +3339,40 @@ dbl mesh3_diam_2approx(mesh3_s const *mesh, size_t l) {
 dbl mesh3_diam_2approx_rand(mesh3_s const *mesh, size_t trials, size_t const *seed) {
   if (seed)
     srandom(*seed);
-  dbl diam_min = INFINITY;
-  for (size_t _ = 0; _ < trials; ++_) {
-    size_t l = random() % mesh->nverts;
-    diam_min = fmin(diam_min, mesh3_diam_2approx(mesh, l));
+
+  /* Draw the trial vertices up front, so that the same vertices are
+   * used regardless of the number of threads. */
+  size_t *l = malloc(trials*sizeof(size_t));
+  for (size_t i = 0; i < trials; ++i)
+    l[i] = random() % mesh->nverts;
+
+  /* Find the distance from each trial vertex to the farthest vertex
+   * in one parallel pass over the vertices. */
+  dbl *rmax = calloc(trials, sizeof(dbl));
+#pragma omp parallel
+  {
+    dbl *rmax_thread = calloc(trials, sizeof(dbl));
+
+#pragma omp for schedule(static)
+    for (size_t m = 0; m < mesh->nverts; ++m)
+      for (size_t i = 0; i < trials; ++i)
+        rmax_thread[i] = fmax(
+          rmax_thread[i], dbl3_dist(mesh->verts[l[i]], mesh->verts[m]));
+
+#pragma omp critical
+    for (size_t i = 0; i < trials; ++i)
+      rmax[i] = fmax(rmax[i], rmax_thread[i]);
+
+    free(rmax_thread);
   }
+
+  dbl diam_min = INFINITY;
+  for (size_t i = 0; i < trials; ++i)
+    diam_min = fmin(diam_min, 2*rmax[i]);
+
+  free(rmax);
+  free(l);
+
   return diam_min;
 }
 
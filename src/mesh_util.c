@@ -6,7 +6,7 @@
 #include <jmm/util.h>
 #include <jmm/vec.h>
 
-bool face_in_cell(size_t const f[3], size_t const c[4]) {
+bool face_in_cell(size_t const f[3], jmm_index_t const c[4]) {
   return point_in_cell(f[0], c) && point_in_cell(f[1], c) &&
     point_in_cell(f[2], c);
 }
@@ -15,7 +15,7 @@ bool point_in_face(size_t l, size_t const f[3]) {
   return f[0] == l || f[1] == l || f[2] == l;
 }
 
-bool point_in_cell(size_t l, size_t const c[4]) {
+bool point_in_cell(size_t l, jmm_index_t const c[4]) {
   return c[0] == l || c[1] == l || c[2] == l || c[3] == l;
 }
 
@@ -151,7 +151,7 @@ void triqp2_solve(triqp2_s *qp, dbl tol) {
   }
 
   else if (p_x10_opt == p_x11_opt) {
-    assert(fabs(1 - x10_opt) < tol && x11_opt == 1);
+    assert(fabs(1 - x10_opt) < tol && fabs(1 - x11_opt) < tol);
     x[0] = 1;
     x[1] = 0;
   }
@@ -34,8 +34,20 @@ void *block_get(block_s *block, size_t num_bytes) {
   return ptr;
 }
 
+/* A list of chunks of `num_bytes` bytes which have been returned to
+ * the pool with `pool_put`. Each free chunk stores a pointer to the
+ * next one in its first bytes. */
+typedef struct free_list {
+  size_t num_bytes;
+  void *head;
+} free_list_s;
+
 struct pool {
   array_s *blocks;
+  array_s *free_lists;
+#if JMM_DEBUG
+  size_t num_allocs; // number of calls to `malloc` made by the pool
+#endif
 };
 
 void pool_alloc(pool_s **pool) {
@@ -51,6 +63,9 @@ static void pool_append_block(pool_s *pool, size_t capacity) {
   block_s block;
   block_init(&block, capacity);
   array_append(pool->blocks, &block);
+#if JMM_DEBUG
+  ++pool->num_allocs;
+#endif
 }
 
 void pool_init(pool_s *pool, size_t initial_capacity) {
@@ -58,6 +73,14 @@ void pool_init(pool_s *pool, size_t initial_capacity) {
   array_alloc(&pool->blocks);
   array_init(pool->blocks, sizeof(block_s), 1);
 
+  // Set up free lists
+  array_alloc(&pool->free_lists);
+  array_init(pool->free_lists, sizeof(free_list_s), 4);
+
+#if JMM_DEBUG
+  pool->num_allocs = 0;
+#endif
+
   // Set up first block
   pool_append_block(pool, initial_capacity);
 }
@@ -70,9 +93,31 @@ void pool_deinit(pool_s *pool) {
   // Free block list
   array_deinit(pool->blocks);
   array_dealloc(&pool->blocks);
+
+  // Free list of free lists (the chunks themselves live in the blocks)
+  array_deinit(pool->free_lists);
+  array_dealloc(&pool->free_lists);
+}
+
+static free_list_s *get_free_list(pool_s const *pool, size_t num_bytes) {
+  for (size_t i = 0; i < array_size(pool->free_lists); ++i) {
+    free_list_s *free_list = array_get_ptr(pool->free_lists, i);
+    if (free_list->num_bytes == num_bytes)
+      return free_list;
+  }
+  return NULL;
 }
 
 void *pool_get(pool_s *pool, size_t num_bytes) {
+  // If a chunk of the same size was returned to the pool earlier,
+  // reuse it
+  free_list_s *free_list = get_free_list(pool, num_bytes);
+  if (free_list != NULL && free_list->head != NULL) {
+    void *ptr = free_list->head;
+    free_list->head = *(void **)ptr;
+    return ptr;
+  }
+
   block_s *block = NULL;
 
   // First, traverse the block list and see if we can allocate from
@@ -97,3 +142,27 @@ void *pool_get(pool_s *pool, size_t num_bytes) {
   assert(block->capacity >= num_bytes);
   return block_get(block, num_bytes);
 }
+
+/* Return `ptr`, which was obtained by calling `pool_get` with the same
+ * value of `num_bytes`, to the pool so that it can be handed out again
+ * by a later call to `pool_get`. The memory isn't released until the
+ * pool is deinitialized. */
+void pool_put(pool_s *pool, void *ptr, size_t num_bytes) {
+  assert(num_bytes >= sizeof(void *));
+
+  free_list_s *free_list = get_free_list(pool, num_bytes);
+  if (free_list == NULL) {
+    free_list_s new_free_list = {.num_bytes = num_bytes, .head = NULL};
+    array_append(pool->free_lists, &new_free_list);
+    free_list = array_get_ptr(pool->free_lists, array_size(pool->free_lists) - 1);
+  }
+
+  *(void **)ptr = free_list->head;
+  free_list->head = ptr;
+}
+
+#if JMM_DEBUG
+size_t pool_get_num_allocs(pool_s const *pool) {
+  return pool->num_allocs;
+}
+#endif
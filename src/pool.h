@@ -2,10 +2,14 @@
 
 #include <stddef.h>
 
-typedef struct pool pool_s;
+#include <jmm/common.h>
 
 void pool_alloc(pool_s **pool);
 void pool_dealloc(pool_s **pool);
 void pool_init(pool_s *pool, size_t initial_capacity);
 void pool_deinit(pool_s *pool);
 void *pool_get(pool_s *pool, size_t num_bytes);
+void pool_put(pool_s *pool, void *ptr, size_t num_bytes);
+#if JMM_DEBUG
+size_t pool_get_num_allocs(pool_s const *pool);
+#endif
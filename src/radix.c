@@ -0,0 +1,144 @@
+#include "radix.h"
+
+#include <omp.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+
+/* Radix sorts go one byte at a time */
+#define RADIX_BITS 8
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define RADIX_MASK (RADIX_SIZE - 1)
+
+/* Sort the `n` keys `key` in increasing order in parallel, using a
+ * stable LSD radix sort, applying the same permutation to `val` if it
+ * isn't `NULL`. Only as many passes as there are bytes in `max_key`,
+ * which should bound the keys, are made.
+ *
+ * In each pass, each thread counts the digits in a contiguous block
+ * of the keys. The counts are then turned into offsets ordered first
+ * by digit and then by thread, so that each thread can scatter its
+ * block independently while keeping the sort stable. */
+void radix_sort_u64(size_t n, uint64_t *key, size_t *val, uint64_t max_key) {
+  int num_passes = 0;
+  while (num_passes < 64/RADIX_BITS && max_key >> (RADIX_BITS*num_passes))
+    ++num_passes;
+  if (n < 2 || num_passes == 0)
+    return;
+
+  uint64_t *key_tmp = malloc(n*sizeof(uint64_t));
+  size_t *val_tmp = val ? malloc(n*sizeof(size_t)) : NULL;
+
+  int num_threads = omp_get_max_threads();
+  size_t *count = malloc(num_threads*RADIX_SIZE*sizeof(size_t));
+
+  uint64_t *src_key = key, *dst_key = key_tmp;
+  size_t *src_val = val, *dst_val = val_tmp;
+
+  for (int pass = 0; pass < num_passes; ++pass) {
+    int shift = RADIX_BITS*pass;
+
+#pragma omp parallel num_threads(num_threads)
+    {
+      size_t t = omp_get_thread_num(), T = omp_get_num_threads();
+      size_t i0 = n*t/T, i1 = n*(t + 1)/T;
+
+      size_t *c = &count[t*RADIX_SIZE];
+      memset(c, 0x0, RADIX_SIZE*sizeof(size_t));
+      for (size_t i = i0; i < i1; ++i)
+        ++c[(src_key[i] >> shift) & RADIX_MASK];
+
+#pragma omp barrier
+#pragma omp single
+      {
+        size_t offset = 0;
+        for (size_t d = 0; d < RADIX_SIZE; ++d) {
+          for (size_t s = 0; s < T; ++s) {
+            size_t tmp = count[s*RADIX_SIZE + d];
+            count[s*RADIX_SIZE + d] = offset;
+            offset += tmp;
+          }
+        }
+      }
+
+      for (size_t i = i0; i < i1; ++i) {
+        size_t j = c[(src_key[i] >> shift) & RADIX_MASK]++;
+        dst_key[j] = src_key[i];
+        if (val)
+          dst_val[j] = src_val[i];
+      }
+    }
+
+    SWAP(src_key, dst_key);
+    SWAP(src_val, dst_val);
+  }
+
+  if (src_key != key) {
+    memcpy(key, src_key, n*sizeof(uint64_t));
+    if (val)
+      memcpy(val, src_val, n*sizeof(size_t));
+  }
+
+  free(count);
+  free(val_tmp);
+  free(key_tmp);
+}
+
+/* Sort the `n` tuples of `m` indices stored row-major in `tuple`
+ * (each less than `bound`) in lexicographic order, returning the
+ * sorting permutation (which the caller frees). As many of the
+ * trailing columns as fit are packed into one 64-bit key and sorted
+ * by together, working from the last column to the first. Equal
+ * tuples stay in their original order. */
+size_t *radix_sort_tuples(size_t n, size_t m, size_t const *tuple, size_t bound) {
+  int b = 1;
+  while (b < 64 && (bound - 1) >> b)
+    ++b;
+  size_t cols_per_key = MAX(1, 64/b);
+
+  size_t *perm = malloc(n*sizeof(size_t));
+  uint64_t *key = malloc(n*sizeof(uint64_t));
+
+#pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < n; ++i)
+    perm[i] = i;
+
+  for (size_t j1 = m; j1 > 0; ) {
+    size_t j0 = j1 > cols_per_key ? j1 - cols_per_key : 0;
+
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n; ++i) {
+      uint64_t k = 0;
+      for (size_t j = j0; j < j1; ++j)
+        k = (k << b) | tuple[perm[i]*m + j];
+      key[i] = k;
+    }
+
+    uint64_t max_key = 0;
+    for (size_t j = j0; j < j1; ++j)
+      max_key = (max_key << b) | (bound - 1);
+
+    radix_sort_u64(n, key, perm, max_key);
+
+    j1 = j0;
+  }
+
+  free(key);
+
+  return perm;
+}
+
+/* Given the `n` sorted keys `key`, each less than `m`, fill
+ * `offsets[0:m + 1]` so that the keys equal to `k` are
+ * `key[offsets[k]:offsets[k + 1]]`, as in the compressed adjacency
+ * tables used throughout. */
+void radix_get_offsets(size_t n, uint64_t const *key, size_t m, size_t *offsets) {
+#pragma omp parallel for schedule(static)
+  for (size_t i = 0; i <= n; ++i) {
+    size_t k0 = i == 0 ? 0 : key[i - 1] + 1;
+    size_t k1 = i == n ? m : key[i];
+    for (size_t k = k0; k <= k1; ++k)
+      offsets[k] = i;
+  }
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+void radix_sort_u64(size_t n, uint64_t *key, size_t *val, uint64_t max_key);
+size_t *radix_sort_tuples(size_t n, size_t m, size_t const *tuple, size_t bound);
+void radix_get_offsets(size_t n, uint64_t const *key, size_t m, size_t *offsets);
@@ -0,0 +1,300 @@
+#include <jmm/renderer.h>
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include <jmm/array.h>
+#include <jmm/bb.h>
+#include <jmm/bmesh.h>
+#include <jmm/mesh2.h>
+#include <jmm/mesh3.h>
+#include <jmm/rtree.h>
+#include <jmm/util.h>
+#include <jmm/vec.h>
+
+#include "macros.h"
+
+/* The image is split into square tiles of `RENDERER_TILE_SIZE^2`
+ * pixels, which are traced in parallel. */
+#define RENDERER_TILE_SIZE 16
+
+/* A `bmesh33_s` whose level sets are being rendered, along with the
+ * data used to shade them. The cells bracketing each level are found
+ * with `bmesh33_get_cells_bracketing_level`. */
+typedef struct {
+  bmesh33_s const *bmesh;
+  dbl const *spread;
+  dbl const *org;
+} layer_s;
+
+struct renderer {
+  camera_s camera;
+  mesh2_s *surface_mesh;
+  rtree_s *surface_rtree;
+  array_s *layers;
+
+  /* Scratch space for the indices of the cells bracketing a level */
+  array_s *lc;
+};
+
+void renderer_alloc(renderer_s **renderer) {
+  *renderer = malloc(sizeof(renderer_s));
+}
+
+void renderer_dealloc(renderer_s **renderer) {
+  assert(*renderer != NULL);
+  free(*renderer);
+  *renderer = NULL;
+}
+
+/* Set up `renderer` to render frames with `camera`. The boundary
+ * surface of `mesh` is drawn in each frame, and is only inserted into
+ * an R-tree here, once. */
+void renderer_init(renderer_s *renderer, mesh3_s const *mesh,
+                   camera_s const *camera) {
+  renderer->camera = *camera;
+
+  renderer->surface_mesh = mesh3_get_surface_mesh(mesh);
+
+  rtree_alloc(&renderer->surface_rtree);
+  rtree_init(renderer->surface_rtree, 16, RTREE_SPLIT_STRATEGY_SURFACE_AREA);
+  rtree_insert_mesh2(renderer->surface_rtree, renderer->surface_mesh);
+  rtree_build(renderer->surface_rtree);
+
+  array_alloc(&renderer->layers);
+  array_init(renderer->layers, sizeof(layer_s), ARRAY_DEFAULT_CAPACITY);
+
+  array_alloc(&renderer->lc);
+  array_init(renderer->lc, sizeof(size_t), ARRAY_DEFAULT_CAPACITY);
+}
+
+void renderer_deinit(renderer_s *renderer) {
+  array_deinit(renderer->layers);
+  array_dealloc(&renderer->layers);
+
+  array_deinit(renderer->lc);
+  array_dealloc(&renderer->lc);
+
+  rtree_deinit(renderer->surface_rtree);
+  rtree_dealloc(&renderer->surface_rtree);
+
+  mesh2_deinit(renderer->surface_mesh);
+  mesh2_dealloc(&renderer->surface_mesh);
+}
+
+/* Add `bmesh` to the set of meshes whose level sets are rendered. The
+ * spreading factor `spread` and origin `org` (given at the vertices
+ * of the mesh underlying `bmesh`) are used to shade the level sets,
+ * and aren't copied. */
+void renderer_add_bmesh33(renderer_s *renderer, bmesh33_s const *bmesh,
+                          dbl const *spread, dbl const *org) {
+  layer_s layer = {.bmesh = bmesh, .spread = spread, .org = org};
+  array_append(renderer->layers, &layer);
+}
+
+/* Find the closest hit for each ray in the packet in either the
+ * surface or the level set R-tree. */
+static void trace(renderer_s const *renderer, rtree_s const *level_rtree,
+                  ray3 const *ray, size_t n, isect *hit,
+                  robj_s const **skip_robj) {
+  isect level_hit[RTREE_PACKET_SIZE];
+  rtree_intersect_packet(renderer->surface_rtree, ray, n, hit, skip_robj);
+  rtree_intersect_packet(level_rtree, ray, n, level_hit, skip_robj);
+  for (size_t k = 0; k < n; ++k)
+    if (level_hit[k].t < hit[k].t)
+      hit[k] = level_hit[k];
+}
+
+/* Accumulate the color of the surface hit by `ray` at `hit` into
+ * `rgba`, using backwards alpha blending, and move the origin of
+ * `ray` to the hit. */
+static void shade(renderer_s const *renderer, ray3 *ray, isect const *hit,
+                  dbl *rgba, dbl *transparency) {
+  static dbl3 const surf_rgb = {0.54, 0.54, 0.54};
+  static dbl3 const eik_rgb = {1.0, 1.0, 1.0};
+
+  dbl const surf_alpha = 0.5;
+  dbl const eik_alpha = 1;
+
+  robj_type_e robj_type = robj_get_type(hit->obj);
+  void const *robj_data = robj_get_data(hit->obj);
+
+  dbl alpha = 1, scale = 1;
+  dbl const *rgb = NULL;
+  dbl3 n;
+
+  /* Increment the distance along the ray */
+  dbl3_saxpy_inplace(hit->t, ray->dir, ray->org);
+
+  /* Update the current alpha and RGB value */
+  switch (robj_type) {
+  case ROBJ_MESH2_TRI:
+    alpha *= surf_alpha;
+    rgb = &surf_rgb[0];
+    break;
+  case ROBJ_BMESH33_CELL:
+    alpha *= eik_alpha;
+    rgb = &eik_rgb[0];
+    break;
+  default:
+    assert(false);
+  }
+
+  if (robj_type == ROBJ_BMESH33_CELL) {
+    bmesh33_cell_s const *bmesh33_cell = robj_data;
+
+    /* Find the layer this cell belongs to */
+    layer_s const *layer = NULL;
+    for (size_t i = 0; i < array_size(renderer->layers); ++i) {
+      layer = array_get_ptr(renderer->layers, i);
+      if (bmesh33_cell->bmesh == layer->bmesh)
+        break;
+    }
+    assert(layer != NULL && bmesh33_cell->bmesh == layer->bmesh);
+
+    dbl spread_interp = mesh3_linterp(bmesh33_cell->mesh, layer->spread, ray->org);
+    dbl org_interp = mesh3_linterp(bmesh33_cell->mesh, layer->org, ray->org);
+
+    /* Convert the interpolated spreading factor to dB */
+    dbl spread_dB = 20*log10(fmax(1e-16, spread_interp));
+    /* Clamp and map the range [-60 dB, 0 dB] to [0, 1] for
+     * use as a scaling factor */
+    dbl spread_mapped = fmax(0, fmin(1, 1 - spread_dB/(-90)));
+    alpha *= spread_mapped*squash(org_interp, 2);
+  }
+
+  /* Get the surface normal and dot it with the eye vector for
+   * Lambertian shading */
+  if (robj_type == ROBJ_MESH2_TRI) {
+    mesh2_tri_s const *mesh2_tri = robj_data;
+    mesh2_get_unit_surface_normal(renderer->surface_mesh, mesh2_tri->l, n);
+  } else if (robj_type == ROBJ_BMESH33_CELL) {
+    bmesh33_cell_s const *bmesh33_cell = robj_data;
+    bmesh33_cell_Df(bmesh33_cell, ray->org, n);
+    dbl3_normalize(n);
+  } else {
+    assert(false);
+  }
+  scale *= fabs(dbl3_dot(n, ray->dir));
+
+  /* We're raymarching, so do backwards alpha blending */
+  dbl3_saxpy_inplace(scale*alpha, rgb, rgba);
+
+  /* Update transparency for early stopping */
+  *transparency *= 1 - alpha;
+}
+
+/* Render the `n` consecutive pixels in row `i` starting at column
+ * `j0`. The rays are traced together as a packet, and each one is
+ * marched through the transparent surfaces it hits, with the rays
+ * which are still going retraced together at each step. */
+static void render_packet(renderer_s const *renderer, rtree_s const *level_rtree,
+                          size_t i, size_t j0, size_t n, dbl4 *img) {
+  camera_s const *camera = &renderer->camera;
+
+  ray3 ray[RTREE_PACKET_SIZE];
+  isect hit[RTREE_PACKET_SIZE];
+  dbl transparency[RTREE_PACKET_SIZE];
+  for (size_t k = 0; k < n; ++k) {
+    ray[k] = camera_get_ray_for_index(camera, i, j0 + k);
+    transparency[k] = 1;
+  }
+
+  trace(renderer, level_rtree, ray, n, hit, NULL);
+
+  dbl4 *rgba = &img[i*camera->dim[1] + j0];
+  for (size_t k = 0; k < n; ++k) {
+    rgba[k][0] = rgba[k][1] = rgba[k][2] = 0;
+    rgba[k][3] = isfinite(hit[k].t) ? 1 : 0;
+  }
+
+  size_t num_active = n, active[RTREE_PACKET_SIZE];
+  for (size_t k = 0; k < n; ++k)
+    active[k] = k;
+
+  while (true) {
+    /* Shade the current hit for each active ray, and drop the rays
+     * which missed or have become opaque. */
+    size_t m = 0;
+    for (size_t p = 0; p < num_active; ++p) {
+      size_t k = active[p];
+      if (!isfinite(hit[k].t))
+        continue;
+      shade(renderer, &ray[k], &hit[k], rgba[k], &transparency[k]);
+      if (transparency[k] < 1e-3)
+        continue;
+      active[m++] = k;
+    }
+    num_active = m;
+    if (num_active == 0)
+      break;
+
+    /* Advance the start of each ray and keep tracing.
+     *
+     * NOTE: if we have multiple overlapping intersections, we might
+     * trip them repeatedly, so we need to skip any intersections with
+     * a distance of zero here. */
+    ray3 active_ray[RTREE_PACKET_SIZE];
+    isect active_hit[RTREE_PACKET_SIZE];
+    robj_s const *skip[RTREE_PACKET_SIZE];
+    for (size_t p = 0; p < num_active; ++p) {
+      active_ray[p] = ray[active[p]];
+      skip[p] = hit[active[p]].obj;
+    }
+    trace(renderer, level_rtree, active_ray, num_active, active_hit, skip);
+    for (size_t p = 0; p < num_active; ++p) {
+      size_t k = active[p];
+      hit[k] = active_hit[p];
+      while (hit[k].t < EPS) {
+        dbl3_saxpy_inplace(EPS, ray[k].dir, ray[k].org);
+        robj_s const *skip_robj = hit[k].obj;
+        trace(renderer, level_rtree, &ray[k], 1, &hit[k], &skip_robj);
+      }
+    }
+  }
+}
+
+/* Render a frame showing the level sets at `level`, writing RGBA
+ * values for each pixel to `img`, which should have `dim[0]*dim[1]`
+ * entries for the dimensions of the camera (in row-major order). */
+void renderer_render_frame(renderer_s *renderer, dbl level, dbl4 *img) {
+  camera_s const *camera = &renderer->camera;
+
+  /* Only the cells bracketing `level` go into the level set's
+   * R-tree. These are found quickly using the interval tree of each
+   * `bmesh33_s`, and there are few of them, so we just build a new
+   * R-tree each frame. */
+  rtree_s *level_rtree;
+  rtree_alloc(&level_rtree);
+  rtree_init(level_rtree, 16, RTREE_SPLIT_STRATEGY_SURFACE_AREA);
+  for (size_t i = 0; i < array_size(renderer->layers); ++i) {
+    layer_s const *layer = array_get_ptr(renderer->layers, i);
+    array_clear(renderer->lc);
+    bmesh33_get_cells_bracketing_level(layer->bmesh, level, renderer->lc);
+    rtree_insert_bmesh33_cells(level_rtree, layer->bmesh, level,
+                               array_size(renderer->lc),
+                               array_get_ptr(renderer->lc, 0));
+  }
+  rtree_build(level_rtree);
+
+  size_t tile_dim[2];
+  for (int i = 0; i < 2; ++i)
+    tile_dim[i] = (camera->dim[i] + RENDERER_TILE_SIZE - 1)/RENDERER_TILE_SIZE;
+
+  size_t ntiles = tile_dim[0]*tile_dim[1];
+#pragma omp parallel for schedule(dynamic)
+  for (size_t l = 0; l < ntiles; ++l) {
+    size_t i0 = RENDERER_TILE_SIZE*(l/tile_dim[1]);
+    size_t j0 = RENDERER_TILE_SIZE*(l%tile_dim[1]);
+    size_t i1 = MIN(i0 + RENDERER_TILE_SIZE, camera->dim[0]);
+    size_t j1 = MIN(j0 + RENDERER_TILE_SIZE, camera->dim[1]);
+    for (size_t i = i0; i < i1; ++i)
+      for (size_t j = j0; j < j1; j += RTREE_PACKET_SIZE)
+        render_packet(renderer, level_rtree, i, j,
+                      MIN((size_t)RTREE_PACKET_SIZE, j1 - j), img);
+  }
+
+  rtree_deinit(level_rtree);
+  rtree_dealloc(&level_rtree);
+}
@@ -318,73 +318,6 @@ size_t rnode_leaf_size(rnode_s const *node) {
   return node->leaf_data.size;
 }
 
-// TODO: better to do this using a stack instead of recursively
-static bool rnode_query_bbox(rnode_s const *node, rect3 const *bbox) {
-  if (!rect3_overlaps(&node->bbox, bbox))
-    return false;
-  if (node->type == RNODE_TYPE_INTERNAL)
-    return rnode_query_bbox(node->child[0], bbox)
-        || rnode_query_bbox(node->child[1], bbox);
-  for (size_t i = 0; i < node->leaf_data.size; ++i)
-    if (robj_isects_bbox(&node->leaf_data.obj[i], bbox))
-      return true;
-  return false;
-}
-
-static void
-rnode_intersect_leaf(rnode_s const *node, ray3 const *ray, isect *isect,
-                     robj_s const *skip_robj) {
-  dbl t;
-  robj_s const *obj;
-  for (size_t i = 0; i < node->leaf_data.size; ++i) {
-    obj = &node->leaf_data.obj[i];
-    if (robj_equal(skip_robj, obj))
-      continue;
-    if (robj_intersect(obj, ray, &t) && 0 <= t && t < isect->t) {
-      isect->t = t;
-      isect->obj = obj;
-    }
-  }
-}
-
-static void
-rnode_intersect(rnode_s const *node, ray3 const *ray, isect *isect,
-                robj_s const *skip_robj) {
-  /* First, check whether the ray intersects the current node's
-   * bounding box. If it doesn't, we don't want to update the
-   * intersection's t value or check for intersections below this
-   * node, so we return early. */
-  dbl t = ray3_intersect_rect3(ray, &node->bbox);
-  if (isinf(t))
-    return;
-
-  /* If this is a leaf node, then we've bottomed out in the recursion:
-   * time to check for intersections with each contained object. */
-  if (node->type == RNODE_TYPE_LEAF) {
-    rnode_intersect_leaf(node, ray, isect, skip_robj);
-    return;
-  }
-
-  /* Intersect the bounding boxes of the two child nodes. */
-  dbl t_child[2] = {
-    ray3_intersect_rect3(ray, &node->child[0]->bbox),
-    ray3_intersect_rect3(ray, &node->child[1]->bbox)
-  };
-
-  /* Sort the pair of intersection parameters, and grab pointers to
-   * the child nodes in the same order. */
-  rnode_s *child[2] = {node->child[0], node->child[1]};
-  if (t_child[1] < t_child[0]) {
-    SWAP(t_child[0], t_child[1]);
-    SWAP(child[0], child[1]);
-  }
-
-  /* Intersect the child nodes in sorted order. */
-  for (int i = 0; i < 2; ++i)
-    if (isfinite(t_child[i]))
-      rnode_intersect(child[i], ray, isect, skip_robj);
-}
-
 /**
  * The number of bins to use when using one pass of Tibshirani's
  * binmedian algorithm to approximate the median along each axis when
@@ -433,16 +366,132 @@ cleanup:
   return success;
 }
 
+// Section: flat nodes
+
+/**
+ * After they're built, the nodes of an R-tree are stored in a single
+ * array in depth-first order. The first child of an internal node
+ * immediately follows it, and `offset` is the index of its second
+ * child. For a leaf, `offset` is the index of its first object in
+ * the array of objects, which are stored contiguously in the same
+ * order as the leaves. The bounding boxes are rounded outwards to
+ * single precision so that each node fits in 32 bytes.
+ *
+ * The ray-object intersection tests accept hits which are slightly
+ * outside of the object, so each bounding box is also padded by
+ * `FNODE_PAD_RTOL` times the size of the whole tree. This ensures a
+ * ray always enters a node before it hits any of the objects inside,
+ * which is what makes it safe to prune nodes using the closest hit
+ * found so far, regardless of the order the nodes are visited in.
+ */
+typedef struct {
+  float min[3], max[3];
+  uint32_t offset;
+  uint32_t num_objs; // `FNODE_INTERNAL` for internal nodes
+} fnode_s;
+
+#define FNODE_INTERNAL UINT32_MAX
+
+#define FNODE_PAD_RTOL 1e-9
+
+static float round_down(dbl x) {
+  float y = x;
+  return y > x ? nextafterf(y, -INFINITY) : y;
+}
+
+static float round_up(dbl x) {
+  float y = x;
+  return y < x ? nextafterf(y, INFINITY) : y;
+}
+
+static void fnode_set_bbox(fnode_s *fnode, rect3 const *bbox, dbl pad) {
+  for (int i = 0; i < 3; ++i) {
+    fnode->min[i] = round_down(bbox->min[i] - pad);
+    fnode->max[i] = round_up(bbox->max[i] + pad);
+  }
+}
+
+static bool fnode_overlaps(fnode_s const *fnode, rect3 const *bbox) {
+  for (int i = 0; i < 3; ++i)
+    if (fnode->max[i] < bbox->min[i] || fnode->min[i] > bbox->max[i])
+      return false;
+  return true;
+}
+
+/**
+ * Precomputed data for slab tests between a ray and a bounding box.
+ */
+typedef struct {
+  dbl org[3];
+  dbl inv_dir[3];
+  bool parallel[3]; // Is the ray parallel to the slabs along this axis?
+} slab_ray_s;
+
+static slab_ray_s make_slab_ray(ray3 const *ray) {
+  dbl const atol = 1e-15;
+  slab_ray_s slab_ray;
+  for (int i = 0; i < 3; ++i) {
+    slab_ray.org[i] = ray->org[i];
+    slab_ray.parallel[i] = fabs(ray->dir[i]) <= atol;
+    slab_ray.inv_dir[i] = slab_ray.parallel[i] ? 0 : 1/ray->dir[i];
+  }
+  return slab_ray;
+}
+
+/* Do slab tests for the ray against the bounding boxes of two nodes
+ * at once, returning the parameter where the ray enters each box (or
+ * `INFINITY` if it misses). The loop over the pair of boxes is
+ * innermost so that the compiler can vectorize it. */
+static void slab_test2(slab_ray_s const *slab_ray, fnode_s const *fnode[2],
+                       dbl t[2]) {
+  dbl t_near[2] = {0, 0}, t_far[2] = {INFINITY, INFINITY};
+  for (int i = 0; i < 3; ++i) {
+    if (slab_ray->parallel[i]) {
+      for (int j = 0; j < 2; ++j)
+        if (slab_ray->org[i] < fnode[j]->min[i] || slab_ray->org[i] > fnode[j]->max[i])
+          t_far[j] = -INFINITY;
+      continue;
+    }
+    for (int j = 0; j < 2; ++j) {
+      dbl t0 = (fnode[j]->min[i] - slab_ray->org[i])*slab_ray->inv_dir[i];
+      dbl t1 = (fnode[j]->max[i] - slab_ray->org[i])*slab_ray->inv_dir[i];
+      t_near[j] = fmax(t_near[j], fmin(t0, t1));
+      t_far[j] = fmin(t_far[j], fmax(t0, t1));
+    }
+  }
+  for (int j = 0; j < 2; ++j)
+    t[j] = t_near[j] <= t_far[j] ? t_near[j] : INFINITY;
+}
+
+static dbl slab_test(slab_ray_s const *slab_ray, fnode_s const *fnode) {
+  fnode_s const *fnode_pair[2] = {fnode, fnode};
+  dbl t[2];
+  slab_test2(slab_ray, fnode_pair, t);
+  return t[0];
+}
+
 // Section: rtree_s
 
 #define RTREE_POOL_INITIAL_CAPACITY 4096
 
 struct rtree {
+  /* The tree as it's built, with objects stored in the leaves. After
+   * `rtree_build`, this is just an empty leaf with the bounding box
+   * of the whole tree. */
   rnode_s root;
   size_t leaf_thresh; // Maximum size of a leaf node
   rtree_split_strategy_e split_strategy;
   pool_s *pool;
   bool pool_owner;
+  bool is_built;
+
+  /* The flattened tree, which is used for queries. This is kept up
+   * to date with `root` as objects are inserted. */
+  size_t num_fnodes;
+  fnode_s *fnode;
+  size_t num_objs;
+  robj_s *obj;
+  size_t depth;
 };
 
 void rtree_alloc(rtree_s **rtree) {
@@ -454,6 +503,61 @@ void rtree_dealloc(rtree_s **rtree) {
   *rtree = NULL;
 }
 
+static void count_rnodes(rnode_s const *node, size_t depth, rtree_s *rtree) {
+  ++rtree->num_fnodes;
+  rtree->depth = MAX(rtree->depth, depth);
+  if (node->type == RNODE_TYPE_LEAF) {
+    rtree->num_objs += node->leaf_data.size;
+  } else {
+    count_rnodes(node->child[0], depth + 1, rtree);
+    count_rnodes(node->child[1], depth + 1, rtree);
+  }
+}
+
+static void flatten_rnode(rnode_s const *node, rtree_s *rtree, dbl pad,
+                          size_t *i_fnode, size_t *i_obj) {
+  fnode_s *fnode = &rtree->fnode[(*i_fnode)++];
+  fnode_set_bbox(fnode, &node->bbox, pad);
+  if (node->type == RNODE_TYPE_LEAF) {
+    fnode->offset = *i_obj;
+    fnode->num_objs = node->leaf_data.size;
+    memcpy(&rtree->obj[*i_obj], node->leaf_data.obj,
+           node->leaf_data.size*sizeof(robj_s));
+    *i_obj += node->leaf_data.size;
+  } else {
+    fnode->num_objs = FNODE_INTERNAL;
+    flatten_rnode(node->child[0], rtree, pad, i_fnode, i_obj);
+    fnode->offset = *i_fnode;
+    flatten_rnode(node->child[1], rtree, pad, i_fnode, i_obj);
+  }
+}
+
+/* Rebuild the flattened tree from `rtree->root`. */
+static void flatten(rtree_s *rtree) {
+  rtree->num_fnodes = 0;
+  rtree->num_objs = 0;
+  rtree->depth = 0;
+  count_rnodes(&rtree->root, 0, rtree);
+
+  assert(rtree->num_fnodes < UINT32_MAX);
+  assert(rtree->num_objs < UINT32_MAX);
+
+  rtree->fnode = realloc(rtree->fnode, rtree->num_fnodes*sizeof(fnode_s));
+  rtree->obj = realloc(rtree->obj, rtree->num_objs*sizeof(robj_s));
+
+  dbl pad = 0;
+  for (int i = 0; i < 3; ++i) {
+    dbl extent = rtree->root.bbox.max[i] - rtree->root.bbox.min[i];
+    if (isfinite(extent))
+      pad = fmax(pad, FNODE_PAD_RTOL*extent);
+  }
+
+  size_t i_fnode = 0, i_obj = 0;
+  flatten_rnode(&rtree->root, rtree, pad, &i_fnode, &i_obj);
+  assert(i_fnode == rtree->num_fnodes);
+  assert(i_obj == rtree->num_objs);
+}
+
 void rtree_init(rtree_s *rtree, size_t leaf_thresh,
                 rtree_split_strategy_e split_strategy) {
   rnode_init(&rtree->root, RNODE_TYPE_LEAF);
@@ -463,6 +567,12 @@ void rtree_init(rtree_s *rtree, size_t leaf_thresh,
   pool_alloc(&rtree->pool);
   pool_init(rtree->pool, RTREE_POOL_INITIAL_CAPACITY);
   rtree->pool_owner = true;
+
+  rtree->is_built = false;
+
+  rtree->fnode = NULL;
+  rtree->obj = NULL;
+  flatten(rtree);
 }
 
 void rtree_deinit(rtree_s *rtree) {
@@ -472,6 +582,12 @@ void rtree_deinit(rtree_s *rtree) {
     pool_deinit(rtree->pool);
     pool_dealloc(&rtree->pool);
   }
+
+  free(rtree->fnode);
+  rtree->fnode = NULL;
+
+  free(rtree->obj);
+  rtree->obj = NULL;
 }
 
 rtree_s *rtree_copy(rtree_s const *rtree) {
@@ -482,10 +598,23 @@ rtree_s *rtree_copy(rtree_s const *rtree) {
   copy->pool = rtree->pool;
   copy->pool_owner = false; // The original rtree is responsible for
                             // freeing the pool
+  copy->is_built = rtree->is_built;
+
+  copy->num_fnodes = rtree->num_fnodes;
+  copy->fnode = malloc(rtree->num_fnodes*sizeof(fnode_s));
+  memcpy(copy->fnode, rtree->fnode, rtree->num_fnodes*sizeof(fnode_s));
+
+  copy->num_objs = rtree->num_objs;
+  copy->obj = malloc(rtree->num_objs*sizeof(robj_s));
+  memcpy(copy->obj, rtree->obj, rtree->num_objs*sizeof(robj_s));
+
+  copy->depth = rtree->depth;
+
   return copy;
 }
 
 void rtree_insert_bmesh33(rtree_s *rtree, bmesh33_s const *bmesh) {
+  assert(!rtree->is_built);
   rnode_s *node = &rtree->root;
   assert(node->type == RNODE_TYPE_LEAF);
   size_t num_cells = bmesh33_num_cells(bmesh);
@@ -497,9 +626,31 @@ void rtree_insert_bmesh33(rtree_s *rtree, bmesh33_s const *bmesh) {
     rnode_append_robj(node, obj);
   }
   rnode_recompute_bbox(node);
+  flatten(rtree);
+}
+
+/* Insert the cells `lc[0], ..., lc[n - 1]` of `bmesh`, restricted to
+ * `level`. This is useful when the cells bracketing `level` are
+ * already known, since no level view needs to be created. */
+void rtree_insert_bmesh33_cells(rtree_s *rtree, bmesh33_s const *bmesh,
+                                dbl level, size_t n, size_t const *lc) {
+  assert(!rtree->is_built);
+  rnode_s *node = &rtree->root;
+  assert(node->type == RNODE_TYPE_LEAF);
+  robj_s obj = {.type = ROBJ_BMESH33_CELL};
+  for (size_t i = 0; i < n; ++i) {
+    bmesh33_cell_s *cell = pool_get(rtree->pool, sizeof(bmesh33_cell_s));
+    *cell = bmesh33_get_cell(bmesh, lc[i]);
+    cell->level = level;
+    obj.data = cell;
+    rnode_append_robj(node, obj);
+  }
+  rnode_recompute_bbox(node);
+  flatten(rtree);
 }
 
 void rtree_insert_mesh2(rtree_s *rtree, mesh2_s const *mesh) {
+  assert(!rtree->is_built);
   rnode_s *node = &rtree->root;
   assert(node->type == RNODE_TYPE_LEAF);
   size_t num_faces = mesh2_nfaces(mesh);
@@ -512,9 +663,11 @@ void rtree_insert_mesh2(rtree_s *rtree, mesh2_s const *mesh) {
     rnode_append_robj(node, obj);
   }
   rnode_recompute_bbox(node);
+  flatten(rtree);
 }
 
 void rtree_insert_mesh3(rtree_s *rtree, mesh3_s const *mesh) {
+  assert(!rtree->is_built);
   rnode_s *node = &rtree->root;
   assert(node->type == RNODE_TYPE_LEAF);
   size_t num_cells = mesh3_ncells(mesh);
@@ -527,6 +680,7 @@ void rtree_insert_mesh3(rtree_s *rtree, mesh3_s const *mesh) {
     rnode_append_robj(node, obj);
   }
   rnode_recompute_bbox(node);
+  flatten(rtree);
 }
 
 static void refine_node_surface_area(rtree_s const *rtree, rnode_s *node) {
@@ -610,41 +764,329 @@ void refine_node(rtree_s const *rtree, rnode_s *node) {
 }
 
 void rtree_build(rtree_s *rtree) {
+  assert(!rtree->is_built);
+
   refine_node(rtree, &rtree->root);
+  flatten(rtree);
+
+  /* The objects now live in `rtree->obj`, so we can free the
+   * pointer-based tree, keeping only its bounding box. */
+  rect3 bbox = rtree->root.bbox;
+  rnode_deinit(&rtree->root);
+  rnode_init(&rtree->root, RNODE_TYPE_LEAF);
+  rtree->root.bbox = bbox;
+
+  rtree->is_built = true;
 }
 
 rect3 rtree_get_bbox(rtree_s const *rtree) {
   return rtree->root.bbox;
 }
 
-static void count_leaf_nodes(rnode_s const *node, size_t *num_leaf_nodes) {
-  if (node->type == RNODE_TYPE_LEAF) {
-    ++*num_leaf_nodes;
-  } else {
-    count_leaf_nodes(node->child[0], num_leaf_nodes);
-    count_leaf_nodes(node->child[1], num_leaf_nodes);
-  }
-}
-
 size_t rtree_get_num_leaf_nodes(rtree_s const *rtree) {
   size_t num_leaf_nodes = 0;
-  count_leaf_nodes(&rtree->root, &num_leaf_nodes);
+  for (size_t i = 0; i < rtree->num_fnodes; ++i)
+    if (rtree->fnode[i].num_objs != FNODE_INTERNAL)
+      ++num_leaf_nodes;
   return num_leaf_nodes;
 }
 
 bool rtree_query_bbox(rtree_s const *rtree, rect3 const *bbox) {
-  return rnode_query_bbox(&rtree->root, bbox);
+  size_t stack[rtree->depth + 1], size = 0;
+  stack[size++] = 0;
+  while (size > 0) {
+    fnode_s const *fnode = &rtree->fnode[stack[--size]];
+    if (!fnode_overlaps(fnode, bbox))
+      continue;
+    if (fnode->num_objs == FNODE_INTERNAL) {
+      stack[size++] = fnode->offset;
+      stack[size++] = fnode - rtree->fnode + 1;
+      continue;
+    }
+    for (size_t i = 0; i < fnode->num_objs; ++i)
+      if (robj_isects_bbox(&rtree->obj[fnode->offset + i], bbox))
+        return true;
+  }
+  return false;
+}
+
+/* Update `isect` if `obj` is hit closer along the ray. Ties are
+ * broken in favor of the object which comes first in `rtree->obj`, so
+ * that the result doesn't depend on the order the leaves are
+ * visited in. */
+static void update_isect(isect *isect, robj_s const *obj, dbl t) {
+  if (t < 0)
+    return;
+  if (t < isect->t || (t == isect->t && obj < isect->obj)) {
+    isect->t = t;
+    isect->obj = obj;
+  }
+}
+
+static void intersect_leaf(rtree_s const *rtree, fnode_s const *fnode,
+                           ray3 const *ray, isect *isect,
+                           robj_s const *skip_robj) {
+  dbl t;
+  robj_s const *obj;
+  for (size_t i = 0; i < fnode->num_objs; ++i) {
+    obj = &rtree->obj[fnode->offset + i];
+    if (robj_equal(skip_robj, obj))
+      continue;
+    if (robj_intersect(obj, ray, &t))
+      update_isect(isect, obj, t);
+  }
 }
 
 void rtree_intersect(rtree_s const *rtree, ray3 const *ray, isect *isect,
                      robj_s const *skip_robj) {
   isect->t = INFINITY;
   isect->obj = NULL;
-  rnode_intersect(&rtree->root, ray, isect, skip_robj);
+
+  slab_ray_s slab_ray = make_slab_ray(ray);
+
+  /* Each entry of the stack is a node whose bounding box the ray
+   * enters at `t`. Since the far child of each internal node is
+   * pushed before the near one, there are never more than `depth +
+   * 1` nodes on the stack. */
+  struct {
+    size_t i;
+    dbl t;
+  } stack[rtree->depth + 1];
+  size_t size = 0;
+
+  dbl t_root = slab_test(&slab_ray, &rtree->fnode[0]);
+  if (isinf(t_root))
+    return;
+  stack[size].i = 0;
+  stack[size++].t = t_root;
+
+  while (size > 0) {
+    --size;
+
+    /* Skip nodes which the ray enters after the closest intersection
+     * found so far. */
+    if (stack[size].t > isect->t)
+      continue;
+
+    fnode_s const *fnode = &rtree->fnode[stack[size].i];
+
+    if (fnode->num_objs != FNODE_INTERNAL) {
+      intersect_leaf(rtree, fnode, ray, isect, skip_robj);
+      continue;
+    }
+
+    size_t i_child[2] = {fnode - rtree->fnode + 1, fnode->offset};
+    fnode_s const *child[2] = {&rtree->fnode[i_child[0]], &rtree->fnode[i_child[1]]};
+
+    dbl t_child[2];
+    slab_test2(&slab_ray, child, t_child);
+
+    /* Push the far child first so that the near child is visited
+     * first. */
+    if (t_child[0] < t_child[1]) {
+      SWAP(t_child[0], t_child[1]);
+      SWAP(i_child[0], i_child[1]);
+    }
+    for (int j = 0; j < 2; ++j) {
+      if (isinf(t_child[j]))
+        continue;
+      stack[size].i = i_child[j];
+      stack[size++].t = t_child[j];
+    }
+  }
+}
+
+/**
+ * Precomputed slab test data for a packet of up to
+ * `RTREE_PACKET_SIZE` rays, stored as a structure of arrays so that
+ * the loops over the rays in the packet can be vectorized. Unused
+ * lanes are padded so that they miss every node.
+ */
+typedef struct {
+  size_t n;
+  dbl org[3][RTREE_PACKET_SIZE];
+  dbl inv_dir[3][RTREE_PACKET_SIZE];
+  bool parallel[3][RTREE_PACKET_SIZE];
+} slab_packet_s;
+
+static void make_slab_packet(ray3 const *ray, size_t n, slab_packet_s *packet) {
+  assert(n <= RTREE_PACKET_SIZE);
+  packet->n = n;
+  for (size_t j = 0; j < RTREE_PACKET_SIZE; ++j) {
+    slab_ray_s slab_ray;
+    if (j < n)
+      slab_ray = make_slab_ray(&ray[j]);
+    for (int i = 0; i < 3; ++i) {
+      packet->org[i][j] = j < n ? slab_ray.org[i] : 0;
+      packet->inv_dir[i][j] = j < n ? slab_ray.inv_dir[i] : 0;
+      packet->parallel[i][j] = j < n ? slab_ray.parallel[i] : false;
+    }
+  }
+}
+
+/* Do the slab test for each ray in the packet against the bounding
+ * box of `fnode`. This does the same arithmetic as `slab_test2`, so
+ * that the entry parameters agree with the scalar traversal
+ * exactly. Rays which miss the box, or which enter it after their
+ * closest intersection `t_max` so far, get `INFINITY`. */
+static void slab_test_packet(slab_packet_s const *packet, fnode_s const *fnode,
+                             dbl const t_max[RTREE_PACKET_SIZE],
+                             dbl t[RTREE_PACKET_SIZE]) {
+  dbl t_near[RTREE_PACKET_SIZE], t_far[RTREE_PACKET_SIZE];
+  for (size_t j = 0; j < RTREE_PACKET_SIZE; ++j) {
+    t_near[j] = 0;
+    t_far[j] = INFINITY;
+  }
+  for (int i = 0; i < 3; ++i) {
+    dbl min = fnode->min[i], max = fnode->max[i];
+#pragma omp simd
+    for (size_t j = 0; j < RTREE_PACKET_SIZE; ++j) {
+      dbl org = packet->org[i][j], inv_dir = packet->inv_dir[i][j];
+      dbl t0 = (min - org)*inv_dir;
+      dbl t1 = (max - org)*inv_dir;
+      bool parallel = packet->parallel[i][j];
+      bool miss = parallel && (org < min || org > max);
+      t_near[j] = parallel ? t_near[j] : fmax(t_near[j], fmin(t0, t1));
+      t_far[j] = miss ? -INFINITY : parallel ? t_far[j] : fmin(t_far[j], fmax(t0, t1));
+    }
+  }
+#pragma omp simd
+  for (size_t j = 0; j < RTREE_PACKET_SIZE; ++j)
+    t[j] = t_near[j] <= t_far[j] && t_near[j] <= t_max[j] ? t_near[j] : INFINITY;
+}
+
+static bool packet_is_active(dbl const t[RTREE_PACKET_SIZE]) {
+  for (size_t j = 0; j < RTREE_PACKET_SIZE; ++j)
+    if (isfinite(t[j]))
+      return true;
+  return false;
+}
+
+/* Intersect each active ray in the packet with the objects in a
+ * leaf. Triangles are fetched once per leaf and shared by the whole
+ * packet; the other objects go through `robj_intersect`. */
+static void intersect_leaf_packet(rtree_s const *rtree, fnode_s const *fnode,
+                                  ray3 const *ray, bool const active[RTREE_PACKET_SIZE],
+                                  isect *isect, robj_s const **skip_robj) {
+  for (size_t i = 0; i < fnode->num_objs; ++i) {
+    robj_s const *obj = &rtree->obj[fnode->offset + i];
+
+    tri3 tri;
+    bool is_tri = obj->type == ROBJ_MESH2_TRI || obj->type == ROBJ_TRI3;
+    if (obj->type == ROBJ_MESH2_TRI) {
+      mesh2_tri_s const *mesh_tri = obj->data;
+      tri = mesh2_get_tri(mesh_tri->mesh, mesh_tri->l);
+    } else if (obj->type == ROBJ_TRI3) {
+      tri = *(tri3 const *)obj->data;
+    }
+
+    for (size_t j = 0; j < RTREE_PACKET_SIZE; ++j) {
+      if (!active[j])
+        continue;
+      if (skip_robj != NULL && robj_equal(skip_robj[j], obj))
+        continue;
+      dbl t;
+      bool hit = is_tri ?
+        ray3_intersects_tri3(&ray[j], &tri, &t) :
+        robj_intersect(obj, &ray[j], &t);
+      if (hit)
+        update_isect(&isect[j], obj, t);
+    }
+  }
+}
+
+/* Trace a packet of at most `RTREE_PACKET_SIZE` rays through the
+ * R-tree together. A node is visited if any ray in the packet could
+ * still find a closer intersection in it, and the leaves are only
+ * intersected with those rays. */
+static void intersect_packet(rtree_s const *rtree, ray3 const *ray, size_t n,
+                             isect *isect, robj_s const **skip_robj) {
+  slab_packet_s packet;
+  make_slab_packet(ray, n, &packet);
+
+  /* Padded lanes have `t_max = -INFINITY`, so they never enter a
+   * node. */
+  dbl t_max[RTREE_PACKET_SIZE];
+  for (size_t j = 0; j < RTREE_PACKET_SIZE; ++j) {
+    t_max[j] = j < n ? INFINITY : -INFINITY;
+    if (j < n) {
+      isect[j].t = INFINITY;
+      isect[j].obj = NULL;
+    }
+  }
+
+  /* As in `rtree_intersect`, but with the entry parameter of each ray
+   * in the packet stored on the stack. */
+  struct {
+    size_t i;
+    dbl t[RTREE_PACKET_SIZE];
+  } stack[rtree->depth + 1];
+  size_t size = 0;
+
+  slab_test_packet(&packet, &rtree->fnode[0], t_max, stack[size].t);
+  if (!packet_is_active(stack[size].t))
+    return;
+  stack[size++].i = 0;
+
+  while (size > 0) {
+    --size;
+
+    /* Deactivate rays which enter this node after the closest
+     * intersection they've found so far. */
+    bool active[RTREE_PACKET_SIZE], any_active = false;
+    for (size_t j = 0; j < RTREE_PACKET_SIZE; ++j) {
+      active[j] = isfinite(stack[size].t[j]) && stack[size].t[j] <= t_max[j];
+      any_active |= active[j];
+    }
+    if (!any_active)
+      continue;
+
+    fnode_s const *fnode = &rtree->fnode[stack[size].i];
+
+    if (fnode->num_objs != FNODE_INTERNAL) {
+      intersect_leaf_packet(rtree, fnode, ray, active, isect, skip_robj);
+      for (size_t j = 0; j < n; ++j)
+        t_max[j] = isect[j].t;
+      continue;
+    }
+
+    size_t i_child[2] = {fnode - rtree->fnode + 1, fnode->offset};
+
+    dbl t_child[2][RTREE_PACKET_SIZE];
+    for (int k = 0; k < 2; ++k)
+      slab_test_packet(&packet, &rtree->fnode[i_child[k]], t_max, t_child[k]);
+
+    /* Push the child which is far for most of the rays first. */
+    int vote = 0;
+    for (size_t j = 0; j < RTREE_PACKET_SIZE; ++j)
+      vote += (t_child[0][j] < t_child[1][j]) - (t_child[1][j] < t_child[0][j]);
+    int first = vote > 0 ? 1 : 0;
+
+    for (int k = 0; k < 2; ++k) {
+      int c = k == 0 ? first : 1 - first;
+      if (!packet_is_active(t_child[c]))
+        continue;
+      stack[size].i = i_child[c];
+      memcpy(stack[size++].t, t_child[c], sizeof(t_child[c]));
+    }
+  }
+}
+
+/* Intersect `n` rays with the R-tree, writing the closest
+ * intersection for `ray[i]` to `isect[i]`. If `skip_robj` isn't
+ * `NULL`, `ray[i]` ignores `skip_robj[i]`, as in
+ * `rtree_intersect`. The rays are traced in packets of
+ * `RTREE_PACKET_SIZE`, which is fastest when consecutive rays are
+ * coherent (e.g., neighboring camera rays). The results are
+ * identical to calling `rtree_intersect` for each ray. */
+void rtree_intersect_packet(rtree_s const *rtree, ray3 const *ray, size_t n,
+                            isect *isect, robj_s const **skip_robj) {
+  for (size_t i = 0; i < n; i += RTREE_PACKET_SIZE)
+    intersect_packet(rtree, &ray[i], MIN((size_t)RTREE_PACKET_SIZE, n - i), &isect[i],
+                     skip_robj == NULL ? NULL : &skip_robj[i]);
 }
 
 void rtree_intersectN(rtree_s const *rtree, ray3 const *ray, size_t n,
                       isect *isect) {
-  for (size_t i = 0; i < n; ++i)
-    rtree_intersect(rtree, &ray[i], &isect[i], NULL);
+  rtree_intersect_packet(rtree, ray, n, isect, NULL);
 }
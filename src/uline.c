@@ -8,9 +8,13 @@
 #include <jmm/log.h>
 #include <jmm/mesh3.h>
 
+#include "pool.h"
+
 static size_t MAX_NUM_ITER = 100;
 
 struct uline {
+  pool_s *pool; // where `u` was allocated from (`NULL` for the heap)
+
   /* Line update parameters: */
   eik3_s const *eik;
   size_t lhat;
@@ -34,11 +38,21 @@ struct uline {
 };
 
 void uline_alloc(uline_s **u) {
-  *u = malloc(sizeof(uline_s));
+  uline_alloc_from_pool(u, NULL);
+}
+
+/* Allocate `*u` from `pool` instead of the heap. If `pool` is `NULL`,
+ * this is the same as `uline_alloc`. */
+void uline_alloc_from_pool(uline_s **u, pool_s *pool) {
+  *u = pool ? pool_get(pool, sizeof(uline_s)) : malloc(sizeof(uline_s));
+  (*u)->pool = pool;
 }
 
 void uline_dealloc(uline_s **u) {
-  free(*u);
+  if ((*u)->pool)
+    pool_put((*u)->pool, *u, sizeof(uline_s));
+  else
+    free(*u);
   *u = NULL;
 }
 
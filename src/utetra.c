@@ -16,10 +16,13 @@
 #include <jmm/util.h>
 
 #include "macros.h"
+#include "pool.h"
 
 #define MAX_NITER 100
 
 struct utetra {
+  pool_s *pool; // where `utetra` was allocated from (`NULL` for the heap)
+
   eik3_s const *eik;
 
   stype_e stype;
@@ -58,17 +61,26 @@ struct utetra {
 };
 
 void utetra_alloc(utetra_s **utetra) {
-  *utetra = malloc(sizeof(utetra_s));
+  utetra_alloc_from_pool(utetra, NULL);
+}
+
+/* Allocate `*utetra` from `pool` instead of the heap. If `pool` is
+ * `NULL`, this is the same as `utetra_alloc`. Line updates done while
+ * solving `*utetra` are allocated from the same pool. */
+void utetra_alloc_from_pool(utetra_s **utetra, pool_s *pool) {
+  *utetra = pool ? pool_get(pool, sizeof(utetra_s)) : malloc(sizeof(utetra_s));
+  (*utetra)->pool = pool;
 }
 
 void utetra_dealloc(utetra_s **utetra) {
-  free(*utetra);
+  if ((*utetra)->pool)
+    pool_put((*utetra)->pool, *utetra, sizeof(utetra_s));
+  else
+    free(*utetra);
   *utetra = NULL;
 }
 
 static void set_s_and_T_cell_inds(utetra_s *u) {
-  static int CALL_NUMBER = 0;
-
   if (u->stype == STYPE_CONSTANT)
     return;
 
@@ -106,22 +118,6 @@ static void set_s_and_T_cell_inds(utetra_s *u) {
     assert(u->s_lc != (size_t)NO_INDEX);
 
   assert(u->T_lc != (size_t)NO_INDEX);
-
-#if JMM_DEBUG
-  uint4 cv;
-  mesh3_cv(eik->mesh, *s_lc, cv);
-
-  size_t num_valid = 0, num_trial = 0;
-  for (size_t i = 0; i < 4; ++i) {
-    num_valid += eik3_is_valid(eik, cv[i]);
-    num_trial ++ eik3_is_trial(eik, cv[i]);
-  }
-
-  assert(num_valid == 3);
-  assert(num_trial == 1);
-#endif
-
-  ++CALL_NUMBER;
 }
 
 void utetra_init(utetra_s *u, eik3_s const *eik, size_t lhat, uint3 const l) {
@@ -184,42 +180,62 @@ bool utetra_is_degenerate(utetra_s const *u) {
   return points_are_coplanar(x);
 }
 
-// static void perturb_hessian_if_necessary(dbl22 H) {
-//   // Compute the trace and determinant of the Hessian
-//   dbl tr = H[0][0] + H[1][1];
-//   dbl det = H[0][0]*H[1][1] - H[0][1]*H[1][0];
-//   assert(tr != 0 && det != 0);
-
-//   // Conditionally perturb the Hessian
-//   dbl min_eig_doubled = tr - sqrt(tr*tr - 4*det);
-//   if (min_eig_doubled < 0) {
-//     H[0][0] -= min_eig_doubled;
-//     H[1][1] -= min_eig_doubled;
-//   }
-// }
+/** Functions for `solve_stype_constant`: */
+
+/* The state of the projected Newton iteration used to solve an
+ * update when the slowness is constant. In this case, the cost
+ * function is:
+ *
+ *     f(lam) = T(b) + |x - X*b|,
+ *
+ * where b = (1 - lam[0] - lam[1], lam[0], lam[1]) and T is the BB
+ * polynomial interpolating T on the base of the update, so its
+ * gradient and Hessian can be computed in closed form. */
+typedef struct {
+  dbl2 lam;
+  dbl f;
+  dbl2 g;
+  dbl22 H;
+  dbl2 p; // Newton step
+} newton_s;
+
+static void perturb_hessian_if_necessary(dbl22 H) {
+  // Compute the trace and determinant of the Hessian
+  dbl tr = H[0][0] + H[1][1];
+  dbl det = H[0][0]*H[1][1] - H[0][1]*H[1][0];
+  assert(tr != 0 && det != 0);
+
+  // Conditionally perturb the Hessian
+  dbl min_eig_doubled = tr - sqrt(tr*tr - 4*det);
+  if (min_eig_doubled < 0) {
+    H[0][0] -= min_eig_doubled;
+    H[1][1] -= min_eig_doubled;
+  }
+}
 
-// static void get_p(dbl22 const H, dbl2 const g, dbl2 const lam, dbl2 p) {
-//   dbl2 tmp;
+static void get_p(dbl22 const H, dbl2 const g, dbl2 const lam, dbl tol,
+                  dbl2 p) {
+  dbl2 tmp;
 
-//   // Set up QP for next iterate
-//   triqp2_s qp;
-//   dbl22_dbl2_mul(H, lam, tmp);
-//   dbl2_sub(g, tmp, qp.b);
-//   memcpy(qp.A, H, sizeof(dbl22));
+  // Set up QP for next iterate
+  triqp2_s qp;
+  dbl22_dbl2_mul(H, lam, tmp);
+  dbl2_sub(g, tmp, qp.b);
+  memcpy(qp.A, H, sizeof(dbl22));
 
-//   // ... solve it
-//   triqp2_solve(&qp, EPS);
+  // ... solve it
+  triqp2_solve(&qp, tol);
 
-//   // Compute the projected Newton step
-//   dbl2_sub(qp.x, lam, p);
-// }
+  // Compute the projected Newton step
+  dbl2_sub(qp.x, lam, p);
+}
 
-// // TODO: question... would it make more sense to use different
-// // vectors for a1 and a2? This choice seems to result in a lot of
-// // numerical instability. For now I'm fixing this by replacing sums
-// // and dot products involving a1 or a2 with the Neumaier equivalent.
-// static dbl const a1[3] = {-1, 1, 0};
-// static dbl const a2[3] = {-1, 0, 1};
+// TODO: question... would it make more sense to use different
+// vectors for a1 and a2? This choice seems to result in a lot of
+// numerical instability. For now I'm fixing this by replacing sums
+// and dot products involving a1 or a2 with the Neumaier equivalent.
+static dbl const a1[3] = {-1, 1, 0};
+static dbl const a2[3] = {-1, 0, 1};
 
 // static void set_L_and_x_minus_xb(utetra_s *u, dbl3 const b) {
 //   dbl33_dbl3_mul(u->X, b, u->xb);
@@ -228,46 +244,54 @@ bool utetra_is_degenerate(utetra_s const *u) {
 //   assert(u->L > 0);
 // }
 
-// static void set_f_g_and_H_stype_constant(utetra_s *u, dbl3 const b) {
-//   dbl3 tmp1;
-//   dbl33 tmp2;
-//   dbl2 DL, DT;
-//   dbl22 D2L, D2T;
+static void set_f_g_and_H_stype_constant(utetra_s const *u, newton_s *nt) {
+  dbl3 b = {1 - nt->lam[0] - nt->lam[1], nt->lam[0], nt->lam[1]};
 
-//   dbl33_dbl3_mul(u->Xt, u->x_minus_xb, tmp1);
-//   dbl3_dbl_div(tmp1, -u->L, tmp1);
+  dbl3 xb, x_minus_xb;
+  dbl33_dbl3_mul(u->X, b, xb);
+  dbl3_sub(u->x, xb, x_minus_xb);
+  dbl L = dbl3_norm(x_minus_xb);
+  assert(L > 0);
 
-//   DL[0] = dbl3_ndot(a1, tmp1);
-//   DL[1] = dbl3_ndot(a2, tmp1);
-//   assert(dbl2_isfinite(DL));
+  dbl3 tmp1;
+  dbl33 tmp2;
+  dbl2 DL, DT;
+  dbl22 D2L, D2T;
 
-//   dbl3_outer(tmp1, tmp1, tmp2);
-//   dbl33_sub(u->XtX, tmp2, tmp2);
-//   dbl33_dbl_div(tmp2, u->L, tmp2);
+  dbl33_dbl3_mul(u->Xt, x_minus_xb, tmp1);
+  dbl3_dbl_div(tmp1, -L, tmp1);
 
-//   dbl33_dbl3_nmul(tmp2, a1, tmp1);
-//   D2L[0][0] = dbl3_ndot(tmp1, a1);
-//   D2L[1][0] = D2L[0][1] = dbl3_ndot(tmp1, a2);
-//   dbl33_dbl3_nmul(tmp2, a2, tmp1);
-//   D2L[1][1] = dbl3_ndot(tmp1, a2);
-//   assert(dbl22_isfinite(D2L));
+  DL[0] = dbl3_ndot(a1, tmp1);
+  DL[1] = dbl3_ndot(a2, tmp1);
+  assert(dbl2_isfinite(DL));
 
-//   DT[0] = bb32_df(&u->T, b, a1);
-//   DT[1] = bb32_df(&u->T, b, a2);
+  dbl3_outer(tmp1, tmp1, tmp2);
+  dbl33_sub(u->XtX, tmp2, tmp2);
+  dbl33_dbl_div(tmp2, L, tmp2);
 
-//   D2T[0][0] = bb32_d2f(&u->T, b, a1, a1);
-//   D2T[1][0] = D2T[0][1] = bb32_d2f(&u->T, b, a1, a2);
-//   D2T[1][1] = bb32_d2f(&u->T, b, a2, a2);
+  dbl33_dbl3_nmul(tmp2, a1, tmp1);
+  D2L[0][0] = dbl3_ndot(tmp1, a1);
+  D2L[1][0] = D2L[0][1] = dbl3_ndot(tmp1, a2);
+  dbl33_dbl3_nmul(tmp2, a2, tmp1);
+  D2L[1][1] = dbl3_ndot(tmp1, a2);
+  assert(dbl22_isfinite(D2L));
 
-//   u->f = u->L + bb32_f(&u->T, b);
-//   assert(isfinite(u->f));
+  DT[0] = bb32_df(&u->T, b, a1);
+  DT[1] = bb32_df(&u->T, b, a2);
 
-//   dbl2_add(DL, DT, u->g);
-//   assert(dbl2_isfinite(u->g));
+  D2T[0][0] = bb32_d2f(&u->T, b, a1, a1);
+  D2T[1][0] = D2T[0][1] = bb32_d2f(&u->T, b, a1, a2);
+  D2T[1][1] = bb32_d2f(&u->T, b, a2, a2);
 
-//   dbl22_add(D2L, D2T, u->H);
-//   assert(dbl22_isfinite(u->H));
-// }
+  nt->f = L + bb32_f(&u->T, b);
+  assert(isfinite(nt->f));
+
+  dbl2_add(DL, DT, nt->g);
+  assert(dbl2_isfinite(nt->g));
+
+  dbl22_add(D2L, D2T, nt->H);
+  assert(dbl22_isfinite(nt->H));
+}
 
 // static void lift_b_from_face_to_cell(uint3 const lf, dbl3 const bf, uint4 lc, dbl4 bc) {
 //   dbl4_zero(bc);
@@ -755,68 +779,107 @@ bool utetra_is_degenerate(utetra_s const *u) {
 //   assert(dbl3_angle(u->x_minus_xb, u->topt) < JMM_PI/2);
 // }
 
-// static void set_lambda(utetra_s *u, dbl2 const lam) {
-//   assert(u->stype == STYPE_CONSTANT);
-
-//   u->lam[0] = lam[0];
-//   u->lam[1] = lam[1];
+static void set_lambda_stype_constant(utetra_s const *u, newton_s *nt,
+                                      dbl2 const lam) {
+  nt->lam[0] = lam[0];
+  nt->lam[1] = lam[1];
+
+  /* Set the cost function value, its gradient, and its Hessian */
+  set_f_g_and_H_stype_constant(u, nt);
+
+  /* Now, compute Newton step solving the minimization problem:
+   *
+   *     minimize  y’*H*y/2 + [g - H*x]’*y + [x’*H*x/2 - g’*x + f(x)]
+   *   subject to  x >= 0
+   *               sum(x) <= 1
+   *
+   * perturbing the Hessian below should ensure a descent
+   * direction. (It would be interesting to see if we can remove the
+   * perturbation entirely.) */
+
+  // Possibly perturb the Hessian to make it positive definite
+  perturb_hessian_if_necessary(nt->H);
+
+  // Compute the projected Newton step from the current iterate to the
+  // next iterate
+  get_p(nt->H, nt->g, nt->lam, pow(u->tol, 2), nt->p);
+}
 
-//   dbl3 b = {1 - lam[0] - lam[1], lam[0], lam[1]};
-//   assert(dbl3_valid_bary_coord(b));
-//   dbl33_dbl3_mul(u->X, b, u->xb);
+/* Take a projected Newton step with a backtracking line search. If
+ * the line search can't find a step which decreases `f` enough (which
+ * happens once we're within roundoff of the minimizer), `nt` is left
+ * unchanged and `false` is returned. */
+static bool step_stype_constant(utetra_s const *u, newton_s *nt) {
+  dbl const atol = 1e-15, c1 = 1e-4;
+
+  // Get values for current iterate
+  newton_s nt0 = *nt;
+
+  // Do backtracking line search
+  dbl lam1[2], beta = 1;
+  dbl c1_times_g_dot_p = c1*dbl2_dot(nt0.p, nt0.g);
+  dbl2_saxpy(beta, nt0.p, nt0.lam, lam1);
+  set_lambda_stype_constant(u, nt, lam1);
+  while (nt->f > nt0.f + beta*c1_times_g_dot_p + atol) {
+    beta *= 0.9;
+    if (beta <= 1e-16) {
+      *nt = nt0;
+      return false;
+    }
+    dbl2_saxpy(beta, nt0.p, nt0.lam, lam1);
+    set_lambda_stype_constant(u, nt, lam1);
+  }
 
-//   set_L_and_x_minus_xb(u, b);
+  return true;
+}
 
-//   /* Set topt before updating f, g, and H */
-//   set_topt(u, b);
+/* Solve the update using projected Newton's method when the slowness
+ * is constant. This finds the same minimizer as
+ * `utetra_solve_surrogate`, but each iteration only evaluates `T`
+ * and the distance from `x` to the base of the update and their
+ * derivatives, instead of doing six line updates and fitting a
+ * quadratic to them. */
+static void solve_stype_constant(utetra_s *u, dbl const *lam) {
+  assert(u->stype == STYPE_CONSTANT);
+
+  newton_s nt;
+  set_lambda_stype_constant(u, &nt, lam ? lam : (dbl[2]) {1./3, 1./3});
+
+  /* Stop after taking a step no longer than `u->tol`: since Newton's
+   * method converges quadratically, the error after this last step is
+   * much smaller than the tolerance. */
+  u->niter = 0;
+  while (true) {
+    bool converged = dbl2_norm(nt.p) <= u->tol;
+    if (!step_stype_constant(u, &nt))
+      break;
+    ++u->niter;
+    if (converged)
+      break;
+    if (u->niter == MAX_NITER) {
+      log_warn("utetra_solve: reached max no. iters");
+      break;
+    }
+  }
 
-//   /* Set the cost function value, its gradient, and its Hessian */
-//   set_f_g_and_H(u, b);
+  dbl2_copy(nt.lam, u->lam);
 
-//   /* Now, compute Newton step solving the minimization problem:
-//    *
-//    *     minimize  y’*H*y/2 + [g - H*x]’*y + [x’*H*x/2 - g’*x + f(x)]
-//    *   subject to  x >= 0
-//    *               sum(x) <= 1
-//    *
-//    * perturbing the Hessian below should ensure a descent
-//    * direction. (It would be interesting to see if we can remove the
-//    * perturbation entirely.) */
+  /** Set f and topt now. These are computed the same way as they are
+   * by a `uline` in `utetra_solve_surrogate`. */
 
-//   // Possibly perturb the Hessian to make it positive definite
-//   perturb_hessian_if_necessary(u->H);
+  assert(isinf(u->f));
+  assert(dbl3_all_nan(u->topt));
 
-//   // Compute the projected Newton step from the current iterate to the
-//   // next iterate
-//   get_p(u->H, u->g, lam, u->p);
-// }
+  dbl3 bopt = {1 - u->lam[0] - u->lam[1], u->lam[0], u->lam[1]};
 
-// static void step(utetra_s *u) {
-//   assert(u->stype == STYPE_CONSTANT);
+  dbl3 xopt;
+  dbl33_dbl3_mul(u->X, bopt, xopt);
 
-//   dbl const atol = 1e-15, c1 = 1e-4;
-
-//   dbl lam1[2], f, c1_times_g_dot_p, beta;
-
-//   // Get values for current iterate
-//   dbl lam[2] = {u->lam[0], u->lam[1]};
-//   dbl p[2] = {u->p[0], u->p[1]};
-//   f = u->f;
-
-//   // Do backtracking line search
-//   beta = 1;
-//   c1_times_g_dot_p = c1*dbl2_dot(p, u->g);
-//   dbl2_saxpy(beta, p, lam, lam1);
-//   set_lambda(u, lam1);
-//   while (u->f > f + beta*c1_times_g_dot_p + atol) {
-//     beta *= 0.9;
-//     assert(beta > 1e-16);
-//     dbl2_saxpy(beta, p, lam, lam1);
-//     set_lambda(u, lam1);
-//   }
+  u->f = bb32_f(&u->T, bopt) + dbl3_dist(u->x, xopt);
 
-//   ++u->niter;
-// }
+  dbl3_sub(u->x, xopt, u->topt);
+  dbl3_normalize(u->topt);
+}
 
 dbl eval_poly(dbl const *a, dbl const *lam) {
   dbl x = lam[0], y = lam[1];
@@ -829,13 +892,12 @@ void contract(dbl2 const lam_center, dbl factor, dbl2 lam) {
 }
 
 /**
- * Do a tetrahedron update starting at `lam`, writing the result to
- * `jet`. If `lam` is `NULL`, then the first iterate will be selected
- * automatically.
+ * Solve the update by repeatedly fitting a quadratic to the values
+ * of six line updates and minimizing it over a shrinking
+ * triangle. This works for any `stype`. The initial iterate is
+ * selected automatically, so `lam` is ignored.
  */
-void utetra_solve(utetra_s *u, dbl const *lam) {
-  static int CALL_NUMBER = 0;
-
+void utetra_solve_surrogate(utetra_s *u, dbl const *lam) {
 
   // DEBUGGING
 
@@ -855,181 +917,165 @@ void utetra_solve(utetra_s *u, dbl const *lam) {
   // fclose(fp);
 
 
-  // if (u->stype == STYPE_FUNC_PTR) {
 
-    dbl2 lam_prev = {NAN, NAN}, lam_opt = {NAN, NAN};
-
-    dbl2 lam_node[6] = {
-      {0, 0},   {0.5, 0},   {1, 0},
-      {0, 0.5}, {0.5, 0.5},
-      {0, 1}
-    };
+  dbl2 lam_prev = {NAN, NAN}, lam_opt = {NAN, NAN};
 
-    dbl beta = 10.0;
-    dbl factor = (beta + 1)/beta;
-    dbl prev_error = NAN;
+  dbl2 lam_node[6] = {
+    {0, 0},   {0.5, 0},   {1, 0},
+    {0, 0.5}, {0.5, 0.5},
+    {0, 1}
+  };
 
-    size_t num_iter = 0;
+  dbl beta = 10.0;
+  dbl factor = (beta + 1)/beta;
+  dbl prev_error = NAN;
 
-    // printf("DOING S != 1 UTETRA #%d\n", CALL_NUMBER);
+  /* All of the line updates below reuse the same `uline` */
+  uline_s *uline;
+  uline_alloc_from_pool(&uline, u->pool);
 
-    while (true) {
+  size_t num_iter = 0;
 
-      // printf("* it = %lu\n", num_iter);
+  while (true) {
 
-      dbl f[6] = {NAN, NAN, NAN, NAN, NAN, NAN};
-      for (size_t i = 0; i < 6; ++i) {
-        dbl const *lam_ = lam_node[i];
-        dbl3 x_node;
-        dbl3 b = {1 - lam_[0] - lam_[1], lam_[0], lam_[1]};
-        dbl33_dbl3_mul(u->X, b, x_node);
+    // printf("* it = %lu\n", num_iter);
 
-        dbl T = bb32_f(&u->T, b);
+    dbl f[6] = {NAN, NAN, NAN, NAN, NAN, NAN};
+    for (size_t i = 0; i < 6; ++i) {
+      dbl const *lam_ = lam_node[i];
+      dbl3 x_node;
+      dbl3 b = {1 - lam_[0] - lam_[1], lam_[0], lam_[1]};
+      dbl33_dbl3_mul(u->X, b, x_node);
 
-        uline_s *uline;
-        uline_alloc(&uline);
-        uline_init_from_points(uline, u->eik, u->x, x_node, u->tol, T);
-        uline_solve(uline);
+      dbl T = bb32_f(&u->T, b);
 
-        f[i] = uline_get_value(uline);
+      uline_init_from_points(uline, u->eik, u->x, x_node, u->tol, T);
+      uline_solve(uline);
 
-        uline_dealloc(&uline);
-      }
+      f[i] = uline_get_value(uline);
+    }
 
-      dbl const invV[6][6] = {
-        { 1,  0,  0,  0,  0,  0},
-        {-3,  4, -1,  0,  0,  0},
-        {-3,  0,  0,  4,  0, -1},
-        { 2, -4,  2,  0,  0,  0},
-        { 4, -4,  0, -4,  4,  0},
-        { 2,  0,  0, -4,  0,  2}
-      };
-
-      dbl a[6];
-      for (size_t i = 0; i < 6; ++i) {
-        a[i] = 0;
-        for (size_t j = 0; j < 6; ++j) {
-          a[i] += invV[i][j]*f[j];
-        }
-      }
+    dbl const invV[6][6] = {
+      { 1,  0,  0,  0,  0,  0},
+      {-3,  4, -1,  0,  0,  0},
+      {-3,  0,  0,  4,  0, -1},
+      { 2, -4,  2,  0,  0,  0},
+      { 4, -4,  0, -4,  4,  0},
+      { 2,  0,  0, -4,  0,  2}
+    };
 
-      /* Check that everything is correct at the nodal values... */
-      dbl2 const lam_node_orig[6] = {
-        {0, 0},   {0.5, 0},   {1, 0},
-        {0, 0.5}, {0.5, 0.5},
-        {0, 1}
-      };
-      for (size_t i = 0; i < 6; ++i)
-        assert(fabs(eval_poly(a, lam_node_orig[i]) - f[i]) < 1e-12);
-
-      // /* Write to disk... */
-      // FILE *fp = fopen("f_poly.bin", "w");
-      // for (size_t i = 0; i <= 100; ++i) {
-      //   for (size_t j = 0; j <= 100; ++j) {
-      //     dbl2 lam = {i/100., j/100.};
-      //     dbl f = NAN;
-      //     if (lam[0] + lam[1] <= 1) {
-      //       f = eval_poly(a, lam);
-      //     }
-      //     fwrite(&f, sizeof(dbl), 1, fp);
-      //   }
-      // }
-      // fclose(fp);
-
-      triqp2_s qp = {
-        .b = {a[1], a[2]},
-        .A = {{2*a[3], a[4]}, {a[4], 2*a[5]}},
-        .x = {NAN, NAN}
-      };
-
-      triqp2_solve(&qp, pow(u->tol, 2));
-
-      // printf("  - lam_node = np.array([[%g, %g]", lam_node[0][0], lam_node[0][1]);
-      // for (size_t i = 1; i < 6; ++i)
-      //   printf(", [%g, %g]", lam_node[i][0], lam_node[i][1]);
-      // printf("])\n");
-      // printf("  - lam = np.array([%g, %g]), error = %g\n", qp.x[0], qp.x[1], dbl2_dist(qp.x, lam_prev));
-
-      lam = &qp.x[0];
-      dbl error = dbl2_dist(lam, lam_prev);
-      if (error <= u->tol) {
-        dbl2_copy(lam, lam_opt);
-        break;
-      } else {
-        dbl2_copy(lam, lam_prev);
+    dbl a[6];
+    for (size_t i = 0; i < 6; ++i) {
+      a[i] = 0;
+      for (size_t j = 0; j < 6; ++j) {
+        a[i] += invV[i][j]*f[j];
       }
+    }
 
-      if (error > 2*prev_error) {
-        beta += 1;
-        factor = (beta + 1)/beta;
-        // printf("  ! reduced factor to %g\n", factor);
-      }
+    /* Check that everything is correct at the nodal values... */
+    dbl2 const lam_node_orig[6] = {
+      {0, 0},   {0.5, 0},   {1, 0},
+      {0, 0.5}, {0.5, 0.5},
+      {0, 1}
+    };
+    for (size_t i = 0; i < 6; ++i)
+      assert(fabs(eval_poly(a, lam_node_orig[i]) - f[i]) < 1e-12);
+
+    // /* Write to disk... */
+    // FILE *fp = fopen("f_poly.bin", "w");
+    // for (size_t i = 0; i <= 100; ++i) {
+    //   for (size_t j = 0; j <= 100; ++j) {
+    //     dbl2 lam = {i/100., j/100.};
+    //     dbl f = NAN;
+    //     if (lam[0] + lam[1] <= 1) {
+    //       f = eval_poly(a, lam);
+    //     }
+    //     fwrite(&f, sizeof(dbl), 1, fp);
+    //   }
+    // }
+    // fclose(fp);
+
+    triqp2_s qp = {
+      .b = {a[1], a[2]},
+      .A = {{2*a[3], a[4]}, {a[4], 2*a[5]}},
+      .x = {NAN, NAN}
+    };
 
-      for (size_t i = 0; i < 6; ++i) {
-        contract(lam_prev, factor, lam_node[i]);
-        assert(lam_node[i][0] >= -EPS);
-        assert(lam_node[i][1] >= -EPS);
-        assert(lam_node[i][0] + lam_node[i][1] <= 1 + EPS);
-      }
+    triqp2_solve(&qp, pow(u->tol, 2));
 
-      prev_error = error;
-      ++num_iter;
+    // printf("  - lam_node = np.array([[%g, %g]", lam_node[0][0], lam_node[0][1]);
+    // for (size_t i = 1; i < 6; ++i)
+    //   printf(", [%g, %g]", lam_node[i][0], lam_node[i][1]);
+    // printf("])\n");
+    // printf("  - lam = np.array([%g, %g]), error = %g\n", qp.x[0], qp.x[1], dbl2_dist(qp.x, lam_prev));
 
-      if (num_iter == MAX_NITER) {
-        log_warn("utetra_solve: reached max no. iters");
-        dbl2_copy(lam, lam_opt);
-        break;
-      }
+    lam = &qp.x[0];
+    dbl error = dbl2_dist(lam, lam_prev);
+    if (error <= u->tol) {
+      dbl2_copy(lam, lam_opt);
+      break;
+    } else {
+      dbl2_copy(lam, lam_prev);
     }
 
-    /* make sure to set u->lam now */
-    dbl2_copy(lam_opt, u->lam);
-
-    /** Set f and topt now */
+    if (error > 2*prev_error) {
+      beta += 1;
+      factor = (beta + 1)/beta;
+      // printf("  ! reduced factor to %g\n", factor);
+    }
 
-    assert(isinf(u->f));
-    assert(dbl3_all_nan(u->topt));
+    for (size_t i = 0; i < 6; ++i) {
+      contract(lam_prev, factor, lam_node[i]);
+      assert(lam_node[i][0] >= -EPS);
+      assert(lam_node[i][1] >= -EPS);
+      assert(lam_node[i][0] + lam_node[i][1] <= 1 + EPS);
+    }
 
-    dbl3 bopt = {1 - lam_opt[0] - lam_opt[1], lam_opt[0], lam_opt[1]};
-    dbl Topt = bb32_f(&u->T, bopt);
+    prev_error = error;
+    ++num_iter;
 
-    dbl3 xopt;
-    dbl33_dbl3_mul(u->X, bopt, xopt);
+    if (num_iter == MAX_NITER) {
+      log_warn("utetra_solve: reached max no. iters");
+      dbl2_copy(lam, lam_opt);
+      break;
+    }
+  }
 
-    uline_s *uline;
-    uline_alloc(&uline);
-    uline_init_from_points(uline, u->eik, u->x, xopt, u->tol, Topt);
-    uline_solve(uline);
+  /* make sure to set u->lam now */
+  dbl2_copy(lam_opt, u->lam);
 
-    u->f = uline_get_value(uline);
-    uline_get_topt(uline, u->topt);
+  /** Set f and topt now */
 
-    uline_dealloc(&uline);
-  // }
+  assert(isinf(u->f));
+  assert(dbl3_all_nan(u->topt));
 
-  // /////
+  dbl3 bopt = {1 - lam_opt[0] - lam_opt[1], lam_opt[0], lam_opt[1]};
+  dbl Topt = bb32_f(&u->T, bopt);
 
-  // else if (u->stype == STYPE_CONSTANT) {
-  //   u->niter = 0;
+  dbl3 xopt;
+  dbl33_dbl3_mul(u->X, bopt, xopt);
 
-  //   if (lam == NULL)
-  //     set_lambda(u, (dbl[2]) {1./3, 1./3});
-  //   else
-  //     set_lambda(u, lam);
+  uline_init_from_points(uline, u->eik, u->x, xopt, u->tol, Topt);
+  uline_solve(uline);
 
-  //   int const max_niter = 100;
-  //   for (int _ = 0; _ < max_niter; ++_) {
-  //     if (dbl2_norm(u->p) <= u->tol)
-  //       break;
-  //     step(u);
-  //   }
-  //   if (dbl2_norm(u->p) > u->tol)
-  //     log_warn("utetra_solve: exceeded max no. of iters.");
-  // }
+  u->f = uline_get_value(uline);
+  uline_get_topt(uline, u->topt);
 
-  // else { assert(false); } // TODO: stype not implemented
+  uline_dealloc(&uline);
+}
 
-  ++CALL_NUMBER;
+/**
+ * Do a tetrahedron update starting at `lam`, writing the result to
+ * `jet`. If `lam` is `NULL`, then the first iterate will be selected
+ * automatically. If the slowness is constant, the update is solved
+ * using projected Newton's method, and otherwise by
+ * `utetra_solve_surrogate`.
+ */
+void utetra_solve(utetra_s *u, dbl const *lam) {
+  if (u->stype == STYPE_CONSTANT)
+    solve_stype_constant(u, lam);
+  else
+    utetra_solve_surrogate(u, lam);
 }
 
 static void get_b(utetra_s const *u, dbl b[3]) {
@@ -1132,10 +1178,10 @@ bool utetra_is_backwards(utetra_s const *utetra, eik3_s const *eik) {
   if (dbl3_dot(dxhat0, t) < 0)
     dbl3_negate(t);
 
-  jet31t const *jet = eik3_get_jet_ptr(eik);
+  dbl3 const *DT = eik3_get_DT_ptr(eik);
 
   for (size_t i = 0; i < 3; ++i)
-    if (dbl3_dot(t, jet[utetra->l[i]].Df) <= 0)
+    if (dbl3_dot(t, DT[utetra->l[i]]) <= 0)
       return true;
 
   return false;
@@ -1179,6 +1225,10 @@ size_t utetra_get_l(utetra_s const *utetra) {
   return utetra->lhat;
 }
 
+void utetra_get_update_inds(utetra_s const *utetra, uint3 l) {
+  memcpy(l, utetra->l, sizeof(uint3));
+}
+
 size_t utetra_get_active_inds(utetra_s const *utetra, uint3 la) {
 #if JMM_DEBUG
   assert(update_inds_are_set(utetra));
@@ -1461,7 +1511,7 @@ bool utetras_have_same_inds(utetra_s const *u1, utetra_s const *u2) {
 
   size_t l2[3];
   memcpy(l2, u2->l, sizeof(size_t[3]));
-  SORT3(l2[0], l2[1], l1[2]);
+  SORT3(l2[0], l2[1], l2[2]);
 
   return l1[0] == l2[0] && l1[1] == l2[1] && l1[2] == l2[2];
 }
@@ -1,9 +1,70 @@
 #include <jmm/utetra_cache.h>
 
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <jmm/hmap.h>
+#include <jmm/vec.h>
+
+#include "macros.h"
+
+/* The cache is a hash map from each target index `lhat` to the
+ * bucket of `utetra` that update it. Each bucket stores the cached
+ * `utetra` in insertion order along with their sorted update indices,
+ * so every operation only has to look at the `utetra` sharing a
+ * target index. Buckets removed by `utetra_cache_purge` are kept on a
+ * free list so that their storage can be reused. */
+
+typedef struct {
+  uint3 l; // sorted update indices
+  utetra_s *utetra;
+} entry_s;
+
+#define INITIAL_NUM_BUCKETS 32
+
 struct utetra_cache {
-  array_s *utetra_arr;
+  hmap_s *bucket; // `lhat` -> `array_s *` of `entry_s`
+  array_s *all_entries; // every bucket allocated so far
+  array_s *free_entries;
+
+  /* Scratch space used by `utetra_cache_pop_bracket` */
+  array_s *bracket;
+  array_s *bracket_inds;
+
+  size_t num_hits;
+  size_t num_misses;
 };
 
+static void get_sorted_inds(uint3 const l, uint3 l_sorted) {
+  memcpy(l_sorted, l, sizeof(uint3));
+  SORT_UINT3(l_sorted);
+}
+
+static array_s *get_entries(utetra_cache_s const *cache, size_t lhat) {
+  array_s *entries;
+  return hmap_get(cache->bucket, &lhat, &entries) ? entries : NULL;
+}
+
+static array_s *get_or_add_entries(utetra_cache_s *cache, size_t lhat) {
+  array_s *entries = get_entries(cache, lhat);
+  if (entries != NULL)
+    return entries;
+
+  if (array_is_empty(cache->free_entries)) {
+    array_alloc(&entries);
+    array_init(entries, sizeof(entry_s), 16);
+    array_append(cache->all_entries, &entries);
+  } else {
+    array_get(cache->free_entries, array_size(cache->free_entries) - 1, &entries);
+    array_delete(cache->free_entries, array_size(cache->free_entries) - 1);
+  }
+
+  hmap_insert(cache->bucket, &lhat, &entries);
+
+  return entries;
+}
+
 void utetra_cache_alloc(utetra_cache_s **cache) {
   *cache = malloc(sizeof(utetra_cache_s));
 }
@@ -14,98 +75,162 @@ void utetra_cache_dealloc(utetra_cache_s **cache) {
 }
 
 void utetra_cache_init(utetra_cache_s *cache) {
-  array_alloc(&cache->utetra_arr);
-  array_init(cache->utetra_arr, sizeof(utetra_s *), 16);
+  hmap_alloc(&cache->bucket);
+  hmap_init(cache->bucket, sizeof(size_t), sizeof(array_s *), INITIAL_NUM_BUCKETS);
+
+  array_alloc(&cache->all_entries);
+  array_init(cache->all_entries, sizeof(array_s *), ARRAY_DEFAULT_CAPACITY);
+
+  array_alloc(&cache->free_entries);
+  array_init(cache->free_entries, sizeof(array_s *), ARRAY_DEFAULT_CAPACITY);
+
+  array_alloc(&cache->bracket);
+  array_init(cache->bracket, sizeof(utetra_s *), ARRAY_DEFAULT_CAPACITY);
+
+  array_alloc(&cache->bracket_inds);
+  array_init(cache->bracket_inds, sizeof(size_t), ARRAY_DEFAULT_CAPACITY);
+
+  cache->num_hits = 0;
+  cache->num_misses = 0;
 }
 
 void utetra_cache_deinit(utetra_cache_s *cache) {
-  utetra_s *utetra;
-  for (size_t i = 0; i < array_size(cache->utetra_arr); ++i) {
-    array_get(cache->utetra_arr, i, &utetra);
-    utetra_dealloc(&utetra);
+  hmap_deinit(cache->bucket);
+  hmap_dealloc(&cache->bucket);
+
+  /* Buckets on the free list are empty, so we can free every bucket
+   * the same way without having to walk the map */
+  for (size_t i = 0; i < array_size(cache->all_entries); ++i) {
+    array_s *entries;
+    array_get(cache->all_entries, i, &entries);
+    for (size_t j = 0; j < array_size(entries); ++j)
+      utetra_dealloc(&((entry_s *)array_get_ptr(entries, j))->utetra);
+    array_deinit(entries);
+    array_dealloc(&entries);
   }
 
-  array_deinit(cache->utetra_arr);
-  array_dealloc(&cache->utetra_arr);
+  array_deinit(cache->all_entries);
+  array_dealloc(&cache->all_entries);
+
+  array_deinit(cache->free_entries);
+  array_dealloc(&cache->free_entries);
+
+  array_deinit(cache->bracket);
+  array_dealloc(&cache->bracket);
+
+  array_deinit(cache->bracket_inds);
+  array_dealloc(&cache->bracket_inds);
 }
 
-bool utetra_cache_contains_utetra(utetra_cache_s const *cache, utetra_s const *utetra) {
-  utetra_s const *utetra_other = NULL;
-  for (size_t i = 0; i < array_size(cache->utetra_arr); ++i) {
-    array_get(cache->utetra_arr, i, &utetra_other);
-    if (utetras_have_same_inds(utetra, utetra_other))
+static bool entries_contain_inds(array_s const *entries, uint3 const l) {
+  for (size_t i = 0; i < array_size(entries); ++i)
+    if (uint3_equal(((entry_s *)array_get_ptr(entries, i))->l, l))
       return true;
-  }
   return false;
 }
 
-bool utetra_cache_contains_inds(utetra_cache_s const *cache, size_t lhat, uint3 const l) {
-  for (size_t j = 0; j < array_size(cache->utetra_arr); ++j) {
-    utetra_s *utetra;
-    array_get(cache->utetra_arr, j, &utetra);
-    if (utetra_has_inds(utetra, lhat, l))
-      return true;
-  }
-  return false;
+bool utetra_cache_contains_utetra(utetra_cache_s const *cache, utetra_s const *utetra) {
+  array_s const *entries = get_entries(cache, utetra_get_l(utetra));
+  if (entries == NULL)
+    return false;
+
+  uint3 l;
+  utetra_get_update_inds(utetra, l);
+  SORT_UINT3(l);
+
+  return entries_contain_inds(entries, l);
 }
 
-array_s *utetra_cache_pop_bracket(utetra_cache_s *cache, utetra_s const *utetra) {
+/* Check whether an update with target index `lhat` and update indices
+ * `l` (in any order) is in the cache. This is checked before every
+ * tetrahedron update, so we keep track of how often it succeeds. */
+bool utetra_cache_contains_inds(utetra_cache_s *cache, size_t lhat, uint3 const l) {
+  array_s const *entries = get_entries(cache, lhat);
+
+  uint3 l_sorted;
+  get_sorted_inds(l, l_sorted);
+
+  bool found = entries != NULL && entries_contain_inds(entries, l_sorted);
+  if (found)
+    ++cache->num_hits;
+  else
+    ++cache->num_misses;
+
+  return found;
+}
+
+/* Look for cached `utetra` which bracket `utetra`. If there are any,
+ * remove them from the cache and return them. The returned array is
+ * owned by `cache` and is only valid until the next call; the caller
+ * is responsible for deallocating the `utetra` it contains. If there
+ * isn't a bracket, return `NULL`. */
+array_s const *utetra_cache_pop_bracket(utetra_cache_s *cache, utetra_s const *utetra) {
   size_t l = utetra_get_l(utetra);
 
+  array_s *entries = get_entries(cache, l);
+  if (entries == NULL)
+    return NULL;
+
   /* Array containing matched bracket utetra */
-  array_s *utetras;
-  array_alloc(&utetras);
-  array_init(utetras, sizeof(utetra_s *), ARRAY_DEFAULT_CAPACITY);
+  array_s *utetras = cache->bracket;
+  array_clear(utetras);
 
   /* Array containing their indices */
-  array_s *i_arr;
-  array_alloc(&i_arr);
-  array_init(i_arr, sizeof(size_t), ARRAY_DEFAULT_CAPACITY);
-
-  /* First, find the indices of the cached utetra which share the same
-   * target node and have the same active indices as `utetra`. */
-  for (size_t i = 0; i < array_size(cache->utetra_arr); ++i) {
-    utetra_s const *utetra_other;
-    array_get(cache->utetra_arr, i, &utetra_other);
-    if (l != utetra_get_l(utetra_other)
-        || !utetras_have_same_minimizer(utetra, utetra_other))
+  array_s *i_arr = cache->bracket_inds;
+  array_clear(i_arr);
+
+  /* First, find the indices of the cached utetra which have the same
+   * active indices as `utetra`. Since we only look in the bucket for
+   * `l`, they all share the same target node already. */
+  for (size_t i = 0; i < array_size(entries); ++i) {
+    utetra_s const *utetra_other = ((entry_s *)array_get_ptr(entries, i))->utetra;
+    if (!utetras_have_same_minimizer(utetra, utetra_other))
       continue;
     array_append(i_arr, &i);
     array_append(utetras, &utetra_other);
   }
 
   /* If the utetras bracket the ray, we evict them from the cache
-   * using the index array. If they don't, we clean up the utetra
-   * array now. */
-  if (utetra_is_bracketed_by_utetras(utetra, utetras)) {
-    array_delete_all(cache->utetra_arr, i_arr);
-  } else {
-    array_deinit(utetras);
-    array_dealloc(&utetras);
-  }
-  array_deinit(i_arr);
-  array_dealloc(&i_arr);
+   * using the index array and return them. */
+  if (!utetra_is_bracketed_by_utetras(utetra, utetras))
+    return NULL;
+
+  array_delete_all(entries, i_arr);
 
-  /* If we cleaned up utetras, it equals `NULL` now. So we return
-   * `NULL` if there isn't a bracket, and the array of utetras
-   * otherwise. */
   return utetras;
 }
 
 void utetra_cache_purge(utetra_cache_s *cache, size_t l) {
-  utetra_s *utetra;
-  for (size_t i = array_size(cache->utetra_arr); i > 0; --i) {
-    array_get(cache->utetra_arr, i - 1, &utetra);
-    if (utetra_get_l(utetra) == l) {
-      utetra_dealloc(&utetra);
-      array_delete(cache->utetra_arr, i - 1);
-    }
-  }
+  array_s *entries = get_entries(cache, l);
+  if (entries == NULL)
+    return;
+
+  for (size_t j = 0; j < array_size(entries); ++j)
+    utetra_dealloc(&((entry_s *)array_get_ptr(entries, j))->utetra);
+  array_clear(entries);
+
+  hmap_remove(cache->bucket, &l);
+  array_append(cache->free_entries, &entries);
 }
 
 bool utetra_cache_try_add_unique(utetra_cache_s *cache, utetra_s *utetra) {
-  if (utetra_cache_contains_utetra(cache, utetra))
+  array_s *entries = get_or_add_entries(cache, utetra_get_l(utetra));
+
+  entry_s entry = {.utetra = utetra};
+  utetra_get_update_inds(utetra, entry.l);
+  SORT_UINT3(entry.l);
+
+  if (entries_contain_inds(entries, entry.l))
     return false;
-  array_append(cache->utetra_arr, &utetra);
+
+  array_append(entries, &entry);
   return true;
 }
+
+size_t utetra_cache_get_num_hits(utetra_cache_s const *cache) {
+  return cache->num_hits;
+}
+
+size_t utetra_cache_get_num_misses(utetra_cache_s const *cache) {
+  return cache->num_misses;
+}
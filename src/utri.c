@@ -14,7 +14,11 @@
 #include <jmm/slerp.h>
 #include <jmm/uline.h>
 
+#include "pool.h"
+
 struct utri {
+  pool_s *pool; // where `utri` was allocated from (`NULL` for the heap)
+
   eik3_s const *eik;
   stype_e stype;
   sfunc_s const *sfunc;
@@ -37,11 +41,22 @@ struct utri {
 };
 
 void utri_alloc(utri_s **utri) {
-  *utri = malloc(sizeof(utri_s));
+  utri_alloc_from_pool(utri, NULL);
+}
+
+/* Allocate `*utri` from `pool` instead of the heap. If `pool` is
+ * `NULL`, this is the same as `utri_alloc`. Line updates done while
+ * solving `*utri` are allocated from the same pool. */
+void utri_alloc_from_pool(utri_s **utri, pool_s *pool) {
+  *utri = pool ? pool_get(pool, sizeof(utri_s)) : malloc(sizeof(utri_s));
+  (*utri)->pool = pool;
 }
 
 void utri_dealloc(utri_s **utri) {
-  free(*utri);
+  if ((*utri)->pool)
+    pool_put((*utri)->pool, *utri, sizeof(utri_s));
+  else
+    free(*utri);
   *utri = NULL;
 }
 
@@ -93,7 +108,7 @@ rotate_jet_for_diffraction(mesh3_s const *mesh,
   /* Get the diffracting edges incident on `l_diff` */
   size_t num_inc_diff_edges = mesh3_get_num_inc_diff_edges(mesh, l_diff);
   assert(num_inc_diff_edges > 0);
-  size_t (*le)[2] = malloc(num_inc_diff_edges*sizeof(size_t[2]));
+  size_t le[num_inc_diff_edges][2];
   mesh3_get_inc_diff_edges(mesh, l_diff, le);
 
   /* Get an incident diffracting tangent edge */
@@ -126,9 +141,6 @@ rotate_jet_for_diffraction(mesh3_s const *mesh,
   /* Compute the diffracted tangent vector */
   for (size_t i = 0; i < 3; ++i)
     jet->Df[i] = cos_beta*te[i] + sin_beta*tf[i];
-
-  /* Clean up */
-  free(le);
 }
 
 void utri_init(utri_s *u, eik3_s const *eik, size_t lhat, size_t const l[2]) {
@@ -196,10 +208,6 @@ static dbl hybrid_Dp(dbl lam, cubic_s const *p) {
 }
 
 bool utri_solve(utri_s *utri) {
-  static int CALL_NUMBER = 0;
-
-  ++CALL_NUMBER;
-
   if (utri->stype == STYPE_CONSTANT) {
     dbl lam, f[2], Df[2];
 
@@ -240,7 +248,9 @@ bool utri_solve(utri_s *utri) {
 
     size_t num_iter = 0;
 
-    // printf("DOING S != 1 UTRI #%d\n", CALL_NUMBER);
+    /* All of the line updates below reuse the same `uline` */
+    uline_s *uline;
+    uline_alloc_from_pool(&uline, utri->pool);
 
     while (true) {
       // printf("* it = %lu\n", num_iter);
@@ -252,14 +262,10 @@ bool utri_solve(utri_s *utri) {
 
         dbl T = bb31_f(&utri->T, (dbl2) {1 - lam_node[i], lam_node[i]});
 
-        uline_s *uline;
-        uline_alloc(&uline);
         uline_init_from_points(uline,utri->eik,utri->x,x_node,utri->tol,T);
         uline_solve(uline);
 
         f[i] = uline_get_value(uline);
-
-        uline_dealloc(&uline);
       }
 
       cubic_s p = cubic_from_lagrange_data(f);
@@ -315,8 +321,6 @@ bool utri_solve(utri_s *utri) {
     dbl3 x_opt;
     dbl3_saxpy(lam_opt, utri->x1_minus_x0, utri->x0, x_opt);
 
-    uline_s *uline;
-    uline_alloc(&uline);
     uline_init_from_points(uline,utri->eik,utri->x,x_opt,utri->tol,T_opt);
     uline_solve(uline);
 
@@ -476,6 +480,11 @@ size_t utri_get_l(utri_s const *utri) {
   return utri->l;
 }
 
+void utri_get_update_inds(utri_s const *utri, uint2 l) {
+  l[0] = utri->l0;
+  l[1] = utri->l1;
+}
+
 /* Check whether `u`'s `l`, `l0`, and `l1` are collinear (i.e.,
  * whether the `utri` is "degenerate"). */
 bool utri_is_degenerate(utri_s const *u) {
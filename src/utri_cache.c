@@ -1,11 +1,59 @@
 #include <jmm/utri_cache.h>
 
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include <jmm/array.h>
+#include <jmm/hmap.h>
+
+#include "macros.h"
+
+/* Like `utetra_cache`, this is a hash map from each target index to
+ * the bucket of cached `utri` that update it, stored in insertion
+ * order along with their sorted update indices. Purged buckets are
+ * recycled through a free list. */
+
+typedef struct {
+  uint2 l; // sorted update indices
+  utri_s *utri;
+} entry_s;
+
+#define INITIAL_NUM_BUCKETS 32
 
 struct utri_cache {
-  array_s *utri_arr;
+  hmap_s *bucket; // `lhat` -> `array_s *` of `entry_s`
+  array_s *all_entries; // every bucket allocated so far
+  array_s *free_entries;
+
+  size_t num_hits;
+  size_t num_misses;
 };
 
+static array_s *get_entries(utri_cache_s const *cache, size_t lhat) {
+  array_s *entries;
+  return hmap_get(cache->bucket, &lhat, &entries) ? entries : NULL;
+}
+
+static array_s *get_or_add_entries(utri_cache_s *cache, size_t lhat) {
+  array_s *entries = get_entries(cache, lhat);
+  if (entries != NULL)
+    return entries;
+
+  if (array_is_empty(cache->free_entries)) {
+    array_alloc(&entries);
+    array_init(entries, sizeof(entry_s), 8);
+    array_append(cache->all_entries, &entries);
+  } else {
+    array_get(cache->free_entries, array_size(cache->free_entries) - 1, &entries);
+    array_delete(cache->free_entries, array_size(cache->free_entries) - 1);
+  }
+
+  hmap_insert(cache->bucket, &lhat, &entries);
+
+  return entries;
+}
+
 void utri_cache_alloc(utri_cache_s **cache) {
   *cache = malloc(sizeof(utri_cache_s));
 }
@@ -16,41 +64,80 @@ void utri_cache_dealloc(utri_cache_s **cache) {
 }
 
 void utri_cache_init(utri_cache_s *cache) {
-  array_alloc(&cache->utri_arr);
-  array_init(cache->utri_arr, sizeof(utri_s *), 16);
+  hmap_alloc(&cache->bucket);
+  hmap_init(cache->bucket, sizeof(size_t), sizeof(array_s *), INITIAL_NUM_BUCKETS);
+
+  array_alloc(&cache->all_entries);
+  array_init(cache->all_entries, sizeof(array_s *), ARRAY_DEFAULT_CAPACITY);
+
+  array_alloc(&cache->free_entries);
+  array_init(cache->free_entries, sizeof(array_s *), ARRAY_DEFAULT_CAPACITY);
+
+  cache->num_hits = 0;
+  cache->num_misses = 0;
 }
 
 void utri_cache_deinit(utri_cache_s *cache) {
-  utri_s *utri;
-  for (size_t i = 0; i < array_size(cache->utri_arr); ++i) {
-    array_get(cache->utri_arr, i, &utri);
-    utri_dealloc(&utri);
+  hmap_deinit(cache->bucket);
+  hmap_dealloc(&cache->bucket);
+
+  /* Buckets on the free list are empty, so freeing every bucket
+   * allocated so far frees the cached `utri` as well */
+  for (size_t i = 0; i < array_size(cache->all_entries); ++i) {
+    array_s *entries;
+    array_get(cache->all_entries, i, &entries);
+    for (size_t j = 0; j < array_size(entries); ++j)
+      utri_dealloc(&((entry_s *)array_get_ptr(entries, j))->utri);
+    array_deinit(entries);
+    array_dealloc(&entries);
   }
 
-  array_deinit(cache->utri_arr);
-  array_dealloc(&cache->utri_arr);
+  array_deinit(cache->all_entries);
+  array_dealloc(&cache->all_entries);
+
+  array_deinit(cache->free_entries);
+  array_dealloc(&cache->free_entries);
 }
 
-/* Check whether `utri` has been stored in the cache for
- * edge-diffracted updates already. */
-bool utri_cache_contains_utri(utri_cache_s const *cache, utri_s const *utri) {
-  utri_s const *utri_other = NULL;
-  for (size_t i = 0; i < array_size(cache->utri_arr); ++i) {
-    array_get(cache->utri_arr, i, &utri_other);
-    if (utris_have_same_inds(utri, utri_other))
+static bool entries_contain_inds(array_s const *entries, uint2 const l) {
+  for (size_t i = 0; i < array_size(entries); ++i) {
+    entry_s const *entry = array_get_ptr(entries, i);
+    if (entry->l[0] == l[0] && entry->l[1] == l[1])
       return true;
   }
   return false;
 }
 
-bool utri_cache_contains_inds(utri_cache_s const *cache, size_t lhat, uint2 l) {
-  for (size_t j = 0; j < array_size(cache->utri_arr); ++j) {
-    utri_s *utri;
-    array_get(cache->utri_arr, j, &utri);
-    if (utri_has_inds(utri, lhat, l))
-      return true;
-  }
-  return false;
+/* Check whether `utri` has been stored in the cache for
+ * edge-diffracted updates already. */
+bool utri_cache_contains_utri(utri_cache_s const *cache, utri_s const *utri) {
+  array_s const *entries = get_entries(cache, utri_get_l(utri));
+  if (entries == NULL)
+    return false;
+
+  uint2 l;
+  utri_get_update_inds(utri, l);
+  SORT_UINT2(l);
+
+  return entries_contain_inds(entries, l);
+}
+
+/* Check whether an update with target index `lhat` and update indices
+ * `l` (in either order) is in the cache, keeping track of how often
+ * it succeeds. */
+bool utri_cache_contains_inds(utri_cache_s *cache, size_t lhat, uint2 l) {
+  array_s const *entries = get_entries(cache, lhat);
+
+  uint2 l_sorted = {l[0], l[1]};
+  SORT_UINT2(l_sorted);
+
+  bool found = entries != NULL && entries_contain_inds(entries, l_sorted);
+  if (found)
+    ++cache->num_hits;
+  else
+    ++cache->num_misses;
+
+  return found;
 }
 
 /* Look through the cache of old edge-diffracted two-point updates for
@@ -63,51 +150,64 @@ utri_s *utri_cache_pop(utri_cache_s *cache, utri_s const *utri) {
   size_t l_active = utri_get_active_ind(utri);
   size_t l_inactive = utri_get_inactive_ind(utri);
 
-  utri_s *utri_other = NULL;
+  /* only the bucket for `l` can contain a match */
+  array_s *entries = get_entries(cache, l);
+  if (entries == NULL)
+    return NULL;
 
-  /* iterate over the other `utri` in the cache... */
-  for (size_t i = 0; i < array_size(cache->utri_arr); ++i) {
-    array_get(cache->utri_arr, i, &utri_other);
+  /* iterate over the other `utri` in the bucket... */
+  for (size_t i = 0; i < array_size(entries); ++i) {
+    utri_s *utri_other = ((entry_s *)array_get_ptr(entries, i))->utri;
 
-    /* if this is a distinct `utri`, with the same target index and
-     * the same active index (so, the inactive index must be
-     * different!) ... */
-    if (l == utri_get_l(utri_other) &&
-        l_active == utri_get_active_ind(utri_other) &&
+    /* if this is a distinct `utri` with the same active index (so,
+     * the inactive index must be different!) ... */
+    if (l_active == utri_get_active_ind(utri_other) &&
         l_inactive != utri_get_inactive_ind(utri_other)) {
-      /* ... then delete it and break from the loop */
-      array_delete(cache->utri_arr, i);
-      break;
+      /* ... then delete it and return it */
+      array_delete(entries, i);
+      return utri_other;
     }
-
-    /* make sure to set `utri_other` back to `NULL` here---if we don't
-     * end up breaking, on the last loop, we will return `NULL` to
-     * signal that we didn't find a matching `utri` to delete */
-    utri_other = NULL;
   }
 
-  return utri_other;
+  /* we didn't find a matching `utri` to delete */
+  return NULL;
 }
 
-
 /* Remove and free triangle updates targeting the node with index `l`
  * from `cache`. */
 void utri_cache_purge(utri_cache_s *cache, size_t l) {
-  utri_s *utri;
-  for (size_t i = array_size(cache->utri_arr); i > 0; --i) {
-    array_get(cache->utri_arr, i - 1, &utri);
-    if (utri_get_l(utri) == l) {
-      utri_dealloc(&utri);
-      array_delete(cache->utri_arr, i - 1);
-    }
-  }
+  array_s *entries = get_entries(cache, l);
+  if (entries == NULL)
+    return;
+
+  for (size_t j = 0; j < array_size(entries); ++j)
+    utri_dealloc(&((entry_s *)array_get_ptr(entries, j))->utri);
+  array_clear(entries);
+
+  hmap_remove(cache->bucket, &l);
+  array_append(cache->free_entries, &entries);
 }
 
 /* Try to add `utri` to `cache`. If `utri` is already contained, then
  * return `false` to signal failure. Otherwise, return `true`. */
 bool utri_cache_try_add_unique(utri_cache_s *cache, utri_s *utri) {
-  if (utri_cache_contains_utri(cache, utri))
+  array_s *entries = get_or_add_entries(cache, utri_get_l(utri));
+
+  entry_s entry = {.utri = utri};
+  utri_get_update_inds(utri, entry.l);
+  SORT_UINT2(entry.l);
+
+  if (entries_contain_inds(entries, entry.l))
     return false;
-  array_append(cache->utri_arr, &utri);
+
+  array_append(entries, &entry);
   return true;
 }
+
+size_t utri_cache_get_num_hits(utri_cache_s const *cache) {
+  return cache->num_hits;
+}
+
+size_t utri_cache_get_num_misses(utri_cache_s const *cache) {
+  return cache->num_misses;
+}
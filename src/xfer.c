@@ -1,81 +1,228 @@
 #include <jmm/xfer.h>
 
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <jmm/bb.h>
 #include <jmm/grid3.h>
 #include <jmm/index.h>
+#include <jmm/mat.h>
 #include <jmm/mesh3.h>
 #include <jmm/vec.h>
 
+#include "macros.h"
+
+/* The output grid is split into cubic tiles of `XFER_TILE_SIZE^3`
+ * grid nodes, which are processed independently. */
+#define XFER_TILE_SIZE 16
+
 typedef struct {
   mesh3_s const *mesh;
+  jet31t const *jet;
   grid3_s const *grid;
   dbl *y;
-  grid3_s subgrid;
+  dbl3 *Dy;
+
+  /* The tiles are laid out in row-major order in a `tile_dim[0] x
+   * tile_dim[1] x tile_dim[2]` block. The cells whose bounding boxes
+   * overlap tile `i` are stored in increasing order in
+   * `tile_cells[tile_offsets[i]:tile_offsets[i + 1]]`. */
+  int tile_dim[3];
+  size_t *tile_cells;
+  size_t *tile_offsets;
+} xfer_wkspc_s;
+
+/* Get the range of grid indices covered by the bounding box of cell
+ * `lc`, clamped to the grid. Returns `false` if the range is
+ * empty. */
+static bool get_cell_ind_range(xfer_wkspc_s const *wkspc, size_t lc,
+                               int ind0[3], int ind1[3]) {
+  rect3 bbox;
+  mesh3_get_cell_bbox(wkspc->mesh, lc, &bbox);
+
   int offset[3];
-  bb33 bb;
-  size_t lc;
-} xfer_tetra_wkspc_t;
+  grid3_s subgrid = grid3_restrict_to_rect(wkspc->grid, &bbox, offset);
+
+  for (int i = 0; i < 3; ++i) {
+    ind0[i] = MAX(0, offset[i]);
+    ind1[i] = MIN(wkspc->grid->dim[i] - 1, offset[i] + subgrid.dim[i] - 1);
+    if (ind0[i] > ind1[i])
+      return false;
+  }
+
+  return true;
+}
+
+static size_t get_tile_index(xfer_wkspc_s const *wkspc, int const ind[3]) {
+  return ((size_t)ind[0]*wkspc->tile_dim[1] + ind[1])*wkspc->tile_dim[2] + ind[2];
+}
 
-static void xfer_tetra(int3 const subgrid_ind, xfer_tetra_wkspc_t *wkspc) {
+/* Bin the cells of the mesh into the tiles they overlap. This is
+ * done in two passes, first counting and then filling, the same way
+ * the vertex-cell incidences are set up in `mesh3_init`. */
+static void bin_cells(xfer_wkspc_s *wkspc) {
+  for (int i = 0; i < 3; ++i)
+    wkspc->tile_dim[i] = (wkspc->grid->dim[i] + XFER_TILE_SIZE - 1)/XFER_TILE_SIZE;
+
+  size_t ntiles = (size_t)wkspc->tile_dim[0]*wkspc->tile_dim[1]*wkspc->tile_dim[2];
+
+  size_t ncells = mesh3_ncells(wkspc->mesh);
+
+  size_t *count = calloc(ntiles, sizeof(size_t));
+  int ind0[3], ind1[3], ind[3];
+  for (size_t lc = 0; lc < ncells; ++lc) {
+    if (!get_cell_ind_range(wkspc, lc, ind0, ind1))
+      continue;
+    for (ind[0] = ind0[0]/XFER_TILE_SIZE; ind[0] <= ind1[0]/XFER_TILE_SIZE; ++ind[0])
+      for (ind[1] = ind0[1]/XFER_TILE_SIZE; ind[1] <= ind1[1]/XFER_TILE_SIZE; ++ind[1])
+        for (ind[2] = ind0[2]/XFER_TILE_SIZE; ind[2] <= ind1[2]/XFER_TILE_SIZE; ++ind[2])
+          ++count[get_tile_index(wkspc, ind)];
+  }
+
+  wkspc->tile_offsets = malloc((ntiles + 1)*sizeof(size_t));
+  wkspc->tile_offsets[0] = 0;
+  for (size_t i = 0; i < ntiles; ++i)
+    wkspc->tile_offsets[i + 1] = wkspc->tile_offsets[i] + count[i];
+
+  memset(count, 0x0, ntiles*sizeof(size_t));
+  wkspc->tile_cells = malloc(wkspc->tile_offsets[ntiles]*sizeof(size_t));
+  for (size_t lc = 0; lc < ncells; ++lc) {
+    if (!get_cell_ind_range(wkspc, lc, ind0, ind1))
+      continue;
+    for (ind[0] = ind0[0]/XFER_TILE_SIZE; ind[0] <= ind1[0]/XFER_TILE_SIZE; ++ind[0])
+      for (ind[1] = ind0[1]/XFER_TILE_SIZE; ind[1] <= ind1[1]/XFER_TILE_SIZE; ++ind[1])
+        for (ind[2] = ind0[2]/XFER_TILE_SIZE; ind[2] <= ind1[2]/XFER_TILE_SIZE; ++ind[2]) {
+          size_t i = get_tile_index(wkspc, ind);
+          wkspc->tile_cells[wkspc->tile_offsets[i] + count[i]++] = lc;
+        }
+  }
+
+  free(count);
+}
+
+/* Compute the matrix whose first three rows map the standard
+ * directions in R^3 to directions in the barycentric coordinates of
+ * cell `lc` (see `bmesh33_cell_Df`). */
+static void get_grad_transform(mesh3_s const *mesh, size_t lc, dbl44 A) {
+  size_t lv[4];
+  mesh3_cv(mesh, lc, lv);
+  for (size_t i = 0; i < 4; ++i) {
+    dbl const *xi = mesh3_get_vert_ptr(mesh, lv[i]);
+    for (size_t j = 0; j < 3; ++j)
+      A[j][i] = xi[j];
+    A[3][i] = 1;
+  }
+  dbl44_invert(A);
+  dbl44_transpose(A);
+}
+
+/* Transfer values to the grid nodes in the tile indexed by
+ * `tile_ind`. Each grid node is owned by the cell with the smallest
+ * index which contains it. Since each tile's cells are sorted, we
+ * get this by skipping nodes which have already been set. This makes
+ * the output independent of how the tiles are scheduled. */
+static void xfer_tile(xfer_wkspc_s const *wkspc, int const tile_ind[3]) {
   dbl const atol = 1e-14;
 
-  // Get the Cartesian coordinates of the point in the subgrid indexed
-  // by `subgrid_ind`.
-  dbl3 point;
-  grid3_get_point(&wkspc->subgrid, subgrid_ind, point);
-
-  // Get the indices of this point in the original containing grid.
-  int3 grid_ind;
-  int3_add(subgrid_ind, wkspc->offset, grid_ind);
-
-  // Return early if this point is outside the original grid.
-  //
-  // TODO: could remove this check by ensuring that a generated
-  // subgrid is contained in the parent grid.
-  if (!grid3_inbounds(wkspc->grid, grid_ind))
-    return;
-
-  /**
-   * Check if the point is in cell `lc`, computing its barycentric
-   * coordinates along the way.
-   */
-  dbl b[4];
-  tetra3 tetra = mesh3_get_tetra(wkspc->mesh, wkspc->lc);
-  if (tetra3_contains_point(&tetra, point, &atol)) {
-    tetra3_get_bary_coords(&tetra, point, b);
-    size_t l = ind2l3(wkspc->grid->dim, grid_ind);
-    dbl y = bb33_f(&wkspc->bb, b);
-    // If the grid value is NaN, just set it. Otherwise, set it to the
-    // average of the new value and existing grid value. This is a bit
-    // arbitrary, but if we're doing everything else right, it should
-    // be okay.
-    if (isnan(wkspc->y[l])) {
-      wkspc->y[l] = y;
-    } else {
-      wkspc->y[l] = (y + wkspc->y[l])/2;
+  int tile_ind0[3], tile_ind1[3];
+  for (int i = 0; i < 3; ++i) {
+    tile_ind0[i] = XFER_TILE_SIZE*tile_ind[i];
+    tile_ind1[i] = MIN(tile_ind0[i] + XFER_TILE_SIZE, wkspc->grid->dim[i]) - 1;
+  }
+
+  size_t i = get_tile_index(wkspc, tile_ind);
+
+  for (size_t p = wkspc->tile_offsets[i]; p < wkspc->tile_offsets[i + 1]; ++p) {
+    size_t lc = wkspc->tile_cells[p];
+
+    int ind0[3], ind1[3];
+    get_cell_ind_range(wkspc, lc, ind0, ind1);
+    for (int j = 0; j < 3; ++j) {
+      ind0[j] = MAX(ind0[j], tile_ind0[j]);
+      ind1[j] = MIN(ind1[j], tile_ind1[j]);
+    }
+
+    tetra3 tetra = mesh3_get_tetra(wkspc->mesh, lc);
+
+    /* Only set up the Bezier tetrahedron (and the gradient
+     * transform) once we find a node which needs them. */
+    bool have_bb = false;
+    bb33 bb;
+    dbl44 A;
+
+    int ind[3];
+    for (ind[0] = ind0[0]; ind[0] <= ind1[0]; ++ind[0]) {
+      for (ind[1] = ind0[1]; ind[1] <= ind1[1]; ++ind[1]) {
+        for (ind[2] = ind0[2]; ind[2] <= ind1[2]; ++ind[2]) {
+          size_t l = ind2l3(wkspc->grid->dim, ind);
+          if (!isnan(wkspc->y[l]))
+            continue;
+
+          dbl3 point;
+          grid3_get_point(wkspc->grid, ind, point);
+          if (!tetra3_contains_point(&tetra, point, &atol))
+            continue;
+
+          if (!have_bb) {
+            bb33_init_from_cell_and_jets(&bb, wkspc->mesh, wkspc->jet, lc);
+            if (wkspc->Dy)
+              get_grad_transform(wkspc->mesh, lc, A);
+            have_bb = true;
+          }
+
+          dbl4 b;
+          tetra3_get_bary_coords(&tetra, point, b);
+          wkspc->y[l] = bb33_f(&bb, b);
+
+          if (wkspc->Dy)
+            for (int j = 0; j < 3; ++j)
+              wkspc->Dy[l][j] = bb33_df(&bb, b, A[j]);
+        }
+      }
     }
   }
 }
 
-void xfer(mesh3_s const *mesh, jet31t const *jet, grid3_s const *grid, dbl *y) {
-  // Initialize values on grid to NaN.
-  for (size_t i = 0; i < grid3_size(grid); ++i) {
-    y[i] = NAN;
+/* Transfer the cubic spline defined by `jet` on `mesh` to the nodes
+ * of `grid`, writing the values to `y` and, if `Dy` isn't `NULL`,
+ * their gradients to `Dy`. Nodes outside the mesh are set to
+ * `NAN`. The grid is split into tiles which are processed in
+ * parallel. */
+void xfer_with_grad(mesh3_s const *mesh, jet31t const *jet,
+                    grid3_s const *grid, dbl *y, dbl3 *Dy) {
+  xfer_wkspc_s wkspc = {
+    .mesh = mesh,
+    .jet = jet,
+    .grid = grid,
+    .y = y,
+    .Dy = Dy
+  };
+
+  bin_cells(&wkspc);
+
+  size_t size = grid3_size(grid);
+#pragma omp parallel for schedule(static)
+  for (size_t l = 0; l < size; ++l) {
+    y[l] = NAN;
+    if (Dy)
+      Dy[l][0] = Dy[l][1] = Dy[l][2] = NAN;
   }
 
-  /**
-   * Traverse the cells of the tetrahedron mesh, restrict the grid so
-   * that it just covers each cell, and then evaluate the Bezier
-   * tetrahedron at each grid node if it contains the grid node.
-   */
-  xfer_tetra_wkspc_t wkspc  = {.mesh = mesh, .grid = grid, .y = y};
-  for (wkspc.lc = 0; wkspc.lc < mesh3_ncells(mesh); ++wkspc.lc) {
-    rect3 bbox;
-    mesh3_get_cell_bbox(mesh, wkspc.lc, &bbox);
-    wkspc.subgrid = grid3_restrict_to_rect(grid, &bbox, wkspc.offset);
-    bb33_init_from_cell_and_jets(&wkspc.bb, mesh, jet, wkspc.lc);
-    grid3_map(&wkspc.subgrid, (grid3_map_func_t)xfer_tetra, &wkspc);
+  size_t ntiles = (size_t)wkspc.tile_dim[0]*wkspc.tile_dim[1]*wkspc.tile_dim[2];
+#pragma omp parallel for schedule(dynamic)
+  for (size_t i = 0; i < ntiles; ++i) {
+    int3 tile_ind;
+    tile_ind[2] = i % wkspc.tile_dim[2];
+    tile_ind[1] = (i/wkspc.tile_dim[2]) % wkspc.tile_dim[1];
+    tile_ind[0] = i/((size_t)wkspc.tile_dim[1]*wkspc.tile_dim[2]);
+    xfer_tile(&wkspc, tile_ind);
   }
+
+  free(wkspc.tile_cells);
+  free(wkspc.tile_offsets);
+}
+
+void xfer(mesh3_s const *mesh, jet31t const *jet, grid3_s const *grid, dbl *y) {
+  xfer_with_grad(mesh, jet, grid, y, NULL);
 }
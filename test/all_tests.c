@@ -12,13 +12,20 @@ TestSuite *camera_tests();   // failing
 TestSuite *dbl22_tests();
 TestSuite *dbl44_tests();
 // TestSuite *eik3_tests();  // doesn't compile (see source)
+TestSuite *eik3_solve_tests();
+TestSuite *eik3hh_tests();
+TestSuite *front_tests();
 TestSuite *geom_tests();
+TestSuite *hmap_tests();
 TestSuite *mesh2_tests();
 TestSuite *mesh3_tests();
 TestSuite *opt_tests();
+TestSuite *renderer_tests();
 TestSuite *utd_tests();
+TestSuite *utetra_tests();
 // TestSuite *utri_tests();  // doesn't compile (see source)
 TestSuite *vec_tests();
+TestSuite *xfer_tests();
 
 int main(int argc, char **argv) {
   int suite_result;
@@ -34,13 +41,20 @@ int main(int argc, char **argv) {
   add_suite(suite, dbl22_tests());
   add_suite(suite, dbl44_tests());
   // add_suite(suite, eik3_tests());
+  add_suite(suite, eik3_solve_tests());
+  add_suite(suite, eik3hh_tests());
+  add_suite(suite, front_tests());
   add_suite(suite, geom_tests());
+  add_suite(suite, hmap_tests());
   add_suite(suite, mesh2_tests());
   add_suite(suite, mesh3_tests());
   add_suite(suite, opt_tests());
+  add_suite(suite, renderer_tests());
   add_suite(suite, utd_tests());
+  add_suite(suite, utetra_tests());
   // add_suite(suite, utri_tests());
   add_suite(suite, vec_tests());
+  add_suite(suite, xfer_tests());
 
   suite_result = run_test_suite(suite, create_text_reporter());
   destroy_test_suite(suite);
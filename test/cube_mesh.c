@@ -0,0 +1,46 @@
+#include "cube_mesh.h"
+
+#include <stdlib.h>
+
+/* Split the unit cube into `N^3` subcubes, and each subcube into six
+ * tetrahedra sharing its main diagonal. The vertex with grid index
+ * `(i, j, k)` has index `(i*(N + 1) + j)*(N + 1) + k`. */
+void make_cube_mesh(mesh3_s *mesh, size_t N) {
+  mesh3_data_s data;
+
+  data.nverts = (N + 1)*(N + 1)*(N + 1);
+  data.verts = malloc(data.nverts*sizeof(dbl3));
+  for (size_t i = 0; i <= N; ++i)
+    for (size_t j = 0; j <= N; ++j)
+      for (size_t k = 0; k <= N; ++k) {
+        size_t l = (i*(N + 1) + j)*(N + 1) + k;
+        data.verts[l][0] = (dbl)i/N;
+        data.verts[l][1] = (dbl)j/N;
+        data.verts[l][2] = (dbl)k/N;
+      }
+
+  size_t const tets[6][4] = {
+    {0, 1, 3, 7}, {0, 1, 5, 7}, {0, 2, 3, 7},
+    {0, 2, 6, 7}, {0, 4, 5, 7}, {0, 4, 6, 7}
+  };
+
+  data.ncells = 6*N*N*N;
+  data.cells = malloc(data.ncells*sizeof(uint4));
+  size_t lc = 0;
+  for (size_t i = 0; i < N; ++i)
+    for (size_t j = 0; j < N; ++j)
+      for (size_t k = 0; k < N; ++k) {
+        size_t cv[8];
+        for (size_t m = 0; m < 8; ++m)
+          cv[m] = ((i + ((m >> 2) & 1))*(N + 1) + j + ((m >> 1) & 1))*(N + 1)
+            + k + (m & 1);
+        for (size_t m = 0; m < 6; ++m, ++lc)
+          for (size_t q = 0; q < 4; ++q)
+            data.cells[lc][q] = cv[tets[m][q]];
+      }
+
+  mesh3_init(mesh, &data, true, true, NULL);
+
+  free(data.verts);
+  free(data.cells);
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include <jmm/mesh3.h>
+
+void make_cube_mesh(mesh3_s *mesh, size_t N);
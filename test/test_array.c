@@ -30,8 +30,41 @@ Ensure(array, basic_test) {
   array_dealloc(&arr);
 }
 
+Ensure(array, pop_front_is_fifo) {
+  array_s *arr;
+  array_alloc(&arr);
+  array_init(arr, sizeof(int), 4);
+
+  /* Interleave appends and pops so that the space freed at the front
+   * of the array gets reused */
+  int next_in = 0, next_out = 0;
+  for (int round = 0; round < 16; ++round) {
+    for (int i = 0; i < round + 3; ++i, ++next_in)
+      array_append(arr, &next_in);
+    for (int i = 0; i < round + 1; ++i, ++next_out) {
+      int elt;
+      array_pop_front(arr, &elt);
+      assert_that(elt, is_equal_to(next_out));
+    }
+    assert_that(array_size(arr), is_equal_to(next_in - next_out));
+    for (int i = next_out; i < next_in; ++i)
+      assert_that(array_find(arr, &i), is_equal_to(i - next_out));
+  }
+
+  while (!array_is_empty(arr)) {
+    int elt;
+    array_pop_front(arr, &elt);
+    assert_that(elt, is_equal_to(next_out++));
+  }
+  assert_that(next_out, is_equal_to(next_in));
+
+  array_deinit(arr);
+  array_dealloc(&arr);
+}
+
 TestSuite *array_tests() {
   TestSuite *suite = create_test_suite();
   add_test_with_context(suite, array, basic_test);
+  add_test_with_context(suite, array, pop_front_is_fifo);
   return suite;
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <cgreen/cgreen.h>
 #include <jmm/bmesh.h>
 #include <jmm/camera.h>
+#include <jmm/mesh2.h>
 #include <jmm/mesh3.h>
 #include <jmm/rtree.h>
 #include <test_config.h>
@@ -66,7 +67,7 @@ static void create_approximate_sphere_bmesh33(bmesh33_s **bmesh_handle,
       .nverts = 64, .verts = verts, .ncells = 40, .cells = cells};
 
   mesh3_alloc(mesh_handle);
-  mesh3_init(*mesh_handle, &data, false, NULL);
+  mesh3_init(*mesh_handle, &data, false, false, NULL);
 
   /**
    * Next, compute the jets for each vertex in `verts`.
@@ -152,6 +153,233 @@ Ensure(bmesh33, mesh3_cell_contains_point_works) {
   TEAR_DOWN_APPROXIMATE_SPHERE();
 }
 
+Ensure(bmesh33, f_batch_agrees_with_f_on_approximate_sphere) {
+  SET_UP_APPROXIMATE_SPHERE();
+
+  /* Sample on a grid which slightly overhangs [-1, 1]^3 so that some
+   * of the points lie outside the mesh */
+  size_t const N = 11;
+  dbl3 *x = malloc(N*N*N*sizeof(dbl3));
+  for (size_t i = 0, l = 0; i < N; ++i)
+    for (size_t j = 0; j < N; ++j)
+      for (size_t k = 0; k < N; ++k, ++l) {
+        x[l][0] = -1.1 + 2.2*i/(N - 1);
+        x[l][1] = -1.1 + 2.2*j/(N - 1);
+        x[l][2] = -1.1 + 2.2*k/(N - 1);
+      }
+
+  dbl *f = malloc(N*N*N*sizeof(dbl));
+  bmesh33_f_batch(bmesh, N*N*N, x, f);
+
+  for (size_t l = 0; l < N*N*N; ++l) {
+    dbl f_gt = bmesh33_f(bmesh, x[l]);
+    if (isnan(f_gt))
+      assert_that(isnan(f[l]));
+    else
+      assert_that_double(f[l], is_nearly_double(f_gt));
+  }
+
+  free(f);
+  free(x);
+
+  TEAR_DOWN_APPROXIMATE_SPHERE();
+}
+
+Ensure(bmesh33, Df_batch_agrees_with_Df_on_approximate_sphere) {
+  SET_UP_APPROXIMATE_SPHERE();
+
+  /* The gradient jumps across the faces of the mesh, so unlike in
+   * `f_batch_agrees_with_f_on_approximate_sphere`, the grid is offset
+   * so that no points lie on a face. Some points are still outside
+   * the mesh. */
+  size_t const N = 11;
+  dbl3 *x = malloc(N*N*N*sizeof(dbl3));
+  for (size_t i = 0, l = 0; i < N; ++i)
+    for (size_t j = 0; j < N; ++j)
+      for (size_t k = 0; k < N; ++k, ++l) {
+        x[l][0] = -1.1 + 2.2*(i + 0.31)/N;
+        x[l][1] = -1.1 + 2.2*(j + 0.17)/N;
+        x[l][2] = -1.1 + 2.2*(k + 0.43)/N;
+      }
+
+  dbl3 *Df = malloc(N*N*N*sizeof(dbl3));
+  bmesh33_Df_batch(bmesh, N*N*N, x, Df);
+
+  size_t num_inside = 0;
+  for (size_t l = 0; l < N*N*N; ++l) {
+    dbl3 Df_gt;
+    bmesh33_Df(bmesh, x[l], Df_gt);
+    for (size_t i = 0; i < 3; ++i) {
+      if (isnan(Df_gt[i]))
+        assert_that(isnan(Df[l][i]));
+      else
+        assert_that_double(Df[l][i], is_nearly_double(Df_gt[i]));
+    }
+    num_inside += !isnan(Df_gt[0]);
+  }
+  assert_that(num_inside, is_greater_than(0));
+  assert_that(num_inside, is_less_than(N*N*N));
+
+  free(Df);
+  free(x);
+
+  TEAR_DOWN_APPROXIMATE_SPHERE();
+}
+
+Ensure(bmesh33, get_cells_bracketing_level_works_on_approximate_sphere) {
+  SET_UP_APPROXIMATE_SPHERE();
+
+  array_s *lc;
+  array_alloc(&lc);
+  array_init(lc, sizeof(size_t), ARRAY_DEFAULT_CAPACITY);
+
+  size_t const num_levels = 31;
+  for (size_t i = 0; i < num_levels; ++i) {
+    dbl level = -0.25 + 2.0*i/(num_levels - 1);
+
+    array_clear(lc);
+    bmesh33_get_cells_bracketing_level(bmesh, level, lc);
+
+    /* Compare with checking each cell in turn */
+    size_t k = 0;
+    for (size_t l = 0; l < bmesh33_num_cells(bmesh); ++l) {
+      if (!bb33_convex_hull_brackets_value(bmesh33_get_bb_ptr(bmesh, l), level))
+        continue;
+      assert_that(k, is_less_than(array_size(lc)));
+      size_t l_gt;
+      array_get(lc, k++, &l_gt);
+      assert_that(l, is_equal_to(l_gt));
+    }
+    assert_that(k, is_equal_to(array_size(lc)));
+
+    /* The level view should consist of the same cells */
+    bmesh33_s *level_bmesh = bmesh33_restrict_to_level(bmesh, level);
+    assert_that(bmesh33_num_cells(level_bmesh), is_equal_to(k));
+    for (size_t l = 0; l < k; ++l) {
+      bmesh33_cell_s cell = bmesh33_get_cell(level_bmesh, l);
+      assert_that(cell.l, is_equal_to(*(size_t *)array_get_ptr(lc, l)));
+      assert_that(cell.mesh, is_equal_to(mesh));
+    }
+    bmesh33_deinit(level_bmesh);
+    bmesh33_dealloc(&level_bmesh);
+  }
+
+  array_deinit(lc);
+  array_dealloc(&lc);
+
+  TEAR_DOWN_APPROXIMATE_SPHERE();
+}
+
+Ensure(bmesh33, rtree_intersect_packet_agrees_with_rtree_intersect) {
+  SET_UP_APPROXIMATE_SPHERE();
+
+  bmesh33_s *level_bmesh = bmesh33_restrict_to_level(bmesh, 0.5);
+
+  rtree_s *rtree;
+  rtree_alloc(&rtree);
+  rtree_init(rtree, 4, RTREE_SPLIT_STRATEGY_SURFACE_AREA);
+  rtree_insert_bmesh33(rtree, level_bmesh);
+  rtree_build(rtree);
+
+  camera_s camera = {.type = CAMERA_TYPE_ORTHOGRAPHIC,
+                     .pos = {0.1, -2, 0.2},
+                     .look = {0, 1, 0},
+                     .left = {-1, 0, 0},
+                     .up = {0, 0, 1},
+                     .width = 2.2,
+                     .height = 2.2,
+                     .dim = {21, 21}};
+
+  size_t npix = camera.dim[0]*camera.dim[1];
+
+  ray3 *ray = malloc(npix*sizeof(ray3));
+  for (size_t i = 0, l = 0; i < camera.dim[0]; ++i)
+    for (size_t j = 0; j < camera.dim[1]; ++j, ++l)
+      ray[l] = camera_get_ray_for_index(&camera, i, j);
+
+  /* Check the first hit of each ray, and then the next hit after
+   * skipping the first one, which is how the renderer marches
+   * through the level set. */
+  isect *isect_packet = malloc(npix*sizeof(isect));
+  robj_s const **skip = malloc(npix*sizeof(robj_s const *));
+  rtree_intersect_packet(rtree, ray, npix, isect_packet, NULL);
+  for (size_t l = 0; l < npix; ++l) {
+    isect isect;
+    rtree_intersect(rtree, &ray[l], &isect, NULL);
+    assert_that(isect_packet[l].t == isect.t);
+    assert_that(isect_packet[l].obj, is_equal_to(isect.obj));
+    skip[l] = isect.obj;
+  }
+
+  rtree_intersect_packet(rtree, ray, npix, isect_packet, skip);
+  for (size_t l = 0; l < npix; ++l) {
+    isect isect;
+    rtree_intersect(rtree, &ray[l], &isect, skip[l]);
+    assert_that(isect_packet[l].t == isect.t);
+    assert_that(isect_packet[l].obj, is_equal_to(isect.obj));
+  }
+
+  free(skip);
+  free(isect_packet);
+  free(ray);
+
+  rtree_deinit(rtree);
+  rtree_dealloc(&rtree);
+
+  bmesh33_deinit(level_bmesh);
+  bmesh33_dealloc(&level_bmesh);
+
+  TEAR_DOWN_APPROXIMATE_SPHERE();
+}
+
+Ensure(bmesh33, extract_isosurfaces_works_on_approximate_sphere) {
+  SET_UP_APPROXIMATE_SPHERE();
+
+  dbl const level[3] = {0.75, 0.25, 0.5};
+
+  for (size_t num_subdivisions = 1; num_subdivisions <= 3; ++num_subdivisions) {
+    mesh2_s *surf[3];
+    bmesh33_extract_isosurfaces(bmesh, 3, level, num_subdivisions, surf);
+
+    for (size_t i = 0; i < 3; ++i) {
+      size_t nverts = mesh2_nverts(surf[i]), nfaces = mesh2_nfaces(surf[i]);
+      assert_that(nfaces, is_greater_than(0));
+
+      /* Vertices shared by neighboring triangles should be merged */
+      assert_that(nverts, is_less_than(3*nfaces));
+
+      /* The vertices should lie on the level set */
+      dbl3 const *verts = mesh2_get_verts_ptr(surf[i]);
+      dbl *f = malloc(nverts*sizeof(dbl));
+      bmesh33_f_batch(bmesh, nverts, verts, f);
+      for (size_t l = 0; l < nverts; ++l)
+        assert_that_double(fabs(f[l] - level[i]), is_less_than_double(1e-12));
+      free(f);
+
+      /* The normals should point away from the origin */
+      for (size_t lf = 0; lf < nfaces; ++lf) {
+        dbl3 n, x;
+        mesh2_get_unit_surface_normal(surf[i], lf, n);
+        mesh2_get_centroid(surf[i], lf, x);
+        assert_that_double(dbl3_dot(n, x), is_greater_than_double(0));
+      }
+
+      /* Extracting the same level on its own gives the same mesh */
+      mesh2_s *surf1 = bmesh33_extract_isosurface(bmesh, level[i], num_subdivisions);
+      assert_that(mesh2_nverts(surf1), is_equal_to(nverts));
+      assert_that(mesh2_nfaces(surf1), is_equal_to(nfaces));
+      assert_that(mesh2_get_verts_ptr(surf1), is_equal_to_contents_of(verts, nverts*sizeof(dbl3)));
+      mesh2_deinit(surf1);
+      mesh2_dealloc(&surf1);
+
+      mesh2_deinit(surf[i]);
+      mesh2_dealloc(&surf[i]);
+    }
+  }
+
+  TEAR_DOWN_APPROXIMATE_SPHERE();
+}
+
 /*
  * This test is failing, and I'm not sure why
  *
@@ -245,6 +473,11 @@ TestSuite *bmesh33_tests() {
   add_test_with_context(suite, bmesh33,
                         approximate_sphere_setup_and_teardown_works);
   add_test_with_context(suite, bmesh33, mesh3_cell_contains_point_works);
+  add_test_with_context(suite, bmesh33, f_batch_agrees_with_f_on_approximate_sphere);
+  add_test_with_context(suite, bmesh33, Df_batch_agrees_with_Df_on_approximate_sphere);
+  add_test_with_context(suite, bmesh33, get_cells_bracketing_level_works_on_approximate_sphere);
+  add_test_with_context(suite, bmesh33, rtree_intersect_packet_agrees_with_rtree_intersect);
+  add_test_with_context(suite, bmesh33, extract_isosurfaces_works_on_approximate_sphere);
   add_test_with_context(suite, bmesh33,
                         ray_intersects_level_works_on_approximate_sphere);
   return suite;
@@ -0,0 +1,359 @@
+#include <cgreen/cgreen.h>
+#include <jmm/binfile.h>
+#include <jmm/eik3.h>
+#include <jmm/eik3_batch.h>
+#include <jmm/mesh3.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cube_mesh.h"
+
+Describe(eik3_solve);
+BeforeEach(eik3_solve) {}
+AfterEach(eik3_solve) {}
+
+static void solve_pt_src(eik3_s *eik, size_t num_threads, dbl *T) {
+  dbl3 const xsrc = {0.5, 0.5, 0.5};
+
+  eik3_reset(eik);
+  assert_that(eik3_set_num_threads(eik, num_threads), is_equal_to(JMM_ERROR_NONE));
+  eik3_add_pt_src_bcs(eik, xsrc, 0.1);
+  assert_that(eik3_solve(eik), is_equal_to(JMM_ERROR_NONE));
+  assert_that(eik3_is_solved(eik));
+
+  mesh3_s const *mesh = eik3_get_mesh(eik);
+  for (size_t l = 0; l < mesh3_nverts(mesh); ++l)
+    T[l] = eik3_get_T(eik, l);
+}
+
+static void assert_solutions_match(eik3_s const *eik1, eik3_s const *eik2) {
+  size_t nverts = mesh3_nverts(eik3_get_mesh(eik1));
+
+  assert_that(eik3_get_T_ptr(eik2),
+              is_equal_to_contents_of(eik3_get_T_ptr(eik1), nverts*sizeof(dbl)));
+  assert_that(eik3_get_DT_ptr(eik2),
+              is_equal_to_contents_of(eik3_get_DT_ptr(eik1), nverts*sizeof(dbl3)));
+  assert_that(eik3_get_state_ptr(eik2),
+              is_equal_to_contents_of(eik3_get_state_ptr(eik1),
+                                      nverts*sizeof(state_e)));
+  assert_that(eik3_get_accepted_ptr(eik2),
+              is_equal_to_contents_of(eik3_get_accepted_ptr(eik1),
+                                      nverts*sizeof(jmm_index_t)));
+
+  for (size_t l = 0; l < nverts; ++l) {
+    par3_s par1 = eik3_get_par(eik1, l), par2 = eik3_get_par(eik2, l);
+    assert_that(par2.l, is_equal_to_contents_of(par1.l, sizeof(par1.l)));
+    assert_that(par2.b, is_equal_to_contents_of(par1.b, sizeof(par1.b)));
+  }
+}
+
+/* Solving with several threads should accept the nodes in the same
+ * order as a serial solve and give exactly the same solution. The
+ * point source is in the middle of the cube, so there are lots of
+ * nodes with equal values for the band to mix up. */
+Ensure(eik3_solve, parallel_solve_agrees_with_serial_solve) {
+  mesh3_s *mesh;
+  mesh3_alloc(&mesh);
+  make_cube_mesh(mesh, 8);
+
+  size_t nverts = mesh3_nverts(mesh);
+  dbl *T = malloc(nverts*sizeof(dbl));
+
+  eik3_s *eik_serial;
+  eik3_alloc(&eik_serial);
+  eik3_init(eik_serial, mesh, &SFUNC_CONSTANT);
+  solve_pt_src(eik_serial, 1, T);
+
+  eik3_s *eik;
+  eik3_alloc(&eik);
+  eik3_init(eik, mesh, &SFUNC_CONSTANT);
+
+  for (size_t num_threads = 2; num_threads <= 4; ++num_threads) {
+    solve_pt_src(eik, num_threads, T);
+    assert_that(eik3_get_num_threads(eik), is_equal_to(num_threads));
+    assert_solutions_match(eik_serial, eik);
+  }
+
+  free(T);
+
+  eik3_deinit(eik);
+  eik3_dealloc(&eik);
+
+  eik3_deinit(eik_serial);
+  eik3_dealloc(&eik_serial);
+
+  mesh3_deinit(mesh);
+  mesh3_dealloc(&mesh);
+}
+
+static dbl s(dbl3 x) {
+  return 1 + x[0]*x[0];
+}
+
+/* There's no lower bound for a slowness we can only sample, so we
+ * can't pick a band width and have to solve serially. */
+Ensure(eik3_solve, set_num_threads_fails_for_func_ptr_slowness) {
+  mesh3_s *mesh;
+  mesh3_alloc(&mesh);
+  make_cube_mesh(mesh, 2);
+
+  sfunc_s const sfunc = {.stype = STYPE_FUNC_PTR, .funcs = {.s = s}};
+
+  eik3_s *eik;
+  eik3_alloc(&eik);
+  eik3_init(eik, mesh, &sfunc);
+
+  assert_that(eik3_set_num_threads(eik, 4), is_equal_to(JMM_ERROR_BAD_ARGUMENTS));
+  assert_that(eik3_get_num_threads(eik), is_equal_to(1));
+
+  eik3_deinit(eik);
+  eik3_dealloc(&eik);
+
+  mesh3_deinit(mesh);
+  mesh3_dealloc(&mesh);
+}
+
+/* Likewise, we can't pick a bucket width for the front, so we fall
+ * back to a heap. */
+Ensure(eik3_solve, set_front_type_falls_back_to_heap_for_func_ptr_slowness) {
+  mesh3_s *mesh;
+  mesh3_alloc(&mesh);
+  make_cube_mesh(mesh, 2);
+
+  sfunc_s const sfunc = {.stype = STYPE_FUNC_PTR, .funcs = {.s = s}};
+
+  eik3_s *eik;
+  eik3_alloc(&eik);
+  eik3_init(eik, mesh, &sfunc);
+
+  assert_that(eik3_set_front_type(eik, FRONT_TYPE_BUCKET),
+              is_equal_to(JMM_ERROR_BAD_ARGUMENTS));
+  assert_that(front_get_type(eik3_get_front(eik)), is_equal_to(FRONT_TYPE_HEAP));
+
+  eik3_deinit(eik);
+  eik3_dealloc(&eik);
+
+  mesh3_deinit(mesh);
+  mesh3_dealloc(&mesh);
+}
+
+/* Each problem in a batch should be solved exactly as it would be by
+ * a fresh solver. Use more sources than threads, so that solvers are
+ * reused (and reset) within a call, and call the batch solver twice
+ * to check that resetting between calls works, too. */
+Ensure(eik3_solve, batch_solve_pt_srcs_agrees_with_eik3_solve) {
+  mesh3_s *mesh;
+  mesh3_alloc(&mesh);
+  make_cube_mesh(mesh, 4);
+
+  size_t nverts = mesh3_nverts(mesh);
+
+  size_t const num_srcs = 7;
+  dbl3 xsrc[num_srcs];
+  dbl rfac[num_srcs];
+  for (size_t i = 0; i < num_srcs; ++i) {
+    mesh3_copy_vert(mesh, (17*i + 3) % nverts, xsrc[i]);
+    rfac[i] = 0.3;
+  }
+
+  /* Solve each problem from scratch */
+  jet31t *jet_gt = malloc(num_srcs*nverts*sizeof(jet31t));
+  for (size_t i = 0; i < num_srcs; ++i) {
+    eik3_s *eik;
+    eik3_alloc(&eik);
+    eik3_init(eik, mesh, &SFUNC_CONSTANT);
+    eik3_add_pt_src_bcs(eik, xsrc[i], rfac[i]);
+    assert_that(eik3_solve(eik), is_equal_to(JMM_ERROR_NONE));
+    for (size_t l = 0; l < nverts; ++l)
+      jet_gt[i*nverts + l] = eik3_get_jet(eik, l);
+    eik3_deinit(eik);
+    eik3_dealloc(&eik);
+  }
+
+  eik3_batch_s *batch;
+  eik3_batch_alloc(&batch);
+  eik3_batch_init(batch, mesh, &SFUNC_CONSTANT, 3);
+
+  size_t stride = nverts + 5;
+  jet31t *jet = malloc(num_srcs*stride*sizeof(jet31t));
+
+  assert_that(eik3_batch_solve_pt_srcs(batch, num_srcs, xsrc, rfac, jet,
+                                       nverts - 1),
+              is_equal_to(JMM_ERROR_BAD_ARGUMENTS));
+
+  for (int k = 0; k < 2; ++k) {
+    assert_that(eik3_batch_solve_pt_srcs(batch, num_srcs, xsrc, rfac, jet,
+                                         stride),
+                is_equal_to(JMM_ERROR_NONE));
+    for (size_t i = 0; i < num_srcs; ++i)
+      assert_that(&jet[i*stride],
+                  is_equal_to_contents_of(&jet_gt[i*nverts],
+                                          nverts*sizeof(jet31t)));
+  }
+
+  free(jet);
+  free(jet_gt);
+
+  eik3_batch_deinit(batch);
+  eik3_batch_dealloc(&batch);
+
+  mesh3_deinit(mesh);
+  mesh3_dealloc(&mesh);
+}
+
+static void write_and_read_back(eik3_s const *eik, eik3_s *eik_bin) {
+  char const *path = "test_eik3_binfile.bin";
+
+  binfile_s *binfile;
+  binfile_alloc(&binfile);
+  binfile_init(binfile);
+  eik3_add_to_binfile(eik, binfile);
+  assert_that(binfile_write(binfile, path), is_equal_to(JMM_ERROR_NONE));
+  binfile_deinit(binfile);
+
+  assert_that(binfile_init_from_path(binfile, path), is_equal_to(JMM_ERROR_NONE));
+  assert_that(eik3_read_binfile(eik_bin, binfile), is_equal_to(JMM_ERROR_NONE));
+  binfile_deinit(binfile);
+  binfile_dealloc(&binfile);
+
+  remove(path);
+}
+
+/* Writing a solution to a binfile and reading it back should
+ * reproduce it exactly. If the solution is only partial, the
+ * `TRIAL` nodes are put back on the front, and resuming the solve
+ * should give exactly the same result as solving in one go. (This
+ * relies on the front breaking ties between equal values the same
+ * way regardless of the order nodes were inserted in.) */
+Ensure(eik3_solve, binfile_round_trip_works_for_pt_src) {
+  mesh3_s *mesh;
+  mesh3_alloc(&mesh);
+  make_cube_mesh(mesh, 6);
+
+  dbl3 const xsrc = {0.5, 0.5, 0.5};
+
+  eik3_s *eik, *eik_partial, *eik_bin;
+  eik3_alloc(&eik);
+  eik3_alloc(&eik_partial);
+  eik3_alloc(&eik_bin);
+  eik3_init(eik, mesh, &SFUNC_CONSTANT);
+  eik3_init(eik_partial, mesh, &SFUNC_CONSTANT);
+  eik3_init(eik_bin, mesh, &SFUNC_CONSTANT);
+
+  eik3_add_pt_src_bcs(eik, xsrc, 0.1);
+  assert_that(eik3_solve(eik), is_equal_to(JMM_ERROR_NONE));
+
+  write_and_read_back(eik, eik_bin);
+  assert_that(eik3_is_solved(eik_bin));
+  assert_solutions_match(eik, eik_bin);
+
+  eik3_add_pt_src_bcs(eik_partial, xsrc, 0.1);
+  for (size_t i = 0, l0; i < mesh3_nverts(mesh)/2; ++i)
+    assert_that(eik3_step(eik_partial, &l0), is_equal_to(JMM_ERROR_NONE));
+  assert_that(eik3_num_trial(eik_partial), is_greater_than(0));
+
+  write_and_read_back(eik_partial, eik_bin);
+  assert_false(eik3_is_solved(eik_bin));
+  assert_that(eik3_num_trial(eik_bin), is_equal_to(eik3_num_trial(eik_partial)));
+  assert_that(eik3_peek(eik_bin), is_equal_to(eik3_peek(eik_partial)));
+
+  assert_that(eik3_solve(eik_bin), is_equal_to(JMM_ERROR_NONE));
+  assert_solutions_match(eik, eik_bin);
+
+  eik3_deinit(eik_bin);
+  eik3_deinit(eik_partial);
+  eik3_deinit(eik);
+  eik3_dealloc(&eik_bin);
+  eik3_dealloc(&eik_partial);
+  eik3_dealloc(&eik);
+
+  mesh3_deinit(mesh);
+  mesh3_dealloc(&mesh);
+}
+
+/* The deprecated `eik3_get_jet_ptr` should keep returning the jets
+ * that `eik3_get_jet` assembles, including after `eik` changes. */
+Ensure(eik3_solve, get_jet_ptr_agrees_with_get_jet) {
+  mesh3_s *mesh;
+  mesh3_alloc(&mesh);
+  make_cube_mesh(mesh, 4);
+
+  size_t nverts = mesh3_nverts(mesh);
+
+  eik3_s *eik;
+  eik3_alloc(&eik);
+  eik3_init(eik, mesh, &SFUNC_CONSTANT);
+
+  dbl *T = malloc(nverts*sizeof(dbl));
+  for (size_t num_solves = 0; num_solves < 2; ++num_solves) {
+    solve_pt_src(eik, 1, T);
+    if (num_solves == 1)
+      eik3_set_jet(eik, 0, jet31t_make_empty());
+
+    jet31t const *jet = eik3_get_jet_ptr(eik);
+    for (size_t l = 0; l < nverts; ++l) {
+      jet31t jet_gt = eik3_get_jet(eik, l);
+      assert_that(&jet[l], is_equal_to_contents_of(&jet_gt, sizeof(jet31t)));
+    }
+  }
+  free(T);
+
+  eik3_deinit(eik);
+  eik3_dealloc(&eik);
+
+  mesh3_deinit(mesh);
+  mesh3_dealloc(&mesh);
+}
+
+#if JMM_DEBUG
+/* Once the update pool has grown to hold the peak number of live
+ * updates, it should be able to serve every later update without
+ * calling `malloc`. Solving the same problem twice, the second solve
+ * shouldn't allocate at all. */
+Ensure(eik3_solve, pool_allocs_stop_growing_after_warm_up) {
+  mesh3_s *mesh;
+  mesh3_alloc(&mesh);
+  make_cube_mesh(mesh, 8);
+
+  eik3_s *eik;
+  eik3_alloc(&eik);
+  eik3_init(eik, mesh, &SFUNC_CONSTANT);
+
+  dbl3 const xsrc = {0.5, 0.5, 0.5};
+
+  eik3_add_pt_src_bcs(eik, xsrc, 0.1);
+  assert_that(eik3_solve(eik), is_equal_to(JMM_ERROR_NONE));
+
+  size_t num_allocs = eik3_get_num_pool_allocs(eik);
+  assert_that(num_allocs, is_greater_than(0));
+
+  for (int i = 0; i < 2; ++i) {
+    eik3_reset(eik);
+    eik3_add_pt_src_bcs(eik, xsrc, 0.1);
+    assert_that(eik3_solve(eik), is_equal_to(JMM_ERROR_NONE));
+    assert_that(eik3_get_num_pool_allocs(eik), is_equal_to(num_allocs));
+  }
+
+  eik3_deinit(eik);
+  eik3_dealloc(&eik);
+
+  mesh3_deinit(mesh);
+  mesh3_dealloc(&mesh);
+}
+#endif
+
+TestSuite *eik3_solve_tests() {
+  TestSuite *suite = create_test_suite();
+  add_test_with_context(suite, eik3_solve, parallel_solve_agrees_with_serial_solve);
+  add_test_with_context(suite, eik3_solve, set_num_threads_fails_for_func_ptr_slowness);
+  add_test_with_context(suite, eik3_solve, set_front_type_falls_back_to_heap_for_func_ptr_slowness);
+  add_test_with_context(suite, eik3_solve, batch_solve_pt_srcs_agrees_with_eik3_solve);
+  add_test_with_context(suite, eik3_solve, binfile_round_trip_works_for_pt_src);
+  add_test_with_context(suite, eik3_solve, get_jet_ptr_agrees_with_get_jet);
+#if JMM_DEBUG
+  add_test_with_context(suite, eik3_solve, pool_allocs_stop_growing_after_warm_up);
+#endif
+  return suite;
+}
@@ -0,0 +1,99 @@
+#include <cgreen/cgreen.h>
+#include <jmm/array.h>
+#include <jmm/eik3.h>
+#include <jmm/eik3hh.h>
+#include <jmm/eik3hh_branch.h>
+#include <jmm/mesh3.h>
+
+#include "cube_mesh.h"
+
+Describe(eik3hh);
+BeforeEach(eik3hh) {}
+AfterEach(eik3hh) {}
+
+static void assert_branches_match(eik3hh_branch_s *branch1,
+                                  eik3hh_branch_s *branch2) {
+  eik3_s const *eik1 = eik3hh_branch_get_eik(branch1);
+  eik3_s const *eik2 = eik3hh_branch_get_eik(branch2);
+  size_t nverts = mesh3_nverts(eik3_get_mesh(eik1));
+  assert_that(eik3_get_T_ptr(eik1),
+              is_equal_to_contents_of(eik3_get_T_ptr(eik2), nverts*sizeof(dbl)));
+  assert_that(eik3_get_DT_ptr(eik1),
+              is_equal_to_contents_of(eik3_get_DT_ptr(eik2), nverts*sizeof(dbl3)));
+}
+
+/* Solve the one-reflection tree for a point source in the middle of
+ * a cube, whose faces are its reflectors. Whatever the number of
+ * threads, the root's children should be the visible reflections in
+ * the order `eik3hh_branch_get_visible_refls` lists them, each solved
+ * exactly as it would be serially, and they shouldn't have any
+ * children of their own. */
+Ensure(eik3hh, solve_agrees_with_serial_branch_solves_for_cube) {
+  mesh3_s *mesh;
+  mesh3_alloc(&mesh);
+  make_cube_mesh(mesh, 6);
+
+  dbl3 const xsrc = {0.5, 0.5, 0.5};
+  dbl const c = 340, rfac = 0.2;
+
+  /* Solve the tree serially, one branch at a time */
+  eik3hh_s *hh_gt;
+  eik3hh_alloc(&hh_gt);
+  eik3hh_init_with_pt_src(hh_gt, mesh, c, rfac, xsrc);
+
+  eik3hh_branch_s *root_gt = eik3hh_get_root_branch(hh_gt);
+  eik3hh_branch_solve(root_gt, false);
+
+  array_s *refl_inds = eik3hh_branch_get_visible_refls(root_gt);
+  size_t num_children = array_size(refl_inds);
+  assert_that(num_children, is_greater_than(1));
+
+  for (size_t i = 0; i < num_children; ++i) {
+    size_t refl_ind;
+    array_get(refl_inds, i, &refl_ind);
+    eik3hh_branch_solve(eik3hh_branch_add_refl(root_gt, refl_ind), false);
+  }
+
+  array_deinit(refl_inds);
+  array_dealloc(&refl_inds);
+
+  array_s *children_gt = eik3hh_branch_get_children(root_gt);
+
+  for (size_t num_threads = 1; num_threads <= 4; num_threads += 3) {
+    eik3hh_s *hh;
+    eik3hh_alloc(&hh);
+    eik3hh_init_with_pt_src(hh, mesh, c, rfac, xsrc);
+    eik3hh_solve(hh, 1, num_threads, false);
+
+    eik3hh_branch_s *root = eik3hh_get_root_branch(hh);
+    assert_true(eik3hh_branch_is_solved(root));
+    assert_branches_match(root, root_gt);
+
+    array_s *children = eik3hh_branch_get_children(root);
+    assert_that(array_size(children), is_equal_to(num_children));
+
+    for (size_t i = 0; i < num_children; ++i) {
+      eik3hh_branch_s *child, *child_gt;
+      array_get(children, i, &child);
+      array_get(children_gt, i, &child_gt);
+      assert_true(eik3hh_branch_is_solved(child));
+      assert_branches_match(child, child_gt);
+      assert_that(array_size(eik3hh_branch_get_children(child)), is_equal_to(0));
+    }
+
+    eik3hh_deinit(hh);
+    eik3hh_dealloc(&hh);
+  }
+
+  eik3hh_deinit(hh_gt);
+  eik3hh_dealloc(&hh_gt);
+
+  mesh3_deinit(mesh);
+  mesh3_dealloc(&mesh);
+}
+
+TestSuite *eik3hh_tests() {
+  TestSuite *suite = create_test_suite();
+  add_test_with_context(suite, eik3hh, solve_agrees_with_serial_branch_solves_for_cube);
+  return suite;
+}
@@ -0,0 +1,164 @@
+#include <cgreen/cgreen.h>
+#include <jmm/front.h>
+
+#include <stdlib.h>
+
+Describe(front);
+BeforeEach(front) {}
+AfterEach(front) {}
+
+static dbl value(void *ptr, size_t l) {
+  return ((dbl *)ptr)[l];
+}
+
+/* Insert `n` nodes with pseudorandom values into a front of type
+ * `type`, decrease half of them, and check that they're popped in
+ * order, up to the width of the buckets. */
+static void check_pop_order(front_type_e type, dbl width) {
+  size_t n = 1000;
+
+  dbl *T = malloc(n*sizeof(dbl));
+  srand(0);
+  for (size_t l = 0; l < n; ++l)
+    T[l] = 10.0*rand()/RAND_MAX;
+  T[n - 1] = INFINITY;
+
+  front_s *front;
+  front_alloc(&front);
+  front_init(front, type, n, width, value, T);
+
+  for (size_t l = 0; l < n; ++l)
+    front_insert(front, l);
+  assert_that(front_size(front), is_equal_to(n));
+
+  for (size_t l = 0; l < n; l += 2) {
+    T[l] /= 2;
+    front_update(front, l);
+  }
+
+  /* The node with an infinite value gets a finite one */
+  T[n - 1] = 1;
+  front_update(front, n - 1);
+
+  dbl T_max = -INFINITY;
+  for (size_t i = 0; i < n; ++i) {
+    size_t l = front_peek(front);
+    assert_that(front_contains(front, l));
+    front_pop(front);
+    assert_that(front_contains(front, l), is_false);
+    assert_that(T[l] >= T_max - width);
+    T_max = fmax(T_max, T[l]);
+  }
+  assert_that(front_size(front), is_equal_to(0));
+  assert_that(front_get_num_pops(front), is_equal_to(n));
+
+  front_clear(front);
+  assert_that(front_get_num_pops(front), is_equal_to(0));
+
+  front_deinit(front);
+  front_dealloc(&front);
+
+  free(T);
+}
+
+/* Like `check_pop_order`, but decrease the values several times
+ * before updating the front once with `front_update_many`. Some of
+ * the nodes are passed more than once. */
+static void check_pop_order_after_update_many(front_type_e type, dbl width) {
+  size_t n = 1000;
+
+  dbl *T = malloc(n*sizeof(dbl));
+  srand(1);
+  for (size_t l = 0; l < n; ++l)
+    T[l] = 10.0*rand()/RAND_MAX;
+
+  front_s *front;
+  front_alloc(&front);
+  front_init(front, type, n, width, value, T);
+
+  for (size_t l = 0; l < n; ++l)
+    front_insert(front, l);
+
+  size_t m = n/2;
+  size_t *l = malloc(m*sizeof(size_t));
+  for (size_t i = 0; i < m; ++i) {
+    l[i] = rand() % n;
+    T[l[i]] *= (dbl)rand()/RAND_MAX;
+  }
+  front_update_many(front, m, l);
+
+  dbl T_max = -INFINITY;
+  for (size_t i = 0; i < n; ++i) {
+    size_t l0 = front_peek(front);
+    front_pop(front);
+    assert_that(T[l0] >= T_max - width);
+    T_max = fmax(T_max, T[l0]);
+  }
+  assert_that(front_size(front), is_equal_to(0));
+
+  front_deinit(front);
+  front_dealloc(&front);
+
+  free(l);
+  free(T);
+}
+
+/* Check that `front_peek_many` returns the nodes that the following
+ * pops will return, in the same order, and leaves the front as it
+ * was. */
+static void check_peek_many(front_type_e type, dbl width) {
+  size_t n = 1000, k = 16;
+
+  dbl *T = malloc(n*sizeof(dbl));
+  srand(2);
+  for (size_t l = 0; l < n; ++l)
+    T[l] = 10.0*rand()/RAND_MAX;
+
+  front_s *front;
+  front_alloc(&front);
+  front_init(front, type, n, width, value, T);
+
+  for (size_t l = 0; l < n; ++l)
+    front_insert(front, l);
+
+  size_t l[16];
+  while (front_size(front) > 0) {
+    size_t num_peeked = front_peek_many(front, k, l);
+    assert_that(num_peeked, is_equal_to(k < front_size(front) ? k : front_size(front)));
+    assert_that(front_peek(front), is_equal_to(l[0]));
+    for (size_t i = 0; i < num_peeked; ++i) {
+      assert_that(front_peek(front), is_equal_to(l[i]));
+      front_pop(front);
+    }
+  }
+
+  front_deinit(front);
+  front_dealloc(&front);
+
+  free(T);
+}
+
+Ensure(front, heap_pops_in_order) {
+  check_pop_order(FRONT_TYPE_HEAP, 0);
+  check_pop_order_after_update_many(FRONT_TYPE_HEAP, 0);
+}
+
+Ensure(front, peek_many_agrees_with_pops) {
+  check_peek_many(FRONT_TYPE_HEAP, 0);
+  check_peek_many(FRONT_TYPE_BUCKET, 0.01);
+  check_peek_many(FRONT_TYPE_BUCKET, 0.5);
+}
+
+Ensure(front, bucket_pops_in_order_up_to_width) {
+  check_pop_order(FRONT_TYPE_BUCKET, 0.01);
+  check_pop_order(FRONT_TYPE_BUCKET, 0.5);
+  check_pop_order_after_update_many(FRONT_TYPE_BUCKET, 0.01);
+}
+
+TestSuite *front_tests() {
+  TestSuite *suite = create_test_suite();
+  add_test_with_context(suite, front, heap_pops_in_order);
+  add_test_with_context(suite, front, bucket_pops_in_order_up_to_width);
+  add_test_with_context(suite, front, peek_many_agrees_with_pops);
+  return suite;
+}
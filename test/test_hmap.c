@@ -0,0 +1,103 @@
+#include <cgreen/cgreen.h>
+#include <jmm/hmap.h>
+
+Describe(hmap);
+BeforeEach(hmap) {}
+AfterEach(hmap) {}
+
+Ensure(hmap, basic_test) {
+  hmap_s *map;
+  hmap_alloc(&map);
+  hmap_init(map, sizeof(int), sizeof(float), 8);
+
+  assert_that(hmap_is_empty(map));
+
+  int k;
+  float v;
+
+  for (k = 1; k <= 4; ++k) {
+    v = 5 - k;
+    assert_that(hmap_insert(map, &k, &v));
+    assert_that(hmap_size(map), is_equal_to(k));
+  }
+  assert_that(hmap_is_empty(map), is_false);
+
+  for (k = 1; k <= 4; ++k) {
+    assert_that(hmap_contains(map, &k));
+    assert_that(hmap_get(map, &k, &v));
+    assert_that(v, is_equal_to(5 - k));
+  }
+
+  k = -10;
+  assert_that(hmap_contains(map, &k), is_false);
+  assert_that(hmap_get(map, &k, &v), is_false);
+
+  /* Inserting an existing key leaves its element alone... */
+  k = 2;
+  v = -10.0;
+  assert_that(hmap_insert(map, &k, &v), is_false);
+  assert_that(hmap_get(map, &k, &v));
+  assert_that(v, is_equal_to(3.0));
+
+  /* ... while setting it replaces it */
+  v = -10.0;
+  hmap_set(map, &k, &v);
+  assert_that(hmap_size(map), is_equal_to(4));
+  assert_that(hmap_get(map, &k, &v));
+  assert_that(v, is_equal_to(-10.0));
+
+  assert_that(hmap_remove(map, &k));
+  assert_that(hmap_remove(map, &k), is_false);
+  assert_that(hmap_contains(map, &k), is_false);
+  assert_that(hmap_size(map), is_equal_to(3));
+
+  hmap_clear(map);
+  assert_that(hmap_is_empty(map));
+  for (k = 1; k <= 4; ++k)
+    assert_that(hmap_contains(map, &k), is_false);
+
+  hmap_deinit(map);
+  hmap_dealloc(&map);
+}
+
+Ensure(hmap, grows_and_removes_edges) {
+  hmap_s *map;
+  hmap_alloc(&map);
+  hmap_init(map, sizeof(size_t[2]), sizeof(double), 4);
+
+  size_t n = 1000;
+
+  for (size_t i = 0; i < n; ++i) {
+    size_t key[2] = {i, i + 1};
+    double value = i;
+    hmap_set(map, key, &value);
+  }
+  assert_that(hmap_size(map), is_equal_to(n));
+
+  /* Remove every third edge */
+  for (size_t i = 0; i < n; i += 3) {
+    size_t key[2] = {i, i + 1};
+    assert_that(hmap_remove(map, key));
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    size_t key[2] = {i, i + 1};
+    double value;
+    if (i % 3 == 0) {
+      assert_that(hmap_get(map, key, &value), is_false);
+    } else {
+      assert_that(hmap_get(map, key, &value));
+      assert_that_double(value, is_equal_to_double(i));
+    }
+  }
+
+  hmap_deinit(map);
+  hmap_dealloc(&map);
+}
+
+TestSuite *hmap_tests() {
+  TestSuite *suite = create_test_suite();
+  add_test_with_context(suite, hmap, basic_test);
+  add_test_with_context(suite, hmap, grows_and_removes_edges);
+  return suite;
+}
@@ -1,7 +1,11 @@
 #include <cgreen/cgreen.h>
+#include <jmm/binfile.h>
 #include <jmm/mesh3.h>
 #include <jmm/util.h>
 
+#include <math.h>
+#include <stdlib.h>
+
 Describe(mesh3);
 BeforeEach(mesh3) {}
 AfterEach(mesh3) {}
@@ -15,7 +19,7 @@ AfterEach(mesh3) {}
       .nverts = 8, .verts = verts, .ncells = 5, .cells = cells}; \
   mesh3_s *mesh;                                                 \
   mesh3_alloc(&mesh);                                            \
-  mesh3_init(mesh, &data, true, NULL);
+  mesh3_init(mesh, &data, true, true, NULL);
 
 #define TEAR_DOWN_MESH() \
   mesh3_deinit(mesh);    \
@@ -300,6 +304,246 @@ Ensure(mesh3, get_num_diffractors_for_cube) {
   TEAR_DOWN_MESH();
 }
 
+Ensure(mesh3, adj_info_agrees_with_unindexed_queries_for_cube) {
+  SET_UP_CUBE_MESH();
+
+  mesh3_s *mesh_noadj;
+  mesh3_alloc(&mesh_noadj);
+  mesh3_init(mesh_noadj, &data, true, false, NULL);
+
+  assert_true(mesh3_has_adj_info(mesh));
+  assert_false(mesh3_has_adj_info(mesh_noadj));
+
+  size_t buf[64][3], buf_adj[64][3];
+
+  for (size_t i = 0; i < 8; ++i) {
+    int nvv = mesh3_nvv(mesh, i);
+    assert_that(mesh3_nvv(mesh_noadj, i), is_equal_to(nvv));
+    mesh3_vv(mesh_noadj, i, (size_t *)buf);
+    mesh3_vv(mesh, i, (size_t *)buf_adj);
+    assert_that(buf_adj, is_equal_to_contents_of(buf, nvv*sizeof(size_t)));
+
+    int nve = mesh3_nve(mesh, i);
+    assert_that(mesh3_nve(mesh_noadj, i), is_equal_to(nve));
+    mesh3_ve(mesh_noadj, i, (size_t (*)[2])buf);
+    mesh3_ve(mesh, i, (size_t (*)[2])buf_adj);
+    assert_that(buf_adj, is_equal_to_contents_of(buf, nve*sizeof(uint2)));
+
+    int nvf = mesh3_nvf(mesh, i);
+    assert_that(mesh3_nvf(mesh_noadj, i), is_equal_to(nvf));
+    mesh3_vf(mesh_noadj, i, buf);
+    mesh3_vf(mesh, i, buf_adj);
+    assert_that(buf_adj, is_equal_to_contents_of(buf, nvf*sizeof(uint3)));
+  }
+
+  mesh3_deinit(mesh_noadj);
+  mesh3_dealloc(&mesh_noadj);
+
+  TEAR_DOWN_MESH();
+}
+
+Ensure(mesh3, find_cell_containing_point_works_for_cube) {
+  SET_UP_CUBE_MESH();
+
+  /* Check against a brute force search over the cells at a grid of
+   * points inside the cube, both with and without a hint */
+  for (int i = 0; i < 8; ++i) {
+    for (int j = 0; j < 8; ++j) {
+      for (int k = 0; k < 8; ++k) {
+        dbl3 x = {(i + 0.3)/8, (j + 0.6)/8, (k + 0.45)/8};
+
+        size_t lc_gt = (size_t)NO_INDEX;
+        for (size_t lc = 0; lc < 5; ++lc)
+          if (mesh3_cell_contains_point(mesh, lc, x)) {
+            lc_gt = lc;
+            break;
+          }
+        assert_that(lc_gt, is_not_equal_to((size_t)NO_INDEX));
+
+        size_t lc = mesh3_find_cell_containing_point(mesh, x, NO_INDEX);
+        assert_true(mesh3_cell_contains_point(mesh, lc, x));
+
+        for (size_t lc_hint = 0; lc_hint < 5; ++lc_hint) {
+          lc = mesh3_find_cell_containing_point(mesh, x, lc_hint);
+          assert_true(mesh3_cell_contains_point(mesh, lc, x));
+        }
+      }
+    }
+  }
+
+  dbl3 x_out = {1.5, 0.5, 0.5};
+  assert_that(mesh3_find_cell_containing_point(mesh, x_out, NO_INDEX),
+              is_equal_to((size_t)NO_INDEX));
+  assert_that(mesh3_find_cell_containing_point(mesh, x_out, 0),
+              is_equal_to((size_t)NO_INDEX));
+
+  TEAR_DOWN_MESH();
+}
+
+Ensure(mesh3, linterp_batch_agrees_with_linterp_for_cube) {
+  SET_UP_CUBE_MESH();
+
+  dbl values[8];
+  for (size_t l = 0; l < 8; ++l) {
+    dbl const *x = mesh3_get_vert_ptr(mesh, l);
+    values[l] = 1 + x[0] - 2*x[1] + 3*x[0]*x[2];
+  }
+
+  /* Sample on a grid which overhangs the cube, so that some of the
+   * points lie outside the mesh */
+  size_t const N = 9;
+  dbl3 *x = malloc(N*N*N*sizeof(dbl3));
+  for (size_t i = 0, l = 0; i < N; ++i)
+    for (size_t j = 0; j < N; ++j)
+      for (size_t k = 0; k < N; ++k, ++l) {
+        x[l][0] = -0.1 + 1.2*(i + 0.3)/N;
+        x[l][1] = -0.1 + 1.2*(j + 0.6)/N;
+        x[l][2] = -0.1 + 1.2*(k + 0.45)/N;
+      }
+
+  dbl *y = malloc(N*N*N*sizeof(dbl));
+  mesh3_linterp_batch(mesh, values, N*N*N, x, y);
+
+  size_t num_inside = 0;
+  for (size_t l = 0; l < N*N*N; ++l) {
+    dbl y_gt = mesh3_linterp(mesh, values, x[l]);
+    if (isnan(y_gt)) {
+      assert_that(isnan(y[l]));
+    } else {
+      assert_that_double(y[l], is_nearly_double(y_gt));
+      ++num_inside;
+    }
+  }
+  assert_that(num_inside, is_greater_than(0));
+  assert_that(num_inside, is_less_than(N*N*N));
+
+  free(y);
+  free(x);
+
+  TEAR_DOWN_MESH();
+}
+
+Ensure(mesh3, insert_verts_works_for_cube) {
+  SET_UP_CUBE_MESH();
+  TEAR_DOWN_MESH();
+
+  /* Inserting reallocates the arrays in `data`, so copy them */
+  data.verts = malloc(sizeof(verts));
+  memcpy(data.verts, verts, sizeof(verts));
+  data.cells = malloc(sizeof(cells));
+  memcpy(data.cells, cells, sizeof(cells));
+
+  /* Nothing is inserted if any of the points are outside the mesh */
+  dbl3 x[3] = {{0.25, 0.5, 0.75}, {0.3, 0.35, 0.4}, {1.5, 0.5, 0.5}};
+  assert_that(mesh3_data_insert_verts(&data, 3, x, 1e-10),
+              is_equal_to(BAD_ARGUMENT));
+  assert_that(data.nverts, is_equal_to(8));
+  assert_that(data.ncells, is_equal_to(5));
+
+  /* Each inserted vertex splits a cell into four */
+  x[2][0] = 0.26;
+  assert_that(mesh3_data_insert_verts(&data, 3, x, 1e-10),
+              is_equal_to(SUCCESS));
+  assert_that(data.nverts, is_equal_to(11));
+  assert_that(data.ncells, is_equal_to(14));
+
+  mesh3_alloc(&mesh);
+  mesh3_init(mesh, &data, true, true, NULL);
+
+  for (size_t l = 0; l < mesh3_nverts(mesh); ++l) {
+    dbl3 y;
+    mesh3_copy_vert(mesh, l, y);
+    assert_true(mesh3_has_vertex(mesh, y));
+    assert_that(mesh3_get_vert_index(mesh, y), is_equal_to(l));
+    y[1] += 1e-6;
+    assert_false(mesh3_has_vertex(mesh, y));
+    assert_that(mesh3_get_vert_index(mesh, y), is_equal_to((size_t)NO_INDEX));
+  }
+
+  /* The new cells still cover the cube */
+  for (int i = 0; i < 8; ++i) {
+    for (int j = 0; j < 8; ++j) {
+      for (int k = 0; k < 8; ++k) {
+        dbl3 y = {(i + 0.3)/8, (j + 0.6)/8, (k + 0.45)/8};
+        assert_that(mesh3_find_cell_containing_point(mesh, y, NO_INDEX),
+                    is_not_equal_to((size_t)NO_INDEX));
+      }
+    }
+  }
+
+  TEAR_DOWN_MESH();
+
+  mesh3_data_deinit(&data);
+}
+
+Ensure(mesh3, binfile_round_trip_works_for_cube) {
+  SET_UP_CUBE_MESH();
+
+  char const *path = "test_mesh3_binfile.bin";
+
+  binfile_s *binfile;
+  binfile_alloc(&binfile);
+  binfile_init(binfile);
+  mesh3_add_to_binfile(mesh, binfile);
+  assert_that(binfile_write(binfile, path), is_equal_to(JMM_ERROR_NONE));
+  binfile_deinit(binfile);
+
+  assert_that(binfile_init_from_path(binfile, path), is_equal_to(JMM_ERROR_NONE));
+
+  mesh3_s *mesh_bin;
+  mesh3_alloc(&mesh_bin);
+  assert_that(mesh3_init_from_binfile(mesh_bin, binfile),
+              is_equal_to(JMM_ERROR_NONE));
+
+  assert_that(mesh3_nverts(mesh_bin), is_equal_to(mesh3_nverts(mesh)));
+  assert_that(mesh3_ncells(mesh_bin), is_equal_to(mesh3_ncells(mesh)));
+  assert_that(mesh3_nbdf(mesh_bin), is_equal_to(mesh3_nbdf(mesh)));
+  assert_that(mesh3_nbde(mesh_bin), is_equal_to(mesh3_nbde(mesh)));
+  assert_that(mesh3_get_num_reflectors(mesh_bin),
+              is_equal_to(mesh3_get_num_reflectors(mesh)));
+  assert_that_double(mesh3_get_diam(mesh_bin),
+                     is_equal_to_double(mesh3_get_diam(mesh)));
+
+  assert_true(mesh3_has_adj_info(mesh_bin));
+
+  for (size_t i = 0; i < 8; ++i) {
+    assert_that(mesh3_bdv(mesh_bin, i), is_equal_to(mesh3_bdv(mesh, i)));
+
+    int nvv = mesh3_nvv(mesh, i);
+    assert_that(mesh3_nvv(mesh_bin, i), is_equal_to(nvv));
+    assert_that(mesh3_get_vv_ptr(mesh_bin, i),
+                is_equal_to_contents_of(mesh3_get_vv_ptr(mesh, i),
+                                        nvv*sizeof(jmm_index_t)));
+  }
+
+  dbl3 x = {0.25, 0.5, 0.75};
+  assert_that(mesh3_find_cell_containing_point(mesh_bin, x, NO_INDEX),
+              is_equal_to(mesh3_find_cell_containing_point(mesh, x, NO_INDEX)));
+
+  mesh3_deinit(mesh_bin);
+  mesh3_dealloc(&mesh_bin);
+
+  binfile_deinit(binfile);
+  binfile_dealloc(&binfile);
+
+  remove(path);
+
+  TEAR_DOWN_MESH();
+}
+
+Ensure(mesh3, init_fails_for_mesh_too_large_for_jmm_index_t) {
+  /* The size check happens before anything is read from `data`, so
+   * there's no need to actually allocate a huge mesh here. */
+  mesh3_data_s data = {
+    .nverts = JMM_INDEX_MAX, .verts = NULL, .ncells = 1, .cells = NULL};
+
+  mesh3_s *mesh;
+  mesh3_alloc(&mesh);
+  assert_that(mesh3_init(mesh, &data, true, true, NULL),
+              is_equal_to(JMM_ERROR_BAD_ARGUMENTS));
+  mesh3_dealloc(&mesh);
+}
+
 TestSuite *mesh3_tests() {
   TestSuite *suite = create_test_suite();
 
@@ -316,6 +560,12 @@ TestSuite *mesh3_tests() {
   add_test_with_context(suite, mesh3, bdc_works_for_cube);
   add_test_with_context(suite, mesh3, bdv_works_for_cube);
   add_test_with_context(suite, mesh3, get_num_diffractors_for_cube);
+  add_test_with_context(suite, mesh3, adj_info_agrees_with_unindexed_queries_for_cube);
+  add_test_with_context(suite, mesh3, find_cell_containing_point_works_for_cube);
+  add_test_with_context(suite, mesh3, linterp_batch_agrees_with_linterp_for_cube);
+  add_test_with_context(suite, mesh3, insert_verts_works_for_cube);
+  add_test_with_context(suite, mesh3, binfile_round_trip_works_for_cube);
+  add_test_with_context(suite, mesh3, init_fails_for_mesh_too_large_for_jmm_index_t);
 
   return suite;
 }
\ No newline at end of file
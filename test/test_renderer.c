@@ -0,0 +1,188 @@
+#include <cgreen/cgreen.h>
+#include <jmm/bmesh.h>
+#include <jmm/camera.h>
+#include <jmm/mesh2.h>
+#include <jmm/mesh3.h>
+#include <jmm/renderer.h>
+#include <jmm/rtree.h>
+#include <jmm/util.h>
+#include <jmm/vec.h>
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "cube_mesh.h"
+
+Describe(renderer);
+BeforeEach(renderer) {}
+AfterEach(renderer) {}
+
+/* Render the level set of `bmesh` at `level` the straightforward
+ * way: put the boundary surface and every cell bracketing `level`
+ * into one R-tree, and march each ray through it on its own. This
+ * is how frames were rendered before `renderer_s`, and uses the same
+ * shading as `renderer_render_frame`. Returns the number of hits
+ * with the level set. */
+static size_t render_reference(mesh3_s const *mesh, bmesh33_s const *bmesh,
+                               dbl const *spread, dbl const *org,
+                               camera_s const *camera, dbl level, dbl4 *img) {
+  mesh2_s *surface_mesh = mesh3_get_surface_mesh(mesh);
+  bmesh33_s *level_bmesh = bmesh33_restrict_to_level(bmesh, level);
+
+  rtree_s *rtree;
+  rtree_alloc(&rtree);
+  rtree_init(rtree, 16, RTREE_SPLIT_STRATEGY_SURFACE_AREA);
+  rtree_insert_mesh2(rtree, surface_mesh);
+  rtree_insert_bmesh33(rtree, level_bmesh);
+  rtree_build(rtree);
+
+  size_t num_level_hits = 0;
+
+  for (size_t i = 0, l = 0; i < camera->dim[0]; ++i) {
+    for (size_t j = 0; j < camera->dim[1]; ++j, ++l) {
+      ray3 ray = camera_get_ray_for_index(camera, i, j);
+
+      isect hit;
+      rtree_intersect(rtree, &ray, &hit, NULL);
+
+      img[l][0] = img[l][1] = img[l][2] = 0;
+      img[l][3] = isfinite(hit.t) ? 1 : 0;
+
+      dbl transparency = 1;
+      while (isfinite(hit.t)) {
+        void const *data = robj_get_data(hit.obj);
+
+        dbl3_saxpy_inplace(hit.t, ray.dir, ray.org);
+
+        dbl alpha, gray;
+        dbl3 n;
+        if (robj_get_type(hit.obj) == ROBJ_MESH2_TRI) {
+          alpha = 0.5;
+          gray = 0.54;
+          mesh2_get_unit_surface_normal(surface_mesh, ((mesh2_tri_s const *)data)->l, n);
+        } else {
+          dbl spread_dB = 20*log10(fmax(1e-16, mesh3_linterp(mesh, spread, ray.org)));
+          alpha = fmax(0, fmin(1, 1 - spread_dB/(-90)))
+            *squash(mesh3_linterp(mesh, org, ray.org), 2);
+          gray = 1;
+          bmesh33_cell_Df(data, ray.org, n);
+          dbl3_normalize(n);
+          ++num_level_hits;
+        }
+
+        dbl value = alpha*gray*fabs(dbl3_dot(n, ray.dir));
+        for (size_t k = 0; k < 3; ++k)
+          img[l][k] += value;
+
+        transparency *= 1 - alpha;
+        if (transparency < 1e-3)
+          break;
+
+        rtree_intersect(rtree, &ray, &hit, hit.obj);
+        while (hit.t < EPS) {
+          dbl3_saxpy_inplace(EPS, ray.dir, ray.org);
+          rtree_intersect(rtree, &ray, &hit, hit.obj);
+        }
+      }
+    }
+  }
+
+  rtree_deinit(rtree);
+  rtree_dealloc(&rtree);
+
+  bmesh33_deinit(level_bmesh);
+  bmesh33_dealloc(&level_bmesh);
+
+  mesh2_deinit(surface_mesh);
+  mesh2_dealloc(&surface_mesh);
+
+  return num_level_hits;
+}
+
+/* `renderer_s` traces tiles of rays in packets and finds the cells
+ * bracketing each level with an interval tree, but should draw the
+ * same frames as the reference renderer above. Render a few frames
+ * of spherical wavefronts in a cube, including one at a decreasing
+ * level, and compare them pixel by pixel. */
+Ensure(renderer, render_frame_matches_reference) {
+  mesh3_s *mesh;
+  mesh3_alloc(&mesh);
+  make_cube_mesh(mesh, 4);
+
+  size_t nverts = mesh3_nverts(mesh);
+
+  dbl3 const xsrc = {-0.5, -0.25, -0.5};
+
+  jet31t *jet = malloc(nverts*sizeof(jet31t));
+  dbl *spread = malloc(nverts*sizeof(dbl));
+  dbl *org = malloc(nverts*sizeof(dbl));
+  for (size_t l = 0; l < nverts; ++l) {
+    dbl3 dx;
+    dbl3_sub(mesh3_get_vert_ptr(mesh, l), xsrc, dx);
+    jet[l].f = dbl3_norm(dx);
+    dbl3_normalized(dx, jet[l].Df);
+    spread[l] = 1/jet[l].f;
+    org[l] = 0.5 + 0.01*l/nverts;
+  }
+
+  bmesh33_s *bmesh;
+  bmesh33_alloc(&bmesh);
+  bmesh33_init_from_mesh3_and_jets(bmesh, mesh, jet);
+
+  camera_s camera = {
+    .type = CAMERA_TYPE_PERSPECTIVE,
+    .pos = {2.5, 3, 2},
+    .look = {-2, -2.5, -1.5},
+    .left = {-2.5, 2, 0},
+    .fovy = 40,
+    .aspect = 1,
+    .dim = {48, 40}
+  };
+  dbl3_normalize(camera.look);
+  dbl3_normalize(camera.left);
+  dbl3_cross(camera.look, camera.left, camera.up);
+
+  renderer_s *renderer;
+  renderer_alloc(&renderer);
+  renderer_init(renderer, mesh, &camera);
+  renderer_add_bmesh33(renderer, bmesh, spread, org);
+
+  size_t npix = camera.dim[0]*camera.dim[1];
+  dbl4 *img = malloc(npix*sizeof(dbl4));
+  dbl4 *img_ref = malloc(npix*sizeof(dbl4));
+
+  dbl const level[] = {0.9, 1.2, 1.5, 1.1, 1.8};
+  for (size_t i = 0; i < sizeof(level)/sizeof(level[0]); ++i) {
+    renderer_render_frame(renderer, level[i], img);
+
+    size_t num_level_hits = render_reference(
+      mesh, bmesh, spread, org, &camera, level[i], img_ref);
+    assert_that(num_level_hits, is_greater_than(0));
+
+    for (size_t l = 0; l < npix; ++l)
+      for (size_t k = 0; k < 4; ++k)
+        assert_that_double(img[l][k], is_nearly_double(img_ref[l][k]));
+  }
+
+  free(img);
+  free(img_ref);
+
+  renderer_deinit(renderer);
+  renderer_dealloc(&renderer);
+
+  bmesh33_deinit(bmesh);
+  bmesh33_dealloc(&bmesh);
+
+  free(jet);
+  free(spread);
+  free(org);
+
+  mesh3_deinit(mesh);
+  mesh3_dealloc(&mesh);
+}
+
+TestSuite *renderer_tests() {
+  TestSuite *suite = create_test_suite();
+  add_test_with_context(suite, renderer, render_frame_matches_reference);
+  return suite;
+}
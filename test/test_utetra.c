@@ -0,0 +1,94 @@
+#include <cgreen/cgreen.h>
+#include <jmm/eik3.h>
+#include <jmm/mesh3.h>
+#include <jmm/utetra.h>
+#include <jmm/vec.h>
+
+#include <math.h>
+
+#include "cube_mesh.h"
+
+Describe(utetra);
+BeforeEach(utetra) {}
+AfterEach(utetra) {}
+
+/* With a constant slowness, `utetra_solve` uses a projected Newton
+ * method instead of the generic quadratic surrogate. Check that the
+ * two agree for every tetrahedron update of a plane wave on a small
+ * mesh: the Newton method should never find a larger value, and the
+ * jets should agree up to the tolerance the surrogate is solved to. */
+Ensure(utetra, stype_constant_agrees_with_surrogate) {
+  mesh3_s *mesh;
+  mesh3_alloc(&mesh);
+  make_cube_mesh(mesh, 4);
+
+  eik3_s *eik;
+  eik3_alloc(&eik);
+  eik3_init(eik, mesh, &SFUNC_CONSTANT);
+
+  dbl3 t = {1, 2, 3};
+  dbl3_normalize(t);
+
+  for (size_t l = 0; l < mesh3_nverts(mesh); ++l) {
+    jet31t jet = {.f = dbl3_dot(t, mesh3_get_vert_ptr(mesh, l))};
+    dbl3_copy(t, jet.Df);
+    eik3_set_jet(eik, l, jet);
+  }
+
+  size_t num_updates = 0;
+
+  for (size_t lc = 0; lc < mesh3_ncells(mesh); ++lc) {
+    uint4 cv;
+    mesh3_cv(mesh, lc, cv);
+
+    for (size_t i = 0; i < 4; ++i) {
+      size_t lhat = cv[i];
+
+      uint3 l;
+      for (size_t j = 0, k = 0; j < 4; ++j)
+        if (j != i)
+          l[k++] = cv[j];
+
+      utetra_s *utetra[2];
+      for (size_t j = 0; j < 2; ++j) {
+        utetra_alloc(&utetra[j]);
+        utetra_init(utetra[j], eik, lhat, l);
+      }
+
+      if (!utetra_is_degenerate(utetra[0]) &&
+          !utetra_is_backwards(utetra[0], eik)) {
+        utetra_solve(utetra[0], NULL);
+        utetra_solve_surrogate(utetra[1], NULL);
+
+        jet31t jet[2];
+        for (size_t j = 0; j < 2; ++j)
+          utetra_get_jet31t(utetra[j], &jet[j]);
+
+        dbl tol = mesh3_get_face_tol(mesh, l);
+
+        assert_that(jet[0].f <= jet[1].f + 1e-13);
+        assert_that(jet[1].f - jet[0].f <= tol);
+        assert_that(dbl3_dist(jet[0].Df, jet[1].Df) <= sqrt(tol));
+
+        ++num_updates;
+      }
+
+      for (size_t j = 0; j < 2; ++j)
+        utetra_dealloc(&utetra[j]);
+    }
+  }
+
+  assert_that(num_updates, is_greater_than(0));
+
+  eik3_deinit(eik);
+  eik3_dealloc(&eik);
+
+  mesh3_deinit(mesh);
+  mesh3_dealloc(&mesh);
+}
+
+TestSuite *utetra_tests() {
+  TestSuite *suite = create_test_suite();
+  add_test_with_context(suite, utetra, stype_constant_agrees_with_surrogate);
+  return suite;
+}
@@ -0,0 +1,97 @@
+#include <cgreen/cgreen.h>
+#include <jmm/grid3.h>
+#include <jmm/mesh3.h>
+#include <jmm/vec.h>
+#include <jmm/xfer.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cube_mesh.h"
+
+Describe(xfer);
+
+BeforeEach(xfer) {
+  double_absolute_tolerance_is(1e-13);
+  double_relative_tolerance_is(1e-13);
+}
+
+AfterEach(xfer) {}
+
+/* The spline interpolating the jets of a linear function is that
+ * linear function, so transferring it to a grid should be exact up
+ * to roundoff. The grid overhangs the mesh on every side, and none
+ * of its nodes lie on the boundary of the mesh, so each node is
+ * either clearly inside or clearly outside. */
+Ensure(xfer, works_for_linear_function_on_cube) {
+  mesh3_s *mesh;
+  mesh3_alloc(&mesh);
+  make_cube_mesh(mesh, 4);
+
+  dbl const c = 0.5;
+  dbl3 const a = {1, -2, 3};
+
+  size_t nverts = mesh3_nverts(mesh);
+  jet31t *jet = malloc(nverts*sizeof(jet31t));
+  for (size_t l = 0; l < nverts; ++l) {
+    jet[l].f = c + dbl3_dot(a, mesh3_get_vert_ptr(mesh, l));
+    dbl3_copy(a, jet[l].Df);
+  }
+
+  grid3_s grid = {.dim = {16, 16, 16}, .min = {-0.25, -0.25, -0.25}, .h = 0.1};
+
+  size_t size = grid3_size(&grid);
+  dbl *y = malloc(size*sizeof(dbl));
+  dbl3 *Dy = malloc(size*sizeof(dbl3));
+  xfer_with_grad(mesh, jet, &grid, y, Dy);
+
+  size_t num_inside = 0;
+
+  int ind[3];
+  for (ind[0] = 0; ind[0] < grid.dim[0]; ++ind[0])
+    for (ind[1] = 0; ind[1] < grid.dim[1]; ++ind[1])
+      for (ind[2] = 0; ind[2] < grid.dim[2]; ++ind[2]) {
+        size_t l = ind2l3(grid.dim, ind);
+
+        dbl3 x;
+        grid3_get_point(&grid, ind, x);
+
+        bool inside = true;
+        for (int i = 0; i < 3; ++i)
+          inside = inside && 0 < x[i] && x[i] < 1;
+
+        if (inside) {
+          assert_that_double(y[l], is_nearly_double(c + dbl3_dot(a, x)));
+          for (int i = 0; i < 3; ++i)
+            assert_that_double(Dy[l][i], is_nearly_double(a[i]));
+          ++num_inside;
+        } else {
+          assert_true(isnan(y[l]));
+          for (int i = 0; i < 3; ++i)
+            assert_true(isnan(Dy[l][i]));
+        }
+      }
+
+  assert_that(num_inside, is_equal_to(10*10*10));
+
+  /* Transferring without the gradient should give the same values */
+  dbl *y_nograd = malloc(size*sizeof(dbl));
+  xfer(mesh, jet, &grid, y_nograd);
+  for (size_t l = 0; l < size; ++l)
+    assert_that(isnan(y_nograd[l]) ? isnan(y[l]) : y_nograd[l] == y[l]);
+
+  free(y_nograd);
+  free(Dy);
+  free(y);
+  free(jet);
+
+  mesh3_deinit(mesh);
+  mesh3_dealloc(&mesh);
+}
+
+TestSuite *xfer_tests() {
+  TestSuite *suite = create_test_suite();
+  add_test_with_context(suite, xfer, works_for_linear_function_on_cube);
+  return suite;
+}
@@ -27,11 +27,18 @@ cdef extern from "jmm/def.h":
     ctypedef double dbl
     ctypedef double[3] dbl3
     ctypedef double[3][3] dbl33
+    ctypedef unsigned int jmm_index_t # -Dindex_width=32 (the default)
 
     cdef enum error:
         SUCCESS
         BAD_ARGUMENT
 
+cdef extern from "jmm/error.h":
+    ctypedef enum jmm_error_e:
+        JMM_ERROR_NONE
+        JMM_ERROR_BAD_ARGUMENTS
+        JMM_ERROR_RUNTIME_ERROR
+
 cdef extern from "jmm/jet.h":
     struct jet31t:
         dbl f
@@ -58,6 +65,7 @@ cdef extern from "jmm/bmesh.h":
 
     void bmesh33_alloc(bmesh33 **bmesh)
     void bmesh33_init_from_mesh3_and_jets(bmesh33 *bmesh, const mesh3 *mesh, const jet31t *jet)
+    void bmesh33_init_from_mesh3_and_3d_data(bmesh33 *bmesh, const mesh3 *mesh, const dbl *f, const dbl3 *Df)
     dbl bmesh33_f(const bmesh33 *bmesh, const dbl3 x)
 
 cdef class Bmesh33:
@@ -85,8 +93,8 @@ cdef extern from "jmm/mesh3.h":
 
     void mesh3_alloc(mesh3 **mesh)
     void mesh3_dealloc(mesh3 **mesh)
-    void mesh3_init(mesh3 *mesh, const mesh3_data *data, bool compute_bd_info, const dbl *eps)
-    const size_t *mesh3_get_cells_ptr(const mesh3 *mesh)
+    jmm_error_e mesh3_init(mesh3 *mesh, const mesh3_data *data, bool compute_bd_info, bool compute_adj_info, const dbl *eps)
+    const jmm_index_t *mesh3_get_cells_ptr(const mesh3 *mesh)
     const dbl *mesh3_get_verts_ptr(const mesh3 *mesh)
     size_t mesh3_ncells(const mesh3 *mesh)
     size_t mesh3_nverts(const mesh3 *mesh)
@@ -142,9 +150,11 @@ cdef class Mesh3:
     def __cinit__(self):
         mesh3_alloc(&self.mesh)
 
-    def __init__(self, Mesh3Data mesh_data, bool compute_bd_info=True, eps=None):
+    def __init__(self, Mesh3Data mesh_data, bool compute_bd_info=True,
+                 bool compute_adj_info=True, eps=None):
         cdef dbl eps_ = np.nan if eps is None else eps
-        mesh3_init(self.mesh, &mesh_data.data, compute_bd_info, &eps_)
+        if mesh3_init(self.mesh, &mesh_data.data, compute_bd_info, compute_adj_info, &eps_) != JMM_ERROR_NONE:
+            raise ValueError('mesh is too large for jmm_index_t')
 
     @staticmethod
     cdef from_ptr(mesh3 *mesh):
@@ -155,7 +165,7 @@ cdef class Mesh3:
     @property
     def cells(self):
         cdef size_t ncells = mesh3_ncells(self.mesh)
-        return np.asarray(<const size_t[:ncells, :4]> mesh3_get_cells_ptr(self.mesh))
+        return np.asarray(<const jmm_index_t[:ncells, :4]> mesh3_get_cells_ptr(self.mesh))
 
     @property
     def verts(self):
@@ -226,7 +236,8 @@ cdef extern from "jmm/eik3.h":
     void eik3_dealloc(eik3 **eik)
     void eik3_init(eik3 *eik, const mesh3 *mesh, const sfunc *sfunc)
     const mesh3 *eik3_get_mesh(const eik3 *eik)
-    jet31t *eik3_get_jet_ptr(const eik3 *eik)
+    const dbl *eik3_get_T_ptr(const eik3 *eik)
+    const dbl3 *eik3_get_DT_ptr(const eik3 *eik)
 
 cdef class Eik3:
     cdef eik3 *eik
@@ -243,12 +254,17 @@ cdef class Eik3:
         _.eik = eik
         return _
 
+    @property
+    def T(self):
+        cdef size_t nverts = mesh3_nverts(eik3_get_mesh(self.eik))
+        return np.asarray(<const dbl[:nverts]> eik3_get_T_ptr(self.eik))
+
     def build_T_bmesh(self):
         cdef mesh3 *mesh = eik3_get_mesh(self.eik)
-        cdef jet31t *jet = eik3_get_jet_ptr(self.eik)
         cdef bmesh33 *bmesh
         bmesh33_alloc(&bmesh)
-        bmesh33_init_from_mesh3_and_jets(bmesh, mesh, jet)
+        bmesh33_init_from_mesh3_and_3d_data(bmesh, mesh, eik3_get_T_ptr(self.eik),
+                                            eik3_get_DT_ptr(self.eik))
         return Bmesh33.from_ptr(bmesh)
 
 cdef extern from "jmm/eik3hh_branch.h":